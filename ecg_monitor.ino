@@ -9,76 +9,316 @@
  * of the ECG monitoring system.
  */
 
-#include "src/config/config.h"
-#include "src/sensors/ecg_sensor.h"
-#include "src/processing/signal_processor.h"
+#include <ArduinoJson.h>  // First, so the build finds it for the web server and uplink
+#include "src/ecg_core.h"
+#include "src/config/runtime_config.h"
 #include "src/web/web_server.h"
+#include "src/network/wifi_link.h"
+#include "src/scheduler/scheduler.h"
+#include "src/uplink/uplink.h"
+#include "src/power/power_manager.h"
+#include "src/storage/sample_history.h"
+#include "src/memory/memory_arena.h"
+#include "src/memory/heap_guard.h"
+#include "src/telemetry/boot_profile.h"
+#include <sys/time.h>
+#include <esp_sntp.h>
 
 // Global objects
+RuntimeConfig runtimeConfig;
 ECGSensor ecgSensor(ECG_PIN, LO_PLUS_PIN, LO_MINUS_PIN);
 SignalProcessor signalProcessor;
+BeatIndicator beatIndicator(LED_PIN);
+SerialPlotter serialPlotter(Serial);
+ECGPipeline pipeline(ecgSensor, signalProcessor);
 ECGWebServer webServer;
+ECGSimulator ecgSimulator;
+WiFiLink wifiLink;
+Uplink uplink;
+PowerManager powerManager;
+SampleHistory sampleHistory;
+StaticArena<HISTORY_ARENA_SIZE> historyArena("sample history");
+Scheduler scheduler;
+BootProfile bootProfile;
+int samplingTask = -1;
+bool firstSampleTaken = false;
+bool timeSyncStarted = false;
+
+// Latest processed sample, published to the web server by the status task
+ECGFrame latestFrame;
+bool statusPending = false;
+
+// Low power mode: samples are collected on each wake and processed per block
+ECGFrame sampleBlock[MAX_LOW_POWER_BLOCK_SIZE];
+int sampleBlockCount = 0;
 
 void setup() {
+  bootProfile.mark(BOOT_PHASE_SETUP);
   Serial.begin(SERIAL_BAUD_RATE);
   Serial.println("=== ESP32 ECG Monitor Starting ===");
   
-  // Initialize LED
-  pinMode(LED_PIN, OUTPUT);
-  digitalWrite(LED_PIN, LOW);
+  // Fast boot: everything the first sample needs comes first. Storage and
+  // WiFi start afterwards as scheduler tasks, so recording never waits on them.
   
-  // Initialize ECG sensor
-  ecgSensor.begin();
-  Serial.println("✓ ECG sensor initialized");
+  // Load runtime configuration (NVS, falls back to config.h defaults)
+  runtimeConfig.begin();
+  bootProfile.mark(BOOT_PHASE_CONFIG);
   
-  // Initialize signal processor
+  // Initialize ECG sensor at the loaded rate
+  ECGSettings settings;
+  runtimeConfig.takePendingChanges(settings);
+  ecgSensor.begin(settings.sampleRate);
+  if (ENABLE_ECG_SIMULATOR) {
+    ecgSensor.setFrontEnd(&ecgSimulator);
+  }
+  
+  // Initialize signal processor and LED; the loaded settings apply from the first sample
   signalProcessor.begin();
-  Serial.println("✓ Signal processor initialized");
+  pipeline.requestSettings(settings);
+  beatIndicator.begin();
+  
+  // Raw sample history for /waveform (longer window when PSRAM is fitted);
+  // also holds the samples taken before the outbox is mounted
+  bool historyInPsram = false;
+#if defined(ESP32)
+  if (psramFound()) {
+    historyInPsram = sampleHistory.begin((size_t)SAMPLE_HISTORY_PSRAM_SECONDS * runtimeConfig.get().sampleRate);
+  }
+#endif
+  if (!historyInPsram) {
+    sampleHistory.begin((int16_t*)historyArena.allocate(HISTORY_ARENA_SIZE),
+                        HISTORY_ARENA_SIZE / sizeof(int16_t));
+  }
+  
+  // Configure power mode (low power turns the radio off between windows)
+  powerManager.begin(&ecgSensor.getClock(), ENABLE_LOW_POWER_MODE);
+  
+  // Beat LED and serial plot (skipped in low power mode)
+  if (!powerManager.isLowPower()) {
+    pipeline.setBeatIndicator(&beatIndicator);
+    if (ENABLE_SERIAL_PLOTTING) {
+      pipeline.setSerialPlotter(&serialPlotter);
+    }
+  }
+  bootProfile.mark(BOOT_PHASE_SENSOR);
+  
+  // Take the first sample now; the sampling task keeps the cadence from here
+  scheduler.begin(&ecgSensor.getClock());
+  samplingTask = scheduler.addTask("sampling", runSampling, 0);
+  scheduler.runDue();
+  Serial.println("✓ ECG sampling started");
+  
+  // Store-and-forward uplink; the outbox is mounted by the storage task
+  uplink.applySettings(runtimeConfig.get());
+  uplink.setSampleRate(ecgSensor.getSampleRate());
+  uplink.setWiFiLink(&wifiLink);
+  
+  // WiFi connects in the background from the first loop()
+  wifiLink.begin(runtimeConfig.get(), !powerManager.isLowPower());
   
   // Initialize web server
-  webServer.begin();
-  Serial.println("✓ Web server initialized");
+  webServer.setRuntimeConfig(&runtimeConfig);
+  webServer.setSampleClock(&ecgSensor.getClock());
+  webServer.setUplink(&uplink);
+  webServer.setEnergyMonitor(&powerManager.getEnergyMonitor());
+  webServer.setSampleHistory(&sampleHistory);
+#if ECG_FEATURE_ARTIFACT_DETECTION
+  webServer.setQualityMask(&signalProcessor.getQualityMask());   // /quality answers 503 without it
+#endif
+  webServer.setWiFiLink(&wifiLink);
+  webServer.setScheduler(&scheduler);
+  webServer.setBootProfile(&bootProfile);
+  webServer.setBackgroundTask(serviceSampling);
+  if (!powerManager.isLowPower()) {
+    webServer.begin();
+  }
+  
+  // Cooperative tasks, run from loop() in deadline order; none of them blocks
+  scheduler.addTask("storage", startStorage, 0);
+  scheduler.addTask("led", updateBeatIndicator, LED_TASK_PERIOD);
+  scheduler.addTask("web", handleWebClients, WEB_TASK_PERIOD);
+  scheduler.addTask("status", publishStatus, STATUS_TASK_PERIOD);
+  scheduler.addTask("wifi", updateWiFiLink, WIFI_TASK_PERIOD);
+  scheduler.addTask("uplink", updateUplink, UPLINK_TASK_PERIOD);
+  scheduler.addTask("housekeeping", housekeeping, HOUSEKEEPING_TASK_PERIOD);
+  scheduler.addTask("clock sync", syncSampleClock, CLOCK_SYNC_INTERVAL);
+  
+  // Static memory budget; from here on the heap must not be used
+  MemoryArena::printReport(Serial);
+  HeapGuard::arm();
   
+  bootProfile.mark(BOOT_PHASE_SETUP_DONE);
+  bootProfile.printReport(Serial);
   Serial.println("=== System Ready ===");
   Serial.println("Place electrodes and start monitoring!");
 }
 
 void loop() {
-  // Handle web server requests
+  scheduler.runDue();
+  
+  if (powerManager.isLowPower()) {
+    // Light sleep until just before the next sample (radio windows excluded)
+    powerManager.sleepUntilNextSample();
+  } else {
+    // Yield until the next deadline (whole ticks only, never past a sample)
+    scheduler.idle();
+  }
+}
+
+// Scheduler task: take the due sample, then wait for the sample clock's next deadline
+void runSampling() {
+  serviceSampling();
+  scheduler.runAt(samplingTask, ecgSensor.getClock().getNextDeadline());
+}
+
+// Scheduler task (once): mount the outbox and queue what was recorded before it
+void startStorage() {
+  {
+    HeapGuard::Allow allow;  // LittleFS allocates while mounting
+    if (!uplink.begin(&ecgSensor.getClock())) return;
+  }
+  uplink.addHistory(sampleHistory);
+  
+  bootProfile.mark(BOOT_PHASE_STORAGE);
+  Serial.println("✓ Uplink storage ready");
+}
+
+void updateBeatIndicator() {
+  beatIndicator.update();
+}
+
+void handleWebClients() {
   webServer.handleClient();
+}
+
+void updateWiFiLink() {
+  wifiLink.loop();
+  if (wifiLink.isConnected()) {
+    bootProfile.mark(BOOT_PHASE_WIFI);
+    startTimeSync();
+  }
+}
+
+// SNTP starts on the first connection in both power modes; in low power
+// mode it syncs when a transmit window has WiFi up
+void startTimeSync() {
+  if (timeSyncStarted) return;
   
-  // Check if it's time for next ECG sample
-  if (ecgSensor.isTimeForSample()) {
-    // Read ECG data
-    int ecgValue = ecgSensor.readValue();
+  sntp_set_time_sync_notification_cb(onTimeSync);
+  sntp_set_sync_interval(SNTP_SYNC_INTERVAL);
+  configTime(0, 0, NTP_SERVER);
+  timeSyncStarted = true;
+}
+
+void updateUplink() {
+  uplink.loop();
+  powerManager.updateRadio(uplink.isLinkUp(), uplink.getPendingBytes());
+}
+
+void housekeeping() {
+  // Hand configuration changes to the pipeline (sensor and processor switch
+  // together at a block boundary, the uplink with them in handleSample());
+  // a newer change waits until that happened
+  ECGSettings settings;
+  if (!pipeline.isSettingsChangePending() && runtimeConfig.takePendingChanges(settings)) {
+    pipeline.requestSettings(settings);
+    uplink.applySettings(settings);
+    wifiLink.applySettings(settings);
+  }
+  
+  // Memory audit mode: report (and reset on) heap use in the loop
+  HeapGuard::check();
+}
+
+// Also called by the web server while it streams long responses
+void serviceSampling() {
+  ECGFrame frame;
+  if (!pipeline.acquire(frame)) return;
+  
+  if (!firstSampleTaken) {
+    bootProfile.mark(BOOT_PHASE_FIRST_SAMPLE);
+    firstSampleTaken = true;
+  }
+  
+  if (powerManager.isLowPower()) {
+    // Only capture on this wake-up; the pipeline runs once per block
+    sampleBlock[sampleBlockCount++] = frame;
     
-    if (ecgSensor.areLeadsConnected()) {
-      // Process the signal
-      signalProcessor.processSample(ecgValue);
-      
-      // Update web server data
-      webServer.updateECGData(ecgValue, signalProcessor.getHeartRate(), 
-                              signalProcessor.getSignalQuality());
-      
-      // Handle heartbeat LED
-      if (signalProcessor.isHeartbeatDetected()) {
-        digitalWrite(LED_PIN, HIGH);
-        delay(50);
-        digitalWrite(LED_PIN, LOW);
+    if (sampleBlockCount >= getLowPowerBlockSize(ecgSensor.getSampleRate())) {
+      for (int i = 0; i < sampleBlockCount; i++) {
+        handleSample(sampleBlock[i]);
       }
-      
-      // Serial output for debugging/plotting
-      Serial.print(ecgValue);
-      Serial.print(",");
-      Serial.print(signalProcessor.getThreshold());
-      Serial.print(",");
-      Serial.println(signalProcessor.getHeartRate() * 10);
-    } else {
-      Serial.println("! Leads disconnected");
-      digitalWrite(LED_PIN, LOW);
+      sampleBlockCount = 0;
     }
+  } else {
+    handleSample(frame);
+  }
+}
+
+void handleSample(const ECGFrame& frame) {
+  // Keep every sequence in the history; lead-off stretches are marked as gaps
+  sampleHistory.append(frame.leadsConnected ? frame.value : SAMPLE_GAP, frame.sequence);
+  
+  // Shared path: quality mask, signal processing, beat LED, serial plot
+  pipeline.process(frame);
+  
+  // First sample at a new rate: the uplink starts a block at that rate
+  if (frame.settingsChanged) {
+    uplink.setSampleRate(ecgSensor.getClock().getSampleRate(frame.sequence));
   }
   
-  // Small delay to prevent watchdog timeout
-  delay(1);
+  // Record lead transitions for the collector
+  if (pipeline.didLeadsChange()) {
+    uplink.addEvent(frame.leadsConnected ? EVENT_LEADS_ON : EVENT_LEADS_OFF, frame.sequence, 0);
+  }
+  
+  if (!frame.leadsConnected) return;
+  
+  // Mask changes go to the collector as a run-length encoded event stream
+  if (pipeline.didArtifactFlagsChange()) {
+    uplink.addEvent(EVENT_ARTIFACT, frame.sequence, signalProcessor.getArtifactFlags());
+  }
+  
+  // Queue for the collector
+  uplink.addSample(frame.value, frame.sequence, frame.sampleTime);
+  
+  if (pipeline.isBeat()) {
+    uplink.addEvent(EVENT_BEAT, frame.sequence, signalProcessor.getHeartRate());
+  }
+  
+  // Web data is refreshed by the status task
+  latestFrame = frame;
+  statusPending = true;
+}
+
+// Scheduler task: publish the latest results to the web server
+void publishStatus() {
+  if (!statusPending) return;
+  statusPending = false;
+  
+  webServer.updateECGData(latestFrame.value, signalProcessor.getHeartRate(), 
+                          signalProcessor.getSignalQuality(),
+                          latestFrame.sequence, latestFrame.sampleTime);
+  webServer.updateHeartRate(signalProcessor.getInstantHeartRate(),
+                            signalProcessor.getInstantConfidence(),
+                            signalProcessor.getHeartRateConfidence());
+  webServer.updateCalibration(signalProcessor.getThreshold(),
+                              signalProcessor.getBaseline(),
+                              signalProcessor.getNoiseFloor(),
+                              signalProcessor.getPeakAmplitude(),
+                              signalProcessor.isThresholdCalibrated());
+}
+
+// SNTP callback (lwIP task): the time was just set from the server, so it
+// is a true reference point. Polling gettimeofday() in between would read
+// the local crystal back and measure no drift.
+void onTimeSync(struct timeval* tv) {
+  ecgSensor.getClock().postReference(micros(), (int64_t)tv->tv_sec * 1000000 + tv->tv_usec);
+}
+
+// Scheduler task: add the reference of the last SNTP sync to the clock
+void syncSampleClock() {
+  if (ecgSensor.getClock().applyPostedReference()) {
+    bootProfile.mark(BOOT_PHASE_CLOCK_SYNC);
+  }
 }
@@ -0,0 +1,54 @@
+/*
+ * Simple ESP32 ECG Monitor with Serial Output
+ * 
+ * The serial-only build of the monitor: the same sensor, signal processor
+ * and outputs as ecg_monitor.ino, without WiFi, web server or uplink.
+ * Needs no libraries besides this one; open the Serial Plotter at
+ * 115200 baud to see the signal.
+ * 
+ * Hardware Connections:
+ * AD8232 -> ESP32
+ * VCC    -> 3.3V
+ * GND    -> GND
+ * OUTPUT -> GPIO34 (ADC1_CH6)
+ * LO+    -> GPIO32 (Lead Off Detection +)
+ * LO-    -> GPIO33 (Lead Off Detection -)
+ * LED    -> GPIO2 (Built-in LED)
+ * 
+ * Pins, sample rate and detection settings are in src/config/config.h.
+ */
+
+#include <ecg_core.h>
+
+// Global objects
+ECGSensor ecgSensor(ECG_PIN, LO_PLUS_PIN, LO_MINUS_PIN);
+SignalProcessor signalProcessor;
+BeatIndicator beatIndicator(LED_PIN);
+SerialPlotter serialPlotter(Serial);
+ECGPipeline pipeline(ecgSensor, signalProcessor);
+
+void setup() {
+  Serial.begin(SERIAL_BAUD_RATE);
+  Serial.println("=== ESP32 ECG Monitor ===");
+  Serial.println("Connect electrodes and start monitoring");
+  
+  ecgSensor.begin();
+  signalProcessor.begin();
+  beatIndicator.begin();
+  
+  pipeline.setBeatIndicator(&beatIndicator);
+  pipeline.setSerialPlotter(&serialPlotter);
+  serialPlotter.printHeader();
+  Serial.println("========================================");
+}
+
+void loop() {
+  // Take and process the next ECG sample if it is due
+  ECGFrame frame;
+  if (pipeline.acquire(frame)) {
+    pipeline.process(frame);
+  }
+  
+  // End the beat LED pulse
+  beatIndicator.update();
+}
@@ -0,0 +1,144 @@
+/*
+ * Sample Codec Implementation
+ */
+
+#include "sample_codec.h"
+
+static void putLE(uint8_t* out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static uint64_t getLE(const uint8_t* in, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) {
+    value |= (uint64_t)in[i] << (8 * i);
+  }
+  return value;
+}
+
+static size_t putVarint(uint8_t* out, size_t outSize, int32_t value) {
+  // Zigzag: small negative and positive deltas both become small numbers
+  uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+  size_t length = 0;
+  
+  do {
+    if (length >= outSize) return 0;
+    uint8_t byte = zigzag & 0x7F;
+    zigzag >>= 7;
+    out[length++] = zigzag ? (byte | 0x80) : byte;
+  } while (zigzag);
+  
+  return length;
+}
+
+static size_t getVarint(const uint8_t* in, size_t length, int32_t& value) {
+  uint32_t zigzag = 0;
+  size_t used = 0;
+  
+  while (used < length && used < 5) {
+    uint8_t byte = in[used];
+    zigzag |= (uint32_t)(byte & 0x7F) << (7 * used);
+    used++;
+    if (!(byte & 0x80)) {
+      value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+      return used;
+    }
+  }
+  
+  return 0;  // Truncated or overlong
+}
+
+size_t encodeSampleBlock(const SampleBlockHeader& header, const int16_t* samples,
+                         uint8_t* out, size_t outSize) {
+  if (outSize < SAMPLE_BLOCK_HEADER_SIZE) return 0;
+  
+  out[0] = RECORD_SAMPLE_BLOCK;
+  putLE(out + 1, header.firstSequence, 4);
+  putLE(out + 5, header.sampleCount, 2);
+  putLE(out + 7, header.sampleRate, 2);
+  putLE(out + 9, header.firstSampleTime, 8);
+  putLE(out + 17, (uint64_t)header.firstEpochMs, 8);
+  
+  size_t position = SAMPLE_BLOCK_HEADER_SIZE;
+  int16_t previous = 0;
+  
+  for (uint16_t i = 0; i < header.sampleCount; i++) {
+    size_t used = putVarint(out + position, outSize - position, samples[i] - previous);
+    if (used == 0) return 0;
+    position += used;
+    previous = samples[i];
+  }
+  
+  return position;
+}
+
+bool decodeSampleBlock(const uint8_t* in, size_t length, SampleBlockHeader& header,
+                       int16_t* samples, size_t maxSamples) {
+  if (length < SAMPLE_BLOCK_HEADER_SIZE || in[0] != RECORD_SAMPLE_BLOCK) return false;
+  
+  header.firstSequence = getLE(in + 1, 4);
+  header.sampleCount = getLE(in + 5, 2);
+  header.sampleRate = getLE(in + 7, 2);
+  header.firstSampleTime = getLE(in + 9, 8);
+  header.firstEpochMs = (int64_t)getLE(in + 17, 8);
+  
+  if (header.sampleCount > maxSamples) return false;
+  
+  size_t position = SAMPLE_BLOCK_HEADER_SIZE;
+  int32_t previous = 0;
+  
+  for (uint16_t i = 0; i < header.sampleCount; i++) {
+    int32_t delta;
+    size_t used = getVarint(in + position, length - position, delta);
+    if (used == 0) return false;
+    position += used;
+    previous += delta;
+    samples[i] = (int16_t)previous;
+  }
+  
+  return position == length;
+}
+
+size_t encodeEvent(const ECGEvent& event, uint8_t* out, size_t outSize) {
+  if (outSize < EVENT_RECORD_SIZE) return 0;
+  
+  out[0] = RECORD_EVENT;
+  out[1] = event.type;
+  putLE(out + 2, event.sequence, 4);
+  putLE(out + 6, (uint32_t)event.value, 4);
+  
+  return EVENT_RECORD_SIZE;
+}
+
+bool decodeEvent(const uint8_t* in, size_t length, ECGEvent& event) {
+  if (length != EVENT_RECORD_SIZE || in[0] != RECORD_EVENT) return false;
+  
+  event.type = in[1];
+  event.sequence = getLE(in + 2, 4);
+  event.value = (int32_t)getLE(in + 6, 4);
+  
+  return true;
+}
+
+size_t readRecordFrame(const uint8_t* in, size_t length, const uint8_t*& record,
+                       size_t& recordLength) {
+  if (length < RECORD_FRAME_HEADER_SIZE) return 0;
+  
+  recordLength = (size_t)getLE(in, 2);
+  if (length < RECORD_FRAME_HEADER_SIZE + recordLength) return 0;
+  
+  record = in + RECORD_FRAME_HEADER_SIZE;
+  return RECORD_FRAME_HEADER_SIZE + recordLength;
+}
+
+size_t writeRecordFrame(const uint8_t* record, size_t recordLength, uint8_t* out, size_t outSize) {
+  if (recordLength > 0xFFFF || outSize < RECORD_FRAME_HEADER_SIZE + recordLength) return 0;
+  
+  putLE(out, recordLength, 2);
+  for (size_t i = 0; i < recordLength; i++) {
+    out[RECORD_FRAME_HEADER_SIZE + i] = record[i];
+  }
+  return RECORD_FRAME_HEADER_SIZE + recordLength;
+}
@@ -0,0 +1,86 @@
+/*
+ * Sample Codec Header
+ * 
+ * Compact binary records shared by the device uplink and host tools.
+ * Sample blocks store the first value and zigzag varint deltas, which
+ * keeps 12-bit ECG at roughly 1-1.5 bytes per sample. Plain C++ with no
+ * Arduino dependencies so it builds unchanged on the host.
+ * 
+ * All multi-byte header fields are little-endian.
+ */
+
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Record types (first byte of every record)
+enum RecordType {
+  RECORD_SAMPLE_BLOCK = 1,
+  RECORD_EVENT = 2
+};
+
+// Event types
+enum ECGEventType {
+  EVENT_BEAT = 1,          // value = heart rate (BPM)
+  EVENT_LEADS_OFF = 2,
+  EVENT_LEADS_ON = 3,
+  EVENT_ANNOTATION = 4,    // value = reference beat label (MIT-BIH symbol, e.g. 'N'), host tools only
+  EVENT_ARTIFACT = 5       // value = ArtifactFlags from this sample on (0 = clean again)
+};
+
+struct SampleBlockHeader {
+  uint32_t firstSequence;   // Sequence number of the first sample
+  uint16_t sampleCount;
+  uint16_t sampleRate;      // Hz
+  uint64_t firstSampleTime; // Local sample clock (us)
+  int64_t firstEpochMs;     // Epoch time of first sample (0 if unsynchronized)
+};
+
+struct ECGEvent {
+  uint8_t type;             // ECGEventType
+  uint32_t sequence;        // Sample the event refers to
+  int32_t value;
+};
+
+// Missing samples in decoded series (host tools; same value as SAMPLE_GAP)
+const int16_t SAMPLE_GAP_VALUE = -1;
+
+const size_t SAMPLE_BLOCK_HEADER_SIZE = 25;
+const size_t EVENT_RECORD_SIZE = 10;
+
+// Worst-case encoded size of a block (12-bit deltas need at most 2 varint bytes)
+inline size_t maxEncodedBlockSize(size_t sampleCount) {
+  return SAMPLE_BLOCK_HEADER_SIZE + 3 + 2 * sampleCount;
+}
+
+// Encode a sample block; returns bytes written, 0 if out is too small
+size_t encodeSampleBlock(const SampleBlockHeader& header, const int16_t* samples,
+                         uint8_t* out, size_t outSize);
+
+// Decode a sample block; returns false on malformed input or too many samples
+bool decodeSampleBlock(const uint8_t* in, size_t length, SampleBlockHeader& header,
+                       int16_t* samples, size_t maxSamples);
+
+// Encode / decode an event record
+size_t encodeEvent(const ECGEvent& event, uint8_t* out, size_t outSize);
+bool decodeEvent(const uint8_t* in, size_t length, ECGEvent& event);
+
+// Records are framed as [uint16 length][record] in the outbox and in uploads
+const size_t RECORD_FRAME_HEADER_SIZE = 2;
+
+// Split the next framed record off a batch; returns bytes consumed
+// (0 if the frame is incomplete)
+size_t readRecordFrame(const uint8_t* in, size_t length, const uint8_t*& record,
+                       size_t& recordLength);
+
+// Frame a record; returns bytes written, 0 if out is too small
+size_t writeRecordFrame(const uint8_t* record, size_t recordLength, uint8_t* out, size_t outSize);
+
+// Record type of an encoded record (0 if empty)
+inline uint8_t getRecordType(const uint8_t* in, size_t length) {
+  return length > 0 ? in[0] : 0;
+}
+
+#endif // SAMPLE_CODEC_H
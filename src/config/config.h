@@ -18,46 +18,192 @@ const int SERIAL_BAUD_RATE = 115200;
 
 // ========== WiFi CONFIGURATION ==========
 // Update these with your network credentials
-const char* WIFI_SSID = "YOUR_WIFI_NETWORK_NAME";     // Replace with your WiFi name
-const char* WIFI_PASSWORD = "YOUR_WIFI_PASSWORD";      // Replace with your WiFi password
+const char* const WIFI_SSID = "YOUR_WIFI_NETWORK_NAME";     // Replace with your WiFi name
+const char* const WIFI_PASSWORD = "YOUR_WIFI_PASSWORD";      // Replace with your WiFi password
 const int WEB_SERVER_PORT = 80;
 
 // ========== ECG SAMPLING SETTINGS ==========
 const int SAMPLE_RATE = 500;                           // Hz - ECG sampling rate
 const unsigned long SAMPLE_INTERVAL = 1000000 / SAMPLE_RATE; // microseconds
+// Rates with compile-time specialized pipelines (see processing/sample_rate.h)
+const int SUPPORTED_SAMPLE_RATES[] = { 250, 500, 1000 };  // Hz
+const int MAX_SAMPLE_RATE = 1000;                      // Hz - highest supported rate (sizes buffers)
+
+// ========== SAMPLE CLOCK ==========
+const unsigned long MAX_SAMPLE_LATENESS = 10;           // Samples - skip ahead (and count missed) beyond this
+const unsigned long CLOCK_SYNC_INTERVAL = 1000;         // ms between checks for a new SNTP reference
+const unsigned long SNTP_SYNC_INTERVAL = 3600000;       // ms between SNTP updates (each is a reference point)
+const unsigned long MIN_DRIFT_MEASUREMENT_SPAN = 900000; // ms between references before estimating drift
+const float DRIFT_SMOOTHING = 0.3;                      // Weight of each new drift measurement
+const float MAX_CLOCK_DRIFT_PPM = 500;                  // Reject drift estimates beyond this
+const int SAMPLE_CLOCK_EPOCHS = 8;                      // Grid changes kept to time earlier samples
+const char* const NTP_SERVER = "pool.ntp.org";
 
 // ========== SIGNAL PROCESSING SETTINGS ==========
-const int ECG_BUFFER_SIZE = 100;        // Buffer size for signal processing
+const int ECG_BUFFER_MS = 200;          // Raw window for mean, variance and signal quality
+const int ECG_BUFFER_SIZE = SAMPLE_RATE * ECG_BUFFER_MS / 1000;         // Samples at SAMPLE_RATE
+const int MAX_ECG_BUFFER_SIZE = MAX_SAMPLE_RATE * ECG_BUFFER_MS / 1000; // Samples at the highest rate
 const int HEARTBEAT_THRESHOLD = 2048;   // Threshold for heartbeat detection (0-4095)
-const int BEAT_BUFFER_SIZE = 10;        // Number of heartbeat intervals to average
+
+// ========== ADAPTIVE THRESHOLD CALIBRATION ==========
+// HEARTBEAT_THRESHOLD is used until the first calibration window completes
+const int CALIBRATION_WINDOW_MS = 4000;             // Calibration window length
+const int CALIBRATION_WINDOW_SIZE = SAMPLE_RATE * CALIBRATION_WINDOW_MS / 1000; // Samples
+const float CALIBRATION_PEAK_QUANTILE = 0.98;       // Quantile treated as R-peak amplitude
+const float CALIBRATION_SMOOTHING = 0.5;            // Weight of each new window (0-1)
+const float THRESHOLD_PEAK_FRACTION = 0.6;          // Threshold position between baseline and peak
+const float THRESHOLD_NOISE_MARGIN = 3.0;           // Minimum threshold distance above baseline (x noise)
+const float CALIBRATION_MIN_PEAK_TO_NOISE = 4.0;    // Reject windows with weaker R-peaks
+const int MIN_CALIBRATION_PEAK_HEIGHT = 50;         // ADC counts - reject flat-line windows
+
+// ========== ARTIFACT DETECTION ==========
+// Masked samples are skipped by beat detection, threshold learning and HR averaging
+const int ARTIFACT_SEGMENT_MS = 40;                 // Sliding window for energy and peak-to-peak
+const int MAX_ARTIFACT_SEGMENT_SIZE = 64;           // Samples - segment buffer at the highest rate
+const int ARTIFACT_CLIP_MARGIN = 16;                // ADC counts from either rail treated as clipped
+const int ARTIFACT_MAX_SLOPE = 150;                 // ADC counts per ms between two samples
+const int ARTIFACT_MAX_PEAK_TO_PEAK = 2400;         // ADC counts within two segments
+const float ARTIFACT_NOISE_RATIO = 4.0;             // High-frequency RMS limit (x learned level)
+const int ARTIFACT_NOISE_MIN_RMS = 12;              // ADC counts at SAMPLE_RATE - QRS energy added to the noise limit
+const int ARTIFACT_HOLD_MS = 250;                   // Mask kept after the last flagged sample
+const int ARTIFACT_RELEARN_WINDOWS = 8;             // Windows without a clean segment before the level follows all segments
+const int QUALITY_MASK_RUNS = 32;                   // Mask runs kept for readers
 
 // ========== HEART RATE LIMITS ==========
 const unsigned long MIN_BEAT_INTERVAL = 300;  // ms (200 BPM max)
 const unsigned long MAX_BEAT_INTERVAL = 2000; // ms (30 BPM min)
 
+// ========== HEART RATE ESTIMATION ==========
+// Intervals inside the limits above are checked against the recent median RR
+const int HR_MEDIAN_WINDOW = 9;                     // RR intervals per sliding median (odd)
+const float HR_RR_TOLERANCE = 0.2;                  // Largest accepted deviation from the median RR
+const int HR_MIN_REFERENCE_INTERVALS = 3;           // Intervals before outliers are rejected
+const int SLIDING_MEDIAN_CAPACITY = 32;             // Largest sliding median window
+static_assert(HR_MEDIAN_WINDOW <= SLIDING_MEDIAN_CAPACITY && HR_MEDIAN_WINDOW < 32,
+              "HR_MEDIAN_WINDOW exceeds the sliding median and outcome history");
+
 // ========== ADC CONFIGURATION ==========
 const int ADC_RESOLUTION = 12;          // 12-bit ADC (0-4095)
 const adc_attenuation_t ADC_ATTENUATION = ADC_11db; // For 3.3V range
 
 // ========== FILTER SETTINGS ==========
-const int MOVING_AVERAGE_SIZE = 5;      // Moving average filter size
+const int MOVING_AVERAGE_WINDOW_MS = 10;  // Moving average window length
+const int MOVING_AVERAGE_SIZE = (SAMPLE_RATE * MOVING_AVERAGE_WINDOW_MS + 500) / 1000; // Samples (5 at 500 Hz)
+
+// ========== RUNTIME CONFIGURATION ==========
+// The constants in this file are the compile-time defaults; values changed
+// through /config are persisted in NVS and override them at boot.
+const char* const CONFIG_NAMESPACE = "ecg";     // NVS namespace
+const char* const WIFI_CACHE_NAMESPACE = "wifi"; // NVS namespace of the last access point
+const char* const CONFIG_FILE_PATH = "ecg_config.bin"; // Backing file on non-ESP32 builds
+const uint32_t CONFIG_VERSION = 3;              // Bump when ECGSettings layout changes
+const int CONFIG_APPLY_BLOCK_MS = 100;          // Settings swap at block boundaries
+const int CONFIG_APPLY_BLOCK_SIZE = SAMPLE_RATE * CONFIG_APPLY_BLOCK_MS / 1000; // Samples at SAMPLE_RATE
+const int MAX_MOVING_AVERAGE_SIZE = 32;         // Upper bound for runtime filter size
 
 // ========== WEB UPDATE INTERVALS ==========
 const unsigned long DATA_UPDATE_INTERVAL = 20;   // ms (50 Hz)
 const unsigned long STATUS_UPDATE_INTERVAL = 1000; // ms (1 Hz)
 
+// ========== SAMPLE HISTORY ==========
+const size_t SAMPLE_HISTORY_SAMPLES = 32768;            // Ring in internal heap (65 s at 500 Hz)
+const int SAMPLE_HISTORY_PSRAM_SECONDS = 600;           // History kept when PSRAM is available
+const int WAVEFORM_MAX_SECONDS = 30;                    // Longest window served by /waveform
+const int WAVEFORM_CHUNK_SAMPLES = 200;                 // Samples formatted per streamed chunk
+const unsigned long WAVEFORM_SEND_TIMEOUT = 3000;       // ms a stalled client may hold the stream
+const int16_t SAMPLE_GAP = -1;                          // History marker for missed samples
+
+// ========== MEMORY BUDGET ==========
+// Subsystem buffers come from fixed arenas (see memory/memory_arena.h)
+const size_t HISTORY_ARENA_SIZE = SAMPLE_HISTORY_SAMPLES * sizeof(int16_t);
+const size_t WEB_ARENA_SIZE = 6144;                     // JSON document + response text per request
+const size_t WEB_JSON_DOCUMENT_SIZE = 3072;             // Largest JSON document (/power)
+const size_t UPLINK_ARENA_SIZE = 128;                   // Collector acknowledgement document
+const size_t STATIC_MEMORY_BUDGET = 96 * 1024;          // Limit for all arenas together
+static_assert(HISTORY_ARENA_SIZE + WEB_ARENA_SIZE + UPLINK_ARENA_SIZE <= STATIC_MEMORY_BUDGET,
+              "Memory arenas exceed STATIC_MEMORY_BUDGET");
+static_assert((SAMPLE_HISTORY_SAMPLES & (SAMPLE_HISTORY_SAMPLES - 1)) == 0,
+              "SAMPLE_HISTORY_SAMPLES must be a power of two");
+#ifndef ECG_MEMORY_AUDIT
+#define ECG_MEMORY_AUDIT 0                              // Build with -DECG_MEMORY_AUDIT=1 to audit
+#endif
+const bool ENABLE_MEMORY_AUDIT = ECG_MEMORY_AUDIT;      // Flag heap allocation after setup()
+const bool MEMORY_AUDIT_ABORT = true;                   // Reset on a violation (false = log only)
+const size_t MEMORY_AUDIT_HEAP_SLACK = 4096;            // Free heap drop tolerated without heap hooks
+const int HEAP_GUARD_MAX_VIOLATIONS = 16;               // Violations kept for the report
+
+// ========== UPLINK (STORE AND FORWARD) ==========
+const char* const UPLINK_COLLECTOR_URL = "";           // HTTP collector, empty = store only
+const int UPLINK_BLOCK_SAMPLES = 250;                   // Samples per compressed block
+const size_t UPLINK_OUTBOX_MAX_BYTES = 1000000;         // Outbox storage limit (~30 min at 500 Hz)
+const size_t UPLINK_OUTBOX_SEGMENT_BYTES = 65536;       // Segment file size; acknowledged segments are deleted
+const size_t UPLINK_OUTBOX_WRITE_BUFFER = 1024;         // Appends held in RAM between flushes (~1.5 s at 500 Hz)
+const unsigned long UPLINK_OUTBOX_FLUSH_INTERVAL = 1000; // ms - appends written to flash, lost on power loss before
+const int UPLINK_OUTBOX_MAX_SEGMENTS = UPLINK_OUTBOX_MAX_BYTES / UPLINK_OUTBOX_SEGMENT_BYTES + 2;
+const size_t UPLINK_MAX_BATCH_BYTES = 4096;             // Bytes per upload request
+const unsigned long UPLINK_INTERVAL = 2000;             // ms between uploads when caught up
+const unsigned long UPLINK_CATCHUP_INTERVAL = 250;      // ms between uploads while behind (16 KB/s)
+const unsigned long UPLINK_HTTP_TIMEOUT = 2000;         // ms
+const uint32_t UPLINK_TASK_STACK_SIZE = 6144;           // Bytes - HTTP client and acknowledgement parser
+const int UPLINK_TASK_PRIORITY = 1;                     // Same as loop(), which runs on the other core
+const int UPLINK_TASK_CORE = 0;                         // Beside the WiFi stack, away from sampling
+const unsigned long UPLINK_MIN_BACKOFF = 1000;          // ms - first retry delay
+const unsigned long UPLINK_MAX_BACKOFF = 60000;         // ms - retry delay cap
+const char* const UPLINK_OUTBOX_DIR = "/littlefs/outbox";     // One file per segment
+const char* const UPLINK_STATE_PATH = "/littlefs/outbox.state";
+
+// ========== LOW POWER MODE ==========
+const bool ENABLE_LOW_POWER_MODE = false;               // Duty-cycled operation for battery patches
+const int LOW_POWER_BLOCK_MS = 100;                     // Buffered per processing wake-up
+const int LOW_POWER_BLOCK_SIZE = SAMPLE_RATE * LOW_POWER_BLOCK_MS / 1000;         // Samples at SAMPLE_RATE
+const int MAX_LOW_POWER_BLOCK_SIZE = MAX_SAMPLE_RATE * LOW_POWER_BLOCK_MS / 1000; // Samples at the highest rate
+const int LOW_POWER_CPU_MHZ = 80;                       // CPU clock in low power mode
+const unsigned long LOW_POWER_TX_INTERVAL = 60000;      // ms between radio transmit windows
+const unsigned long LOW_POWER_TX_WINDOW_MAX = 10000;    // ms - close the window even if not drained
+const unsigned long LIGHT_SLEEP_MIN_US = 800;           // Only sleep if the gap is at least this long
+const unsigned long LIGHT_SLEEP_WAKE_LATENCY_US = 400;  // Wake this early before the sample deadline
+
+// ========== ENERGY ACCOUNTING ==========
+// Typical ESP32 + AD8232 currents (mA); adjust for your board
+const float CURRENT_CPU_ACTIVE_MA = 30.0;               // CPU running at LOW_POWER_CPU_MHZ
+const float CURRENT_CPU_LIGHT_SLEEP_MA = 0.8;
+const float CURRENT_RADIO_ACTIVE_MA = 100.0;            // Connecting / transmitting
+const float CURRENT_RADIO_MODEM_SLEEP_MA = 3.0;         // Associated, DTIM wake-ups only
+const float CURRENT_SENSOR_MA = 0.2;                    // AD8232 front end
+const float BATTERY_CAPACITY_MAH = 500;                 // For battery life estimates
+const int POWER_TRACE_SIZE = 64;                        // State transitions kept for /power
+
+// ========== BOOT ==========
+// Sampling starts before storage and network come up (see telemetry/boot_profile.h)
+const int BOOT_MAX_PHASES = 12;                         // Phases kept for /metrics
+const unsigned long BOOT_FIRST_SAMPLE_TARGET_US = 20000; // App start to first sample (tools/timing/boot_bench)
+
+// ========== SCHEDULER ==========
+// Cooperative tasks run from loop() in deadline order (see scheduler/scheduler.h)
+const int SCHEDULER_MAX_TASKS = 12;
+const unsigned long WEB_TASK_PERIOD = 5;                // ms between HTTP client polls
+const unsigned long WIFI_TASK_PERIOD = 100;             // ms between WiFi link state checks
+const unsigned long UPLINK_TASK_PERIOD = 20;            // ms between outbox upload checks
+const unsigned long STATUS_TASK_PERIOD = 50;            // ms between web status refreshes
+const unsigned long LED_TASK_PERIOD = 10;               // ms between beat LED checks
+const unsigned long HOUSEKEEPING_TASK_PERIOD = 100;     // ms - config changes, heap audit
+const unsigned long SCHEDULER_MIN_SLEEP_US = 2000;      // Idle gap before loop() gives up whole ticks
+
 // ========== SIGNAL QUALITY THRESHOLDS ==========
 const int MIN_SIGNAL_QUALITY = 20;      // Minimum acceptable signal quality (%)
 const int GOOD_SIGNAL_QUALITY = 70;     // Good signal quality threshold (%)
 
 // ========== SYSTEM TIMEOUTS ==========
 const unsigned long WIFI_TIMEOUT = 10000;       // ms - WiFi connection timeout
+const unsigned long WIFI_FAST_CONNECT_TIMEOUT = 3000; // ms - attempt on the cached AP before a full scan
 const unsigned long HEARTBEAT_TIMEOUT = 5000;   // ms - No heartbeat detection timeout
 
 // ========== DEBUG SETTINGS ==========
 const bool ENABLE_SERIAL_PLOTTING = true;       // Enable serial output for plotter
 const bool ENABLE_DEBUG_MESSAGES = true;        // Enable debug messages
 const int SERIAL_PLOT_SCALE_FACTOR = 10;        // Scale factor for heart rate in serial plot
+const unsigned long BEAT_LED_PULSE_MS = 50;     // LED on time per detected beat (non-blocking)
+const bool ENABLE_ECG_SIMULATOR = false;        // Replace AD8232 input with synthetic ECG
 
 // ========== HARDWARE SPECIFIC ==========
 const float REFERENCE_VOLTAGE = 3.3;            // ESP32 reference voltage
@@ -0,0 +1,50 @@
+/*
+ * Build Features
+ * 
+ * Subsystems that need more than the ESP32 core are compiled only when
+ * their dependency is part of the build. The web server, the uplink and
+ * the arena allocator for JSON documents need ArduinoJson: they are built
+ * when the sketch includes <ArduinoJson.h> (which also makes the Arduino
+ * build find the library), and left out of a serial-only build together
+ * with the WiFi link they use. Define ECG_FEATURE_NETWORK as 0 or 1 in the
+ * build flags to override.
+ * 
+ * The stages of the signal path are on by default. Building with one set
+ * to 0 leaves its code and buffers out, and SignalProcessor falls back to
+ * what the original serial example did (tools/size_report measures each):
+ *   ECG_FEATURE_ADAPTIVE_THRESHOLD - learned detection threshold; without
+ *     it the heartbeatThreshold setting is used as a fixed threshold
+ *   ECG_FEATURE_ARTIFACT_DETECTION - artifact classifier and quality mask;
+ *     without it every sample reaches the detector and the flags read 0
+ *   ECG_FEATURE_MEDIAN_HEART_RATE - median of the RR intervals with
+ *     outlier rejection; without it the rate is that of the last interval
+ */
+
+#ifndef FEATURES_H
+#define FEATURES_H
+
+#ifndef ECG_FEATURE_NETWORK
+#if defined(__has_include)
+#if __has_include(<ArduinoJson.h>)
+#define ECG_FEATURE_NETWORK 1
+#else
+#define ECG_FEATURE_NETWORK 0
+#endif
+#else
+#define ECG_FEATURE_NETWORK 1
+#endif
+#endif
+
+#ifndef ECG_FEATURE_ADAPTIVE_THRESHOLD
+#define ECG_FEATURE_ADAPTIVE_THRESHOLD 1
+#endif
+
+#ifndef ECG_FEATURE_ARTIFACT_DETECTION
+#define ECG_FEATURE_ARTIFACT_DETECTION 1
+#endif
+
+#ifndef ECG_FEATURE_MEDIAN_HEART_RATE
+#define ECG_FEATURE_MEDIAN_HEART_RATE 1
+#endif
+
+#endif // FEATURES_H
@@ -0,0 +1,208 @@
+/*
+ * Runtime Configuration Class Implementation
+ * 
+ * Settings are stored as a single versioned blob so a partially written
+ * or outdated record is ignored instead of half-applied.
+ */
+
+#include "runtime_config.h"
+#include "../processing/sample_rate.h"
+
+#if defined(ESP32)
+#include <Preferences.h>
+#else
+#include <stdio.h>
+#endif
+
+// "sampleRate must be one of ..." listing the instantiated rate profiles
+static const char* describeSupportedRates() {
+  static char message[64] = "";
+  if (message[0] != '\0') return message;
+  
+  size_t length = snprintf(message, sizeof(message), "sampleRate must be one of");
+  for (int i = 0; i < getRateProfileCount() && length < sizeof(message); i++) {
+    length += snprintf(message + length, sizeof(message) - length, "%s %d",
+                       i > 0 ? "," : "", getRateProfile(i).sampleRate);
+  }
+  return message;
+}
+
+RuntimeConfig::RuntimeConfig() {
+  getDefaults(active);
+  pending = active;
+  pendingChanges = false;
+  loadedFromStorage = false;
+}
+
+bool RuntimeConfig::begin() {
+  ECGSettings stored;
+  
+  if (load(stored) && validate(stored) == NULL) {
+    active = stored;
+    loadedFromStorage = true;
+    Serial.println("Runtime configuration loaded from storage");
+  } else {
+    getDefaults(active);
+    loadedFromStorage = false;
+    Serial.println("Runtime configuration using compile-time defaults");
+  }
+  
+  pending = active;
+  pendingChanges = true;  // Let the pipeline pick up the loaded settings
+  
+  return true;
+}
+
+void RuntimeConfig::getDefaults(ECGSettings& settings) {
+  memset(&settings, 0, sizeof(settings));
+  strncpy(settings.wifiSsid, WIFI_SSID, sizeof(settings.wifiSsid) - 1);
+  strncpy(settings.wifiPassword, WIFI_PASSWORD, sizeof(settings.wifiPassword) - 1);
+  settings.sampleRate = SAMPLE_RATE;
+  settings.movingAverageSize = MOVING_AVERAGE_SIZE;
+  settings.heartbeatThreshold = HEARTBEAT_THRESHOLD;
+  settings.adaptiveThreshold = true;
+  settings.artifactMasking = true;
+  settings.minBeatInterval = MIN_BEAT_INTERVAL;
+  settings.maxBeatInterval = MAX_BEAT_INTERVAL;
+  settings.dataUpdateInterval = DATA_UPDATE_INTERVAL;
+  settings.statusUpdateInterval = STATUS_UPDATE_INTERVAL;
+  strncpy(settings.collectorUrl, UPLINK_COLLECTOR_URL, sizeof(settings.collectorUrl) - 1);
+}
+
+void RuntimeConfig::getDefaults(ProcessingSettings& processing) {
+  processing.sampleRate = SAMPLE_RATE;
+  processing.movingAverageSize = MOVING_AVERAGE_SIZE;
+  processing.heartbeatThreshold = HEARTBEAT_THRESHOLD;
+  processing.adaptiveThreshold = true;
+  processing.artifactMasking = true;
+  processing.minBeatInterval = MIN_BEAT_INTERVAL;
+  processing.maxBeatInterval = MAX_BEAT_INTERVAL;
+}
+
+void RuntimeConfig::getProcessingSettings(const ECGSettings& settings, ProcessingSettings& processing) {
+  processing.sampleRate = settings.sampleRate;
+  processing.movingAverageSize = settings.movingAverageSize;
+  processing.heartbeatThreshold = settings.heartbeatThreshold;
+  processing.adaptiveThreshold = settings.adaptiveThreshold;
+  processing.artifactMasking = settings.artifactMasking;
+  processing.minBeatInterval = settings.minBeatInterval;
+  processing.maxBeatInterval = settings.maxBeatInterval;
+}
+
+const char* RuntimeConfig::validate(const ECGSettings& settings) {
+  if (settings.wifiSsid[0] == '\0') {
+    return "wifiSsid must not be empty";
+  }
+  if (findRateProfile(settings.sampleRate) == NULL) {
+    return describeSupportedRates();
+  }
+  if (settings.movingAverageSize < 1 || settings.movingAverageSize > MAX_MOVING_AVERAGE_SIZE) {
+    return "movingAverageSize out of range";
+  }
+  if (settings.heartbeatThreshold < 0 || settings.heartbeatThreshold > ADC_MAX_VALUE) {
+    return "heartbeatThreshold out of range";
+  }
+  if (settings.minBeatInterval == 0 || settings.minBeatInterval >= settings.maxBeatInterval) {
+    return "minBeatInterval must be below maxBeatInterval";
+  }
+  if (settings.dataUpdateInterval == 0 || settings.statusUpdateInterval == 0) {
+    return "update intervals must be positive";
+  }
+  if (settings.collectorUrl[0] != '\0' && strncmp(settings.collectorUrl, "http://", 7) != 0 &&
+      strncmp(settings.collectorUrl, "https://", 8) != 0) {
+    return "collectorUrl must be an http(s) URL";
+  }
+  
+  return NULL;
+}
+
+const char* RuntimeConfig::update(const ECGSettings& settings) {
+  const char* error = validate(settings);
+  if (error != NULL) {
+    return error;
+  }
+  
+  if (!save(settings)) {
+    return "failed to persist settings";
+  }
+  
+  active = settings;
+  pending = settings;
+  pendingChanges = true;
+  
+  Serial.println("Runtime configuration updated");
+  return NULL;
+}
+
+void RuntimeConfig::resetToDefaults() {
+  ECGSettings defaults;
+  getDefaults(defaults);
+  
+  save(defaults);
+  active = defaults;
+  pending = defaults;
+  pendingChanges = true;
+  
+  Serial.println("Runtime configuration reset to defaults");
+}
+
+bool RuntimeConfig::takePendingChanges(ECGSettings& settings) {
+  if (!pendingChanges) return false;
+  
+  settings = pending;
+  pendingChanges = false;
+  return true;
+}
+
+#if defined(ESP32)
+
+bool RuntimeConfig::load(ECGSettings& settings) {
+  Preferences prefs;
+  if (!prefs.begin(CONFIG_NAMESPACE, true)) return false;
+  
+  bool ok = prefs.getUInt("version", 0) == CONFIG_VERSION &&
+            prefs.getBytesLength("settings") == sizeof(settings) &&
+            prefs.getBytes("settings", &settings, sizeof(settings)) == sizeof(settings);
+  
+  prefs.end();
+  return ok;
+}
+
+bool RuntimeConfig::save(const ECGSettings& settings) {
+  Preferences prefs;
+  if (!prefs.begin(CONFIG_NAMESPACE, false)) return false;
+  
+  bool ok = prefs.putBytes("settings", &settings, sizeof(settings)) == sizeof(settings) &&
+            prefs.putUInt("version", CONFIG_VERSION) > 0;
+  
+  prefs.end();
+  return ok;
+}
+
+#else
+
+bool RuntimeConfig::load(ECGSettings& settings) {
+  FILE* file = fopen(CONFIG_FILE_PATH, "rb");
+  if (file == NULL) return false;
+  
+  uint32_t version = 0;
+  bool ok = fread(&version, sizeof(version), 1, file) == 1 &&
+            version == CONFIG_VERSION &&
+            fread(&settings, sizeof(settings), 1, file) == 1;
+  
+  fclose(file);
+  return ok;
+}
+
+bool RuntimeConfig::save(const ECGSettings& settings) {
+  FILE* file = fopen(CONFIG_FILE_PATH, "wb");
+  if (file == NULL) return false;
+  
+  bool ok = fwrite(&CONFIG_VERSION, sizeof(CONFIG_VERSION), 1, file) == 1 &&
+            fwrite(&settings, sizeof(settings), 1, file) == 1;
+  
+  fclose(file);
+  return ok;
+}
+
+#endif
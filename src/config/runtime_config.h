@@ -0,0 +1,97 @@
+/*
+ * Runtime Configuration Class Header
+ * 
+ * Typed runtime settings persisted in NVS (or a file on non-ESP32 builds).
+ * Compile-time values in config.h remain the defaults; changes are staged
+ * as pending and picked up by the main loop.
+ */
+
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+#include <Arduino.h>
+#include "config.h"
+
+struct ECGSettings {
+  // WiFi
+  char wifiSsid[33];
+  char wifiPassword[65];
+  
+  // Sampling
+  int sampleRate;
+  
+  // Signal processing
+  int movingAverageSize;
+  int heartbeatThreshold;
+  bool adaptiveThreshold;
+  bool artifactMasking;
+  unsigned long minBeatInterval;
+  unsigned long maxBeatInterval;
+  
+  // Web update intervals
+  unsigned long dataUpdateInterval;
+  unsigned long statusUpdateInterval;
+  
+  // Uplink
+  char collectorUrl[128];
+};
+
+// The signal processing part of ECGSettings. SignalProcessor keeps an
+// active and a pending copy of these only, not of the WiFi and uplink
+// strings.
+struct ProcessingSettings {
+  int sampleRate;
+  int movingAverageSize;
+  int heartbeatThreshold;
+  bool adaptiveThreshold;
+  bool artifactMasking;
+  unsigned long minBeatInterval;
+  unsigned long maxBeatInterval;
+};
+
+class RuntimeConfig {
+private:
+  ECGSettings active;
+  ECGSettings pending;
+  bool pendingChanges;
+  bool loadedFromStorage;
+  
+  // Internal methods
+  bool load(ECGSettings& settings);
+  bool save(const ECGSettings& settings);
+  
+public:
+  // Constructor
+  RuntimeConfig();
+  
+  // Load persisted settings (falls back to compile-time defaults)
+  bool begin();
+  
+  // Get the active settings
+  const ECGSettings& get() { return active; }
+  
+  // Validate, persist and stage new settings
+  // Returns NULL on success, otherwise a description of the problem
+  const char* update(const ECGSettings& settings);
+  
+  // Restore and persist compile-time defaults
+  void resetToDefaults();
+  
+  // Take staged settings; returns false if nothing changed since last call
+  bool takePendingChanges(ECGSettings& settings);
+  
+  // Check whether settings came from persistent storage
+  bool isLoadedFromStorage() { return loadedFromStorage; }
+  
+  // Fill settings with compile-time defaults
+  static void getDefaults(ECGSettings& settings);
+  static void getDefaults(ProcessingSettings& processing);
+  
+  // Copy the signal processing part of settings
+  static void getProcessingSettings(const ECGSettings& settings, ProcessingSettings& processing);
+  
+  // Check settings for out-of-range values (NULL if valid)
+  static const char* validate(const ECGSettings& settings);
+};
+
+#endif // RUNTIME_CONFIG_H
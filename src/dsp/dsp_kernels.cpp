@@ -0,0 +1,40 @@
+/*
+ * DSP Kernels - Scalar Reference
+ * 
+ * The scalar functions double as the reference for the vector backends
+ * and handle the tails those leave over.
+ */
+
+#include "dsp_kernels.h"
+
+int32_t dspScalarSum(const int16_t* x, size_t n) {
+  int32_t sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += x[i];
+  }
+  return sum;
+}
+
+int64_t dspScalarSumSquares(const int16_t* x, size_t n) {
+  int64_t sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += (int32_t)x[i] * x[i];
+  }
+  return sum;
+}
+
+#if defined(DSP_BACKEND_SCALAR)
+
+int32_t dspSum(const int16_t* x, size_t n) {
+  return dspScalarSum(x, n);
+}
+
+int64_t dspSumSquares(const int16_t* x, size_t n) {
+  return dspScalarSumSquares(x, n);
+}
+
+const char* dspBackendName() {
+  return "scalar";
+}
+
+#endif // DSP_BACKEND_SCALAR
@@ -0,0 +1,57 @@
+/*
+ * DSP Kernels Header
+ * 
+ * Hot numeric primitives of the processing pipeline behind one interface,
+ * with a vector backend chosen at compile time:
+ *   - ESP32-S3 with DSP_USE_PIE: PIE 128-bit instructions (ACCX
+ *     multiply-accumulate). It has never been compiled or run, so it is
+ *     opt-in until it passes the tools/dsp checks on an S3.
+ *   - x86 hosts: SSE2
+ *   - ARM hosts: NEON
+ *   - anything else, or DSP_FORCE_SCALAR: portable scalar C
+ * 
+ * All kernels use integer arithmetic with wide accumulators, so every
+ * backend returns bit-identical results to the scalar reference
+ * (dspScalar*). Inputs must lie in [-32767, 32767]; the ADC range is far
+ * inside that.
+ */
+
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(ESP32)
+#include <sdkconfig.h>
+#endif
+
+#if defined(DSP_FORCE_SCALAR)
+#define DSP_BACKEND_SCALAR 1
+#elif defined(CONFIG_IDF_TARGET_ESP32S3) && defined(DSP_USE_PIE)
+#define DSP_BACKEND_ESP32S3 1
+#elif defined(__SSE2__)
+#define DSP_BACKEND_SSE2 1
+#elif defined(__ARM_NEON)
+#define DSP_BACKEND_NEON 1
+#else
+#define DSP_BACKEND_SCALAR 1
+#endif
+
+// ========== VECTOR KERNELS (backend specific) ==========
+
+// Sum of n samples (n <= 65536)
+int32_t dspSum(const int16_t* x, size_t n);
+
+// Sum of squares
+int64_t dspSumSquares(const int16_t* x, size_t n);
+
+// Name of the compiled-in backend
+const char* dspBackendName();
+
+// ========== SCALAR REFERENCE ==========
+
+int32_t dspScalarSum(const int16_t* x, size_t n);
+int64_t dspScalarSumSquares(const int16_t* x, size_t n);
+
+#endif // DSP_KERNELS_H
@@ -0,0 +1,117 @@
+/*
+ * DSP Kernels - ESP32-S3 PIE Backend
+ * 
+ * Multiply-accumulate runs on the 40-bit ACCX accumulator, eight int16
+ * lanes per instruction. ACCX is drained into a 64-bit total every
+ * ACCX_BLOCK_VECTORS vectors (8 products of up to 2^30 each per vector),
+ * which keeps results exact. PIE loads ignore the low address bits, so the
+ * vector loops start at a 16-byte boundary and the ends are done in scalar.
+ * 
+ * Opt-in with DSP_USE_PIE: this file has not been through the Xtensa
+ * toolchain or on an ESP32-S3 yet, so other S3 builds use the scalar
+ * backend.
+ */
+
+#include "dsp_kernels.h"
+
+#if defined(DSP_BACKEND_ESP32S3)
+
+static const size_t ACCX_BLOCK_VECTORS = 64;
+
+static const int16_t ONES[8] __attribute__((aligned(16))) = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+static inline bool isAligned(const void* pointer) {
+  return ((uintptr_t)pointer & 15) == 0;
+}
+
+static inline int64_t readAccx() {
+  uint32_t low, high;
+  asm volatile ("rur.accx_0 %0" : "=r"(low));
+  asm volatile ("rur.accx_1 %0" : "=r"(high));
+  
+  // Sign-extend the 40-bit accumulator
+  int64_t value = (int64_t)(((uint64_t)(high & 0xff) << 32) | low);
+  if (value & (1LL << 39)) value -= (1LL << 40);
+  return value;
+}
+
+// Dot product of whole vectors; a and b must be 16-byte aligned
+static int64_t dotVectors(const int16_t* a, const int16_t* b, size_t vectors) {
+  int64_t total = 0;
+  
+  while (vectors > 0) {
+    size_t block = vectors < ACCX_BLOCK_VECTORS ? vectors : ACCX_BLOCK_VECTORS;
+    
+    asm volatile ("ee.zero.accx");
+    for (size_t k = 0; k < block; k++) {
+      asm volatile (
+        "ee.vld.128.ip q0, %0, 16\n\t"
+        "ee.vld.128.ip q1, %1, 16\n\t"
+        "ee.vmulas.s16.accx q0, q1\n\t"
+        : "+r"(a), "+r"(b) : : "memory");
+    }
+    
+    total += readAccx();
+    vectors -= block;
+  }
+  
+  return total;
+}
+
+// Sum of whole vectors (multiply-accumulate against ones)
+static int64_t sumVectors(const int16_t* x, size_t vectors) {
+  int64_t total = 0;
+  
+  while (vectors > 0) {
+    size_t block = vectors < ACCX_BLOCK_VECTORS ? vectors : ACCX_BLOCK_VECTORS;
+    
+    asm volatile ("ee.zero.accx");
+    for (size_t k = 0; k < block; k++) {
+      const int16_t* ones = ONES;
+      asm volatile (
+        "ee.vld.128.ip q0, %0, 16\n\t"
+        "ee.vld.128.ip q1, %1, 0\n\t"
+        "ee.vmulas.s16.accx q0, q1\n\t"
+        : "+r"(x), "+r"(ones) : : "memory");
+    }
+    
+    total += readAccx();
+    vectors -= block;
+  }
+  
+  return total;
+}
+
+// Samples to process in scalar before x reaches a 16-byte boundary
+static inline size_t headLength(const int16_t* x, size_t n) {
+  size_t head = ((16 - ((uintptr_t)x & 15)) & 15) / sizeof(int16_t);
+  return head < n ? head : n;
+}
+
+int32_t dspSum(const int16_t* x, size_t n) {
+  size_t head = headLength(x, n);
+  if (!isAligned(x + head)) return dspScalarSum(x, n);  // Odd address
+  
+  size_t vectors = (n - head) / 8;
+  size_t tail = head + vectors * 8;
+  
+  return dspScalarSum(x, head) + (int32_t)sumVectors(x + head, vectors) +
+         dspScalarSum(x + tail, n - tail);
+}
+
+int64_t dspSumSquares(const int16_t* x, size_t n) {
+  size_t head = headLength(x, n);
+  if (!isAligned(x + head)) return dspScalarSumSquares(x, n);
+  
+  size_t vectors = (n - head) / 8;
+  size_t tail = head + vectors * 8;
+  
+  return dspScalarSumSquares(x, head) + dotVectors(x + head, x + head, vectors) +
+         dspScalarSumSquares(x + tail, n - tail);
+}
+
+const char* dspBackendName() {
+  return "esp32s3-pie";
+}
+
+#endif // DSP_BACKEND_ESP32S3
@@ -0,0 +1,49 @@
+/*
+ * DSP Kernels - NEON Backend (ARM hosts)
+ * 
+ * Widening multiplies (vmull) and pairwise accumulate-long (vpadal) keep
+ * 64-bit lane sums, so results match the scalar reference exactly.
+ */
+
+#include "dsp_kernels.h"
+
+#if defined(DSP_BACKEND_NEON)
+
+#include <arm_neon.h>
+
+static int64_t horizontalSum64(int64x2_t v) {
+  return vgetq_lane_s64(v, 0) + vgetq_lane_s64(v, 1);
+}
+
+int32_t dspSum(const int16_t* x, size_t n) {
+  if (n < 8) return dspScalarSum(x, n);
+  
+  int32x4_t acc = vdupq_n_s32(0);
+  size_t i = 0;
+  
+  for (; i + 8 <= n; i += 8) {
+    acc = vpadalq_s16(acc, vld1q_s16(x + i));
+  }
+  
+  return vgetq_lane_s32(acc, 0) + vgetq_lane_s32(acc, 1) +
+         vgetq_lane_s32(acc, 2) + vgetq_lane_s32(acc, 3) + dspScalarSum(x + i, n - i);
+}
+
+int64_t dspSumSquares(const int16_t* x, size_t n) {
+  int64x2_t acc = vdupq_n_s64(0);
+  size_t i = 0;
+  
+  for (; i + 8 <= n; i += 8) {
+    int16x8_t v = vld1q_s16(x + i);
+    acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(v), vget_low_s16(v)));
+    acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(v), vget_high_s16(v)));
+  }
+  
+  return horizontalSum64(acc) + dspScalarSumSquares(x + i, n - i);
+}
+
+const char* dspBackendName() {
+  return "neon";
+}
+
+#endif // DSP_BACKEND_NEON
@@ -0,0 +1,56 @@
+/*
+ * DSP Kernels - SSE2 Backend (x86 hosts)
+ * 
+ * Eight int16 lanes per step; pmaddwd forms pairwise 32-bit products that
+ * are widened to 64-bit lanes before accumulating.
+ */
+
+#include "dsp_kernels.h"
+
+#if defined(DSP_BACKEND_SSE2)
+
+#include <emmintrin.h>
+
+static int64_t horizontalSum64(__m128i v) {
+  int64_t lanes[2];
+  _mm_storeu_si128((__m128i*)lanes, v);
+  return lanes[0] + lanes[1];
+}
+
+int32_t dspSum(const int16_t* x, size_t n) {
+  if (n < 8) return dspScalarSum(x, n);
+  
+  const __m128i ones = _mm_set1_epi16(1);
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+  
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(x + i));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(v, ones));
+  }
+  
+  int32_t lanes[4];
+  _mm_storeu_si128((__m128i*)lanes, acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + dspScalarSum(x + i, n - i);
+}
+
+int64_t dspSumSquares(const int16_t* x, size_t n) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+  
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(x + i));
+    __m128i squares = _mm_madd_epi16(v, v);  // Non-negative, fits in uint32
+    acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(squares, zero));
+    acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(squares, zero));
+  }
+  
+  return horizontalSum64(acc) + dspScalarSumSquares(x + i, n - i);
+}
+
+const char* dspBackendName() {
+  return "sse2";
+}
+
+#endif // DSP_BACKEND_SSE2
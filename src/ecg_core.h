@@ -0,0 +1,22 @@
+/*
+ * ESP32 ECG Monitor - Core Components
+ * 
+ * Everything a serial-only monitor needs: the sensor and its front ends,
+ * the signal processor, the local outputs and the pipeline joining them.
+ * Network subsystems (web server, uplink) have their own headers and are
+ * only built when ArduinoJson is part of the build (see config/features.h).
+ */
+
+#ifndef ECG_CORE_H
+#define ECG_CORE_H
+
+#include "config/config.h"
+#include "config/features.h"
+#include "sensors/ecg_sensor.h"
+#include "simulation/ecg_simulator.h"
+#include "processing/signal_processor.h"
+#include "telemetry/beat_indicator.h"
+#include "telemetry/serial_plotter.h"
+#include "monitor/ecg_pipeline.h"
+
+#endif // ECG_CORE_H
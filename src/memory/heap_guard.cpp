@@ -0,0 +1,153 @@
+/*
+ * Heap Guard Implementation
+ * 
+ * The hooks run inside the allocator, so they only record into a fixed
+ * table; check() prints from the main loop where printing is safe.
+ */
+
+#include "heap_guard.h"
+#include "../config/config.h"
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#else
+#include <pthread.h>
+#endif
+
+static volatile bool guardArmed = false;
+static volatile bool heapAllowed = false;
+static volatile bool inHook = false;
+static volatile uint32_t violationCount = 0;
+static uint32_t reportedCount = 0;
+static HeapViolation violations[HEAP_GUARD_MAX_VIOLATIONS];
+
+#if defined(ESP32)
+static TaskHandle_t auditedTask = NULL;
+static size_t armedFreeHeap = 0;
+
+static bool isAuditedTask() {
+  return xTaskGetCurrentTaskHandle() == auditedTask;
+}
+#else
+static pthread_t auditedThread;
+
+static bool isAuditedTask() {
+  return pthread_equal(pthread_self(), auditedThread);
+}
+#endif
+
+void HeapGuard::arm() {
+  if (!ENABLE_MEMORY_AUDIT) return;
+  
+#if defined(ESP32)
+  auditedTask = xTaskGetCurrentTaskHandle();
+  armedFreeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#if !defined(CONFIG_HEAP_USE_HOOKS)
+  Serial.println("WARNING: heap hooks disabled in this core, auditing free heap only");
+#endif
+#else
+  auditedThread = pthread_self();
+#endif
+  
+  guardArmed = true;
+  Serial.println("✓ Memory audit armed: heap allocation after setup is an error");
+}
+
+bool HeapGuard::isArmed() {
+  return guardArmed;
+}
+
+void HeapGuard::recordAllocation(size_t size, void* caller) {
+  if (!guardArmed || heapAllowed || inHook || !isAuditedTask()) return;
+  
+  inHook = true;
+  uint32_t index = violationCount;
+  if (index < HEAP_GUARD_MAX_VIOLATIONS) {
+    violations[index].size = size;
+    violations[index].caller = caller;
+  }
+  violationCount = index + 1;
+  inHook = false;
+}
+
+void HeapGuard::check() {
+  if (!guardArmed) return;
+  
+#if defined(ESP32) && !defined(CONFIG_HEAP_USE_HOOKS)
+  // Without hooks, a sustained drop in free heap is the best signal we have
+  size_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  if (freeHeap + MEMORY_AUDIT_HEAP_SLACK < armedFreeHeap && violationCount == reportedCount) {
+    recordAllocation(armedFreeHeap - freeHeap, NULL);
+  }
+#endif
+  
+  uint32_t count = violationCount;
+  if (count == reportedCount) return;
+  
+  HeapGuard::Allow allow;
+  for (uint32_t i = reportedCount; i < count && i < HEAP_GUARD_MAX_VIOLATIONS; i++) {
+    Serial.print("ERROR: heap allocation after setup: ");
+    Serial.print((unsigned long)violations[i].size);
+    Serial.print(" bytes from 0x");
+    Serial.println((unsigned long)(uintptr_t)violations[i].caller, HEX);
+  }
+  if (count > HEAP_GUARD_MAX_VIOLATIONS) {
+    Serial.print("ERROR: ");
+    Serial.print((unsigned long)(count - HEAP_GUARD_MAX_VIOLATIONS));
+    Serial.println(" further heap allocations not recorded");
+  }
+  reportedCount = count;
+  
+  if (MEMORY_AUDIT_ABORT) {
+    Serial.flush();
+    abort();
+  }
+}
+
+uint32_t HeapGuard::getViolationCount() {
+  return violationCount;
+}
+
+HeapGuard::Allow::Allow(bool allowed) {
+  previous = heapAllowed;
+  heapAllowed = allowed;
+}
+
+HeapGuard::Allow::~Allow() {
+  heapAllowed = previous;
+}
+
+// ========== ALLOCATION HOOKS ==========
+
+#if defined(ESP32) && defined(CONFIG_HEAP_USE_HOOKS)
+
+// Called by ESP-IDF after every successful allocation
+extern "C" void esp_heap_trace_alloc_hook(void*, size_t size, uint32_t) {
+  HeapGuard::recordAllocation(size, __builtin_return_address(0));
+}
+
+#elif !defined(ESP32) && defined(ECG_HOST_HEAP_GUARD) && defined(__GLIBC__)
+
+// Host builds: interpose the C allocator (C++ new goes through malloc too)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+extern "C" void* malloc(size_t size) {
+  HeapGuard::recordAllocation(size, __builtin_return_address(0));
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+  HeapGuard::recordAllocation(count * size, __builtin_return_address(0));
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+  HeapGuard::recordAllocation(size, __builtin_return_address(0));
+  return __libc_realloc(pointer, size);
+}
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Heap Guard Header
+ * 
+ * Memory audit mode: once setup() has finished, every heap allocation made
+ * from the main loop is a violation. Allocations are seen through the
+ * ESP-IDF heap hooks on the device (CONFIG_HEAP_USE_HOOKS) and through a
+ * malloc interposer in host builds (ECG_HOST_HEAP_GUARD). Library calls
+ * that allocate internally and cannot be avoided (WiFi, HTTP client, the
+ * web server's request parsing) are wrapped in an Allow scope, so anything
+ * left is ours to fix.
+ */
+
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+#include <Arduino.h>
+
+struct HeapViolation {
+  size_t size;
+  void* caller;
+};
+
+class HeapGuard {
+public:
+  // Start auditing allocations from the calling task (end of setup)
+  static void arm();
+  static bool isArmed();
+  
+  // Called by the allocation hooks
+  static void recordAllocation(size_t size, void* caller);
+  
+  // Report new violations; resets the device when MEMORY_AUDIT_ABORT is set
+  static void check();
+  
+  static uint32_t getViolationCount();
+  
+  // Scope in which heap use is allowed (true) or audited again (false)
+  class Allow {
+  private:
+    bool previous;
+  public:
+    Allow(bool allowed = true);
+    ~Allow();
+  };
+};
+
+#endif // HEAP_GUARD_H
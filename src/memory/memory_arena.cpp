@@ -0,0 +1,84 @@
+/*
+ * Memory Arena Class Implementation
+ */
+
+#include "memory_arena.h"
+
+MemoryArena* MemoryArena::first = NULL;
+
+MemoryArena::MemoryArena(const char* name, uint8_t* storage, size_t capacity) {
+  this->name = name;
+  this->storage = storage;
+  this->capacity = capacity;
+  used = 0;
+  highWater = 0;
+  lastOffset = 0;
+  failures = 0;
+  
+  // Registration happens during static initialization; order does not matter
+  next = first;
+  first = this;
+}
+
+void* MemoryArena::allocate(size_t size, size_t alignment) {
+  size_t offset = (used + alignment - 1) & ~(alignment - 1);
+  
+  if (offset + size > capacity) {
+    failures++;
+    Serial.print("ERROR: arena '");
+    Serial.print(name);
+    Serial.print("' exhausted (");
+    Serial.print((unsigned long)size);
+    Serial.print(" bytes requested, ");
+    Serial.print((unsigned long)(capacity - used));
+    Serial.println(" free)");
+    return NULL;
+  }
+  
+  lastOffset = offset;
+  used = offset + size;
+  if (used > highWater) highWater = used;
+  
+  return storage + offset;
+}
+
+void MemoryArena::release(void* pointer) {
+  if (pointer == storage + lastOffset && lastOffset < used) {
+    used = lastOffset;
+  }
+}
+
+void MemoryArena::reset() {
+  used = 0;
+  lastOffset = 0;
+}
+
+size_t MemoryArena::getTotalCapacity() {
+  size_t total = 0;
+  for (MemoryArena* arena = first; arena != NULL; arena = arena->next) {
+    total += arena->capacity;
+  }
+  return total;
+}
+
+void MemoryArena::printReport(Print& out) {
+  out.println("Memory arenas (capacity / high water, bytes):");
+  
+  for (MemoryArena* arena = first; arena != NULL; arena = arena->next) {
+    out.print("  ");
+    out.print(arena->name);
+    out.print(": ");
+    out.print((unsigned long)arena->capacity);
+    out.print(" / ");
+    out.print((unsigned long)arena->highWater);
+    if (arena->failures > 0) {
+      out.print(" (");
+      out.print((unsigned long)arena->failures);
+      out.print(" failed allocations)");
+    }
+    out.println();
+  }
+  
+  out.print("  total: ");
+  out.println((unsigned long)getTotalCapacity());
+}
@@ -0,0 +1,100 @@
+/*
+ * Memory Arena Class Header
+ * 
+ * Fixed-size bump allocator over storage sized at compile time. Long-lived
+ * subsystem buffers and per-request scratch (JSON documents, response
+ * text) come from arenas instead of the heap, so a monitor that runs for
+ * days cannot fragment the 320 KB heap. Every arena registers itself so
+ * printReport() can list the complete static memory budget.
+ */
+
+#ifndef MEMORY_ARENA_H
+#define MEMORY_ARENA_H
+
+#include <Arduino.h>
+#include "../config/features.h"
+
+#if ECG_FEATURE_NETWORK
+#include <ArduinoJson.h>
+#endif
+
+class MemoryArena {
+private:
+  const char* name;
+  uint8_t* storage;
+  size_t capacity;
+  size_t used;
+  size_t highWater;
+  size_t lastOffset;        // Start of the most recent allocation (for release)
+  uint32_t failures;
+  MemoryArena* next;
+  
+  static MemoryArena* first;
+  
+public:
+  // Constructor - registers the arena for the report
+  MemoryArena(const char* name, uint8_t* storage, size_t capacity);
+  
+  // Allocate from the arena (NULL and an error message when exhausted)
+  void* allocate(size_t size, size_t alignment = 4);
+  
+  // Give back the most recent allocation (others are kept until reset)
+  void release(void* pointer);
+  
+  // Drop all allocations
+  void reset();
+  
+  // Get arena usage
+  const char* getName() { return name; }
+  size_t getCapacity() { return capacity; }
+  size_t getUsed() { return used; }
+  size_t getHighWater() { return highWater; }
+  uint32_t getFailures() { return failures; }
+  
+  // Frees everything allocated while it is in scope (e.g. per request)
+  class Scope {
+  private:
+    MemoryArena& arena;
+    size_t mark;
+  public:
+    Scope(MemoryArena& arena) : arena(arena), mark(arena.used) {}
+    ~Scope() { arena.used = mark; arena.lastOffset = mark; }
+  };
+  
+  // Registered arenas
+  static MemoryArena* getFirst() { return first; }
+  MemoryArena* getNext() { return next; }
+  static size_t getTotalCapacity();
+  
+  // Print the size and high-water mark of every arena
+  static void printReport(Print& out);
+};
+
+// Arena with its storage inline (place in a global or a member)
+template<size_t SIZE>
+class StaticArena : public MemoryArena {
+private:
+  uint8_t buffer[SIZE] __attribute__((aligned(8)));
+  
+public:
+  StaticArena(const char* name) : MemoryArena(name, buffer, SIZE) {}
+};
+
+#if ECG_FEATURE_NETWORK
+
+// ArduinoJson allocator drawing from an arena. Documents are released in
+// reverse order of creation, so a request's scratch is reused by the next.
+struct ArenaAllocator {
+  MemoryArena* arena;
+  
+  ArenaAllocator(MemoryArena* arena = NULL) : arena(arena) {}
+  void* allocate(size_t size) { return arena ? arena->allocate(size) : NULL; }
+  void deallocate(void* pointer) { if (arena) arena->release(pointer); }
+  void* reallocate(void*, size_t) { return NULL; }  // Documents never grow
+};
+
+typedef BasicJsonDocument<ArenaAllocator> ArenaJsonDocument;
+
+#endif // ECG_FEATURE_NETWORK
+
+#endif // MEMORY_ARENA_H
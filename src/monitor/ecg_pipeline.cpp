@@ -0,0 +1,103 @@
+/*
+ * ECG Pipeline Class Implementation
+ */
+
+#include "ecg_pipeline.h"
+
+ECGPipeline::ECGPipeline(ECGSensor& sensor, SignalProcessor& processor)
+  : sensor(sensor), processor(processor) {
+  beatIndicator = NULL;
+  serialPlotter = NULL;
+  lastLeadsConnected = false;
+  lastArtifactFlags = 0;
+  blockRemaining = 0;
+  settingsRequested = false;
+  settingsStaged = false;
+  markNextFrame = false;
+  leadsChanged = false;
+  artifactFlagsChanged = false;
+  beat = false;
+}
+
+void ECGPipeline::requestSettings(const ECGSettings& settings) {
+  processor.holdSettings(settings);
+  settingsRequested = true;
+}
+
+bool ECGPipeline::acquire(ECGFrame& frame) {
+  // Switch the sensor between blocks; the sample after the switch is the
+  // first one the processor handles with the new settings
+  if (settingsRequested && !settingsStaged && blockRemaining == 0) {
+    int sampleRate = processor.getPendingSettings().sampleRate;
+    if (sampleRate != sensor.getSampleRate()) {
+      sensor.setSampleRate(sampleRate);
+    }
+    settingsRequested = false;
+    settingsStaged = true;
+    markNextFrame = true;
+  }
+  
+  if (!sensor.isTimeForSample()) return false;
+  
+  frame.value = sensor.readValue();
+  frame.leadsConnected = sensor.areLeadsConnected();
+  frame.sequence = sensor.getLastSequence();
+  frame.sampleTime = sensor.getLastSampleTime();
+  frame.settingsChanged = markNextFrame;
+  markNextFrame = false;
+  
+  // Blocks cover CONFIG_APPLY_BLOCK_MS at the rate they start with
+  if (blockRemaining == 0) {
+    blockRemaining = getApplyBlockSize(sensor.getSampleRate());
+  }
+  blockRemaining--;
+  return true;
+}
+
+void ECGPipeline::process(const ECGFrame& frame) {
+  artifactFlagsChanged = false;
+  beat = false;
+  
+  if (frame.settingsChanged) {
+    processor.applyPendingSettings();
+    settingsStaged = false;
+  }
+  
+  // Lead transitions
+  leadsChanged = frame.leadsConnected != lastLeadsConnected;
+  if (leadsChanged) {
+    lastLeadsConnected = frame.leadsConnected;
+    
+    if (!frame.leadsConnected) {
+      Serial.println("! Leads disconnected - check electrode placement");
+      if (beatIndicator != NULL) beatIndicator->off();
+    }
+  }
+  
+#if ECG_FEATURE_ARTIFACT_DETECTION
+  // Number the quality mask by sample sequence, like the history
+  processor.getQualityMask().sync(frame.sequence);
+#endif
+  
+  if (!frame.leadsConnected) {
+    // Keep the processor's sample clock running across the lead-off stretch
+    processor.skipSample();
+    return;
+  }
+  
+  // Process the signal
+  processor.processSample(frame.value);
+  
+  uint8_t artifactFlags = processor.getArtifactFlags();
+  artifactFlagsChanged = artifactFlags != lastArtifactFlags;
+  lastArtifactFlags = artifactFlags;
+  
+  beat = processor.isHeartbeatDetected();
+  if (beat && beatIndicator != NULL) {
+    beatIndicator->pulse();
+  }
+  
+  if (serialPlotter != NULL) {
+    serialPlotter->plot(frame.value, processor);
+  }
+}
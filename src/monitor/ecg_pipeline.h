@@ -0,0 +1,87 @@
+/*
+ * ECG Pipeline Class Header
+ * 
+ * The sample path shared by every monitor build: acquire a sample from
+ * ECGSensor when it is due, keep the quality mask numbered by sequence,
+ * run the SignalProcessor (or skip while the leads are off) and drive the
+ * optional local outputs, the beat LED and the serial plot. The simple
+ * serial monitor is this pipeline alone; the full monitor adds history,
+ * uplink and web updates from what process() reports.
+ * 
+ * acquire() and process() are separate so low power mode can capture on
+ * each wake-up and process a whole block at once. Settings changes follow
+ * the samples: the sensor switches rate between two blocks of acquired
+ * samples and the processor switches with the first sample taken at the
+ * new rate, however far processing lags behind acquisition.
+ */
+
+#ifndef ECG_PIPELINE_H
+#define ECG_PIPELINE_H
+
+#include <Arduino.h>
+#include "../sensors/ecg_sensor.h"
+#include "../processing/signal_processor.h"
+#include "../telemetry/beat_indicator.h"
+#include "../telemetry/serial_plotter.h"
+
+// One acquired sample
+struct ECGFrame {
+  int value;                 // ADC counts
+  bool leadsConnected;
+  uint32_t sequence;
+  uint64_t sampleTime;       // Scheduled time (local us)
+  bool settingsChanged;      // First sample under newly requested settings
+};
+
+class ECGPipeline {
+private:
+  ECGSensor& sensor;
+  SignalProcessor& processor;
+  BeatIndicator* beatIndicator;
+  SerialPlotter* serialPlotter;
+  
+  // State carried between samples
+  bool lastLeadsConnected;
+  uint8_t lastArtifactFlags;
+  int blockRemaining;        // Acquired samples left in the current block
+  
+  // Settings change in progress (the processor holds the settings)
+  bool settingsRequested;    // Waiting for a block boundary
+  bool settingsStaged;       // Sensor switched, processor not yet
+  bool markNextFrame;        // Next acquired frame carries the change
+  
+  // What the last process() call saw
+  bool leadsChanged;
+  bool artifactFlagsChanged;
+  bool beat;
+  
+public:
+  // Constructor
+  ECGPipeline(ECGSensor& sensor, SignalProcessor& processor);
+  
+  // Optional outputs (NULL to leave out)
+  void setBeatIndicator(BeatIndicator* indicator) { beatIndicator = indicator; }
+  void setSerialPlotter(SerialPlotter* plotter) { serialPlotter = plotter; }
+  
+  // Stage new settings for the sensor and the processor; they switch at
+  // the next block boundary of acquired samples (CONFIG_APPLY_BLOCK_MS)
+  void requestSettings(const ECGSettings& settings);
+  
+  // Check whether a requested change has not reached the processor yet
+  // (request the next one only after it has)
+  bool isSettingsChangePending() { return settingsRequested || settingsStaged; }
+  
+  // Take the next sample if it is due
+  // Returns: true if frame was filled
+  bool acquire(ECGFrame& frame);
+  
+  // Run one acquired sample through the processor and the outputs
+  void process(const ECGFrame& frame);
+  
+  // Results of the last process() call
+  bool didLeadsChange() { return leadsChanged; }
+  bool didArtifactFlagsChange() { return artifactFlagsChanged; }
+  bool isBeat() { return beat; }
+};
+
+#endif // ECG_PIPELINE_H
@@ -0,0 +1,201 @@
+/*
+ * WiFi Link Class Implementation
+ */
+
+#include "wifi_link.h"
+
+#if ECG_FEATURE_NETWORK
+#include <WiFi.h>
+#include <Preferences.h>
+#include "../memory/heap_guard.h"
+
+WiFiLink::WiFiLink() {
+  ssid[0] = '\0';
+  password[0] = '\0';
+  state = WIFI_LINK_OFF;
+  stateSince = 0;
+  backoff = UPLINK_MIN_BACKOFF;
+  connectAttempts = 0;
+  memset(&apCache, 0, sizeof(apCache));
+  cachedAttempt = false;
+  lastConnectTime = 0;
+  cachedConnects = 0;
+}
+
+void WiFiLink::begin(const ECGSettings& settings, bool radioOn) {
+  strlcpy(ssid, settings.wifiSsid, sizeof(ssid));
+  strlcpy(password, settings.wifiPassword, sizeof(password));
+  
+  // Also in low power mode, whose transmit windows join the cached AP
+  loadApCache();
+  setState(radioOn ? WIFI_LINK_STARTING : WIFI_LINK_OFF);
+}
+
+void WiFiLink::applySettings(const ECGSettings& settings) {
+  if (strcmp(settings.wifiSsid, ssid) == 0 && strcmp(settings.wifiPassword, password) == 0) return;
+  
+  strlcpy(ssid, settings.wifiSsid, sizeof(ssid));
+  strlcpy(password, settings.wifiPassword, sizeof(password));
+  
+  // Reconnect with new credentials right away
+  if (state != WIFI_LINK_OFF && state != WIFI_LINK_STARTING) {
+    backoff = UPLINK_MIN_BACKOFF;
+    startAttempt();
+  }
+}
+
+void WiFiLink::loop() {
+  if (state == WIFI_LINK_STARTING) {
+    // Started here rather than in setup(), so the first samples never wait on the driver
+    HeapGuard::Allow allow;
+    WiFi.persistent(false);      // Credentials come from RuntimeConfig; skip the flash write
+    WiFi.mode(WIFI_STA);
+    startAttempt();
+    return;
+  }
+  
+  // Radio switched off by the power manager
+  if (WiFi.getMode() == WIFI_OFF) {
+    if (state != WIFI_LINK_OFF) setState(WIFI_LINK_OFF);
+    return;
+  }
+  
+  unsigned long elapsed = millis() - stateSince;
+  
+  switch (state) {
+    case WIFI_LINK_OFF:
+      // Radio just switched on for a transmit window - connect right away
+      backoff = UPLINK_MIN_BACKOFF;
+      startAttempt();
+      break;
+      
+    case WIFI_LINK_WAITING:
+      if (elapsed >= backoff) {
+        // Each failed attempt doubles the wait before the next
+        backoff = min(backoff * 2, UPLINK_MAX_BACKOFF);
+        startAttempt();
+      }
+      break;
+      
+    case WIFI_LINK_CONNECTING:
+      if (WiFi.status() == WL_CONNECTED) {
+        onConnected();
+      } else if (cachedAttempt && elapsed >= WIFI_FAST_CONNECT_TIMEOUT) {
+        // The AP moved to another channel or is gone - scan without waiting
+        Serial.println("✗ Cached access point not found, scanning");
+        apCache.valid = false;
+        startAttempt();
+      } else if (elapsed >= WIFI_TIMEOUT) {
+        Serial.print("✗ WiFi connection failed, retrying in ");
+        Serial.print(backoff / 1000);
+        Serial.println(" s");
+        setState(WIFI_LINK_WAITING);
+      }
+      break;
+      
+    case WIFI_LINK_CONNECTED:
+      if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("✗ WiFi lost, buffering to outbox");
+        backoff = UPLINK_MIN_BACKOFF;
+        setState(WIFI_LINK_WAITING);
+      }
+      break;
+      
+    default:
+      break;
+  }
+}
+
+const char* WiFiLink::getStateName() {
+  switch (state) {
+    case WIFI_LINK_OFF: return "off";
+    case WIFI_LINK_STARTING: return "starting";
+    case WIFI_LINK_WAITING: return "waiting";
+    case WIFI_LINK_CONNECTING: return "connecting";
+    case WIFI_LINK_CONNECTED: return "connected";
+  }
+  return "unknown";
+}
+
+void WiFiLink::onConnected() {
+  lastConnectTime = millis() - stateSince;
+  if (cachedAttempt) cachedConnects++;
+  setState(WIFI_LINK_CONNECTED);
+  backoff = UPLINK_MIN_BACKOFF;
+  
+  Serial.print("✓ WiFi connected in ");
+  Serial.print(lastConnectTime);
+  Serial.print(cachedAttempt ? " ms (cached AP), IP address: " : " ms, IP address: ");
+  Serial.print(WiFi.localIP());
+  Serial.print(", signal strength: ");
+  Serial.print(WiFi.RSSI());
+  Serial.println(" dBm");
+  
+  saveApCache();
+}
+
+void WiFiLink::loadApCache() {
+  Preferences prefs;
+  if (!prefs.begin(WIFI_CACHE_NAMESPACE, true)) return;
+  
+  apCache.valid = prefs.getBytesLength("ap") == sizeof(apCache) &&
+                  prefs.getBytes("ap", &apCache, sizeof(apCache)) == sizeof(apCache) &&
+                  apCache.valid;
+  prefs.end();
+}
+
+void WiFiLink::saveApCache() {
+  WiFiApCache current;
+  memset(&current, 0, sizeof(current));
+  strlcpy(current.ssid, ssid, sizeof(current.ssid));
+  const uint8_t* bssid = WiFi.BSSID();
+  if (bssid == NULL) return;
+  memcpy(current.bssid, bssid, sizeof(current.bssid));
+  current.channel = WiFi.channel();
+  current.valid = true;
+  
+  // Flash writes only when the AP changed
+  if (memcmp(&current, &apCache, sizeof(current)) == 0) return;
+  apCache = current;
+  
+  HeapGuard::Allow allow;  // NVS allocates while writing
+  Preferences prefs;
+  if (!prefs.begin(WIFI_CACHE_NAMESPACE, false)) return;
+  prefs.putBytes("ap", &apCache, sizeof(apCache));
+  prefs.end();
+}
+
+void WiFiLink::setState(WiFiLinkState newState) {
+  state = newState;
+  stateSince = millis();
+}
+
+void WiFiLink::startAttempt() {
+  // Join the last AP directly when it is the same network
+  cachedAttempt = apCache.valid && strcmp(apCache.ssid, ssid) == 0;
+  
+  Serial.print("Connecting to WiFi network: ");
+  Serial.print(ssid);
+  if (cachedAttempt) {
+    Serial.print(" (cached AP, channel ");
+    Serial.print(apCache.channel);
+    Serial.print(")");
+  }
+  Serial.println();
+  
+  {
+    HeapGuard::Allow allow;  // WiFi driver allocates internally
+    WiFi.disconnect();
+    if (cachedAttempt) {
+      WiFi.begin(ssid, password, apCache.channel, apCache.bssid);
+    } else {
+      WiFi.begin(ssid, password);
+    }
+  }
+  
+  // WiFi.begin() returns immediately; later loops see the result
+  connectAttempts++;
+  setState(WIFI_LINK_CONNECTING);
+}
+
+#endif // ECG_FEATURE_NETWORK
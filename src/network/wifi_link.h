@@ -0,0 +1,101 @@
+/*
+ * WiFi Link Class Header
+ * 
+ * Non-blocking WiFi station connection, run as a scheduler task. Each call
+ * to loop() checks the current state and returns:
+ * 
+ *   OFF -> STARTING -> CONNECTING -> CONNECTED
+ *                         |  ^           |
+ *                         v  |           v
+ *                        WAITING <-------+
+ * 
+ * An attempt that is not connected after WIFI_TIMEOUT waits out a backoff
+ * (UPLINK_MIN_BACKOFF doubling up to UPLINK_MAX_BACKOFF) before the next
+ * one.
+ * 
+ * The channel and BSSID of the last access point are kept in NVS. An
+ * attempt for the same SSID joins that AP directly, skipping the scan of
+ * all channels; if it is not connected within WIFI_FAST_CONNECT_TIMEOUT
+ * the cache is dropped and a full scan starts right away. The cache is
+ * read in begin(), so it serves the transmit windows of low power mode
+ * too.
+ * 
+ * The radio belongs to the power manager: while it is switched off the
+ * link stays OFF, and it connects as soon as a transmit window opens.
+ * Sampling never waits on any of this.
+ */
+
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include "../config/features.h"
+
+#if ECG_FEATURE_NETWORK
+
+#include <Arduino.h>
+#include "../config/runtime_config.h"
+
+enum WiFiLinkState {
+  WIFI_LINK_OFF,          // Radio off
+  WIFI_LINK_STARTING,     // Driver start deferred to the first loop()
+  WIFI_LINK_WAITING,      // Backoff before the next attempt
+  WIFI_LINK_CONNECTING,
+  WIFI_LINK_CONNECTED
+};
+
+// Last access point joined, persisted for fast reconnects
+struct WiFiApCache {
+  char ssid[33];
+  uint8_t bssid[6];
+  int32_t channel;
+  bool valid;
+};
+
+class WiFiLink {
+private:
+  char ssid[33];
+  char password[65];
+  WiFiLinkState state;
+  unsigned long stateSince;    // ms
+  unsigned long backoff;       // ms
+  unsigned long connectAttempts;
+  
+  // Fast reconnect
+  WiFiApCache apCache;
+  bool cachedAttempt;          // Current attempt targets the cached AP
+  unsigned long lastConnectTime; // ms from attempt to connected
+  unsigned long cachedConnects;
+  
+  // Internal methods
+  void setState(WiFiLinkState newState);
+  void startAttempt();
+  void onConnected();
+  void loadApCache();
+  void saveApCache();
+  
+public:
+  // Constructor
+  WiFiLink();
+  
+  // Set credentials; radioOn starts connecting from the first loop()
+  void begin(const ECGSettings& settings, bool radioOn);
+  
+  // Apply new credentials (reconnects right away if they changed)
+  void applySettings(const ECGSettings& settings);
+  
+  // Advance the state machine; never blocks
+  void loop();
+  
+  // Getters
+  bool isConnected() { return state == WIFI_LINK_CONNECTED; }
+  WiFiLinkState getState() { return state; }
+  const char* getStateName();
+  unsigned long getConnectAttempts() { return connectAttempts; }
+  bool isCachedAttempt() { return cachedAttempt; }
+  unsigned long getLastConnectTime() { return lastConnectTime; }
+  unsigned long getCachedConnects() { return cachedConnects; }
+};
+
+#endif // ECG_FEATURE_NETWORK
+
+#endif // WIFI_LINK_H
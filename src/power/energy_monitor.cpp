@@ -0,0 +1,113 @@
+/*
+ * Energy Monitor Class Implementation
+ */
+
+#include "energy_monitor.h"
+
+static const float STATE_CURRENT_MA[POWER_STATE_COUNT] = {
+  CURRENT_CPU_ACTIVE_MA,
+  CURRENT_CPU_LIGHT_SLEEP_MA,
+  0,
+  CURRENT_RADIO_MODEM_SLEEP_MA,
+  CURRENT_RADIO_ACTIVE_MA
+};
+
+static const char* const STATE_NAMES[POWER_STATE_COUNT] = {
+  "cpuActive",
+  "cpuLightSleep",
+  "radioOff",
+  "radioModemSleep",
+  "radioActive"
+};
+
+EnergyMonitor::EnergyMonitor() {
+  begin(0);
+}
+
+void EnergyMonitor::begin(uint64_t now) {
+  for (int i = 0; i < POWER_STATE_COUNT; i++) {
+    stateTime[i] = 0;
+  }
+  
+  cpuState = POWER_CPU_ACTIVE;
+  radioState = POWER_RADIO_OFF;
+  cpuSince = now;
+  radioSince = now;
+  traceIndex = 0;
+  traceCount = 0;
+}
+
+void EnergyMonitor::setCpuState(PowerState state, uint64_t now) {
+  if (state == cpuState) return;
+  
+  stateTime[cpuState] += now - cpuSince;
+  cpuState = state;
+  cpuSince = now;
+  record(state, now);
+}
+
+void EnergyMonitor::setRadioState(PowerState state, uint64_t now) {
+  if (state == radioState) return;
+  
+  stateTime[radioState] += now - radioSince;
+  radioState = state;
+  radioSince = now;
+  record(state, now);
+}
+
+void EnergyMonitor::record(PowerState state, uint64_t now) {
+  // CPU sleep/wake happens every sample and would flood the trace,
+  // so only radio transitions are kept
+  if (state == POWER_CPU_ACTIVE || state == POWER_CPU_LIGHT_SLEEP) return;
+  
+  trace[traceIndex].time = now / 1000;
+  trace[traceIndex].state = state;
+  traceIndex = (traceIndex + 1) % POWER_TRACE_SIZE;
+  if (traceCount < POWER_TRACE_SIZE) traceCount++;
+}
+
+uint64_t EnergyMonitor::elapsed(PowerState state, uint64_t now) {
+  if (state == cpuState) return now - cpuSince;
+  if (state == radioState) return now - radioSince;
+  return 0;
+}
+
+uint64_t EnergyMonitor::getStateTime(PowerState state, uint64_t now) {
+  return stateTime[state] + elapsed(state, now);
+}
+
+float EnergyMonitor::getAverageCurrent(uint64_t now) {
+  double cpuTotal = 0;
+  double cpuCharge = 0;
+  double radioCharge = 0;
+  
+  for (int i = 0; i < POWER_STATE_COUNT; i++) {
+    double time = getStateTime((PowerState)i, now);
+    if (i <= POWER_CPU_LIGHT_SLEEP) {
+      cpuTotal += time;
+      cpuCharge += time * STATE_CURRENT_MA[i];
+    } else {
+      radioCharge += time * STATE_CURRENT_MA[i];
+    }
+  }
+  
+  // CPU and radio states cover the same wall-clock time
+  if (cpuTotal <= 0) return 0;
+  return (cpuCharge + radioCharge) / cpuTotal + CURRENT_SENSOR_MA;
+}
+
+float EnergyMonitor::estimateBatteryLife(float capacityMah, uint64_t now) {
+  float current = getAverageCurrent(now);
+  if (current <= 0) return 0;
+  return capacityMah / current;
+}
+
+PowerTransition EnergyMonitor::getTrace(int index) {
+  int start = (traceIndex - traceCount + POWER_TRACE_SIZE) % POWER_TRACE_SIZE;
+  return trace[(start + index) % POWER_TRACE_SIZE];
+}
+
+const char* EnergyMonitor::getStateName(PowerState state) {
+  if (state < 0 || state >= POWER_STATE_COUNT) return "unknown";
+  return STATE_NAMES[state];
+}
@@ -0,0 +1,79 @@
+/*
+ * Energy Monitor Class Header
+ * 
+ * Energy accounting by time spent in each power state. The CPU and the
+ * radio are tracked independently; a per-state current model turns the
+ * time budget into an average current and a battery life estimate.
+ * The most recent radio transitions are kept as a trace for analysis.
+ */
+
+#ifndef ENERGY_MONITOR_H
+#define ENERGY_MONITOR_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+enum PowerState {
+  POWER_CPU_ACTIVE = 0,
+  POWER_CPU_LIGHT_SLEEP = 1,
+  POWER_RADIO_OFF = 2,
+  POWER_RADIO_MODEM_SLEEP = 3,
+  POWER_RADIO_ACTIVE = 4,
+  POWER_STATE_COUNT = 5
+};
+
+struct PowerTransition {
+  uint32_t time;      // ms since boot
+  uint8_t state;      // PowerState entered
+};
+
+class EnergyMonitor {
+private:
+  uint64_t stateTime[POWER_STATE_COUNT];  // Accumulated microseconds
+  PowerState cpuState;
+  PowerState radioState;
+  uint64_t cpuSince;
+  uint64_t radioSince;
+  
+  // Transition trace (ring buffer)
+  PowerTransition trace[POWER_TRACE_SIZE];
+  int traceIndex;
+  int traceCount;
+  
+  // Internal methods
+  void record(PowerState state, uint64_t now);
+  uint64_t elapsed(PowerState state, uint64_t now);
+  
+public:
+  // Constructor
+  EnergyMonitor();
+  
+  // Start accounting from now
+  void begin(uint64_t now);
+  
+  // Report a state change (CPU states and radio states are separate)
+  void setCpuState(PowerState state, uint64_t now);
+  void setRadioState(PowerState state, uint64_t now);
+  
+  // Time spent in a state including the current interval (us)
+  uint64_t getStateTime(PowerState state, uint64_t now);
+  
+  // Average current from the current model (mA)
+  float getAverageCurrent(uint64_t now);
+  
+  // Estimated battery life at the average current (hours)
+  float estimateBatteryLife(float capacityMah, uint64_t now);
+  
+  // Trace access (oldest first)
+  int getTraceCount() { return traceCount; }
+  PowerTransition getTrace(int index);
+  
+  // Getters
+  PowerState getCpuState() { return cpuState; }
+  PowerState getRadioState() { return radioState; }
+  
+  // State name for reports
+  static const char* getStateName(PowerState state);
+};
+
+#endif // ENERGY_MONITOR_H
@@ -0,0 +1,117 @@
+/*
+ * Power Manager Class Implementation
+ */
+
+#include "power_manager.h"
+#include <WiFi.h>
+
+#if defined(ESP32)
+#include <esp_sleep.h>
+#endif
+
+PowerManager::PowerManager() {
+  sampleClock = NULL;
+  lowPower = false;
+  radioEnabled = true;
+  windowOpenedAt = 0;
+  lastWindowClosed = 0;
+}
+
+bool PowerManager::begin(SampleClock* clock, bool lowPowerMode) {
+  sampleClock = clock;
+  lowPower = lowPowerMode;
+  energy.begin(clock->now());
+  
+  if (!lowPower) {
+    energy.setRadioState(POWER_RADIO_ACTIVE, clock->now());
+    return true;
+  }
+  
+  setCpuFrequencyMhz(LOW_POWER_CPU_MHZ);
+  
+  // Start with the radio off; the first window opens after one interval
+  WiFi.mode(WIFI_OFF);
+  radioEnabled = false;
+  lastWindowClosed = millis();
+  
+  Serial.print("Low power mode: CPU ");
+  Serial.print(LOW_POWER_CPU_MHZ);
+  Serial.print(" MHz, transmit every ");
+  Serial.print(LOW_POWER_TX_INTERVAL / 1000);
+  Serial.println(" s");
+  
+  return true;
+}
+
+void PowerManager::updateRadio(bool linkUp, uint64_t pendingBytes) {
+  uint64_t now = sampleClock->now();
+  
+  if (!lowPower) {
+    energy.setRadioState(linkUp ? POWER_RADIO_ACTIVE : POWER_RADIO_OFF, now);
+    return;
+  }
+  
+  if (!radioEnabled) {
+    if (millis() - lastWindowClosed >= LOW_POWER_TX_INTERVAL) {
+      openTransmitWindow();
+    }
+    return;
+  }
+  
+  // Associated and idle between uploads: modem sleep
+  energy.setRadioState(linkUp && pendingBytes == 0 ? POWER_RADIO_MODEM_SLEEP : POWER_RADIO_ACTIVE, now);
+  
+  // Close once drained, or when the window runs too long (e.g. AP unreachable)
+  bool drained = linkUp && pendingBytes == 0;
+  if (drained || millis() - windowOpenedAt >= LOW_POWER_TX_WINDOW_MAX) {
+    closeTransmitWindow();
+  }
+}
+
+void PowerManager::openTransmitWindow() {
+  WiFi.mode(WIFI_STA);
+  WiFi.setSleep(WIFI_PS_MAX_MODEM);
+  
+  radioEnabled = true;
+  windowOpenedAt = millis();
+  energy.setRadioState(POWER_RADIO_ACTIVE, sampleClock->now());
+}
+
+void PowerManager::closeTransmitWindow() {
+  WiFi.mode(WIFI_OFF);
+  
+  radioEnabled = false;
+  lastWindowClosed = millis();
+  uint64_t now = sampleClock->now();
+  energy.setRadioState(POWER_RADIO_OFF, now);
+  
+  // The web server is off in low power mode, so /power is not available
+  if (ENABLE_DEBUG_MESSAGES) {
+    Serial.print("Energy: ");
+    Serial.print(energy.getAverageCurrent(now));
+    Serial.print(" mA average, battery life ");
+    Serial.print(energy.estimateBatteryLife(BATTERY_CAPACITY_MAH, now), 1);
+    Serial.println(" h");
+  }
+}
+
+void PowerManager::sleepUntilNextSample() {
+  if (!lowPower || radioEnabled) return;
+  
+  uint64_t now = sampleClock->now();
+  uint64_t deadline = sampleClock->getNextDeadline();
+  if (deadline <= now || deadline - now < LIGHT_SLEEP_MIN_US) return;
+  
+  energy.setCpuState(POWER_CPU_LIGHT_SLEEP, now);
+  
+#if defined(ESP32)
+  // Timer wake-up slightly early to absorb the wake latency
+  esp_sleep_enable_timer_wakeup(deadline - now - LIGHT_SLEEP_WAKE_LATENCY_US);
+  esp_light_sleep_start();
+#else
+  // Host build (tools/power): the sleep only passes the time
+  delayMicroseconds(deadline - now - LIGHT_SLEEP_WAKE_LATENCY_US);
+#endif
+  
+  energy.setCpuState(POWER_CPU_ACTIVE, sampleClock->now());
+}
@@ -0,0 +1,55 @@
+/*
+ * Power Manager Class Header
+ * 
+ * Duty-cycled operation for battery powered patches. In low power mode
+ * the CPU runs at a reduced clock and light-sleeps between sample
+ * deadlines, and the radio is switched off except for periodic transmit
+ * windows (modem sleep while associated) in which the uplink drains its
+ * outbox. All state changes are reported to the EnergyMonitor.
+ * 
+ * Manual light sleep does not keep a WiFi association, so the CPU only
+ * sleeps while the radio is off.
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "energy_monitor.h"
+#include "../sensors/sample_clock.h"
+
+class PowerManager {
+private:
+  EnergyMonitor energy;
+  SampleClock* sampleClock;
+  bool lowPower;
+  bool radioEnabled;
+  unsigned long windowOpenedAt;
+  unsigned long lastWindowClosed;
+  
+  // Internal methods
+  void openTransmitWindow();
+  void closeTransmitWindow();
+  
+public:
+  // Constructor
+  PowerManager();
+  
+  // Configure CPU and radio for the selected mode
+  bool begin(SampleClock* clock, bool lowPowerMode);
+  
+  // Open/close radio windows; pendingBytes is the uplink backlog
+  void updateRadio(bool linkUp, uint64_t pendingBytes);
+  
+  // Sleep until shortly before the next sample deadline (low power only)
+  void sleepUntilNextSample();
+  
+  // Check mode / radio state
+  bool isLowPower() { return lowPower; }
+  bool isRadioEnabled() { return radioEnabled; }
+  
+  // Energy accounting
+  EnergyMonitor& getEnergyMonitor() { return energy; }
+};
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,140 @@
+/*
+ * Adaptive Threshold Class Implementation
+ * 
+ * Each calibration window feeds three P² estimators. When the window is
+ * full the quantiles are folded into the learned values and the
+ * estimators restart, so the threshold follows gain and electrode changes.
+ */
+
+#include "adaptive_threshold.h"
+#include "../config/config.h"
+
+AdaptiveThreshold::AdaptiveThreshold()
+  : baselineEstimator(0.5),
+    noiseEstimator(0.5),
+    peakEstimator(CALIBRATION_PEAK_QUANTILE) {
+  initialThreshold = HEARTBEAT_THRESHOLD;
+  windowSize = CALIBRATION_WINDOW_SIZE;
+  reset();
+}
+
+void AdaptiveThreshold::reset() {
+  baselineEstimator.reset();
+  noiseEstimator.reset();
+  peakEstimator.reset();
+  lastValue = -1;
+  windowCount = 0;
+  
+  baseline = 0;
+  noiseFloor = 0;
+  peakAmplitude = 0;
+  threshold = initialThreshold;
+  calibrated = false;
+  calibrationCount = 0;
+}
+
+void AdaptiveThreshold::setInitialThreshold(int value) {
+  initialThreshold = value;
+  if (!calibrated) {
+    threshold = value;
+  }
+}
+
+void AdaptiveThreshold::addSample(int ecgValue) {
+  float value = ecgValue;
+  
+  baselineEstimator.add(value);
+  peakEstimator.add(value);
+  if (lastValue >= 0) {
+    noiseEstimator.add(abs(ecgValue - lastValue));
+  }
+  lastValue = ecgValue;
+  
+  windowCount++;
+  if (windowCount >= windowSize) {
+    finishWindow();
+  }
+}
+
+void AdaptiveThreshold::skipSample() {
+  // Keeps windows on the same grid whether or not samples are masked
+  lastValue = -1;
+  
+  windowCount++;
+  if (windowCount >= windowSize) {
+    finishWindow();
+  }
+}
+
+void AdaptiveThreshold::finishWindow() {
+  float windowBaseline = baselineEstimator.getValue();
+  float windowPeak = peakEstimator.getValue();
+  
+  // Median absolute difference scaled to a white-noise standard deviation.
+  // Unlike the signal spread it is not inflated by P/T waves or baseline wander.
+  float windowNoise = noiseEstimator.getValue() / 0.954;
+  
+  baselineEstimator.reset();
+  noiseEstimator.reset();
+  peakEstimator.reset();
+  windowCount = 0;
+  
+  // Reject windows without a clear R-peak above the noise (flat line, pure noise)
+  float peakHeight = windowPeak - windowBaseline;
+  if (peakHeight < MIN_CALIBRATION_PEAK_HEIGHT ||
+      peakHeight < CALIBRATION_MIN_PEAK_TO_NOISE * windowNoise) {
+    if (ENABLE_DEBUG_MESSAGES) {
+      Serial.println("Threshold calibration: window rejected (no clear R-peaks)");
+    }
+    return;
+  }
+  
+  if (!calibrated) {
+    // First valid window - adopt directly
+    baseline = windowBaseline;
+    noiseFloor = windowNoise;
+    peakAmplitude = windowPeak;
+    calibrated = true;
+  } else {
+    // Exponential smoothing across windows
+    baseline += CALIBRATION_SMOOTHING * (windowBaseline - baseline);
+    noiseFloor += CALIBRATION_SMOOTHING * (windowNoise - noiseFloor);
+    peakAmplitude += CALIBRATION_SMOOTHING * (windowPeak - peakAmplitude);
+  }
+  calibrationCount++;
+  
+  // Place the threshold between baseline and R-peak, but clear of the noise
+  float level = baseline + THRESHOLD_PEAK_FRACTION * (peakAmplitude - baseline);
+  float minLevel = baseline + THRESHOLD_NOISE_MARGIN * noiseFloor;
+  if (level < minLevel) level = minLevel;
+  
+  threshold = constrain((int)level, 0, ADC_MAX_VALUE);
+  
+  if (ENABLE_DEBUG_MESSAGES) {
+    Serial.print("Threshold calibrated: ");
+    Serial.print(threshold);
+    Serial.print(" (baseline ");
+    Serial.print((int)baseline);
+    Serial.print(", noise ");
+    Serial.print((int)noiseFloor);
+    Serial.print(", peak ");
+    Serial.print((int)peakAmplitude);
+    Serial.println(")");
+  }
+}
+
+bool AdaptiveThreshold::hasSameState(const AdaptiveThreshold& other) const {
+  // calibrationCount is statistics only
+  return baselineEstimator.hasSameState(other.baselineEstimator) &&
+         noiseEstimator.hasSameState(other.noiseEstimator) &&
+         peakEstimator.hasSameState(other.peakEstimator) &&
+         lastValue == other.lastValue &&
+         windowCount == other.windowCount &&
+         windowSize == other.windowSize &&
+         baseline == other.baseline &&
+         noiseFloor == other.noiseFloor &&
+         peakAmplitude == other.peakAmplitude &&
+         threshold == other.threshold &&
+         initialThreshold == other.initialThreshold &&
+         calibrated == other.calibrated;
+}
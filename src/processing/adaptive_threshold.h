@@ -0,0 +1,71 @@
+/*
+ * Adaptive Threshold Class Header
+ * 
+ * Online calibration of the heartbeat detection threshold. Learns the
+ * signal baseline, noise floor and R-peak amplitude with streaming
+ * quantile estimators over consecutive, non-overlapping windows of
+ * samples. Each finished window is blended into the learned values, so
+ * they follow the last few windows rather than a rolling one.
+ */
+
+#ifndef ADAPTIVE_THRESHOLD_H
+#define ADAPTIVE_THRESHOLD_H
+
+#include <Arduino.h>
+#include "p2_quantile.h"
+
+class AdaptiveThreshold {
+private:
+  // Streaming quantile estimators for the current window
+  P2Quantile baselineEstimator;  // Median of samples
+  P2Quantile noiseEstimator;     // Median of absolute sample-to-sample differences
+  P2Quantile peakEstimator;      // R-peak quantile
+  int lastValue;
+  int windowCount;
+  int windowSize;
+  
+  // Learned values
+  float baseline;
+  float noiseFloor;
+  float peakAmplitude;
+  int threshold;
+  int initialThreshold;
+  bool calibrated;
+  unsigned long calibrationCount;
+  
+  // Internal methods
+  void finishWindow();
+  
+public:
+  // Constructor
+  AdaptiveThreshold();
+  
+  // Reset learned values back to the initial threshold
+  void reset();
+  
+  // Set the threshold used until calibration succeeds
+  void setInitialThreshold(int value);
+  
+  // Set the calibration window length in samples
+  void setWindowSize(int samples) { windowSize = samples; }
+  int getWindowSize() { return windowSize; }
+  
+  // Feed a new (filtered) ECG sample
+  void addSample(int ecgValue);
+  
+  // Count a masked sample toward the window without learning from it
+  void skipSample();
+  
+  // Check whether another instance would learn the same values from here on
+  bool hasSameState(const AdaptiveThreshold& other) const;
+  
+  // Getters
+  int getThreshold() { return threshold; }
+  int getBaseline() { return (int)baseline; }
+  int getNoiseFloor() { return (int)noiseFloor; }
+  int getPeakAmplitude() { return (int)peakAmplitude; }
+  bool isCalibrated() { return calibrated; }
+  unsigned long getCalibrationCount() { return calibrationCount; }
+};
+
+#endif // ADAPTIVE_THRESHOLD_H
@@ -0,0 +1,196 @@
+/*
+ * Artifact Detector Class Implementation
+ */
+
+#include "artifact_detector.h"
+
+ArtifactDetector::ArtifactDetector() : energyEstimator(0.5) {
+  configure(SAMPLE_RATE, CALIBRATION_WINDOW_SIZE);
+}
+
+void ArtifactDetector::configure(int sampleRate, int windowSize) {
+  segmentSize = constrain(sampleRate * ARTIFACT_SEGMENT_MS / 1000, 2, MAX_ARTIFACT_SEGMENT_SIZE);
+  this->windowSize = windowSize;
+  holdSamples = sampleRate * ARTIFACT_HOLD_MS / 1000;
+  maxStep = ARTIFACT_MAX_SLOPE * 1000 / sampleRate;
+  
+  // Second differences of the same QRS grow with the square of the sample
+  // interval, so slower rates need a higher floor
+  float scale = (float)SAMPLE_RATE / sampleRate;
+  minNoiseRms = ARTIFACT_NOISE_MIN_RMS * max(1.0f, scale * scale);
+  reset();
+}
+
+void ArtifactDetector::reset() {
+  for (int i = 0; i < MAX_ARTIFACT_SEGMENT_SIZE; i++) {
+    energy[i] = 0;
+  }
+  energyIndex = 0;
+  energySum = 0;
+  previousValue = 0;
+  previousValue2 = 0;
+  history = 0;
+  
+  segmentCount = 0;
+  segmentMin = ADC_MAX_VALUE;
+  segmentMax = 0;
+  previousMin = ADC_MAX_VALUE;
+  previousMax = 0;
+  segmentClean = true;
+  
+  energyEstimator.reset();
+  windowCount = 0;
+  dirtyWindows = 0;
+  noiseLevel = minNoiseRms;
+  updateEnergyLimit();
+  
+  holdRemaining = 0;
+  holdFlags = 0;
+  flags = 0;
+}
+
+uint8_t ArtifactDetector::addSample(int ecgValue) {
+  uint8_t sampleFlags = 0;
+  
+  if (ecgValue <= ARTIFACT_CLIP_MARGIN || ecgValue >= ADC_MAX_VALUE - ARTIFACT_CLIP_MARGIN) {
+    sampleFlags |= ARTIFACT_CLIPPED;
+  }
+  if (history >= 1 && abs(ecgValue - previousValue) > maxStep) {
+    sampleFlags |= ARTIFACT_SLOPE;
+  }
+  
+  // Second difference: flat for ECG waves at this rate, large for EMG and spikes
+  int32_t second = history >= 2 ? ecgValue - 2 * previousValue + previousValue2 : 0;
+  int32_t squared = second * second;
+  energySum += squared - energy[energyIndex];
+  energy[energyIndex] = squared;
+  energyIndex = (energyIndex + 1) % segmentSize;
+  if (energySum > energyLimit) {
+    sampleFlags |= ARTIFACT_NOISE;
+  }
+  
+  previousValue2 = previousValue;
+  previousValue = ecgValue;
+  if (history < 2) history++;
+  
+  if (ecgValue < segmentMin) segmentMin = ecgValue;
+  if (ecgValue > segmentMax) segmentMax = ecgValue;
+  int peakToPeak = max(segmentMax, previousMax) - min(segmentMin, previousMin);
+  if (peakToPeak > ARTIFACT_MAX_PEAK_TO_PEAK) {
+    sampleFlags |= ARTIFACT_AMPLITUDE;
+  }
+  
+  if (sampleFlags != 0) segmentClean = false;
+  if (++segmentCount >= segmentSize) {
+    finishSegment();
+  }
+  
+  // Windows count measured samples, in step with the threshold calibration
+  if (++windowCount >= windowSize) {
+    finishWindow();
+  }
+  
+  updateHold(sampleFlags);
+  mask.append(flags);
+  return flags;
+}
+
+void ArtifactDetector::addGap() {
+  // The next difference must not span the gap; the reconnect transient is
+  // covered by the hold
+  history = 0;
+  holdRemaining = holdSamples;
+  holdFlags = ARTIFACT_LEAD_OFF;
+  flags = ARTIFACT_LEAD_OFF;
+  mask.append(flags);
+}
+
+void ArtifactDetector::updateHold(uint8_t sampleFlags) {
+  if (sampleFlags != 0) {
+    if (holdRemaining == 0) holdFlags = 0;
+    holdFlags |= sampleFlags;
+    holdRemaining = holdSamples;
+  } else if (holdRemaining > 0) {
+    holdRemaining--;
+  }
+  
+  flags = holdRemaining > 0 ? holdFlags : 0;
+}
+
+void ArtifactDetector::finishSegment() {
+  // Bursts longer than a window must not teach the level; a lasting change
+  // in the signal is followed after ARTIFACT_RELEARN_WINDOWS
+  if (segmentClean || dirtyWindows >= ARTIFACT_RELEARN_WINDOWS) {
+    energyEstimator.add(energySum);
+  }
+  
+  previousMin = segmentMin;
+  previousMax = segmentMax;
+  segmentMin = ADC_MAX_VALUE;
+  segmentMax = 0;
+  segmentCount = 0;
+  segmentClean = true;
+}
+
+void ArtifactDetector::finishWindow() {
+  // Segments restart with the window so both stay on the same grid
+  if (segmentCount > 0) {
+    finishSegment();
+  }
+  
+  if (energyEstimator.getCount() > 0) {
+    // The median ignores bursts shorter than half the window
+    noiseLevel = sqrt(energyEstimator.getValue() / segmentSize);
+    updateEnergyLimit();
+    dirtyWindows = 0;
+  } else if (dirtyWindows < ARTIFACT_RELEARN_WINDOWS) {
+    dirtyWindows++;
+  }
+  
+  energyEstimator.reset();
+  windowCount = 0;
+}
+
+void ArtifactDetector::updateEnergyLimit() {
+  // The floor covers the QRS itself, which adds to the noise in energy;
+  // taking the larger of the two let a QRS on top of the noise through
+  // at slower rates, where the floor sits close to the QRS level
+  float limit = ARTIFACT_NOISE_RATIO * noiseLevel;
+  energyLimit = (int64_t)((limit * limit + minNoiseRms * minNoiseRms) * segmentSize);
+}
+
+bool ArtifactDetector::hasSameState(const ArtifactDetector& other) const {
+  if (segmentSize != other.segmentSize || windowSize != other.windowSize ||
+      holdSamples != other.holdSamples || maxStep != other.maxStep ||
+      minNoiseRms != other.minNoiseRms) {
+    return false;
+  }
+  
+  // Sliding energy compared from the oldest entry
+  for (int i = 0; i < segmentSize; i++) {
+    if (energy[(energyIndex + i) % segmentSize] !=
+        other.energy[(other.energyIndex + i) % other.segmentSize]) {
+      return false;
+    }
+  }
+  if (history != other.history) return false;
+  if (history >= 1 && previousValue != other.previousValue) return false;
+  if (history >= 2 && previousValue2 != other.previousValue2) return false;
+  
+  // The mask is history, not state
+  return energySum == other.energySum &&
+         segmentCount == other.segmentCount &&
+         segmentMin == other.segmentMin &&
+         segmentMax == other.segmentMax &&
+         previousMin == other.previousMin &&
+         previousMax == other.previousMax &&
+         segmentClean == other.segmentClean &&
+         energyEstimator.hasSameState(other.energyEstimator) &&
+         windowCount == other.windowCount &&
+         dirtyWindows == other.dirtyWindows &&
+         noiseLevel == other.noiseLevel &&
+         energyLimit == other.energyLimit &&
+         holdRemaining == other.holdRemaining &&
+         (holdRemaining == 0 || holdFlags == other.holdFlags) &&
+         flags == other.flags;
+}
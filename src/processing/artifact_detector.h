@@ -0,0 +1,101 @@
+/*
+ * Artifact Detector Class Header
+ * 
+ * Incremental motion-artifact and noise-burst classifier on raw samples.
+ * Each sample is checked for ADC rail clipping, an impossible slope, a
+ * peak-to-peak swing no ECG reaches within two segments, and
+ * high-frequency energy (squared second differences over a sliding
+ * segment) far above the level learned from the clean segments of the
+ * previous calibration window. A flagged sample keeps the mask on for
+ * ARTIFACT_HOLD_MS so the settling tail of a burst is covered too.
+ * 
+ * Work per sample is a handful of integer operations; the only float math
+ * runs once per calibration window.
+ */
+
+#ifndef ARTIFACT_DETECTOR_H
+#define ARTIFACT_DETECTOR_H
+
+#include <Arduino.h>
+#include "p2_quantile.h"
+#include "quality_mask.h"
+
+enum ArtifactFlags {
+  ARTIFACT_CLIPPED = 0x01,     // Sample at or near an ADC rail
+  ARTIFACT_SLOPE = 0x02,       // Sample-to-sample step too steep for ECG
+  ARTIFACT_AMPLITUDE = 0x04,   // Peak-to-peak swing too large for ECG
+  ARTIFACT_NOISE = 0x08,       // High-frequency energy burst
+  ARTIFACT_LEAD_OFF = 0x10     // Lead-off stretch and the settling after it
+};
+
+class ArtifactDetector {
+private:
+  // Rate-dependent lengths
+  int segmentSize;
+  int windowSize;
+  int holdSamples;
+  int maxStep;
+  float minNoiseRms;           // Floor of the noise limit at this rate
+  
+  // Sliding high-frequency energy over the last segment
+  int32_t energy[MAX_ARTIFACT_SEGMENT_SIZE];
+  int energyIndex;
+  int64_t energySum;
+  int previousValue;
+  int previousValue2;
+  int history;                 // Valid previous values (0-2)
+  
+  // Peak-to-peak over the current and the previous segment
+  int segmentCount;
+  int segmentMin;
+  int segmentMax;
+  int previousMin;
+  int previousMax;
+  bool segmentClean;           // No sample of this segment was flagged
+  
+  // High-frequency level learned per calibration window
+  P2Quantile energyEstimator;  // Median segment energy
+  int windowCount;
+  int dirtyWindows;            // Consecutive windows without a clean segment
+  float noiseLevel;            // RMS of the second difference (ADC counts)
+  int64_t energyLimit;         // Segment energy above which a sample is noise
+  
+  // Mask state
+  int holdRemaining;
+  uint8_t holdFlags;
+  uint8_t flags;
+  QualityMask mask;
+  
+  // Internal methods
+  void finishSegment();
+  void finishWindow();
+  void updateEnergyLimit();
+  void updateHold(uint8_t sampleFlags);
+  
+public:
+  // Constructor
+  ArtifactDetector();
+  
+  // Clear the learned level and features (the mask keeps its history)
+  void reset();
+  
+  // Set the sample rate and the calibration window length in samples
+  void configure(int sampleRate, int windowSize);
+  
+  // Classify the next raw sample; returns its flags (0 = clean)
+  uint8_t addSample(int ecgValue);
+  
+  // Record a sample that was not measured (leads off)
+  void addGap();
+  
+  // Check whether another detector would classify the same from here on
+  bool hasSameState(const ArtifactDetector& other) const;
+  
+  // Getters
+  uint8_t getFlags() { return flags; }
+  bool isMasked() { return flags != 0; }
+  int getNoiseLevel() { return (int)noiseLevel; }
+  QualityMask& getMask() { return mask; }
+};
+
+#endif // ARTIFACT_DETECTOR_H
@@ -0,0 +1,100 @@
+/*
+ * Heart Rate Estimator Class Implementation
+ */
+
+#include "heart_rate_estimator.h"
+
+#if ECG_FEATURE_MEDIAN_HEART_RATE
+HeartRateEstimator::HeartRateEstimator()
+  : recentIntervals(HR_MEDIAN_WINDOW), acceptedIntervals(HR_MEDIAN_WINDOW) {
+  reset();
+}
+#else
+HeartRateEstimator::HeartRateEstimator() {
+  reset();
+}
+#endif
+
+void HeartRateEstimator::reset() {
+#if ECG_FEATURE_MEDIAN_HEART_RATE
+  recentIntervals.reset();
+  acceptedIntervals.reset();
+#endif
+  outcomes = 0;
+  outcomeCount = 0;
+  acceptedCount = 0;
+  lastAccepted = false;
+  instantRate = 0;
+  instantConfidence = 0;
+  smoothedRate = 0;
+  smoothedConfidence = 0;
+}
+
+bool HeartRateEstimator::addInterval(unsigned long interval) {
+  if (interval == 0) return false;
+  
+  instantRate = constrain(60000 / (long)interval, 30, 200);
+  
+  // Until the reference has a few intervals every interval is taken
+  bool accepted = true;
+  instantConfidence = 50;
+#if ECG_FEATURE_MEDIAN_HEART_RATE
+  if (recentIntervals.getCount() >= HR_MIN_REFERENCE_INTERVALS) {
+    long reference = recentIntervals.getMedian();
+    long deviation = abs((long)interval - reference);
+    long limit = (long)(reference * HR_RR_TOLERANCE);
+    
+    accepted = deviation <= limit;
+    instantConfidence = accepted ? 100 - 50 * deviation / max(limit, 1L) : 0;
+  }
+  
+  // The reference sees outliers too: a lasting change of rhythm becomes
+  // the median after half a window and is accepted from then on
+  recentIntervals.add(interval);
+  recordOutcome(accepted);
+  lastAccepted = accepted;
+  
+  if (accepted) {
+    acceptedIntervals.add(interval);
+    smoothedRate = constrain(60000 / (long)acceptedIntervals.getMedian(), 30, 200);
+  }
+#else
+  recordOutcome(accepted);
+  lastAccepted = accepted;
+  smoothedRate = instantRate;
+#endif
+  smoothedConfidence = 100 * acceptedCount / HR_MEDIAN_WINDOW;
+  
+  return accepted;
+}
+
+void HeartRateEstimator::recordOutcome(bool accepted) {
+  // Bit i is the outcome i intervals ago
+  if (outcomeCount == HR_MEDIAN_WINDOW) {
+    if (outcomes & (1UL << (HR_MEDIAN_WINDOW - 1))) acceptedCount--;
+  } else {
+    outcomeCount++;
+  }
+  
+  outcomes = (outcomes << 1) & ((1UL << HR_MEDIAN_WINDOW) - 1);
+  if (accepted) {
+    outcomes |= 1;
+    acceptedCount++;
+  }
+}
+
+bool HeartRateEstimator::hasSameState(const HeartRateEstimator& other) const {
+  return
+#if ECG_FEATURE_MEDIAN_HEART_RATE
+         recentIntervals.hasSameState(other.recentIntervals) &&
+         acceptedIntervals.hasSameState(other.acceptedIntervals) &&
+#endif
+         outcomes == other.outcomes &&
+         outcomeCount == other.outcomeCount &&
+         acceptedCount == other.acceptedCount &&
+         lastAccepted == other.lastAccepted &&
+         instantRate == other.instantRate &&
+         instantConfidence == other.instantConfidence &&
+         smoothedRate == other.smoothedRate &&
+         smoothedConfidence == other.smoothedConfidence;
+}
@@ -0,0 +1,80 @@
+/*
+ * Heart Rate Estimator Class Header
+ * 
+ * Robust heart rate from detected RR intervals. Each interval is checked
+ * against the median of the recent intervals; one that differs by more
+ * than HR_RR_TOLERANCE (an ectopic beat and its compensatory pause, a
+ * missed beat, a T wave counted as a beat) is rejected. A median is not
+ * moved by a single outlier, and a real change of rhythm takes over the
+ * reference once it holds for half the window.
+ * 
+ * Two rates are reported: the instantaneous rate of the last interval and
+ * the smoothed rate, the median of the accepted intervals. Each comes with
+ * a confidence (0-100): how close the last interval is to the reference,
+ * and how many of the recent intervals were accepted.
+ * 
+ * Built without ECG_FEATURE_MEDIAN_HEART_RATE (config/features.h) there is
+ * no reference: every interval is accepted, both rates are the rate of the
+ * last interval and the instantaneous confidence stays at 50.
+ */
+
+#ifndef HEART_RATE_ESTIMATOR_H
+#define HEART_RATE_ESTIMATOR_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+#include "../config/features.h"
+
+#if ECG_FEATURE_MEDIAN_HEART_RATE
+#include "sliding_median.h"
+#endif
+
+class HeartRateEstimator {
+private:
+#if ECG_FEATURE_MEDIAN_HEART_RATE
+  SlidingMedian recentIntervals;     // Every plausible interval (consistency reference)
+  SlidingMedian acceptedIntervals;   // Intervals behind the smoothed rate
+#endif
+  
+  // Accept/reject outcome of the last HR_MEDIAN_WINDOW intervals
+  uint32_t outcomes;
+  int outcomeCount;
+  int acceptedCount;
+  
+  // Results
+  bool lastAccepted;
+  int instantRate;
+  int instantConfidence;
+  int smoothedRate;
+  int smoothedConfidence;
+  
+  // Internal methods
+  void recordOutcome(bool accepted);
+  
+public:
+  // Constructor
+  HeartRateEstimator();
+  
+  // Forget all intervals
+  void reset();
+  
+  // Add the interval (ms) between two detected beats
+  // Returns: true if accepted into the smoothed rate
+  bool addInterval(unsigned long interval);
+  
+  // Smoothed rate (BPM, 0 until the first accepted interval) and confidence
+  int getHeartRate() { return smoothedRate; }
+  int getConfidence() { return smoothedConfidence; }
+  
+  // Rate of the last interval (BPM) and confidence (0 if it was rejected)
+  int getInstantHeartRate() { return instantRate; }
+  int getInstantConfidence() { return instantConfidence; }
+  
+  // Whether the last interval was accepted
+  bool wasAccepted() { return lastAccepted; }
+  
+  // Check whether another estimator would give the same rates from here on
+  bool hasSameState(const HeartRateEstimator& other) const;
+};
+
+#endif // HEART_RATE_ESTIMATOR_H
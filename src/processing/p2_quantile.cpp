@@ -0,0 +1,135 @@
+/*
+ * P-Square Quantile Estimator Implementation
+ * 
+ * Reference: R. Jain, I. Chlamtac, "The P² algorithm for dynamic
+ * calculation of quantiles and histograms without storing observations",
+ * Communications of the ACM, 1985.
+ */
+
+#include "p2_quantile.h"
+
+P2Quantile::P2Quantile(float quantile) {
+  this->quantile = quantile;
+  reset();
+}
+
+void P2Quantile::reset() {
+  count = 0;
+  
+  for (int i = 0; i < 5; i++) {
+    heights[i] = 0;
+    positions[i] = i;
+  }
+  
+  desired[0] = 0;
+  desired[1] = 2 * quantile;
+  desired[2] = 4 * quantile;
+  desired[3] = 2 + 2 * quantile;
+  desired[4] = 4;
+  
+  increments[0] = 0;
+  increments[1] = quantile / 2;
+  increments[2] = quantile;
+  increments[3] = (1 + quantile) / 2;
+  increments[4] = 1;
+}
+
+void P2Quantile::add(float value) {
+  // Collect the first five observations as initial markers
+  if (count < 5) {
+    // Insert keeping the (at most five) markers ordered
+    int i = count;
+    while (i > 0 && heights[i - 1] > value) {
+      heights[i] = heights[i - 1];
+      i--;
+    }
+    heights[i] = value;
+    count++;
+    return;
+  }
+  
+  // Find the cell containing the new observation
+  int k;
+  if (value < heights[0]) {
+    heights[0] = value;
+    k = 0;
+  } else if (value >= heights[4]) {
+    heights[4] = value;
+    k = 3;
+  } else {
+    k = 0;
+    while (k < 3 && value >= heights[k + 1]) {
+      k++;
+    }
+  }
+  
+  // Shift positions of markers above the cell
+  for (int i = k + 1; i < 5; i++) {
+    positions[i]++;
+  }
+  for (int i = 0; i < 5; i++) {
+    desired[i] += increments[i];
+  }
+  
+  // Adjust the three middle markers if they drifted off their desired position
+  for (int i = 1; i < 4; i++) {
+    float delta = desired[i] - positions[i];
+    
+    if ((delta >= 1 && positions[i + 1] - positions[i] > 1) ||
+        (delta <= -1 && positions[i - 1] - positions[i] < -1)) {
+      int d = (delta > 0) ? 1 : -1;
+      
+      float candidate = parabolic(i, d);
+      if (heights[i - 1] < candidate && candidate < heights[i + 1]) {
+        heights[i] = candidate;
+      } else {
+        heights[i] = linear(i, d);
+      }
+      positions[i] += d;
+    }
+  }
+  
+  count++;
+}
+
+float P2Quantile::parabolic(int i, int d) {
+  float spanAll = positions[i + 1] - positions[i - 1];
+  float spanUp = positions[i + 1] - positions[i];
+  float spanDown = positions[i] - positions[i - 1];
+  
+  return heights[i] + d / spanAll *
+         ((positions[i] - positions[i - 1] + d) * (heights[i + 1] - heights[i]) / spanUp +
+          (positions[i + 1] - positions[i] - d) * (heights[i] - heights[i - 1]) / spanDown);
+}
+
+float P2Quantile::linear(int i, int d) {
+  return heights[i] + d * (heights[i + d] - heights[i]) / (positions[i + d] - positions[i]);
+}
+
+float P2Quantile::getValue() {
+  if (count == 0) return 0;
+  
+  // Not enough samples for markers yet - pick from the ordered prefix
+  if (count < 5) {
+    int index = (int)(quantile * (count - 1) + 0.5f);
+    return heights[index];
+  }
+  
+  return heights[2];
+}
+
+bool P2Quantile::hasSameState(const P2Quantile& other) const {
+  if (quantile != other.quantile || count != other.count) return false;
+  
+  // Before the fifth observation only the ordered prefix is in use
+  int used = count < 5 ? (int)count : 5;
+  for (int i = 0; i < used; i++) {
+    if (heights[i] != other.heights[i]) return false;
+  }
+  if (count < 5) return true;
+  
+  for (int i = 0; i < 5; i++) {
+    if (positions[i] != other.positions[i] || desired[i] != other.desired[i]) return false;
+  }
+  return true;
+}
@@ -0,0 +1,47 @@
+/*
+ * P-Square Quantile Estimator Header
+ * 
+ * Streaming quantile estimation (Jain & Chlamtac P² algorithm).
+ * Tracks a single quantile with five markers - constant memory,
+ * constant time per sample and no sorting of the sample history.
+ */
+
+#ifndef P2_QUANTILE_H
+#define P2_QUANTILE_H
+
+#include <Arduino.h>
+
+class P2Quantile {
+private:
+  float quantile;            // Target quantile (0.0 - 1.0)
+  float heights[5];          // Marker heights
+  int positions[5];          // Actual marker positions
+  float desired[5];          // Desired marker positions
+  float increments[5];       // Desired position increments per sample
+  unsigned long count;       // Samples seen since reset
+  
+  // Internal methods
+  float parabolic(int i, int d);
+  float linear(int i, int d);
+  
+public:
+  // Constructor
+  P2Quantile(float quantile);
+  
+  // Clear all markers and start a new estimate
+  void reset();
+  
+  // Add a new observation
+  void add(float value);
+  
+  // Get the current quantile estimate
+  float getValue();
+  
+  // Number of observations since last reset
+  unsigned long getCount() { return count; }
+  
+  // Check whether another estimator holds the same markers
+  bool hasSameState(const P2Quantile& other) const;
+};
+
+#endif // P2_QUANTILE_H
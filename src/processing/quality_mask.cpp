@@ -0,0 +1,54 @@
+/*
+ * Quality Mask Class Implementation
+ */
+
+#include "quality_mask.h"
+
+QualityMask::QualityMask() {
+  reset();
+}
+
+void QualityMask::reset() {
+  oldest = 0;
+  count = 0;
+  nextSample = 0;
+  maskedSamples = 0;
+}
+
+bool QualityMask::append(uint8_t flags) {
+  uint32_t sample = nextSample++;
+  if (flags != 0) maskedSamples++;
+  
+  if (count > 0) {
+    QualityRun& newest = runs[(oldest + count - 1) % QUALITY_MASK_RUNS];
+    if (newest.flags == flags && newest.start + newest.length == sample) {
+      newest.length++;
+      return false;
+    }
+  }
+  
+  // Start a run, dropping the oldest when full
+  if (count == QUALITY_MASK_RUNS) {
+    oldest = (oldest + 1) % QUALITY_MASK_RUNS;
+    count--;
+  }
+  QualityRun& run = runs[(oldest + count) % QUALITY_MASK_RUNS];
+  run.start = sample;
+  run.length = 1;
+  run.flags = flags;
+  count++;
+  
+  return true;
+}
+
+bool QualityMask::getFlags(uint32_t sample, uint8_t& flags) {
+  // Newest first: recent samples are the common question
+  for (int i = count - 1; i >= 0; i--) {
+    const QualityRun& run = getRun(i);
+    if (sample - run.start < run.length) {
+      flags = run.flags;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,59 @@
+/*
+ * Quality Mask Class Header
+ * 
+ * Run-length encoded per-sample quality flags. Every sample the signal
+ * processor sees (including lead-off samples) appends its artifact flags;
+ * consecutive samples with the same flags share one run. The newest
+ * QUALITY_MASK_RUNS runs are kept, so readers can tell exactly which
+ * stretches were excluded from beat detection.
+ * 
+ * Samples are numbered from 0, or by the caller (sensor sequence numbers)
+ * through sync(). Numbers skipped that way are not covered by any run.
+ */
+
+#ifndef QUALITY_MASK_H
+#define QUALITY_MASK_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+struct QualityRun {
+  uint32_t start;          // Sample index of the first sample
+  uint32_t length;         // Samples (the newest run is still growing)
+  uint8_t flags;           // ArtifactFlags, 0 = clean
+};
+
+class QualityMask {
+private:
+  QualityRun runs[QUALITY_MASK_RUNS];
+  int oldest;
+  int count;
+  uint32_t nextSample;
+  uint32_t maskedSamples;
+  
+public:
+  // Constructor
+  QualityMask();
+  
+  // Forget all runs and restart at sample 0
+  void reset();
+  
+  // Number the next appended sample
+  void sync(uint32_t sample) { nextSample = sample; }
+  
+  // Append the flags of the next sample; true if it starts a new run
+  bool append(uint8_t flags);
+  
+  // Flags of a sample still covered by the kept runs
+  bool getFlags(uint32_t sample, uint8_t& flags);
+  
+  // Runs from oldest (0) to newest
+  int getRunCount() { return count; }
+  const QualityRun& getRun(int i) { return runs[(oldest + i) % QUALITY_MASK_RUNS]; }
+  
+  // Getters
+  uint32_t getNextSample() { return nextSample; }
+  uint32_t getMaskedSamples() { return maskedSamples; }
+};
+
+#endif // QUALITY_MASK_H
@@ -0,0 +1,46 @@
+/*
+ * Sample Rate Profiles Implementation
+ * 
+ * Keep this table in sync with SUPPORTED_SAMPLE_RATES in config.h.
+ */
+
+#include "sample_rate.h"
+
+static constexpr RateProfile RATE_PROFILES[] = {
+  makeRateProfile<250>(),
+  makeRateProfile<500>(),
+  makeRateProfile<1000>()
+};
+
+static const int RATE_PROFILE_COUNT = sizeof(RATE_PROFILES) / sizeof(RATE_PROFILES[0]);
+
+static_assert(sizeof(RATE_PROFILES) / sizeof(RATE_PROFILES[0]) ==
+              sizeof(SUPPORTED_SAMPLE_RATES) / sizeof(SUPPORTED_SAMPLE_RATES[0]),
+              "RATE_PROFILES and SUPPORTED_SAMPLE_RATES are out of sync");
+
+const RateProfile* findRateProfile(int sampleRate) {
+  for (int i = 0; i < RATE_PROFILE_COUNT; i++) {
+    if (RATE_PROFILES[i].sampleRate == sampleRate) {
+      return &RATE_PROFILES[i];
+    }
+  }
+  return NULL;
+}
+
+int getRateProfileCount() {
+  return RATE_PROFILE_COUNT;
+}
+
+const RateProfile& getRateProfile(int index) {
+  return RATE_PROFILES[index];
+}
+
+int getApplyBlockSize(int sampleRate) {
+  const RateProfile* profile = findRateProfile(sampleRate);
+  return profile != NULL ? profile->applyBlockSize : CONFIG_APPLY_BLOCK_SIZE;
+}
+
+int getLowPowerBlockSize(int sampleRate) {
+  const RateProfile* profile = findRateProfile(sampleRate);
+  return profile != NULL ? profile->lowPowerBlockSize : LOW_POWER_BLOCK_SIZE;
+}
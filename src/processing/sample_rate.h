@@ -0,0 +1,81 @@
+/*
+ * Sample Rate Profiles Header
+ * 
+ * Window lengths are specified in milliseconds in config.h and converted
+ * to sample counts at compile time for each supported rate. Each rate
+ * also gets a moving-average kernel specialized for its filter length.
+ * findRateProfile() dispatches between the instantiated rates at runtime;
+ * rates without a profile (offline recordings) use the SAMPLE_RATE values.
+ */
+
+#ifndef SAMPLE_RATE_H
+#define SAMPLE_RATE_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+#include "../dsp/dsp_kernels.h"
+
+// Moving average over a fixed number of samples (sum on the DSP backend)
+template <int N>
+int movingAverageKernel(const int16_t* buffer) {
+  return dspSum(buffer, N) / N;
+}
+
+// Compile-time derived parameters for one sample rate
+template <int RATE>
+struct SampleRateTraits {
+  static const int sampleRate = RATE;
+  static const unsigned long sampleInterval = 1000000UL / RATE;
+  static const int movingAverageSize = (RATE * MOVING_AVERAGE_WINDOW_MS + 500) / 1000;
+  static const int calibrationWindowSize = RATE * CALIBRATION_WINDOW_MS / 1000;
+  static const int bufferSize = RATE * ECG_BUFFER_MS / 1000;
+  static const int applyBlockSize = RATE * CONFIG_APPLY_BLOCK_MS / 1000;
+  static const int lowPowerBlockSize = RATE * LOW_POWER_BLOCK_MS / 1000;
+  
+  static_assert(RATE <= MAX_SAMPLE_RATE, "Rate above MAX_SAMPLE_RATE");
+  static_assert(movingAverageSize >= 1 && movingAverageSize <= MAX_MOVING_AVERAGE_SIZE,
+                "Moving average window does not fit the filter buffer at this rate");
+  static_assert(bufferSize >= MAX_MOVING_AVERAGE_SIZE,
+                "Signal buffer too short to prime the moving average at this rate");
+  static_assert(applyBlockSize >= 1 && lowPowerBlockSize >= 1, "Block shorter than one sample");
+};
+
+struct RateProfile {
+  int sampleRate;                       // Hz
+  unsigned long sampleInterval;         // microseconds
+  int movingAverageSize;                // samples
+  int calibrationWindowSize;            // samples
+  int bufferSize;                       // samples (signal statistics window)
+  int applyBlockSize;                   // samples between settings swaps
+  int lowPowerBlockSize;                // samples per low power processing block
+  int (*movingAverage)(const int16_t* buffer);  // Kernel specialized for movingAverageSize
+};
+
+// Build the runtime profile for a compile-time rate (a constant, so the
+// profile table is placed in flash)
+template <int RATE>
+constexpr RateProfile makeRateProfile() {
+  return RateProfile {
+    SampleRateTraits<RATE>::sampleRate,
+    SampleRateTraits<RATE>::sampleInterval,
+    SampleRateTraits<RATE>::movingAverageSize,
+    SampleRateTraits<RATE>::calibrationWindowSize,
+    SampleRateTraits<RATE>::bufferSize,
+    SampleRateTraits<RATE>::applyBlockSize,
+    SampleRateTraits<RATE>::lowPowerBlockSize,
+    &movingAverageKernel<SampleRateTraits<RATE>::movingAverageSize>
+  };
+}
+
+// Get the profile for a supported rate (NULL if the rate is not instantiated)
+const RateProfile* findRateProfile(int sampleRate);
+
+// Instantiated profiles, in ascending rate order
+int getRateProfileCount();
+const RateProfile& getRateProfile(int index);
+
+// Block lengths in samples at any rate
+int getApplyBlockSize(int sampleRate);
+int getLowPowerBlockSize(int sampleRate);
+
+#endif // SAMPLE_RATE_H
@@ -9,49 +9,81 @@
 
 SignalProcessor::SignalProcessor() {
   bufferIndex = 0;
+  bufferFull = false;
   filterIndex = 0;
   lastBeatState = false;
+  sampleTime = 0;
   lastBeatTime = 0;
-  beatIntervalIndex = 0;
   heartbeatDetected = false;
-  currentHeartRate = 0;
   signalQuality = 0;
   filteredValue = 0;
+  RuntimeConfig::getDefaults(activeSettings);
+  pendingSettings = activeSettings;
+  settingsPending = false;
+  settingsHeld = false;
+  sampleCount = 0;
+  rateProfile = findRateProfile(activeSettings.sampleRate);
+  bufferSize = rateProfile != NULL ? rateProfile->bufferSize : ECG_BUFFER_SIZE;
+  applyBlockSize = getApplyBlockSize(activeSettings.sampleRate);
+  selectFilterKernel();
 }
 
 bool SignalProcessor::begin() {
   // Initialize buffers
-  for (int i = 0; i < ECG_BUFFER_SIZE; i++) {
+  for (int i = 0; i < MAX_ECG_BUFFER_SIZE; i++) {
     ecgBuffer[i] = 0;
   }
   
-  for (int i = 0; i < MOVING_AVERAGE_SIZE; i++) {
+  for (int i = 0; i < MAX_MOVING_AVERAGE_SIZE; i++) {
     filterBuffer[i] = 0;
   }
   
-  for (int i = 0; i < BEAT_BUFFER_SIZE; i++) {
-    beatIntervals[i] = 0;
-  }
+  heartRateEstimator.reset();
   
   Serial.println("Signal processor initialized");
   Serial.print("Buffer size: ");
-  Serial.println(ECG_BUFFER_SIZE);
+  Serial.println(bufferSize);
   Serial.print("Filter size: ");
-  Serial.println(MOVING_AVERAGE_SIZE);
-  Serial.print("Heartbeat threshold: ");
-  Serial.println(HEARTBEAT_THRESHOLD);
+  Serial.println(activeSettings.movingAverageSize);
+  Serial.print("Initial heartbeat threshold: ");
+  Serial.println(activeSettings.heartbeatThreshold);
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+  Serial.print("Calibration window: ");
+  Serial.println(adaptiveThreshold.getWindowSize());
+#endif
   
   return true;
 }
 
 void SignalProcessor::processSample(int ecgValue) {
+  // Swap in new settings only between blocks
+  if (settingsPending && !settingsHeld && (sampleCount % applyBlockSize) == 0) {
+    swapSettings();
+  }
+  sampleCount++;
+  advanceSampleClock();
+  
   // Store raw value in buffer
   ecgBuffer[bufferIndex] = ecgValue;
-  bufferIndex = (bufferIndex + 1) % ECG_BUFFER_SIZE;
+  bufferIndex = (bufferIndex + 1) % bufferSize;
+  if (bufferIndex == 0) bufferFull = true;
   
   // Apply filtering
   filteredValue = applyMovingAverage(ecgValue);
   
+#if ECG_FEATURE_ARTIFACT_DETECTION
+  // Classify the raw sample; masked samples bypass the detectors
+  if (artifactDetector.addSample(ecgValue) != 0 && activeSettings.artifactMasking) {
+    maskSample();
+    return;
+  }
+#endif
+  
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+  // Update threshold calibration
+  adaptiveThreshold.addSample(filteredValue);
+#endif
+  
   // Detect heartbeat
   detectHeartbeat(filteredValue);
   
@@ -59,112 +91,265 @@ void SignalProcessor::processSample(int ecgValue) {
   calculateSignalQuality();
 }
 
+void SignalProcessor::skipSample() {
+  advanceSampleClock();
+  
+#if ECG_FEATURE_ARTIFACT_DETECTION
+  artifactDetector.addGap();
+  
+  if (activeSettings.artifactMasking) {
+    heartbeatDetected = false;
+    lastBeatState = true;
+    lastBeatTime = 0;
+  }
+#endif
+}
+
+void SignalProcessor::maskSample() {
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+  adaptiveThreshold.skipSample();
+#endif
+  heartbeatDetected = false;
+  signalQuality = 0;
+  
+  // An interval across the artifact is not an RR interval, and the next
+  // beat needs a fresh rising edge
+  lastBeatState = true;
+  lastBeatTime = 0;
+}
+
+void SignalProcessor::advanceSampleClock() {
+  // Beat timing follows the samples, not the CPU clock: block processing
+  // in low power mode and offline analysis see the true intervals
+  if (rateProfile != NULL) {
+    sampleTime += rateProfile->sampleInterval;
+  } else {
+    sampleTime += 1000000UL / activeSettings.sampleRate;
+  }
+}
+
 int SignalProcessor::applyMovingAverage(int newValue) {
   // Add new value to filter buffer
   filterBuffer[filterIndex] = newValue;
-  filterIndex = (filterIndex + 1) % MOVING_AVERAGE_SIZE;
+  filterIndex = (filterIndex + 1) % activeSettings.movingAverageSize;
+  
+  // Use the kernel specialized for the current rate when possible
+  if (filterKernel != NULL) {
+    return filterKernel(filterBuffer);
+  }
   
   // Calculate average
-  long sum = 0;
-  for (int i = 0; i < MOVING_AVERAGE_SIZE; i++) {
-    sum += filterBuffer[i];
+  return dspSum(filterBuffer, activeSettings.movingAverageSize) / activeSettings.movingAverageSize;
+}
+
+void SignalProcessor::requestSettings(const ProcessingSettings& settings) {
+  pendingSettings = settings;
+  settingsPending = true;
+  settingsHeld = false;
+}
+
+void SignalProcessor::requestSettings(const ECGSettings& settings) {
+  RuntimeConfig::getProcessingSettings(settings, pendingSettings);
+  settingsPending = true;
+  settingsHeld = false;
+}
+
+void SignalProcessor::holdSettings(const ProcessingSettings& settings) {
+  pendingSettings = settings;
+  settingsPending = true;
+  settingsHeld = true;
+}
+
+void SignalProcessor::holdSettings(const ECGSettings& settings) {
+  RuntimeConfig::getProcessingSettings(settings, pendingSettings);
+  settingsPending = true;
+  settingsHeld = true;
+}
+
+void SignalProcessor::applyPendingSettings() {
+  if (settingsPending) {
+    swapSettings();
   }
+}
+
+void SignalProcessor::swapSettings() {
+  int newSize = pendingSettings.movingAverageSize;
+  
+  // Prime the resized filter from raw history so its output does not step.
+  // Oldest first: the next sample overwrites slot 0, the oldest one.
+  if (newSize != activeSettings.movingAverageSize) {
+    for (int i = 0; i < newSize; i++) {
+      int historyIndex = (bufferIndex - newSize + i + bufferSize) % bufferSize;
+      filterBuffer[i] = ecgBuffer[historyIndex];
+    }
+    filterIndex = 0;
+  }
+  
+  // Switch to the compile-time profile of the new rate
+  if (pendingSettings.sampleRate != activeSettings.sampleRate) {
+    rateProfile = findRateProfile(pendingSettings.sampleRate);
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+    if (rateProfile != NULL) {
+      adaptiveThreshold.setWindowSize(rateProfile->calibrationWindowSize);
+    }
+#endif
+#if ECG_FEATURE_ARTIFACT_DETECTION
+    artifactDetector.configure(pendingSettings.sampleRate,
+                               rateProfile != NULL ? rateProfile->calibrationWindowSize : CALIBRATION_WINDOW_SIZE);
+#endif
+    applyBlockSize = getApplyBlockSize(pendingSettings.sampleRate);
+    
+    // The statistics window covers the same time at the new rate; it
+    // refills from here (quality reads 0 until then)
+    int newBufferSize = rateProfile != NULL ? rateProfile->bufferSize : ECG_BUFFER_SIZE;
+    if (newBufferSize != bufferSize) {
+      bufferSize = newBufferSize;
+      bufferIndex = 0;
+      bufferFull = false;
+    }
+  }
+  
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+  adaptiveThreshold.setInitialThreshold(pendingSettings.heartbeatThreshold);
+#endif
   
-  return sum / MOVING_AVERAGE_SIZE;
+  activeSettings = pendingSettings;
+  settingsPending = false;
+  settingsHeld = false;
+  selectFilterKernel();
+  
+  if (ENABLE_DEBUG_MESSAGES) {
+    Serial.print("Processor settings applied at sample ");
+    Serial.println(sampleCount);
+  }
+}
+
+void SignalProcessor::selectFilterKernel() {
+  if (rateProfile != NULL && rateProfile->movingAverageSize == activeSettings.movingAverageSize) {
+    filterKernel = rateProfile->movingAverage;
+  } else {
+    filterKernel = NULL;
+  }
+}
+
+int SignalProcessor::getThreshold() {
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+  if (activeSettings.adaptiveThreshold) {
+    return adaptiveThreshold.getThreshold();
+  }
+#endif
+  return activeSettings.heartbeatThreshold;
 }
 
 void SignalProcessor::detectHeartbeat(int ecgValue) {
-  bool currentBeatState = ecgValue > HEARTBEAT_THRESHOLD;
+  bool currentBeatState = ecgValue > getThreshold();
   heartbeatDetected = false;
   
   // Detect rising edge (potential heartbeat)
   if (currentBeatState && !lastBeatState) {
-    unsigned long currentTime = millis();
-    
     if (lastBeatTime > 0) {
-      unsigned long interval = currentTime - lastBeatTime;
+      unsigned long interval = (unsigned long)((sampleTime - lastBeatTime) / 1000);
       
       // Check if interval is valid
       if (isValidHeartbeatInterval(interval)) {
-        // Store interval
-        beatIntervals[beatIntervalIndex] = interval;
-        beatIntervalIndex = (beatIntervalIndex + 1) % BEAT_BUFFER_SIZE;
-        
-        // Calculate new heart rate
-        calculateHeartRate();
+        // Outliers are still beats; they only stay out of the rate
+        bool accepted = heartRateEstimator.addInterval(interval);
         
         // Set heartbeat detected flag
         heartbeatDetected = true;
         
         if (ENABLE_DEBUG_MESSAGES) {
           Serial.print("💓 Heartbeat detected! BPM: ");
-          Serial.print(currentHeartRate);
+          Serial.print(getHeartRate());
           Serial.print(", Interval: ");
           Serial.print(interval);
-          Serial.println("ms");
+          Serial.println(accepted ? "ms" : "ms (outlier)");
         }
       }
     }
     
-    lastBeatTime = currentTime;
+    lastBeatTime = sampleTime;
   }
   
   lastBeatState = currentBeatState;
 }
 
-void SignalProcessor::calculateHeartRate() {
-  unsigned long totalInterval = 0;
-  int validIntervals = 0;
-  
-  // Sum all valid intervals
-  for (int i = 0; i < BEAT_BUFFER_SIZE; i++) {
-    if (beatIntervals[i] > 0) {
-      totalInterval += beatIntervals[i];
-      validIntervals++;
-    }
-  }
-  
-  if (validIntervals > 0) {
-    unsigned long avgInterval = totalInterval / validIntervals;
-    currentHeartRate = 60000 / avgInterval; // Convert to BPM
-    
-    // Clamp to reasonable values
-    if (currentHeartRate < 30) currentHeartRate = 30;
-    if (currentHeartRate > 200) currentHeartRate = 200;
-  }
-}
-
 void SignalProcessor::calculateSignalQuality() {
-  if (bufferIndex < ECG_BUFFER_SIZE) {
+  if (!bufferFull) {
     signalQuality = 0;
     return;
   }
   
   // Calculate variance-based signal quality
-  long sum = 0;
-  for (int i = 0; i < ECG_BUFFER_SIZE; i++) {
-    sum += ecgBuffer[i];
-  }
-  int mean = sum / ECG_BUFFER_SIZE;
-  
-  long variance = 0;
-  for (int i = 0; i < ECG_BUFFER_SIZE; i++) {
-    variance += (ecgBuffer[i] - mean) * (ecgBuffer[i] - mean);
-  }
-  variance /= ECG_BUFFER_SIZE;
+  int mean;
+  long variance = computeVariance(mean);
   
   // Convert variance to quality percentage (0-100)
   // Higher variance generally indicates better ECG signal
   signalQuality = constrain(map(variance, 0, 1000000, 0, 100), 0, 100);
   
   // Additional quality checks
+  int currentHeartRate = getHeartRate();
   if (currentHeartRate < 30 || currentHeartRate > 200) {
     signalQuality = max(0, signalQuality - 30);
   }
 }
 
 bool SignalProcessor::isValidHeartbeatInterval(unsigned long interval) {
-  return (interval >= MIN_BEAT_INTERVAL && interval <= MAX_BEAT_INTERVAL);
+  return (interval >= activeSettings.minBeatInterval && interval <= activeSettings.maxBeatInterval);
+}
+
+bool SignalProcessor::hasSameState(const SignalProcessor& other) const {
+  // Settings that shape the output
+  if (rateProfile != other.rateProfile ||
+      filterKernel != other.filterKernel ||
+      bufferSize != other.bufferSize ||
+      settingsPending != other.settingsPending ||
+      activeSettings.sampleRate != other.activeSettings.sampleRate ||
+      activeSettings.movingAverageSize != other.activeSettings.movingAverageSize ||
+      activeSettings.heartbeatThreshold != other.activeSettings.heartbeatThreshold ||
+      activeSettings.adaptiveThreshold != other.activeSettings.adaptiveThreshold ||
+      activeSettings.artifactMasking != other.activeSettings.artifactMasking ||
+      activeSettings.minBeatInterval != other.activeSettings.minBeatInterval ||
+      activeSettings.maxBeatInterval != other.activeSettings.maxBeatInterval) {
+    return false;
+  }
+  
+  // Ring buffers compared from their oldest entry
+  for (int i = 0; i < bufferSize; i++) {
+    if (ecgBuffer[(bufferIndex + i) % bufferSize] !=
+        other.ecgBuffer[(other.bufferIndex + i) % bufferSize]) {
+      return false;
+    }
+  }
+  
+  int filterSize = activeSettings.movingAverageSize;
+  for (int i = 0; i < filterSize; i++) {
+    if (filterBuffer[(filterIndex + i) % filterSize] !=
+        other.filterBuffer[(other.filterIndex + i) % filterSize]) {
+      return false;
+    }
+  }
+  
+  // The last beat only matters relative to the current sample
+  if ((lastBeatTime > 0) != (other.lastBeatTime > 0)) return false;
+  if (lastBeatTime > 0 && sampleTime - lastBeatTime != other.sampleTime - other.lastBeatTime) {
+    return false;
+  }
+  
+  return bufferFull == other.bufferFull &&
+         lastBeatState == other.lastBeatState &&
+         heartbeatDetected == other.heartbeatDetected &&
+         heartRateEstimator.hasSameState(other.heartRateEstimator) &&
+         signalQuality == other.signalQuality &&
+         filteredValue == other.filteredValue &&
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+         adaptiveThreshold.hasSameState(other.adaptiveThreshold) &&
+#endif
+#if ECG_FEATURE_ARTIFACT_DETECTION
+         artifactDetector.hasSameState(other.artifactDetector) &&
+#endif
+         true;
 }
 
 bool SignalProcessor::isHeartbeatDetected() {
@@ -173,50 +358,54 @@ bool SignalProcessor::isHeartbeatDetected() {
   return detected;
 }
 
+long SignalProcessor::computeVariance(int& mean) {
+  int32_t sum = dspSum(ecgBuffer, bufferSize);
+  int64_t sumSquares = dspSumSquares(ecgBuffer, bufferSize);
+  mean = sum / bufferSize;
+  
+  // Sum of (x - mean)^2 expanded; exact for the integer mean used before
+  int64_t deviation = sumSquares - 2 * (int64_t)mean * sum + (int64_t)bufferSize * mean * mean;
+  return deviation / bufferSize;
+}
+
 int SignalProcessor::getMeanValue() {
-  if (bufferIndex < ECG_BUFFER_SIZE) return 0;
+  if (!bufferFull) return 0;
   
-  long sum = 0;
-  for (int i = 0; i < ECG_BUFFER_SIZE; i++) {
-    sum += ecgBuffer[i];
-  }
-  return sum / ECG_BUFFER_SIZE;
+  return dspSum(ecgBuffer, bufferSize) / bufferSize;
 }
 
 int SignalProcessor::getVariance() {
-  if (bufferIndex < ECG_BUFFER_SIZE) return 0;
-  
-  int mean = getMeanValue();
-  long variance = 0;
+  if (!bufferFull) return 0;
   
-  for (int i = 0; i < ECG_BUFFER_SIZE; i++) {
-    variance += (ecgBuffer[i] - mean) * (ecgBuffer[i] - mean);
-  }
-  
-  return variance / ECG_BUFFER_SIZE;
+  int mean;
+  return computeVariance(mean);
 }
 
 void SignalProcessor::reset() {
   // Reset all buffers and state
-  for (int i = 0; i < ECG_BUFFER_SIZE; i++) {
+  for (int i = 0; i < MAX_ECG_BUFFER_SIZE; i++) {
     ecgBuffer[i] = 0;
   }
   
-  for (int i = 0; i < MOVING_AVERAGE_SIZE; i++) {
+  for (int i = 0; i < MAX_MOVING_AVERAGE_SIZE; i++) {
     filterBuffer[i] = 0;
   }
   
-  for (int i = 0; i < BEAT_BUFFER_SIZE; i++) {
-    beatIntervals[i] = 0;
-  }
-  
   bufferIndex = 0;
+  bufferFull = false;
   filterIndex = 0;
-  beatIntervalIndex = 0;
+  lastBeatState = false;
   lastBeatTime = 0;
-  currentHeartRate = 0;
+  heartRateEstimator.reset();
   signalQuality = 0;
   heartbeatDetected = false;
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+  adaptiveThreshold.reset();
+#endif
+#if ECG_FEATURE_ARTIFACT_DETECTION
+  artifactDetector.reset();
+  artifactDetector.getMask().reset();
+#endif
   
   Serial.println("Signal processor reset");
 }
@@ -9,35 +9,74 @@
 #define SIGNAL_PROCESSOR_H
 
 #include <Arduino.h>
+#include "../config/features.h"
+#include "heart_rate_estimator.h"
+#include "sample_rate.h"
+#include "../config/runtime_config.h"
+
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+#include "adaptive_threshold.h"
+#endif
+#if ECG_FEATURE_ARTIFACT_DETECTION
+#include "artifact_detector.h"
+#endif
 
 class SignalProcessor {
 private:
-  // Signal buffers
-  int ecgBuffer[100];  // Will use ECG_BUFFER_SIZE from config
+  // Signal buffers (bufferSize samples cover ECG_BUFFER_MS at the current rate)
+  int16_t ecgBuffer[MAX_ECG_BUFFER_SIZE];
+  int bufferSize;
   int bufferIndex;
+  bool bufferFull;
   
   // Moving average filter
-  int filterBuffer[5];  // Will use MOVING_AVERAGE_SIZE from config
+  int16_t filterBuffer[MAX_MOVING_AVERAGE_SIZE];
   int filterIndex;
+  int (*filterKernel)(const int16_t* buffer);  // Specialized kernel, NULL for custom sizes
+  const RateProfile* rateProfile;
   
-  // Heartbeat detection
+  // Heartbeat detection (times on the sample clock, microseconds)
   bool lastBeatState;
-  unsigned long lastBeatTime;
-  unsigned long beatIntervals[10];  // Will use BEAT_BUFFER_SIZE from config
-  int beatIntervalIndex;
+  uint64_t sampleTime;
+  uint64_t lastBeatTime;
   bool heartbeatDetected;
   
+  // Median heart rate with RR outlier rejection
+  HeartRateEstimator heartRateEstimator;
+  
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+  // Online threshold calibration
+  AdaptiveThreshold adaptiveThreshold;
+#endif
+  
+#if ECG_FEATURE_ARTIFACT_DETECTION
+  // Motion artifact / noise burst mask
+  ArtifactDetector artifactDetector;
+#endif
+  
+  // Runtime settings (pending settings swap in at a block boundary, or
+  // when the caller applies them if they are held)
+  ProcessingSettings activeSettings;
+  ProcessingSettings pendingSettings;
+  bool settingsPending;
+  bool settingsHeld;
+  unsigned long sampleCount;
+  int applyBlockSize;
+  
   // Calculated values
-  int currentHeartRate;
   int signalQuality;
   int filteredValue;
   
   // Internal methods
   int applyMovingAverage(int newValue);
   void detectHeartbeat(int ecgValue);
-  void calculateHeartRate();
+  void maskSample();
   void calculateSignalQuality();
   bool isValidHeartbeatInterval(unsigned long interval);
+  void swapSettings();
+  void selectFilterKernel();
+  void advanceSampleClock();
+  long computeVariance(int& mean);
   
 public:
   // Constructor
@@ -49,20 +88,73 @@ public:
   // Process a new ECG sample
   void processSample(int ecgValue);
   
+  // Account for a sample that is not processed (leads off) so beat
+  // intervals keep the real elapsed time
+  void skipSample();
+  
+  // Stage new settings; applied at the next block boundary
+  void requestSettings(const ProcessingSettings& settings);
+  void requestSettings(const ECGSettings& settings);
+  
+  // Stage new settings that wait for applyPendingSettings(), for callers
+  // that pick the sample themselves (ECGPipeline switches with the sensor)
+  void holdSettings(const ProcessingSettings& settings);
+  void holdSettings(const ECGSettings& settings);
+  
+  // Apply staged settings before the next sample
+  void applyPendingSettings();
+  
+  // Staged settings (valid while hasPendingSettings())
+  bool hasPendingSettings() { return settingsPending; }
+  const ProcessingSettings& getPendingSettings() { return pendingSettings; }
+  
+  // Check whether another processor would produce the same output from
+  // here on (absolute sample counts and times are not compared)
+  bool hasSameState(const SignalProcessor& other) const;
+  
   // Getters
-  int getHeartRate() { return currentHeartRate; }
+  int getHeartRate() { return heartRateEstimator.getHeartRate(); }
   int getSignalQuality() { return signalQuality; }
   int getFilteredValue() { return filteredValue; }
-  int getThreshold() { return 2048; }  // Will use HEARTBEAT_THRESHOLD from config
+  int getThreshold();
   bool isHeartbeatDetected();
   
   // Get statistical information
   int getMeanValue();
   int getVariance();
   
+  // Get learned calibration values (0 and uncalibrated without the
+  // adaptive threshold)
+#if ECG_FEATURE_ADAPTIVE_THRESHOLD
+  int getBaseline() { return adaptiveThreshold.getBaseline(); }
+  int getNoiseFloor() { return adaptiveThreshold.getNoiseFloor(); }
+  int getPeakAmplitude() { return adaptiveThreshold.getPeakAmplitude(); }
+  bool isThresholdCalibrated() { return adaptiveThreshold.isCalibrated(); }
+#else
+  int getBaseline() { return 0; }
+  int getNoiseFloor() { return 0; }
+  int getPeakAmplitude() { return 0; }
+  bool isThresholdCalibrated() { return false; }
+#endif
+  
+  // Rate of the last beat interval and the confidence values (0-100)
+  int getInstantHeartRate() { return heartRateEstimator.getInstantHeartRate(); }
+  int getInstantConfidence() { return heartRateEstimator.getInstantConfidence(); }
+  int getHeartRateConfidence() { return heartRateEstimator.getConfidence(); }
+  
+  // Artifact flags of the last sample (0 = clean) and the per-sample mask
+#if ECG_FEATURE_ARTIFACT_DETECTION
+  uint8_t getArtifactFlags() { return artifactDetector.getFlags(); }
+  QualityMask& getQualityMask() { return artifactDetector.getMask(); }
+#else
+  uint8_t getArtifactFlags() { return 0; }
+#endif
+  
   // Reset processor state
   void reset();
   
   // Check if signal is good quality
   bool isSignalGoodQuality();
 };
+
+#endif // SIGNAL_PROCESSOR_H
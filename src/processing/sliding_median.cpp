@@ -0,0 +1,146 @@
+/*
+ * Sliding Median Class Implementation
+ */
+
+#include "sliding_median.h"
+
+SlidingMedian::SlidingMedian(int window) {
+  this->window = constrain(window, 1, SLIDING_MEDIAN_CAPACITY);
+  reset();
+}
+
+void SlidingMedian::reset() {
+  count = 0;
+  next = 0;
+  lowerSize = 0;
+  upperSize = 0;
+  
+  for (int i = 0; i < SLIDING_MEDIAN_CAPACITY; i++) {
+    values[i] = 0;
+    position[i] = 0;
+    inLower[i] = false;
+  }
+}
+
+void SlidingMedian::add(int32_t value) {
+  uint8_t slot = next;
+  next = (next + 1) % window;
+  values[slot] = value;
+  
+  if (count < window) {
+    // Growing: insert on the matching side, then even out the halves
+    bool toLower = lowerSize == 0 || value <= values[lower[0]];
+    push(toLower, slot);
+    rebalance();
+    count++;
+    return;
+  }
+  
+  // Full: the new value replaces the oldest in place, so the halves keep
+  // their sizes and only the order needs repair
+  bool lowerHeap = inLower[slot];
+  siftUp(lowerHeap, position[slot]);
+  siftDown(lowerHeap, position[slot]);
+  
+  // Only the changed value can be on the wrong side; swapping the two tops
+  // once restores max(lower) <= min(upper)
+  if (lowerSize > 0 && upperSize > 0 && values[lower[0]] > values[upper[0]]) {
+    uint8_t lowerTop = lower[0];
+    uint8_t upperTop = upper[0];
+    place(true, 0, upperTop);
+    place(false, 0, lowerTop);
+    siftDown(true, 0);
+    siftDown(false, 0);
+  }
+}
+
+int32_t SlidingMedian::getMedian() {
+  if (count == 0) return 0;
+  
+  if (lowerSize > upperSize) {
+    return values[lower[0]];
+  }
+  return (values[lower[0]] + values[upper[0]]) / 2;
+}
+
+bool SlidingMedian::hasSameState(const SlidingMedian& other) const {
+  if (window != other.window || count != other.count) return false;
+  
+  // Values from the oldest; the heap layout does not change the median
+  int oldest = count < window ? 0 : next;
+  int otherOldest = other.count < other.window ? 0 : other.next;
+  for (int i = 0; i < count; i++) {
+    if (values[(oldest + i) % window] != other.values[(otherOldest + i) % window]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SlidingMedian::before(bool lowerHeap, int a, int b) {
+  // Whether slot a belongs above slot b in the heap
+  return lowerHeap ? values[a] > values[b] : values[a] < values[b];
+}
+
+void SlidingMedian::place(bool lowerHeap, int index, uint8_t slot) {
+  uint8_t* heap = lowerHeap ? lower : upper;
+  heap[index] = slot;
+  position[slot] = index;
+  inLower[slot] = lowerHeap;
+}
+
+void SlidingMedian::siftUp(bool lowerHeap, int index) {
+  uint8_t* heap = lowerHeap ? lower : upper;
+  uint8_t slot = heap[index];
+  
+  while (index > 0) {
+    int parent = (index - 1) / 2;
+    if (!before(lowerHeap, slot, heap[parent])) break;
+    place(lowerHeap, index, heap[parent]);
+    index = parent;
+  }
+  place(lowerHeap, index, slot);
+}
+
+void SlidingMedian::siftDown(bool lowerHeap, int index) {
+  uint8_t* heap = lowerHeap ? lower : upper;
+  int size = lowerHeap ? lowerSize : upperSize;
+  uint8_t slot = heap[index];
+  
+  while (true) {
+    int child = 2 * index + 1;
+    if (child >= size) break;
+    if (child + 1 < size && before(lowerHeap, heap[child + 1], heap[child])) child++;
+    if (!before(lowerHeap, heap[child], slot)) break;
+    place(lowerHeap, index, heap[child]);
+    index = child;
+  }
+  place(lowerHeap, index, slot);
+}
+
+void SlidingMedian::push(bool lowerHeap, uint8_t slot) {
+  int index = lowerHeap ? lowerSize++ : upperSize++;
+  place(lowerHeap, index, slot);
+  siftUp(lowerHeap, index);
+}
+
+uint8_t SlidingMedian::pop(bool lowerHeap) {
+  uint8_t* heap = lowerHeap ? lower : upper;
+  uint8_t top = heap[0];
+  int last = lowerHeap ? --lowerSize : --upperSize;
+  
+  if (last > 0) {
+    place(lowerHeap, 0, heap[last]);
+    siftDown(lowerHeap, 0);
+  }
+  return top;
+}
+
+void SlidingMedian::rebalance() {
+  // The lower half holds the extra value when the count is odd
+  if (lowerSize > upperSize + 1) {
+    push(false, pop(true));
+  } else if (upperSize > lowerSize) {
+    push(true, pop(false));
+  }
+}
@@ -0,0 +1,63 @@
+/*
+ * Sliding Median Class Header
+ * 
+ * Exact median of the last N values (N up to SLIDING_MEDIAN_CAPACITY).
+ * Two indexed heaps split the window at the median: a max-heap holds the
+ * lower half, a min-heap the upper half. Each value keeps its ring slot,
+ * and every slot knows its heap position, so once the window is full a
+ * new value overwrites the oldest one in place and is sifted into order.
+ * An update is O(log N) with no allocation and no sorting.
+ */
+
+#ifndef SLIDING_MEDIAN_H
+#define SLIDING_MEDIAN_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+class SlidingMedian {
+private:
+  int window;
+  int count;
+  int next;                                    // Slot of the next (oldest once full) value
+  int32_t values[SLIDING_MEDIAN_CAPACITY];     // By ring slot
+  
+  // Heaps of slot numbers; position[] and inLower[] locate each slot
+  uint8_t lower[SLIDING_MEDIAN_CAPACITY];      // Max-heap, lower half (one extra when odd)
+  uint8_t upper[SLIDING_MEDIAN_CAPACITY];      // Min-heap, upper half
+  int lowerSize;
+  int upperSize;
+  uint8_t position[SLIDING_MEDIAN_CAPACITY];
+  bool inLower[SLIDING_MEDIAN_CAPACITY];
+  
+  // Internal methods
+  bool before(bool lowerHeap, int a, int b);
+  void place(bool lowerHeap, int index, uint8_t slot);
+  void siftUp(bool lowerHeap, int index);
+  void siftDown(bool lowerHeap, int index);
+  void push(bool lowerHeap, uint8_t slot);
+  uint8_t pop(bool lowerHeap);
+  void rebalance();
+  
+public:
+  // Constructor (window is clamped to 1..SLIDING_MEDIAN_CAPACITY)
+  SlidingMedian(int window);
+  
+  // Forget all values
+  void reset();
+  
+  // Add a value, dropping the oldest once the window is full
+  void add(int32_t value);
+  
+  // Median of the values in the window (mean of the middle two when even)
+  int32_t getMedian();
+  
+  // Values currently in the window
+  int getCount() { return count; }
+  int getWindow() { return window; }
+  
+  // Check whether another median holds the same values in the same order
+  bool hasSameState(const SlidingMedian& other) const;
+};
+
+#endif // SLIDING_MEDIAN_H
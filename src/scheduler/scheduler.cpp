@@ -0,0 +1,214 @@
+/*
+ * Scheduler Class Implementation
+ */
+
+#include "scheduler.h"
+
+Scheduler::Scheduler() {
+  clock = NULL;
+  taskCount = 0;
+  heapSize = 0;
+}
+
+void Scheduler::begin(SampleClock* clock) {
+  this->clock = clock;
+}
+
+int Scheduler::addTask(const char* name, TaskFunction function, unsigned long periodMs) {
+  if (taskCount >= SCHEDULER_MAX_TASKS || function == NULL) {
+    Serial.println("ERROR: Scheduler task table full");
+    return -1;
+  }
+  
+  int id = taskCount++;
+  Task& task = tasks[id];
+  memset(&task, 0, sizeof(task));
+  task.name = name;
+  task.function = function;
+  task.period = (uint64_t)periodMs * 1000;
+  position[id] = -1;
+  
+  runAt(id, clock->now());
+  return id;
+}
+
+void Scheduler::runAt(int id, uint64_t time) {
+  if (id < 0 || id >= taskCount) return;
+  
+  Task& task = tasks[id];
+  uint64_t previous = task.deadline;
+  task.deadline = time;
+  
+  if (position[id] < 0) {
+    place(heapSize++, id);
+    siftUp(heapSize - 1);
+  } else if (time < previous) {
+    siftUp(position[id]);
+  } else {
+    siftDown(position[id]);
+  }
+}
+
+void Scheduler::cancel(int id) {
+  if (id < 0 || id >= taskCount || position[id] < 0) return;
+  
+  // Move the last entry into the hole and repair in whichever direction
+  int index = position[id];
+  position[id] = -1;
+  heapSize--;
+  if (index < heapSize) {
+    int moved = heap[heapSize];
+    place(index, moved);
+    siftUp(index);
+    siftDown(position[moved]);
+  }
+}
+
+bool Scheduler::runNext() {
+  if (heapSize == 0) return false;
+  
+  uint64_t started = clock->now();
+  int id = heap[0];
+  Task& task = tasks[id];
+  if (task.deadline > started) return false;
+  
+  uint64_t lateness = started - task.deadline;
+  
+  // Next deadline before the run, so the task may re-arm itself
+  if (task.period > 0) {
+    task.deadline += task.period;
+    if (task.deadline <= started) {
+      // Fell behind by whole periods: skip them, keep the grid
+      uint64_t skipped = (started - task.deadline) / task.period + 1;
+      task.deadline += skipped * task.period;
+      task.skippedPeriods += skipped;
+    }
+    siftDown(0);
+  } else {
+    removeTop();
+  }
+  
+  task.function();
+  
+  uint64_t runTime = clock->now() - started;
+  task.runs++;
+  task.latenessSum += lateness;
+  task.latenessSquares += lateness * lateness;
+  task.maxLateness = max(task.maxLateness, (uint32_t)min(lateness, (uint64_t)UINT32_MAX));
+  task.runTimeSum += runTime;
+  task.maxRunTime = max(task.maxRunTime, (uint32_t)min(runTime, (uint64_t)UINT32_MAX));
+  return true;
+}
+
+void Scheduler::runDue() {
+  while (runNext()) {
+  }
+}
+
+void Scheduler::idle() {
+  uint64_t deadline = getNextDeadline();
+  uint64_t current = clock->now();
+  
+  // A tick sleep wakes up to a tick late, so only sleep with a tick to spare
+  if (deadline > current && deadline - current >= SCHEDULER_MIN_SLEEP_US) {
+    delay((deadline - current) / 1000 - 1);
+  } else {
+    yield();
+  }
+}
+
+uint64_t Scheduler::getNextDeadline() {
+  return heapSize > 0 ? tasks[heap[0]].deadline : UINT64_MAX;
+}
+
+void Scheduler::getStats(int id, TaskStats& stats) {
+  memset(&stats, 0, sizeof(stats));
+  if (id < 0 || id >= taskCount) return;
+  
+  const Task& task = tasks[id];
+  stats.name = task.name;
+  stats.runs = task.runs;
+  stats.skippedPeriods = task.skippedPeriods;
+  stats.maxLateness = task.maxLateness;
+  stats.maxRunTime = task.maxRunTime;
+  if (task.runs == 0) return;
+  
+  double mean = (double)task.latenessSum / task.runs;
+  double variance = (double)task.latenessSquares / task.runs - mean * mean;
+  stats.meanLateness = (uint32_t)mean;
+  stats.latenessStd = (uint32_t)sqrt(max(variance, 0.0));
+  stats.meanRunTime = (uint32_t)(task.runTimeSum / task.runs);
+}
+
+void Scheduler::resetStats() {
+  for (int i = 0; i < taskCount; i++) {
+    Task& task = tasks[i];
+    task.runs = 0;
+    task.skippedPeriods = 0;
+    task.maxLateness = 0;
+    task.latenessSum = 0;
+    task.latenessSquares = 0;
+    task.maxRunTime = 0;
+    task.runTimeSum = 0;
+  }
+}
+
+void Scheduler::printReport(Print& out) {
+  out.println("Task          runs   late mean/std/max (us)   run mean/max (us)");
+  for (int i = 0; i < taskCount; i++) {
+    TaskStats stats;
+    getStats(i, stats);
+    char line[96];
+    snprintf(line, sizeof(line), "%-12s %6lu   %6lu %6lu %8lu   %8lu %8lu", stats.name,
+             (unsigned long)stats.runs, (unsigned long)stats.meanLateness,
+             (unsigned long)stats.latenessStd, (unsigned long)stats.maxLateness,
+             (unsigned long)stats.meanRunTime, (unsigned long)stats.maxRunTime);
+    out.println(line);
+  }
+}
+
+bool Scheduler::before(int a, int b) {
+  // Equal deadlines run in the order the tasks were added
+  if (tasks[a].deadline != tasks[b].deadline) return tasks[a].deadline < tasks[b].deadline;
+  return a < b;
+}
+
+void Scheduler::place(int index, int id) {
+  heap[index] = id;
+  position[id] = index;
+}
+
+void Scheduler::siftUp(int index) {
+  int id = heap[index];
+  
+  while (index > 0) {
+    int parent = (index - 1) / 2;
+    if (!before(id, heap[parent])) break;
+    place(index, heap[parent]);
+    index = parent;
+  }
+  place(index, id);
+}
+
+void Scheduler::siftDown(int index) {
+  int id = heap[index];
+  
+  while (true) {
+    int child = 2 * index + 1;
+    if (child >= heapSize) break;
+    if (child + 1 < heapSize && before(heap[child + 1], heap[child])) child++;
+    if (!before(heap[child], id)) break;
+    place(index, heap[child]);
+    index = child;
+  }
+  place(index, id);
+}
+
+void Scheduler::removeTop() {
+  position[heap[0]] = -1;
+  heapSize--;
+  if (heapSize > 0) {
+    place(0, heap[heapSize]);
+    siftDown(0);
+  }
+}
@@ -0,0 +1,110 @@
+/*
+ * Scheduler Class Header
+ * 
+ * Cooperative task scheduler for loop(). Each task is a function with a
+ * deadline; deadlines sit in an indexed min-heap, so the earliest due task
+ * runs first and a task's deadline can be moved in O(log N). Periodic
+ * tasks advance on a fixed grid (deadline += period) like the sample
+ * clock, skipping whole periods they fell behind. A task with period 0
+ * runs once per runAt(), which is how the sampling task follows the
+ * sample clock's own deadlines.
+ * 
+ * Time is the sample clock's local time (us), so task and sample deadlines
+ * share one time base, and host tools can drive both from a virtual clock.
+ * Tasks never block: anything that waits (WiFi, uploads) is a state
+ * machine that checks its condition and returns.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+#include "../sensors/sample_clock.h"
+
+typedef void (*TaskFunction)();
+
+// Timing statistics of one task
+struct TaskStats {
+  const char* name;
+  uint32_t runs;
+  uint32_t skippedPeriods;     // Whole periods lost while running late
+  uint32_t maxLateness;        // Start after the deadline (us)
+  uint32_t meanLateness;
+  uint32_t latenessStd;        // Jitter (us)
+  uint32_t maxRunTime;         // us
+  uint32_t meanRunTime;
+};
+
+class Scheduler {
+private:
+  struct Task {
+    const char* name;
+    TaskFunction function;
+    uint64_t period;           // us, 0 = run once per runAt()
+    uint64_t deadline;
+    
+    // Statistics
+    uint32_t runs;
+    uint32_t skippedPeriods;
+    uint32_t maxLateness;
+    uint64_t latenessSum;
+    uint64_t latenessSquares;
+    uint32_t maxRunTime;
+    uint64_t runTimeSum;
+  };
+  
+  SampleClock* clock;
+  Task tasks[SCHEDULER_MAX_TASKS];
+  int taskCount;
+  
+  // Min-heap of task ids by deadline; position[] locates each task (-1 = idle)
+  uint8_t heap[SCHEDULER_MAX_TASKS];
+  int8_t position[SCHEDULER_MAX_TASKS];
+  int heapSize;
+  
+  // Internal methods
+  bool before(int a, int b);
+  void place(int index, int id);
+  void siftUp(int index);
+  void siftDown(int index);
+  void removeTop();
+  
+public:
+  // Constructor
+  Scheduler();
+  
+  // Use the sample clock's time base
+  void begin(SampleClock* clock);
+  
+  // Add a task first due now (periodMs 0 = only when armed with runAt())
+  // Returns: task id, or -1 if SCHEDULER_MAX_TASKS are in use
+  int addTask(const char* name, TaskFunction function, unsigned long periodMs);
+  
+  // Set the next run of a task (absolute local time, us)
+  void runAt(int id, uint64_t time);
+  
+  // Stop a task until the next runAt()
+  void cancel(int id);
+  
+  // Run the earliest task if it is due
+  // Returns: true if a task ran
+  bool runNext();
+  
+  // Run tasks until none is due
+  void runDue();
+  
+  // Give the CPU away until shortly before the next deadline (whole ticks only)
+  void idle();
+  
+  // Earliest deadline (UINT64_MAX if no task is armed)
+  uint64_t getNextDeadline();
+  
+  // Statistics
+  int getTaskCount() { return taskCount; }
+  void getStats(int id, TaskStats& stats);
+  void resetStats();
+  void printReport(Print& out);
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,37 @@
+/*
+ * AD8232 Front End Class Implementation
+ */
+
+#include "ad8232.h"
+#include "../config/config.h"
+
+AD8232FrontEnd::AD8232FrontEnd(int ecgPin, int loPlusPin, int loMinusPin) {
+  this->ecgPin = ecgPin;
+  this->loPlus = loPlusPin;
+  this->loMinus = loMinusPin;
+}
+
+bool AD8232FrontEnd::begin() {
+  // Configure pins
+  pinMode(loPlus, INPUT);
+  pinMode(loMinus, INPUT);
+  
+  // Configure ADC
+  analogReadResolution(ADC_RESOLUTION);
+  analogSetAttenuation(ADC_ATTENUATION);
+  
+  // Test ADC reading
+  return analogRead(ecgPin) >= 0;
+}
+
+int AD8232FrontEnd::readSample() {
+  return analogRead(ecgPin);
+}
+
+bool AD8232FrontEnd::areLeadsConnected() {
+  bool loPlusState = digitalRead(loPlus);
+  bool loMinusState = digitalRead(loMinus);
+  
+  // Leads are connected when both LO+ and LO- are LOW
+  return !(loPlusState || loMinusState);
+}
@@ -0,0 +1,33 @@
+/*
+ * AD8232 Front End Class Header
+ * 
+ * The AD8232 board: ECG output on an ADC pin, lead-off detection on two
+ * digital pins (LO+ and LO-, both LOW while the electrodes are on).
+ */
+
+#ifndef AD8232_H
+#define AD8232_H
+
+#include <Arduino.h>
+#include "ecg_front_end.h"
+
+class AD8232FrontEnd : public ECGFrontEnd {
+private:
+  int ecgPin;
+  int loPlus;
+  int loMinus;
+  
+public:
+  // Constructor
+  AD8232FrontEnd(int ecgPin, int loPlusPin, int loMinusPin);
+  
+  // Configure the pins and the ADC
+  // Returns: false if the ADC cannot be read
+  bool begin();
+  
+  // ECGFrontEnd
+  int readSample();
+  bool areLeadsConnected();
+};
+
+#endif // AD8232_H
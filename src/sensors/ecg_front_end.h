@@ -0,0 +1,26 @@
+/*
+ * ECG Front End Interface
+ * 
+ * Hardware abstraction for whatever produces the ECG signal: the AD8232
+ * board, the synthetic ECG simulator, or a host-side replay. ECGSensor
+ * keeps the sample timing and reads through this interface, so the rest
+ * of the pipeline does not know which source is fitted.
+ */
+
+#ifndef ECG_FRONT_END_H
+#define ECG_FRONT_END_H
+
+#include <Arduino.h>
+
+class ECGFrontEnd {
+public:
+  virtual ~ECGFrontEnd() {}
+  
+  // Read the next sample (ADC counts)
+  virtual int readSample() = 0;
+  
+  // Lead state for the last sample
+  virtual bool areLeadsConnected() = 0;
+};
+
+#endif // ECG_FRONT_END_H
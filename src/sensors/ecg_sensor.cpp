@@ -1,38 +1,27 @@
 /*
  * ECG Sensor Class Implementation
  * 
- * Handles AD8232 ECG sensor operations
+ * Handles ECG sensor timing on top of the selected front end
  */
 
 #include "ecg_sensor.h"
 #include "../config/config.h"
 
-ECGSensor::ECGSensor(int ecgPin, int loPlusPin, int loMinusPin) {
-  this->ecgPin = ecgPin;
-  this->loPlus = loPlusPin;
-  this->loMinus = loMinusPin;
-  this->lastSampleTime = 0;
+ECGSensor::ECGSensor(int ecgPin, int loPlusPin, int loMinusPin)
+  : ad8232(ecgPin, loPlusPin, loMinusPin) {
+  this->frontEnd = &ad8232;
   this->initialized = false;
 }
 
-bool ECGSensor::begin() {
-  // Configure pins
-  pinMode(loPlus, INPUT);
-  pinMode(loMinus, INPUT);
-  
-  // Configure ADC
-  analogReadResolution(ADC_RESOLUTION);
-  analogSetAttenuation(ADC_ATTENUATION);
-  
-  // Test ADC reading
-  int testRead = analogRead(ecgPin);
-  if (testRead < 0) {
+bool ECGSensor::begin(int sampleRate) {
+  // The board is configured even when the simulator feeds the pipeline
+  if (!ad8232.begin()) {
     Serial.println("ERROR: ECG sensor initialization failed");
     return false;
   }
   
   initialized = true;
-  resetSampleTimer();
+  clock.begin(sampleRate);
   
   Serial.println("ECG sensor initialized successfully");
   Serial.print("ADC resolution: ");
@@ -41,26 +30,30 @@ bool ECGSensor::begin() {
   Serial.print("Reference voltage: ");
   Serial.print(REFERENCE_VOLTAGE);
   Serial.println("V");
+  Serial.print("Sample rate: ");
+  Serial.print(sampleRate);
+  Serial.println(" Hz");
   
   return true;
 }
 
+void ECGSensor::setFrontEnd(ECGFrontEnd* frontEnd) {
+  this->frontEnd = frontEnd != NULL ? frontEnd : &ad8232;
+}
+
 bool ECGSensor::areLeadsConnected() {
   if (!initialized) return false;
   
-  bool loPlusState = digitalRead(loPlus);
-  bool loMinusState = digitalRead(loMinus);
-  
-  // Leads are connected when both LO+ and LO- are LOW
-  return !(loPlusState || loMinusState);
+  return frontEnd->areLeadsConnected();
 }
 
 int ECGSensor::readValue() {
   if (!initialized) return 0;
   
   if (isTimeForSample()) {
-    lastSampleTime = micros();
-    return analogRead(ecgPin);
+    // Advance the deadline grid, not "now", so read latency does not drift the rate
+    clock.takeSample();
+    return frontEnd->readSample();
   }
   
   return -1; // Indicates no new sample
@@ -69,13 +62,13 @@ int ECGSensor::readValue() {
 bool ECGSensor::isTimeForSample() {
   if (!initialized) return false;
   
-  return (micros() - lastSampleTime) >= SAMPLE_INTERVAL;
+  return clock.isSampleDue();
 }
 
 int ECGSensor::getRawValue() {
   if (!initialized) return 0;
   
-  return analogRead(ecgPin);
+  return frontEnd->readSample();
 }
 
 float ECGSensor::getVoltage(int adcValue) {
@@ -83,5 +76,15 @@ float ECGSensor::getVoltage(int adcValue) {
 }
 
 void ECGSensor::resetSampleTimer() {
-  lastSampleTime = micros();
+  clock.restart();
+}
+
+void ECGSensor::setSampleRate(int sampleRate) {
+  if (sampleRate <= 0) return;
+  
+  clock.setSampleRate(sampleRate);
+  
+  Serial.print("Sample rate set to ");
+  Serial.print(sampleRate);
+  Serial.println(" Hz");
 }
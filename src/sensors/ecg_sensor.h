@@ -1,29 +1,35 @@
 /*
  * ECG Sensor Class Header
  * 
- * Handles all ECG sensor operations including reading values,
- * checking lead connections, and managing ADC settings
+ * Handles all ECG sensor operations: sample timing, reading values and
+ * checking lead connections. Samples come from the AD8232 front end on
+ * the given pins unless another front end (the simulator) is selected.
  */
 
 #ifndef ECG_SENSOR_H
 #define ECG_SENSOR_H
 
 #include <Arduino.h>
+#include "sample_clock.h"
+#include "../config/config.h"
+#include "ad8232.h"
 
 class ECGSensor {
 private:
-  int ecgPin;
-  int loPlus;
-  int loMinus;
-  unsigned long lastSampleTime;
+  AD8232FrontEnd ad8232;
+  ECGFrontEnd* frontEnd;
+  SampleClock clock;
   bool initialized;
   
 public:
   // Constructor
   ECGSensor(int ecgPin, int loPlusPin, int loMinusPin);
   
-  // Initialize the sensor
-  bool begin();
+  // Initialize the sensor and start sampling at the given rate (Hz)
+  bool begin(int sampleRate = SAMPLE_RATE);
+  
+  // Read from another front end instead of the AD8232 (NULL restores it)
+  void setFrontEnd(ECGFrontEnd* frontEnd);
   
   // Check if leads are properly connected
   bool areLeadsConnected();
@@ -45,4 +51,18 @@ public:
   
   // Reset sampling timer
   void resetSampleTimer();
+  
+  // Change the sampling rate (Hz)
+  void setSampleRate(int sampleRate);
+  int getSampleRate() { return clock.getSampleRate(); }
+  unsigned long getSampleInterval() { return clock.getSampleInterval(); }
+  
+  // Sequence number and scheduled time (local us) of the last sample
+  uint32_t getLastSequence() { return clock.getSequence() - 1; }
+  uint64_t getLastSampleTime() { return clock.getLastSampleTime(); }
+  
+  // Sample clock (drift correction, epoch conversion)
+  SampleClock& getClock() { return clock; }
 };
+
+#endif // ECG_SENSOR_H
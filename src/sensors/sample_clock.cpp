@@ -0,0 +1,215 @@
+/*
+ * Sample Clock Class Implementation
+ * 
+ * Deadlines are kept in 16.16 fixed point so rates that do not divide
+ * 1 s evenly and fractional drift corrections do not accumulate error.
+ */
+
+#include "sample_clock.h"
+#include "../config/config.h"
+
+SampleClock::SampleClock() {
+  lastMicros = 0;
+  microsHigh = 0;
+  sampleRate = SAMPLE_RATE;
+  nominalInterval = SAMPLE_INTERVAL;
+  intervalFixed = (uint64_t)SAMPLE_INTERVAL << 16;
+  nextDeadline = 0;
+  sequence = 0;
+  lastSampleTime = 0;
+  missedSamples = 0;
+  epochCount = 0;
+  newestEpoch = 0;
+  synchronized = false;
+  referenceLocal = 0;
+  referenceEpoch = 0;
+  anchorLocal = 0;
+  anchorEpoch = 0;
+  driftPpm = 0;
+  driftMeasured = false;
+  rejectedReferences = 0;
+  postedVersion = 0;
+  appliedVersion = 0;
+  postedMicros = 0;
+  postedEpoch = 0;
+}
+
+void SampleClock::begin(int sampleRate) {
+  sequence = 0;
+  missedSamples = 0;
+  epochCount = 0;
+  setSampleRate(sampleRate);
+}
+
+void SampleClock::setSampleRate(int sampleRate) {
+  if (sampleRate <= 0) return;
+  
+  this->sampleRate = sampleRate;
+  nominalInterval = 1000000UL / sampleRate;
+  updateInterval();
+  restart();
+}
+
+void SampleClock::restart() {
+  nextDeadline = now() << 16;
+  startEpoch();
+}
+
+uint64_t SampleClock::now() {
+  uint32_t current = micros();
+  
+  // micros() wraps every ~71 minutes
+  if (current < lastMicros) {
+    microsHigh += (uint64_t)1 << 32;
+  }
+  lastMicros = current;
+  
+  return microsHigh | current;
+}
+
+bool SampleClock::isSampleDue() {
+  return (now() << 16) >= nextDeadline;
+}
+
+uint32_t SampleClock::takeSample() {
+  uint64_t current = now() << 16;
+  
+  // Far behind schedule (e.g. a blocking call) - skip ahead, keep the grid
+  if (current > nextDeadline + MAX_SAMPLE_LATENESS * intervalFixed) {
+    uint32_t skipped = (current - nextDeadline) / intervalFixed;
+    nextDeadline += skipped * intervalFixed;
+    sequence += skipped;
+    missedSamples += skipped;
+  }
+  
+  lastSampleTime = nextDeadline >> 16;
+  nextDeadline += intervalFixed;
+  
+  return sequence++;
+}
+
+uint64_t SampleClock::getSampleTime(uint32_t sequence) {
+  const ClockEpoch* epoch = findEpoch(sequence);
+  if (epoch == NULL) {
+    uint32_t samplesBack = (this->sequence - 1) - sequence;
+    return lastSampleTime - ((samplesBack * intervalFixed) >> 16);
+  }
+  
+  uint32_t offset = sequence - epoch->firstSequence;
+  if (offset < this->sequence - epoch->firstSequence) {
+    return (epoch->firstDeadline + offset * epoch->intervalFixed) >> 16;
+  }
+  
+  // Older than the oldest epoch: extend it back
+  uint32_t samplesBack = epoch->firstSequence - sequence;
+  return (epoch->firstDeadline - samplesBack * epoch->intervalFixed) >> 16;
+}
+
+int SampleClock::getSampleRate(uint32_t sequence) {
+  const ClockEpoch* epoch = findEpoch(sequence);
+  return epoch != NULL ? epoch->sampleRate : sampleRate;
+}
+
+const ClockEpoch* SampleClock::findEpoch(uint32_t sequence) {
+  if (epochCount == 0) return NULL;
+  
+  // Newest first; an epoch holds the sequences taken since it started
+  int index = newestEpoch;
+  for (int i = 0; i < epochCount; i++) {
+    const ClockEpoch& epoch = epochs[index];
+    if (sequence - epoch.firstSequence < this->sequence - epoch.firstSequence) return &epoch;
+    if (i + 1 < epochCount) index = (index + SAMPLE_CLOCK_EPOCHS - 1) % SAMPLE_CLOCK_EPOCHS;
+  }
+  return &epochs[index];
+}
+
+void SampleClock::updateInterval() {
+  // Exact interval in fixed point (1 s / 360 Hz does not truncate);
+  // local ticks per true microsecond is (1 + drift)
+  uint64_t trueInterval = ((uint64_t)1000000 << 16) / sampleRate;
+  intervalFixed = trueInterval + (int64_t)(trueInterval * (double)driftPpm / 1e6);
+  startEpoch();
+}
+
+void SampleClock::startEpoch() {
+  // The next sample is the first on the new grid; a change before any
+  // sample was taken on the newest epoch replaces it
+  if (epochCount == 0 || epochs[newestEpoch].firstSequence != sequence) {
+    newestEpoch = (newestEpoch + 1) % SAMPLE_CLOCK_EPOCHS;
+    if (epochCount < SAMPLE_CLOCK_EPOCHS) epochCount++;
+  }
+  
+  ClockEpoch& epoch = epochs[newestEpoch];
+  epoch.firstSequence = sequence;
+  epoch.firstDeadline = nextDeadline;
+  epoch.intervalFixed = intervalFixed;
+  epoch.sampleRate = sampleRate;
+}
+
+void SampleClock::addReference(uint64_t localTime, int64_t epochTime) {
+  if (!synchronized) {
+    anchorLocal = localTime;
+    anchorEpoch = epochTime;
+    synchronized = true;
+  } else if (localTime - anchorLocal >= MIN_DRIFT_MEASUREMENT_SPAN * 1000ULL) {
+    // Compare elapsed local time with elapsed reference time since the
+    // anchor; the span keeps reference jitter small against the drift
+    double localSpan = (double)(localTime - anchorLocal);
+    double referenceSpan = (double)(epochTime - anchorEpoch);
+    float measured = (localSpan - referenceSpan) / referenceSpan * 1e6;
+    
+    if (fabs(measured) <= MAX_CLOCK_DRIFT_PPM) {
+      driftPpm = driftMeasured ? driftPpm + DRIFT_SMOOTHING * (measured - driftPpm) : measured;
+      driftMeasured = true;
+      updateInterval();
+      
+      if (ENABLE_DEBUG_MESSAGES) {
+        Serial.print("Sample clock drift: ");
+        Serial.print(driftPpm);
+        Serial.println(" ppm");
+      }
+    } else {
+      rejectedReferences++;
+      Serial.println("Sample clock: reference rejected (drift out of range)");
+    }
+    
+    anchorLocal = localTime;
+    anchorEpoch = epochTime;
+  }
+  
+  referenceLocal = localTime;
+  referenceEpoch = epochTime;
+}
+
+void SampleClock::postReference(uint32_t localMicros, int64_t epochTime) {
+  uint32_t version = __atomic_load_n(&postedVersion, __ATOMIC_RELAXED);
+  __atomic_store_n(&postedVersion, version + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  postedMicros = localMicros;
+  postedEpoch = epochTime;
+  __atomic_store_n(&postedVersion, version + 2, __ATOMIC_RELEASE);
+}
+
+bool SampleClock::applyPostedReference() {
+  uint32_t version = __atomic_load_n(&postedVersion, __ATOMIC_ACQUIRE);
+  if (version == appliedVersion || (version & 1) != 0) return false;
+  
+  uint32_t localMicros = postedMicros;
+  int64_t epochTime = postedEpoch;
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (__atomic_load_n(&postedVersion, __ATOMIC_RELAXED) != version) return false;  // Posted again meanwhile
+  appliedVersion = version;
+  
+  // Extend the 32-bit reading back from the current 64-bit time
+  uint64_t current = now();
+  addReference(current - (uint32_t)((uint32_t)current - localMicros), epochTime);
+  return true;
+}
+
+int64_t SampleClock::toEpoch(uint64_t localTime) {
+  if (!synchronized) return 0;
+  
+  // Scale local elapsed time back to reference time
+  double elapsed = (double)((int64_t)(localTime - referenceLocal));
+  return referenceEpoch + (int64_t)(elapsed / (1 + driftPpm / 1e6));
+}
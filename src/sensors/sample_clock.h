@@ -0,0 +1,130 @@
+/*
+ * Sample Clock Class Header
+ * 
+ * Monotonic sample clock with sequence numbers. Samples are scheduled
+ * against absolute deadlines (deadline += interval), so read latency never
+ * accumulates into rate drift. The local crystal's drift is measured
+ * between time references - SNTP sync events or host-provided times -
+ * and corrected in both the sample interval and the epoch timestamps.
+ * References must be true time: the system clock between SNTP syncs runs
+ * on the same crystal and shows no drift.
+ * 
+ * Every change of the grid (rate switch, restart, drift correction) starts
+ * an epoch at the next sequence. The last SAMPLE_CLOCK_EPOCHS are kept, so
+ * the time of an earlier sample is computed on the grid it was taken on.
+ */
+
+#ifndef SAMPLE_CLOCK_H
+#define SAMPLE_CLOCK_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+// Samples on one grid: sample n of the epoch is due at
+// firstDeadline + n * intervalFixed
+struct ClockEpoch {
+  uint32_t firstSequence;
+  uint64_t firstDeadline;       // 16.16 fixed point, local clock
+  uint64_t intervalFixed;
+  int sampleRate;
+};
+
+class SampleClock {
+private:
+  // 64-bit extension of micros()
+  uint32_t lastMicros;
+  uint64_t microsHigh;
+  
+  // Scheduling (16.16 fixed point microseconds, local clock)
+  uint64_t nextDeadline;
+  uint64_t intervalFixed;
+  unsigned long nominalInterval;
+  int sampleRate;
+  
+  // Last sample
+  uint32_t sequence;
+  uint64_t lastSampleTime;
+  unsigned long missedSamples;
+  
+  // Grid history (ring, newest at newestEpoch)
+  ClockEpoch epochs[SAMPLE_CLOCK_EPOCHS];
+  int epochCount;
+  int newestEpoch;
+  
+  // Reference synchronization
+  bool synchronized;
+  uint64_t referenceLocal;      // Local time of last reference point (us)
+  int64_t referenceEpoch;       // Reference epoch time at that point (us)
+  uint64_t anchorLocal;         // Older reference point used to measure drift
+  int64_t anchorEpoch;
+  float driftPpm;               // Local clock rate error (+ = local runs fast)
+  bool driftMeasured;           // First measurement replaces the initial 0
+  unsigned long rejectedReferences;
+  
+  // Reference handed over by another task (seqlock: odd while written)
+  uint32_t postedVersion;
+  uint32_t appliedVersion;
+  uint32_t postedMicros;
+  int64_t postedEpoch;
+  
+  // Internal methods
+  void updateInterval();
+  void startEpoch();
+  const ClockEpoch* findEpoch(uint32_t sequence);
+  
+public:
+  // Constructor
+  SampleClock();
+  
+  // Set sampling rate (Hz) and restart scheduling from now
+  void begin(int sampleRate);
+  
+  // Change the sampling rate keeping the sequence
+  void setSampleRate(int sampleRate);
+  
+  // Restart scheduling from the current time
+  void restart();
+  
+  // Monotonic 64-bit local time in microseconds
+  uint64_t now();
+  
+  // Check if the next sample deadline has passed
+  bool isSampleDue();
+  
+  // Claim the due sample; returns its sequence number
+  uint32_t takeSample();
+  
+  // Add a reference point (epoch microseconds measured at local time)
+  void addReference(uint64_t localTime, int64_t epochTime);
+  
+  // Hand over a reference point from another task (the SNTP sync callback);
+  // localMicros is micros() when epochTime was valid
+  void postReference(uint32_t localMicros, int64_t epochTime);
+  
+  // Add the last posted reference point, if it is new; call from the task
+  // that takes samples
+  bool applyPostedReference();
+  
+  // Scheduled local time of an earlier sample, on the grid it was taken on
+  // (samples older than the kept epochs extend the oldest one back)
+  uint64_t getSampleTime(uint32_t sequence);
+  
+  // Sampling rate an earlier sample was taken at
+  int getSampleRate(uint32_t sequence);
+  
+  // Convert local time to epoch microseconds (0 if not synchronized)
+  int64_t toEpoch(uint64_t localTime);
+  
+  // Getters
+  uint32_t getSequence() { return sequence; }
+  uint64_t getLastSampleTime() { return lastSampleTime; }
+  uint64_t getNextDeadline() { return (nextDeadline + 0xFFFF) >> 16; }  // First us it is due
+  unsigned long getMissedSamples() { return missedSamples; }
+  unsigned long getSampleInterval() { return nominalInterval; }
+  int getSampleRate() { return sampleRate; }
+  bool isSynchronized() { return synchronized; }
+  float getDriftPpm() { return driftPpm; }
+  unsigned long getRejectedReferences() { return rejectedReferences; }
+};
+
+#endif // SAMPLE_CLOCK_H
@@ -0,0 +1,191 @@
+/*
+ * ECG Simulator Class Implementation
+ * 
+ * Reference: P. E. McSharry et al., "A dynamical model for generating
+ * synthetic electrocardiogram signals", IEEE Trans. Biomed. Eng., 2003.
+ * Wave parameters and heart-rate scaling follow the ECGSYN defaults.
+ */
+
+#include "ecg_simulator.h"
+#include "../config/config.h"
+
+// P, Q, R, S, T: angle (rad), amplitude (mV), width (rad)
+static const float WAVE_ANGLES[5] = { -PI / 3, -PI / 12, 0, PI / 12, PI / 2 };
+static const float WAVE_AMPLITUDES[5] = { 0.12, -0.15, 1.0, -0.25, 0.3 };
+static const float WAVE_WIDTHS[5] = { 0.25, 0.1, 0.1, 0.1, 0.4 };
+
+// Premature beat after this fraction of the mean RR interval
+static const float ECTOPIC_COUPLING = 0.65;
+
+ECGSimulator::ECGSimulator() {
+  getDefaults(params);
+  begin(params);
+}
+
+void ECGSimulator::getDefaults(ECGSimulatorParams& params) {
+  params.sampleRate = SAMPLE_RATE;
+  params.heartRate = 72;
+  params.hrvStd = 25;
+  params.amplitude = 800;
+  params.offset = 1800;
+  params.noiseStd = 5;
+  params.baselineWanderAmplitude = 0;
+  params.baselineWanderFrequency = 0.25;
+  params.mainsAmplitude = 0;
+  params.mainsFrequency = 50;
+  params.leadOffPeriod = 0;
+  params.leadOffDuration = 0;
+  params.artifactPeriod = 0;
+  params.artifactDuration = 0;
+  params.artifactAmplitude = 600;
+  params.ectopicRate = 0;
+  params.droppedBeatRate = 0;
+  params.seed = 1;
+}
+
+bool ECGSimulator::begin(const ECGSimulatorParams& params) {
+  if (params.sampleRate <= 0 || params.heartRate <= 0) {
+    Serial.println("ERROR: invalid ECG simulator parameters");
+    return false;
+  }
+  
+  this->params = params;
+  
+  // ECGSYN scaling: QRS keeps its width, P and T move with the RR interval
+  float hrFactor = sqrt(params.heartRate / 60.0);
+  float hrFactor2 = sqrt(hrFactor);
+  float angleScale[5] = { hrFactor2, hrFactor, 1, hrFactor, hrFactor2 };
+  
+  for (int i = 0; i < 5; i++) {
+    waveAngles[i] = WAVE_ANGLES[i] * angleScale[i];
+    waveWidths[i] = WAVE_WIDTHS[i] * hrFactor;
+  }
+  
+  randomState = params.seed != 0 ? params.seed : 1;
+  phase = -PI;
+  sampleIndex = 0;
+  beatCount = 0;
+  beatOnset = false;
+  leadsConnected = true;
+  inArtifact = false;
+  ectopicStage = 0;
+  beatDropped = false;
+  drawNextRR();
+  
+  return true;
+}
+
+int ECGSimulator::nextSample() {
+  float dt = 1.0 / params.sampleRate;
+  float t = sampleIndex * dt;
+  
+  // Advance the beat phase, drawing a new RR interval on wrap-around
+  float previousPhase = phase;
+  phase += 2 * PI * dt / currentRR;
+  if (phase >= PI) {
+    phase -= 2 * PI;
+    previousPhase -= 2 * PI;
+    drawNextRR();
+    beatDropped = params.droppedBeatRate > 0 && nextUniform() < params.droppedBeatRate;
+  }
+  
+  beatOnset = (previousPhase < 0 && phase >= 0);
+  if (beatOnset) {
+    beatCount++;
+    updateEctopic();
+  }
+  
+  // Sum of Gaussian PQRST events (mV); a dropped beat keeps only P and T
+  float millivolts = 0;
+  for (int i = 0; i < 5; i++) {
+    if (beatDropped && i >= 1 && i <= 3) continue;
+    float delta = phase - waveAngles[i];
+    millivolts += WAVE_AMPLITUDES[i] * exp(-delta * delta / (2 * waveWidths[i] * waveWidths[i]));
+  }
+  
+  float value = params.offset + params.amplitude * millivolts;
+  
+  // Interference
+  if (params.baselineWanderAmplitude > 0) {
+    value += params.baselineWanderAmplitude * sin(2 * PI * params.baselineWanderFrequency * t);
+  }
+  if (params.mainsAmplitude > 0) {
+    value += params.mainsAmplitude * sin(2 * PI * params.mainsFrequency * t);
+  }
+  if (params.noiseStd > 0) {
+    value += params.noiseStd * nextGaussian();
+  }
+  
+  // Motion artifacts mid-period: electrode swings plus muscle noise
+  inArtifact = false;
+  if (params.artifactPeriod > 0) {
+    unsigned long ms = (unsigned long)(t * 1000) % params.artifactPeriod;
+    unsigned long start = params.artifactPeriod / 2;
+    if (ms >= start && ms < start + params.artifactDuration) {
+      inArtifact = true;
+      value += params.artifactAmplitude * (sin(2 * PI * 1.3 * t) + 0.5 * sin(2 * PI * 3.7 * t));
+      value += 0.25 * params.artifactAmplitude * nextGaussian();
+    }
+  }
+  
+  // Lead-off gaps: AD8232 output rails while electrodes are off
+  leadsConnected = true;
+  if (params.leadOffPeriod > 0) {
+    unsigned long ms = (unsigned long)(t * 1000) % params.leadOffPeriod;
+    if (ms >= params.leadOffPeriod - params.leadOffDuration) {
+      leadsConnected = false;
+      value = ADC_MAX_VALUE;
+    }
+  }
+  
+  sampleIndex++;
+  
+  return constrain((int)(value + 0.5), 0, ADC_MAX_VALUE);
+}
+
+void ECGSimulator::drawNextRR() {
+  // An ectopic sequence sets the interval itself at each R-peak
+  if (ectopicStage != 0) return;
+  
+  float meanRR = 60.0 / params.heartRate;
+  float rr = meanRR + params.hrvStd / 1000.0 * nextGaussian();
+  
+  // Keep HRV from producing impossible intervals
+  currentRR = constrain(rr, 0.5 * meanRR, 1.5 * meanRR);
+}
+
+void ECGSimulator::updateEctopic() {
+  // The phase runs half an interval on each side of an R-peak, so the
+  // R-to-R interval is set here and carried through the next wrap-around
+  float meanRR = 60.0 / params.heartRate;
+  
+  if (ectopicStage == 0) {
+    if (params.ectopicRate > 0 && nextUniform() < params.ectopicRate) {
+      currentRR = ECTOPIC_COUPLING * meanRR;
+      ectopicStage = 1;
+    }
+  } else if (ectopicStage == 1) {
+    // Full compensatory pause: the next beat is back on the sinus rhythm
+    currentRR = (2 - ECTOPIC_COUPLING) * meanRR;
+    ectopicStage = 2;
+  } else {
+    currentRR = meanRR;
+    ectopicStage = 0;
+  }
+}
+
+float ECGSimulator::nextUniform() {
+  // xorshift32 - deterministic across platforms
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return (randomState >> 8) * (1.0 / 16777216.0);
+}
+
+float ECGSimulator::nextGaussian() {
+  // Box-Muller transform
+  float u1 = nextUniform();
+  float u2 = nextUniform();
+  if (u1 < 1e-7) u1 = 1e-7;
+  return sqrt(-2 * log(u1)) * cos(2 * PI * u2);
+}
@@ -0,0 +1,97 @@
+/*
+ * ECG Simulator Class Header
+ * 
+ * Parametric synthetic ECG source modelled after McSharry's ECGSYN:
+ * PQRST waves are Gaussian events on a phase that advances once per
+ * RR interval. Supports heart rate variability, white noise, baseline
+ * wander, mains hum, periodic lead-off gaps and motion artifacts, plus
+ * ectopic beats and beats without a QRS complex to test rhythm analysis.
+ * Output is in ADC counts; as an ECGFrontEnd it replaces the AD8232 behind
+ * ECGSensor for demos and reproducible runs.
+ */
+
+#ifndef ECG_SIMULATOR_H
+#define ECG_SIMULATOR_H
+
+#include <Arduino.h>
+#include "../sensors/ecg_front_end.h"
+
+struct ECGSimulatorParams {
+  int sampleRate;                  // Hz
+  float heartRate;                 // Mean heart rate (BPM)
+  float hrvStd;                    // RR interval standard deviation (ms)
+  float amplitude;                 // ADC counts per mV
+  float offset;                    // Isoelectric level (ADC counts)
+  float noiseStd;                  // White noise standard deviation (ADC counts)
+  float baselineWanderAmplitude;   // ADC counts
+  float baselineWanderFrequency;   // Hz (respiration, ~0.25 Hz)
+  float mainsAmplitude;            // ADC counts
+  float mainsFrequency;            // Hz (50 or 60)
+  unsigned long leadOffPeriod;     // ms between lead-off gaps (0 = never)
+  unsigned long leadOffDuration;   // ms per lead-off gap
+  unsigned long artifactPeriod;    // ms between motion artifact episodes (0 = never)
+  unsigned long artifactDuration;  // ms per episode
+  float artifactAmplitude;         // Electrode motion swing (ADC counts)
+  float ectopicRate;               // Fraction of beats that are premature (with compensatory pause)
+  float droppedBeatRate;           // Fraction of beats without a QRS complex
+  uint32_t seed;                   // Random seed (same seed = same signal)
+};
+
+class ECGSimulator : public ECGFrontEnd {
+private:
+  ECGSimulatorParams params;
+  
+  // Wave morphology (scaled for the mean heart rate)
+  float waveAngles[5];
+  float waveWidths[5];
+  
+  // Generator state
+  float phase;                     // Beat phase (-PI..PI, R-peak at 0)
+  float currentRR;                 // Current RR interval (seconds)
+  unsigned long sampleIndex;
+  unsigned long beatCount;
+  bool beatOnset;
+  bool leadsConnected;
+  bool inArtifact;
+  int ectopicStage;                // 0 normal, 1 premature beat due, 2 compensatory pause
+  bool beatDropped;                // QRS left out of the current cycle
+  uint32_t randomState;
+  
+  // Internal methods
+  float nextUniform();
+  float nextGaussian();
+  void drawNextRR();
+  void updateEctopic();
+  
+public:
+  // Constructor
+  ECGSimulator();
+  
+  // Fill params with a clean 72 BPM signal at SAMPLE_RATE
+  static void getDefaults(ECGSimulatorParams& params);
+  
+  // Initialize (or restart) the generator
+  bool begin(const ECGSimulatorParams& params);
+  
+  // Generate the next sample (ADC counts, 0-4095)
+  int nextSample();
+  
+  // Simulated lead-off state for the last sample
+  bool areLeadsConnected() { return leadsConnected; }
+  
+  // ECGFrontEnd: the next sample
+  int readSample() { return nextSample(); }
+  
+  // True if the last sample was inside a simulated artifact episode
+  bool isArtifact() { return inArtifact; }
+  
+  // True if the last sample contained an R-peak (reference annotation;
+  // also set for dropped beats, which keep the rhythm)
+  bool isBeatOnset() { return beatOnset; }
+  
+  // Getters
+  unsigned long getBeatCount() { return beatCount; }
+  unsigned long getSampleIndex() { return sampleIndex; }
+};
+
+#endif // ECG_SIMULATOR_H
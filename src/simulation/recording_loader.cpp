@@ -0,0 +1,101 @@
+/*
+ * Recording Loader Class Implementation
+ */
+
+#include "recording_loader.h"
+#include "../config/config.h"
+
+RecordingLoader::RecordingLoader() {
+  file = NULL;
+  sampleRate = SAMPLE_RATE;
+  scale = 1.0;
+  offset = 0;
+  sampleCount = 0;
+  annotationCount = 0;
+  lastAnnotation = '\0';
+}
+
+RecordingLoader::~RecordingLoader() {
+  close();
+}
+
+bool RecordingLoader::open(const char* path) {
+  close();
+  
+  file = fopen(path, "r");
+  if (file == NULL) {
+    Serial.print("ERROR: cannot open recording ");
+    Serial.println(path);
+    return false;
+  }
+  
+  sampleRate = SAMPLE_RATE;
+  scale = 1.0;
+  offset = 0;
+  sampleCount = 0;
+  annotationCount = 0;
+  lastAnnotation = '\0';
+  
+  // Header lines are read up front so getSampleRate() is valid after open()
+  int c;
+  while ((c = fgetc(file)) == '#') {
+    char line[128];
+    if (fgets(line, sizeof(line), file) == NULL) break;
+    parseHeader(line);
+  }
+  if (c != EOF) {
+    ungetc(c, file);
+  }
+  
+  return true;
+}
+
+void RecordingLoader::parseHeader(const char* line) {
+  const char* field;
+  
+  if ((field = strstr(line, "sampleRate=")) != NULL) {
+    sampleRate = atoi(field + 11);
+  }
+  if ((field = strstr(line, "scale=")) != NULL) {
+    scale = atof(field + 6);
+  }
+  if ((field = strstr(line, "offset=")) != NULL) {
+    offset = atof(field + 7);
+  }
+}
+
+bool RecordingLoader::nextSample(int& value) {
+  if (file == NULL) return false;
+  
+  char line[64];
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+    
+    char* end;
+    float stored = strtod(line, &end);
+    if (end == line) continue;  // Not a number
+    
+    // Optional annotation column
+    lastAnnotation = '\0';
+    if (*end == ',') {
+      char symbol = end[1];
+      if (symbol != '\0' && symbol != '\n' && symbol != '\r') {
+        lastAnnotation = symbol;
+        annotationCount++;
+      }
+    }
+    
+    value = constrain((int)(stored * scale + offset + 0.5), 0, ADC_MAX_VALUE);
+    sampleCount++;
+    return true;
+  }
+  
+  return false;
+}
+
+void RecordingLoader::close() {
+  if (file != NULL) {
+    fclose(file);
+    file = NULL;
+  }
+}
@@ -0,0 +1,62 @@
+/*
+ * Recording Loader Class Header
+ * 
+ * Replays annotated ECG recordings stored locally (SPIFFS/SD mounted via
+ * VFS on the ESP32, or a regular file on the host). Recordings are plain
+ * text, one sample per line:
+ * 
+ *   # sampleRate=360
+ *   # scale=1.0 offset=0
+ *   1024
+ *   1030,N
+ * 
+ * The optional second column holds a beat annotation symbol (MIT-BIH
+ * style: N, V, A, ...) at the R-peak sample. Records from PhysioNet can
+ * be exported to this format with rdsamp/rdann.
+ */
+
+#ifndef RECORDING_LOADER_H
+#define RECORDING_LOADER_H
+
+#include <Arduino.h>
+#include <stdio.h>
+
+class RecordingLoader {
+private:
+  FILE* file;
+  int sampleRate;
+  float scale;                  // Multiplier applied to stored values
+  float offset;                 // Added after scaling (ADC counts)
+  unsigned long sampleCount;
+  unsigned long annotationCount;
+  char lastAnnotation;
+  
+  // Internal methods
+  void parseHeader(const char* line);
+  
+public:
+  // Constructor
+  RecordingLoader();
+  ~RecordingLoader();
+  
+  // Open a recording file
+  bool open(const char* path);
+  
+  // Read the next sample; returns false at end of file
+  bool nextSample(int& value);
+  
+  // Annotation of the last sample ('\0' if none)
+  char getAnnotation() { return lastAnnotation; }
+  bool isBeatAnnotated() { return lastAnnotation != '\0'; }
+  
+  // Close the file
+  void close();
+  
+  // Getters
+  bool isOpen() { return file != NULL; }
+  int getSampleRate() { return sampleRate; }
+  unsigned long getSampleCount() { return sampleCount; }
+  unsigned long getAnnotationCount() { return annotationCount; }
+};
+
+#endif // RECORDING_LOADER_H
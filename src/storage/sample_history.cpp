@@ -0,0 +1,195 @@
+/*
+ * Sample History Class Implementation
+ * 
+ * A slot is written before nextSequence is published, so any sequence
+ * in [oldest, nextSequence) holds complete data.
+ */
+
+#include "sample_history.h"
+#include "../config/config.h"
+
+static size_t roundDownToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result <= value / 2) result *= 2;
+  return result;
+}
+
+SampleHistory::SampleHistory() {
+  buffer = NULL;
+  capacity = 0;
+  nextSequence = 0;
+  firstSequence = 0;
+  started = false;
+  lapped = false;
+  inPsram = false;
+  ownsBuffer = false;
+}
+
+SampleHistory::~SampleHistory() {
+  if (ownsBuffer) free(buffer);
+}
+
+bool SampleHistory::begin(size_t capacity) {
+  if (ownsBuffer) free(buffer);
+  buffer = NULL;
+  inPsram = false;
+  ownsBuffer = false;
+  
+  if (capacity == 0) {
+    Serial.println("ERROR: no storage for sample history");
+    this->capacity = 0;
+    return false;
+  }
+  size_t rounded = roundDownToPowerOfTwo(capacity);
+  if (rounded < capacity) rounded *= 2;
+  capacity = rounded;
+  
+#if defined(ESP32)
+  if (psramFound()) {
+    buffer = (int16_t*)ps_malloc(capacity * sizeof(int16_t));
+    inPsram = (buffer != NULL);
+  }
+#endif
+  
+  if (buffer == NULL) {
+    buffer = (int16_t*)malloc(capacity * sizeof(int16_t));
+  }
+  
+  if (buffer == NULL) {
+    Serial.println("ERROR: cannot allocate sample history");
+    this->capacity = 0;
+    return false;
+  }
+  
+  ownsBuffer = true;
+  this->capacity = capacity;
+  started = false;
+  lapped = false;
+  nextSequence = 0;
+  
+  Serial.print("Sample history: ");
+  Serial.print((unsigned long)capacity);
+  Serial.println(inPsram ? " samples in PSRAM" : " samples in heap");
+  
+  return true;
+}
+
+bool SampleHistory::begin(int16_t* storage, size_t capacity) {
+  if (ownsBuffer) free(buffer);
+  ownsBuffer = false;
+  inPsram = false;
+  buffer = storage;
+  
+  if (buffer == NULL || capacity == 0) {
+    Serial.println("ERROR: no storage for sample history");
+    buffer = NULL;
+    this->capacity = 0;
+    return false;
+  }
+  
+  this->capacity = roundDownToPowerOfTwo(capacity);
+  started = false;
+  lapped = false;
+  nextSequence = 0;
+  
+  Serial.print("Sample history: ");
+  Serial.print((unsigned long)this->capacity);
+  Serial.println(" samples in arena");
+  
+  return true;
+}
+
+void SampleHistory::append(int16_t value, uint32_t sequence) {
+  if (buffer == NULL) return;
+  
+  uint32_t next = nextSequence;
+  
+  // First sample, or sequence went backwards (clock restarted) - start fresh
+  if (!started || (int32_t)(sequence - next) < 0) {
+    next = sequence;
+    firstSequence = sequence;
+    __atomic_store_n(&lapped, false, __ATOMIC_RELAXED);
+    started = true;
+  }
+  
+  // Mark missed samples, at most one full lap
+  uint32_t gap = sequence - next;
+  if (gap > capacity) {
+    next = sequence - capacity;
+  }
+  while (next != sequence) {
+    writeSlot(next, SAMPLE_GAP);
+    next++;
+  }
+  
+  writeSlot(sequence, value);
+}
+
+void SampleHistory::writeSlot(uint32_t sequence, int16_t value) {
+  // Once past the first lap, firstSequence no longer bounds the data (and
+  // sequence - firstSequence would wrap after 2^32 samples)
+  if (!lapped && sequence - firstSequence >= capacity - 1) {
+    __atomic_store_n(&lapped, true, __ATOMIC_RELEASE);
+  }
+  
+  // The published nextSequence already excludes this slot from readers;
+  // keep the store from moving ahead of that publication
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  buffer[sequence & (capacity - 1)] = value;
+  __atomic_store_n(&nextSequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t SampleHistory::getNextSequence() {
+  return __atomic_load_n(&nextSequence, __ATOMIC_ACQUIRE);
+}
+
+uint32_t SampleHistory::getOldestSequence() {
+  // The slot the writer fills next aliases the oldest one, so it is excluded
+  uint32_t next = getNextSequence();
+  uint32_t oldest = next - capacity + 1;
+  
+  // Not lapped yet - everything since the first sample is available
+  if (!__atomic_load_n(&lapped, __ATOMIC_ACQUIRE) && next - firstSequence < capacity) {
+    oldest = firstSequence;
+  }
+  return oldest;
+}
+
+bool SampleHistory::snapshot(uint32_t fromSequence, uint32_t toSequence, SampleSnapshot& snapshot) {
+  snapshot.firstSequence = fromSequence;
+  snapshot.count = 0;
+  snapshot.segments[0].data = NULL;
+  snapshot.segments[0].count = 0;
+  snapshot.segments[1].data = NULL;
+  snapshot.segments[1].count = 0;
+  
+  if (buffer == NULL || !started) return false;
+  
+  uint32_t oldest = getOldestSequence();
+  uint32_t next = getNextSequence();
+  
+  if ((int32_t)(fromSequence - oldest) < 0) fromSequence = oldest;
+  if ((int32_t)(toSequence - next) > 0) toSequence = next;
+  if ((int32_t)(toSequence - fromSequence) <= 0) return false;
+  
+  size_t count = toSequence - fromSequence;
+  size_t start = fromSequence & (capacity - 1);
+  size_t firstCount = min(count, capacity - start);
+  
+  snapshot.firstSequence = fromSequence;
+  snapshot.count = count;
+  snapshot.segments[0].data = buffer + start;
+  snapshot.segments[0].count = firstCount;
+  if (firstCount < count) {
+    snapshot.segments[1].data = buffer;
+    snapshot.segments[1].count = count - firstCount;
+  }
+  
+  return true;
+}
+
+bool SampleHistory::isValid(uint32_t firstSequence) {
+  // The reader's loads from the ring must complete before the check
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return (int32_t)(firstSequence - getOldestSequence()) >= 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Sample History Class Header
+ * 
+ * Large circular history of raw samples indexed by sequence number,
+ * allocated in PSRAM when available. Readers take zero-copy snapshots:
+ * a sequence range is returned as at most two contiguous spans pointing
+ * into the ring. The writer never waits for readers; instead a reader
+ * checks with isValid() after consuming data that the writer has not
+ * lapped it in the meantime.
+ * 
+ * The capacity is a power of two, so a sequence's slot (sequence modulo
+ * capacity) stays continuous when the 32-bit sequence number wraps.
+ */
+
+#ifndef SAMPLE_HISTORY_H
+#define SAMPLE_HISTORY_H
+
+#include <Arduino.h>
+
+struct SampleSpan {
+  const int16_t* data;
+  size_t count;
+};
+
+struct SampleSnapshot {
+  uint32_t firstSequence;
+  size_t count;
+  SampleSpan segments[2];   // Second segment is empty unless the range wraps
+};
+
+class SampleHistory {
+private:
+  int16_t* buffer;
+  size_t capacity;
+  uint32_t nextSequence;    // Published with release semantics
+  uint32_t firstSequence;   // First sequence written since begin()
+  bool started;
+  bool lapped;              // Writer has gone round the ring at least once
+  bool inPsram;
+  bool ownsBuffer;
+  
+  // Store one slot and publish it
+  void writeSlot(uint32_t sequence, int16_t value);
+  
+public:
+  // Constructor
+  SampleHistory();
+  ~SampleHistory();
+  
+  // Allocate room for at least the given number of samples (rounded up
+  // to a power of two, PSRAM preferred)
+  bool begin(size_t capacity);
+  
+  // Use caller-provided storage instead (e.g. a memory arena); only the
+  // largest power of two that fits is used
+  bool begin(int16_t* storage, size_t capacity);
+  
+  // Store a sample; skipped sequence numbers are filled with SAMPLE_GAP
+  void append(int16_t value, uint32_t sequence);
+  
+  // Snapshot [fromSequence, toSequence), clamped to what is available.
+  // Returns false if nothing in the range is available.
+  bool snapshot(uint32_t fromSequence, uint32_t toSequence, SampleSnapshot& snapshot);
+  
+  // Check that samples from firstSequence on have not been overwritten
+  bool isValid(uint32_t firstSequence);
+  
+  // Getters
+  uint32_t getNextSequence();
+  uint32_t getOldestSequence();
+  size_t getCapacity() { return capacity; }
+  bool isInPsram() { return inPsram; }
+};
+
+#endif // SAMPLE_HISTORY_H
@@ -0,0 +1,34 @@
+/*
+ * Beat Indicator Class Implementation
+ */
+
+#include "beat_indicator.h"
+#include "../config/config.h"
+
+BeatIndicator::BeatIndicator(int pin) {
+  this->pin = pin;
+  this->lit = false;
+  this->litSince = 0;
+}
+
+void BeatIndicator::begin() {
+  pinMode(pin, OUTPUT);
+  off();
+}
+
+void BeatIndicator::pulse() {
+  digitalWrite(pin, HIGH);
+  lit = true;
+  litSince = millis();
+}
+
+void BeatIndicator::off() {
+  digitalWrite(pin, LOW);
+  lit = false;
+}
+
+void BeatIndicator::update() {
+  if (lit && millis() - litSince >= BEAT_LED_PULSE_MS) {
+    off();
+  }
+}
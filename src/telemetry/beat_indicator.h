@@ -0,0 +1,37 @@
+/*
+ * Beat Indicator Class Header
+ * 
+ * Flashes an LED on each detected beat without blocking: pulse() turns it
+ * on and update(), called from loop(), turns it off after
+ * BEAT_LED_PULSE_MS. Sampling carries on while the LED is lit.
+ */
+
+#ifndef BEAT_INDICATOR_H
+#define BEAT_INDICATOR_H
+
+#include <Arduino.h>
+
+class BeatIndicator {
+private:
+  int pin;
+  bool lit;
+  unsigned long litSince;
+  
+public:
+  // Constructor
+  BeatIndicator(int pin);
+  
+  // Configure the pin (LED off)
+  void begin();
+  
+  // Light the LED for one beat
+  void pulse();
+  
+  // Turn the LED off now
+  void off();
+  
+  // End the pulse once it has lasted BEAT_LED_PULSE_MS
+  void update();
+};
+
+#endif // BEAT_INDICATOR_H
@@ -0,0 +1,41 @@
+/*
+ * Boot Profile Class Implementation
+ */
+
+#include "boot_profile.h"
+
+BootProfile::BootProfile() {
+  phaseCount = 0;
+}
+
+void BootProfile::mark(const char* name) {
+  uint32_t now = micros();
+  uint32_t time;
+  if (phaseCount >= BOOT_MAX_PHASES || getTime(name, time)) return;
+  
+  phases[phaseCount].name = name;
+  phases[phaseCount].time = now;
+  phaseCount++;
+}
+
+bool BootProfile::getTime(const char* name, uint32_t& time) {
+  for (int i = 0; i < phaseCount; i++) {
+    if (strcmp(phases[i].name, name) == 0) {
+      time = phases[i].time;
+      return true;
+    }
+  }
+  return false;
+}
+
+void BootProfile::printReport(Print& out) {
+  out.println("Boot phase          time (ms)   since previous (ms)");
+  uint32_t previous = 0;
+  for (int i = 0; i < phaseCount; i++) {
+    char line[64];
+    snprintf(line, sizeof(line), "%-18s %10.1f %12.1f", phases[i].name,
+             phases[i].time / 1000.0, (phases[i].time - previous) / 1000.0);
+    out.println(line);
+    previous = phases[i].time;
+  }
+}
@@ -0,0 +1,56 @@
+/*
+ * Boot Profile Class Header
+ * 
+ * Timestamps of the boot phases in microseconds since the application
+ * started (the ROM and second-stage bootloader run before that and are
+ * not included). A phase is recorded the first time it is marked, so
+ * marks may sit on paths that run again later, like every WiFi connect.
+ * Served by /metrics.
+ */
+
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <Arduino.h>
+#include "../config/config.h"
+
+// Phases marked by the monitor
+const char* const BOOT_PHASE_SETUP = "setup";
+const char* const BOOT_PHASE_CONFIG = "config loaded";
+const char* const BOOT_PHASE_SENSOR = "sensor ready";
+const char* const BOOT_PHASE_FIRST_SAMPLE = "first sample";
+const char* const BOOT_PHASE_SETUP_DONE = "setup done";
+const char* const BOOT_PHASE_STORAGE = "storage ready";
+const char* const BOOT_PHASE_WIFI = "wifi connected";
+const char* const BOOT_PHASE_CLOCK_SYNC = "clock synced";
+
+struct BootPhase {
+  const char* name;
+  uint32_t time;     // us since the application started
+};
+
+class BootProfile {
+private:
+  BootPhase phases[BOOT_MAX_PHASES];
+  int phaseCount;
+  
+public:
+  // Constructor
+  BootProfile();
+  
+  // Record that a phase was reached now (ignored if already recorded)
+  void mark(const char* name);
+  
+  // Time a phase was reached
+  // Returns: false if it has not been reached yet
+  bool getTime(const char* name, uint32_t& time);
+  
+  // Print the phases with the time since the previous one
+  void printReport(Print& out);
+  
+  // Getters
+  int getPhaseCount() { return phaseCount; }
+  const BootPhase& getPhase(int index) { return phases[index]; }
+};
+
+#endif // BOOT_PROFILE_H
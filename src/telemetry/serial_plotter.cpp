@@ -0,0 +1,24 @@
+/*
+ * Serial Plotter Class Implementation
+ */
+
+#include "serial_plotter.h"
+#include "../config/config.h"
+
+SerialPlotter::SerialPlotter(Print& output) : output(output) {
+}
+
+void SerialPlotter::printHeader() {
+  output.print("Output format: ECG_Value, Filtered_Value, Threshold, Heart_Rate x");
+  output.println(SERIAL_PLOT_SCALE_FACTOR);
+}
+
+void SerialPlotter::plot(int rawValue, SignalProcessor& processor) {
+  output.print(rawValue);
+  output.print(",");
+  output.print(processor.getFilteredValue());
+  output.print(",");
+  output.print(processor.getThreshold());
+  output.print(",");
+  output.println(processor.getHeartRate() * SERIAL_PLOT_SCALE_FACTOR);
+}
@@ -0,0 +1,32 @@
+/*
+ * Serial Plotter Class Header
+ * 
+ * One CSV line per processed sample for the Arduino Serial Plotter:
+ * 
+ *   raw,filtered,threshold,heartRate*SERIAL_PLOT_SCALE_FACTOR
+ * 
+ * Both the simple and the full monitor print this format.
+ */
+
+#ifndef SERIAL_PLOTTER_H
+#define SERIAL_PLOTTER_H
+
+#include <Arduino.h>
+#include "../processing/signal_processor.h"
+
+class SerialPlotter {
+private:
+  Print& output;
+  
+public:
+  // Constructor
+  SerialPlotter(Print& output);
+  
+  // Describe the columns (once, before the first line)
+  void printHeader();
+  
+  // Print the line for a sample the processor has just handled
+  void plot(int rawValue, SignalProcessor& processor);
+};
+
+#endif // SERIAL_PLOTTER_H
@@ -0,0 +1,335 @@
+/*
+ * Outbox Class Implementation
+ * 
+ * Unsent records survive outages and reboots: a segment is only deleted
+ * once the collector has acknowledged all of it, and the acknowledged
+ * offset is saved with a write-and-rename, so a power loss leaves either
+ * the old or the new state file. Records appended since the last flush()
+ * are lost with power, but none of them has been uploaded yet.
+ * 
+ * Opening, renaming and removing files on LittleFS allocates, and the loop
+ * gets here through acknowledge() and segment rotation, so those calls run
+ * in HeapGuard::Allow scopes. Appends, flushes and reads of the open
+ * segment do not allocate.
+ */
+
+#include "outbox.h"
+#include "../memory/heap_guard.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Outbox::Outbox() {
+  file = NULL;
+  appendPositioned = false;
+  directory[0] = '\0';
+  statePath[0] = '\0';
+  segmentCount = 0;
+  endOffset = 0;
+  flushedOffset = 0;
+  ackedOffset = 0;
+  droppedRecords = 0;
+}
+
+Outbox::~Outbox() {
+  if (file != NULL) {
+    fclose(file);
+  }
+}
+
+bool Outbox::begin(const char* directory, const char* statePath) {
+  strlcpy(this->directory, directory, sizeof(this->directory));
+  strlcpy(this->statePath, statePath, sizeof(this->statePath));
+  mkdir(directory, 0755);  // Fails harmlessly when it exists
+  
+  if (!loadState()) {
+    ackedOffset = 0;
+  }
+  
+  scanSegments();
+  if (segmentCount == 0) {
+    // First boot - start at the acknowledged offset
+    if (!startSegment(ackedOffset)) {
+      Serial.println("ERROR: cannot create uplink outbox");
+      return false;
+    }
+  } else {
+    recoverSegment();
+    if (file == NULL) {
+      Serial.println("ERROR: cannot open uplink outbox");
+      return false;
+    }
+  }
+  
+  // The collector has more than the segments hold (they were lost)
+  if (ackedOffset > endOffset) {
+    startSegment(ackedOffset);
+  }
+  if (ackedOffset < segmentBase[0]) {
+    ackedOffset = segmentBase[0];
+    saveState();
+  }
+  removeAcknowledged();
+  
+  Serial.print("Uplink outbox: ");
+  Serial.print((unsigned long)getPendingBytes());
+  Serial.println(" bytes pending");
+  
+  return true;
+}
+
+void Outbox::getSegmentPath(uint64_t base, char* path, size_t size) {
+  // Fixed-width hex, so name order is stream order
+  snprintf(path, size, "%s/%016llx.bin", directory, (unsigned long long)base);
+}
+
+void Outbox::scanSegments() {
+  segmentCount = 0;
+  DIR* dir = opendir(directory);
+  if (dir == NULL) return;
+  
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    char* end;
+    uint64_t base = strtoull(entry->d_name, &end, 16);
+    if (end != entry->d_name + 16 || strcmp(end, ".bin") != 0) continue;
+    if (segmentCount == UPLINK_OUTBOX_MAX_SEGMENTS) break;
+    
+    // Insert in stream order
+    int i = segmentCount++;
+    while (i > 0 && segmentBase[i - 1] > base) {
+      segmentBase[i] = segmentBase[i - 1];
+      i--;
+    }
+    segmentBase[i] = base;
+  }
+  closedir(dir);
+}
+
+void Outbox::recoverSegment() {
+  // Only the newest segment is written to; walk its records, a record cut
+  // short by power loss ends the valid data
+  char path[80];
+  getSegmentPath(segmentBase[segmentCount - 1], path, sizeof(path));
+  if (!openSegment(path, "r+b")) return;
+  
+  uint32_t size = 0;
+  uint8_t frame[2];
+  while (fread(frame, 1, 2, file) == 2) {
+    uint16_t length = frame[0] | (frame[1] << 8);
+    if (length == 0 || fseek(file, length, SEEK_CUR) != 0) break;
+    
+    // fseek may move past EOF - confirm the record is complete
+    long position = ftell(file);
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) < position) break;
+    fseek(file, position, SEEK_SET);
+    
+    size += 2 + length;
+  }
+  
+  // Cut the partial record, so later appends are not followed by its bytes
+  fflush(file);
+  ftruncate(fileno(file), size);
+  endOffset = segmentBase[segmentCount - 1] + size;
+  flushedOffset = endOffset;
+  appendPositioned = false;
+}
+
+bool Outbox::openSegment(const char* path, const char* mode) {
+  file = fopen(path, mode);
+  if (file == NULL) return false;
+  
+  // Appends collect here until flush(); a static buffer keeps stdio from
+  // allocating one on the first write
+  setvbuf(file, writeBuffer, _IOFBF, sizeof(writeBuffer));
+  return true;
+}
+
+bool Outbox::startSegment(uint64_t base) {
+  if (segmentCount == UPLINK_OUTBOX_MAX_SEGMENTS) return false;
+  
+  HeapGuard::Allow allow;  // LittleFS allocates file handles
+  
+  // Closing writes the rest of the old segment
+  if (file != NULL) {
+    fclose(file);
+    file = NULL;
+  }
+  
+  char path[80];
+  getSegmentPath(base, path, sizeof(path));
+  if (!openSegment(path, "w+b")) return false;
+  
+  segmentBase[segmentCount++] = base;
+  endOffset = base;
+  flushedOffset = base;
+  appendPositioned = true;
+  return true;
+}
+
+void Outbox::removeAcknowledged() {
+  // A segment is done when the next one starts at or below the acknowledged offset
+  int done = 0;
+  while (done < segmentCount - 1 && segmentBase[done + 1] <= ackedOffset) {
+    char path[80];
+    getSegmentPath(segmentBase[done], path, sizeof(path));
+    HeapGuard::Allow allow;  // LittleFS allocates while removing
+    remove(path);
+    done++;
+  }
+  if (done == 0) return;
+  
+  memmove(segmentBase, segmentBase + done, (segmentCount - done) * sizeof(segmentBase[0]));
+  segmentCount -= done;
+}
+
+bool Outbox::append(const uint8_t* record, size_t length) {
+  if (file == NULL || length == 0 || length > 0xFFFF) return false;
+  
+  if (getStoredBytes() + 2 + length > UPLINK_OUTBOX_MAX_BYTES) {
+    droppedRecords++;
+    return false;
+  }
+  
+  // Records never straddle segments
+  uint32_t segmentSize = endOffset - segmentBase[segmentCount - 1];
+  if (segmentSize > 0 && segmentSize + 2 + length > UPLINK_OUTBOX_SEGMENT_BYTES) {
+    if (!startSegment(endOffset)) {
+      droppedRecords++;
+      return false;
+    }
+    removeAcknowledged();
+    segmentSize = 0;
+  }
+  
+  uint8_t frame[2] = { (uint8_t)length, (uint8_t)(length >> 8) };
+  
+  // Seeking writes the buffer out, so only after a peek moved the position
+  if (!appendPositioned) {
+    if (fseek(file, segmentSize, SEEK_SET) != 0) {
+      droppedRecords++;
+      return false;
+    }
+    appendPositioned = true;
+  }
+  
+  bool ok = fwrite(frame, 1, 2, file) == 2 &&
+            fwrite(record, 1, length, file) == length;
+  
+  if (!ok) {
+    // Part of the record may be in the file; the next append overwrites it
+    appendPositioned = false;
+    droppedRecords++;
+    return false;
+  }
+  
+  endOffset += 2 + length;
+  return true;
+}
+
+bool Outbox::flush() {
+  if (file == NULL) return false;
+  if (flushedOffset == endOffset) return true;
+  
+  // fsync, so a power loss keeps what the collector may acknowledge
+  if (fflush(file) != 0 || fsync(fileno(file)) != 0) return false;
+  
+  flushedOffset = endOffset;
+  return true;
+}
+
+size_t Outbox::peek(uint8_t* buffer, size_t bufferSize, uint64_t& offset) {
+  offset = ackedOffset;
+  if (file == NULL || ackedOffset >= flushedOffset) return 0;
+  
+  // Segment holding the acknowledged offset
+  int segment = segmentCount - 1;
+  while (segment > 0 && segmentBase[segment] > ackedOffset) {
+    segment--;
+  }
+  uint64_t segmentEnd = segment + 1 < segmentCount ? segmentBase[segment + 1] : flushedOffset;
+  
+  FILE* input = file;
+  if (segment + 1 < segmentCount) {
+    char path[80];
+    getSegmentPath(segmentBase[segment], path, sizeof(path));
+    {
+      HeapGuard::Allow allow;  // LittleFS allocates file handles
+      input = fopen(path, "rb");
+    }
+    if (input == NULL) return 0;
+    
+    // Unbuffered, so stdio does not allocate a buffer on the first read
+    setvbuf(input, NULL, _IONBF, 0);
+  } else {
+    // Reading moves the position appends continue from
+    appendPositioned = false;
+  }
+  
+  uint64_t position = ackedOffset;
+  size_t copied = 0;
+  
+  // Only whole records, so every batch can be decoded on its own
+  fseek(input, position - segmentBase[segment], SEEK_SET);
+  while (position < segmentEnd) {
+    uint8_t frame[2];
+    if (fread(frame, 1, 2, input) != 2) break;
+    
+    size_t length = frame[0] | (frame[1] << 8);
+    if (copied + 2 + length > bufferSize) break;
+    
+    memcpy(buffer + copied, frame, 2);
+    if (fread(buffer + copied + 2, 1, length, input) != length) break;
+    
+    copied += 2 + length;
+    position += 2 + length;
+  }
+  
+  if (input != file) {
+    fclose(input);
+  }
+  return copied;
+}
+
+void Outbox::acknowledge(uint64_t offset) {
+  if (offset <= ackedOffset) return;
+  if (offset > flushedOffset) {
+    offset = flushedOffset;
+  }
+  
+  ackedOffset = offset;
+  saveState();
+  
+  // Delete only after the new offset is stored
+  removeAcknowledged();
+}
+
+bool Outbox::loadState() {
+  FILE* state = fopen(statePath, "rb");
+  if (state == NULL) return false;
+  
+  uint64_t value;
+  bool ok = fread(&value, sizeof(value), 1, state) == 1;
+  fclose(state);
+  
+  if (ok) {
+    ackedOffset = value;
+  }
+  return ok;
+}
+
+bool Outbox::saveState() {
+  // Write a new file and rename it over the old one (atomic on LittleFS)
+  char tempPath[72];
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", statePath);
+  
+  HeapGuard::Allow allow;  // LittleFS allocates file handles
+  FILE* state = fopen(tempPath, "wb");
+  if (state == NULL) return false;
+  
+  bool ok = fwrite(&ackedOffset, sizeof(ackedOffset), 1, state) == 1;
+  ok = fclose(state) == 0 && ok;
+  
+  return ok && rename(tempPath, statePath) == 0;
+}
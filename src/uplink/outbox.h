@@ -0,0 +1,85 @@
+/*
+ * Outbox Class Header
+ * 
+ * Persistent store-and-forward queue of encoded records. Records are
+ * appended as [uint16 length][payload] to segment files in one directory,
+ * each named by the stream offset of its first byte; a small state file
+ * remembers how much of the stream the collector has acknowledged.
+ * Positions are stream offsets that keep growing across segments, so
+ * uploads can resume from the collector's last acknowledged offset.
+ * A segment is deleted once it has been acknowledged entirely, so the
+ * space is reused without copying data.
+ * 
+ * Appends go to a write buffer and reach flash when flush() is called, so
+ * the sampling path never waits for a flash write. Only flushed records
+ * are uploaded and can be acknowledged.
+ */
+
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "../config/config.h"
+
+class Outbox {
+private:
+  FILE* file;               // Newest segment, records are appended here
+  char writeBuffer[UPLINK_OUTBOX_WRITE_BUFFER];  // stdio buffer of file, so it is never allocated
+  bool appendPositioned;    // file position is at endOffset (peek and recovery move it)
+  char directory[48];
+  char statePath[64];
+  
+  uint64_t segmentBase[UPLINK_OUTBOX_MAX_SEGMENTS];  // Stream offset of each segment, oldest first
+  int segmentCount;
+  uint64_t endOffset;       // Stream offset after the last complete record
+  uint64_t flushedOffset;   // Stream offset written to flash
+  uint64_t ackedOffset;     // Stream offset acknowledged by the collector
+  unsigned long droppedRecords;
+  
+  // Internal methods
+  bool loadState();
+  bool saveState();
+  void scanSegments();
+  void recoverSegment();
+  bool startSegment(uint64_t base);
+  bool openSegment(const char* path, const char* mode);
+  void removeAcknowledged();
+  void getSegmentPath(uint64_t base, char* path, size_t size);
+  
+public:
+  // Constructor
+  Outbox();
+  ~Outbox();
+  
+  // Open (or create) the outbox directory and recover after power loss
+  bool begin(const char* directory, const char* statePath);
+  
+  // Append one record; dropped (and counted) if the outbox is full.
+  // Buffered until the next flush().
+  bool append(const uint8_t* record, size_t length);
+  
+  // Write the appended records to flash (call every UPLINK_OUTBOX_FLUSH_INTERVAL)
+  bool flush();
+  
+  // Copy whole flushed records from the acknowledged offset into buffer
+  // (at most to the end of its segment). Returns bytes copied; offset
+  // receives the stream offset of the first byte.
+  size_t peek(uint8_t* buffer, size_t bufferSize, uint64_t& offset);
+  
+  // Mark the stream acknowledged up to offset (ignores stale offsets,
+  // never beyond the flushed records)
+  void acknowledge(uint64_t offset);
+  
+  // Getters
+  uint64_t getPendingBytes() { return endOffset - ackedOffset; }
+  uint64_t getStoredBytes() { return segmentCount > 0 ? endOffset - segmentBase[0] : 0; }
+  uint64_t getAckedOffset() { return ackedOffset; }
+  uint64_t getEndOffset() { return endOffset; }
+  uint64_t getFlushedOffset() { return flushedOffset; }
+  int getSegmentCount() { return segmentCount; }
+  unsigned long getDroppedRecords() { return droppedRecords; }
+  bool isOpen() { return file != NULL; }
+};
+
+#endif // OUTBOX_H
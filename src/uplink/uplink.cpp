@@ -0,0 +1,282 @@
+/*
+ * Uplink Class Implementation
+ */
+
+#include "uplink.h"
+
+#if ECG_FEATURE_NETWORK
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <ArduinoJson.h>
+#include "../memory/heap_guard.h"
+
+#if defined(ESP32)
+#include <LittleFS.h>
+#endif
+
+Uplink::Uplink() : jsonArena("uplink json") {
+  sampleClock = NULL;
+  wifiLink = NULL;
+  RuntimeConfig::getDefaults(settings);
+  sampleRate = settings.sampleRate;
+  storageReady = false;
+  memset(&blockHeader, 0, sizeof(blockHeader));
+  nextSequence = 0;
+  lastFlush = 0;
+  linkUp = false;
+  uploadInFlight = false;
+  inFlightLength = 0;
+  uploadBackoff = UPLINK_INTERVAL;
+  lastUploadAttempt = 0;
+  bytesUploaded = 0;
+  uploadFailures = 0;
+#if defined(ESP32)
+  uploadTask = NULL;
+  requestQueue = NULL;
+  resultQueue = NULL;
+#endif
+}
+
+bool Uplink::begin(SampleClock* clock, const char* outboxDir, const char* statePath) {
+  sampleClock = clock;
+  
+#if defined(ESP32)
+  // Format on first use; the outbox lives on the LittleFS partition
+  if (!LittleFS.begin(true)) {
+    Serial.println("ERROR: LittleFS mount failed - uplink store disabled");
+    return false;
+  }
+#endif
+  
+  storageReady = outbox.begin(outboxDir, statePath);
+  
+#if defined(ESP32)
+  // One batch in flight at a time, so both queues hold one entry
+  if (storageReady && uploadTask == NULL) {
+    requestQueue = xQueueCreateStatic(1, sizeof(UploadRequest), requestStorage, &requestQueueBuffer);
+    resultQueue = xQueueCreateStatic(1, sizeof(UploadResult), resultStorage, &resultQueueBuffer);
+    uploadTask = xTaskCreateStaticPinnedToCore(runUploadTask, "uplink", UPLINK_TASK_STACK_SIZE, this,
+                                               UPLINK_TASK_PRIORITY, uploadStack, &uploadTaskBuffer,
+                                               UPLINK_TASK_CORE);
+  }
+#endif
+  
+  return storageReady;
+}
+
+void Uplink::applySettings(const ECGSettings& settings) {
+  this->settings = settings;
+}
+
+void Uplink::setSampleRate(int sampleRate) {
+  if (sampleRate == this->sampleRate) return;
+  
+  // A block holds samples at one rate only
+  flushBlock();
+  this->sampleRate = sampleRate;
+}
+
+void Uplink::addSample(int ecgValue, uint32_t sequence, uint64_t sampleTime) {
+  if (!storageReady) return;
+  
+  // Blocks hold contiguous samples only
+  if (blockHeader.sampleCount > 0 && sequence != nextSequence) {
+    flushBlock();
+  }
+  
+  if (blockHeader.sampleCount == 0) {
+    blockHeader.firstSequence = sequence;
+    blockHeader.sampleRate = sampleRate;
+    blockHeader.firstSampleTime = sampleTime;
+    blockHeader.firstEpochMs = sampleClock ? sampleClock->toEpoch(sampleTime) / 1000 : 0;
+  }
+  
+  blockSamples[blockHeader.sampleCount++] = ecgValue;
+  nextSequence = sequence + 1;
+  
+  if (blockHeader.sampleCount >= UPLINK_BLOCK_SAMPLES) {
+    flushBlock();
+  }
+}
+
+void Uplink::addEvent(uint8_t type, uint32_t sequence, int32_t value) {
+  if (!storageReady) return;
+  
+  ECGEvent event;
+  event.type = type;
+  event.sequence = sequence;
+  event.value = value;
+  
+  uint8_t record[EVENT_RECORD_SIZE];
+  size_t length = encodeEvent(event, record, sizeof(record));
+  outbox.append(record, length);
+}
+
+void Uplink::addHistory(SampleHistory& history) {
+  if (!storageReady) return;
+  
+  SampleSnapshot snapshot;
+  if (!history.snapshot(history.getOldestSequence(), history.getNextSequence(), snapshot)) return;
+  
+  // Gaps (leads off, missed samples) are not sent, as in live recording
+  uint32_t sequence = snapshot.firstSequence;
+  for (int segment = 0; segment < 2; segment++) {
+    const SampleSpan& span = snapshot.segments[segment];
+    for (size_t i = 0; i < span.count; i++, sequence++) {
+      if (span.data[i] == SAMPLE_GAP) continue;
+      uint64_t sampleTime = 0;
+      if (sampleClock != NULL) {
+        // The history may reach back across a rate switch
+        setSampleRate(sampleClock->getSampleRate(sequence));
+        sampleTime = sampleClock->getSampleTime(sequence);
+      }
+      addSample(span.data[i], sequence, sampleTime);
+    }
+  }
+}
+
+void Uplink::flushBlock() {
+  if (blockHeader.sampleCount == 0) return;
+  
+  size_t length = encodeSampleBlock(blockHeader, blockSamples, encodeBuffer, sizeof(encodeBuffer));
+  if (length > 0) {
+    outbox.append(encodeBuffer, length);
+  }
+  
+  blockHeader.sampleCount = 0;
+}
+
+void Uplink::loop() {
+  bool connected = wifiLink != NULL && wifiLink->isConnected();
+  
+  // Start catching up as soon as the link comes back
+  if (connected && !linkUp) {
+    uploadBackoff = 0;
+  }
+  linkUp = connected;
+  
+  // Appends reach flash here rather than on the sampling path
+  if (storageReady && millis() - lastFlush >= UPLINK_OUTBOX_FLUSH_INTERVAL) {
+    outbox.flush();
+    lastFlush = millis();
+  }
+  
+  collectUpload();
+  uploadPending();
+}
+
+void Uplink::uploadPending() {
+  if (uploadInFlight) return;
+  if (!linkUp || !storageReady || settings.collectorUrl[0] == '\0') return;
+  if (outbox.getPendingBytes() == 0) return;
+  if (millis() - lastUploadAttempt < uploadBackoff) return;
+  
+  lastUploadAttempt = millis();
+  
+  uint64_t offset;
+  size_t length = outbox.peek(uploadBuffer, sizeof(uploadBuffer), offset);
+  if (length == 0) return;
+  
+  startUpload(length, offset);
+}
+
+void Uplink::startUpload(size_t length, uint64_t offset) {
+  UploadRequest request;
+  request.length = length;
+  request.offset = offset;
+  strlcpy(request.collectorUrl, settings.collectorUrl, sizeof(request.collectorUrl));
+  
+  uploadInFlight = true;
+  inFlightLength = length;
+  
+#if defined(ESP32)
+  // The queue is empty while nothing is in flight
+  xQueueSend(requestQueue, &request, 0);
+#else
+  // No upload task off the device: post from the caller
+  UploadResult result;
+  {
+    HeapGuard::Allow allow;
+    result.ok = postBatch(request, result.ackOffset);
+  }
+  finishUpload(result);
+#endif
+}
+
+void Uplink::collectUpload() {
+#if defined(ESP32)
+  UploadResult result;
+  if (uploadInFlight && xQueueReceive(resultQueue, &result, 0) == pdTRUE) {
+    finishUpload(result);
+  }
+#endif
+}
+
+void Uplink::finishUpload(const UploadResult& result) {
+  uploadInFlight = false;
+  
+  if (result.ok) {
+    outbox.acknowledge(result.ackOffset);
+    bytesUploaded += inFlightLength;
+    
+    // Drain faster while behind, but leave the radio and the other tasks room
+    uploadBackoff = (outbox.getPendingBytes() >= UPLINK_MAX_BATCH_BYTES) ? UPLINK_CATCHUP_INTERVAL : UPLINK_INTERVAL;
+  } else {
+    uploadFailures++;
+    uploadBackoff = constrain(uploadBackoff * 2, UPLINK_MIN_BACKOFF, UPLINK_MAX_BACKOFF);
+  }
+}
+
+#if defined(ESP32)
+void Uplink::runUploadTask(void* parameter) {
+  Uplink* uplink = (Uplink*)parameter;
+  UploadRequest request;
+  
+  for (;;) {
+    if (xQueueReceive(uplink->requestQueue, &request, portMAX_DELAY) != pdTRUE) continue;
+    
+    UploadResult result;
+    result.ok = uplink->postBatch(request, result.ackOffset);
+    xQueueSend(uplink->resultQueue, &result, portMAX_DELAY);
+  }
+}
+#endif
+
+// Runs in the upload task, which the heap guard does not audit: HTTPClient
+// keeps its headers and connection state in Strings
+bool Uplink::postBatch(const UploadRequest& request, uint64_t& ackOffset) {
+  HTTPClient http;
+  if (!http.begin(request.collectorUrl)) return false;
+  
+  char offsetText[24];
+  snprintf(offsetText, sizeof(offsetText), "%llu", (unsigned long long)request.offset);
+  
+  http.setTimeout(UPLINK_HTTP_TIMEOUT);
+  http.addHeader("Content-Type", "application/octet-stream");
+  http.addHeader("X-Device-Id", WiFi.macAddress());
+  http.addHeader("X-Stream-Offset", offsetText);
+  
+  int code = http.POST(uploadBuffer, request.length);
+  bool ok = false;
+  
+  if (code == 200) {
+    // Parse the reply straight from the connection into the fixed arena
+    MemoryArena::Scope scope(jsonArena);
+    ArenaJsonDocument doc(UPLINK_ARENA_SIZE, ArenaAllocator(&jsonArena));
+    if (!deserializeJson(doc, http.getStream()) && doc.containsKey("ackOffset")) {
+      ackOffset = doc["ackOffset"].as<uint64_t>();
+      ok = true;
+    }
+  }
+  
+  if (!ok && ENABLE_DEBUG_MESSAGES) {
+    Serial.print("Uplink: upload failed (");
+    Serial.print(code);
+    Serial.println(")");
+  }
+  
+  http.end();
+  return ok;
+}
+
+#endif // ECG_FEATURE_NETWORK
@@ -0,0 +1,154 @@
+/*
+ * Uplink Class Header
+ * 
+ * Store-and-forward delivery of ECG data to a remote collector. Samples
+ * are packed into compressed blocks and, together with events, queued in
+ * a persistent outbox, which is uploaded in batches over HTTP whenever the
+ * WiFi link is up.
+ * 
+ * Collector protocol: POST <collectorUrl> with the framed records as an
+ * application/octet-stream body, X-Device-Id and X-Stream-Offset headers.
+ * The collector replies {"ackOffset": N} with the stream offset it has
+ * stored through; retransmitted data below its offset is ignored.
+ * 
+ * The HTTP request runs in its own FreeRTOS task, so a slow or unreachable
+ * collector never holds up loop(). loop() hands it one batch at a time
+ * through a queue and applies the result when it comes back; the outbox is
+ * only touched from loop().
+ */
+
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#include "../config/features.h"
+
+#if ECG_FEATURE_NETWORK
+
+#include <Arduino.h>
+#include "outbox.h"
+#include "../codec/sample_codec.h"
+#include "../config/runtime_config.h"
+#include "../sensors/sample_clock.h"
+#include "../memory/memory_arena.h"
+#include "../network/wifi_link.h"
+#include "../storage/sample_history.h"
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#endif
+
+// Batch handed to the upload task (the data is in uploadBuffer)
+struct UploadRequest {
+  size_t length;
+  uint64_t offset;
+  char collectorUrl[sizeof(ECGSettings::collectorUrl)];
+};
+
+// Outcome of one post
+struct UploadResult {
+  bool ok;
+  uint64_t ackOffset;
+};
+
+class Uplink {
+private:
+  Outbox outbox;
+  SampleClock* sampleClock;
+  WiFiLink* wifiLink;
+  ECGSettings settings;
+  int sampleRate;               // Rate of the samples being queued
+  bool storageReady;
+  
+  // Block being filled
+  int16_t blockSamples[UPLINK_BLOCK_SAMPLES];
+  SampleBlockHeader blockHeader;
+  uint32_t nextSequence;
+  unsigned long lastFlush;      // Outbox appends last written to flash
+  
+  // Upload state
+  bool linkUp;
+  bool uploadInFlight;          // uploadBuffer belongs to the upload task until its result is in
+  size_t inFlightLength;
+  unsigned long uploadBackoff;
+  unsigned long lastUploadAttempt;
+  
+#if defined(ESP32)
+  // Upload task and its queues, all in static memory
+  TaskHandle_t uploadTask;
+  QueueHandle_t requestQueue;
+  QueueHandle_t resultQueue;
+  StaticTask_t uploadTaskBuffer;
+  StackType_t uploadStack[UPLINK_TASK_STACK_SIZE];
+  StaticQueue_t requestQueueBuffer;
+  StaticQueue_t resultQueueBuffer;
+  uint8_t requestStorage[sizeof(UploadRequest)];
+  uint8_t resultStorage[sizeof(UploadResult)];
+#endif
+  
+  // Statistics
+  uint64_t bytesUploaded;
+  unsigned long uploadFailures;
+  
+  // Scratch buffers
+  uint8_t encodeBuffer[SAMPLE_BLOCK_HEADER_SIZE + 3 + 2 * UPLINK_BLOCK_SAMPLES];
+  uint8_t uploadBuffer[UPLINK_MAX_BATCH_BYTES];
+  StaticArena<UPLINK_ARENA_SIZE> jsonArena;
+  
+  // Internal methods
+  void flushBlock();
+  void uploadPending();
+  void startUpload(size_t length, uint64_t offset);
+  void collectUpload();
+  void finishUpload(const UploadResult& result);
+  bool postBatch(const UploadRequest& request, uint64_t& ackOffset);
+#if defined(ESP32)
+  static void runUploadTask(void* parameter);
+#endif
+  
+public:
+  // Constructor
+  Uplink();
+  
+  // Mount storage, open the outbox and start the upload task
+  bool begin(SampleClock* clock, const char* outboxDir = UPLINK_OUTBOX_DIR,
+             const char* statePath = UPLINK_STATE_PATH);
+  
+  // Upload while this link is connected (call before loop)
+  void setWiFiLink(WiFiLink* link) { wifiLink = link; }
+  
+  // Apply the collector URL (the rate changes with setSampleRate())
+  void applySettings(const ECGSettings& settings);
+  
+  // Rate of the samples queued from now on; a change closes the open block,
+  // so call it on the first sample at the new rate
+  void setSampleRate(int sampleRate);
+  
+  // Queue a sample (sequence gaps start a new block)
+  void addSample(int ecgValue, uint32_t sequence, uint64_t sampleTime);
+  
+  // Queue an event
+  void addEvent(uint8_t type, uint32_t sequence, int32_t value);
+  
+  // Queue the samples still in the history (those taken before begin())
+  void addHistory(SampleHistory& history);
+  
+  // Write queued records to flash, start the next upload and take the
+  // result of the last one; never waits for the network (run as a
+  // scheduler task)
+  void loop();
+  
+  // Getters
+  bool isStorageReady() { return storageReady; }
+  bool isLinkUp() { return linkUp; }
+  bool isUploading() { return uploadInFlight; }
+  uint64_t getPendingBytes() { return outbox.getPendingBytes(); }
+  uint64_t getBytesUploaded() { return bytesUploaded; }
+  unsigned long getDroppedRecords() { return outbox.getDroppedRecords(); }
+  unsigned long getUploadFailures() { return uploadFailures; }
+};
+
+#endif // ECG_FEATURE_NETWORK
+
+#endif // UPLINK_H
@@ -5,27 +5,59 @@
  */
 
 #include "web_server.h"
+
+#if ECG_FEATURE_NETWORK
 #include "../config/config.h"
+#include "../processing/sample_rate.h"
+#include "../memory/heap_guard.h"
+#include <lwip/sockets.h>
 
-ECGWebServer::ECGWebServer() : server(WEB_SERVER_PORT) {
+ECGWebServer::ECGWebServer() : server(WEB_SERVER_PORT), arena("web requests") {
   wifiConnected = false;
+  enabled = false;
   serverStarted = false;
+  runtimeConfig = NULL;
+  sampleClock = NULL;
+  uplink = NULL;
+  energyMonitor = NULL;
+  sampleHistory = NULL;
+  qualityMask = NULL;
+  wifiLink = NULL;
+  scheduler = NULL;
+  bootProfile = NULL;
+  backgroundTask = NULL;
   currentECGValue = 0;
   currentHeartRate = 0;
+  currentInstantHeartRate = 0;
+  currentInstantConfidence = 0;
+  currentHeartRateConfidence = 0;
   currentSignalQuality = 0;
   leadsConnected = false;
   lastDataUpdate = 0;
+  currentSequence = 0;
+  currentSampleTime = 0;
+  currentThreshold = HEARTBEAT_THRESHOLD;
+  currentBaseline = 0;
+  currentNoiseFloor = 0;
+  currentPeakAmplitude = 0;
+  thresholdCalibrated = false;
+  ipAddress[0] = '\0';
+  connectionInfo[0] = '\0';
 }
 
 bool ECGWebServer::begin() {
-  Serial.println("Starting web server...");
-  
-  // Connect to WiFi
-  if (!connectToWiFi()) {
-    Serial.println("ERROR: Failed to connect to WiFi");
+  if (wifiLink == NULL) {
+    Serial.println("ERROR: Web server has no WiFi link");
     return false;
   }
   
+  // WiFi connects in the background; handleClient() starts the server
+  enabled = true;
+  Serial.println("Web server will start once WiFi connects");
+  return true;
+}
+
+void ECGWebServer::startServer() {
   // Setup server routes
   setupRoutes();
   
@@ -36,130 +68,567 @@ bool ECGWebServer::begin() {
   Serial.println("✓ Web server started successfully");
   Serial.print("✓ Access the ECG monitor at: http://");
   Serial.println(WiFi.localIP());
-  
-  return true;
-}
-
-bool ECGWebServer::connectToWiFi() {
-  Serial.print("Connecting to WiFi network: ");
-  Serial.println(WIFI_SSID);
-  
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  
-  unsigned long startTime = millis();
-  while (WiFi.status() != WL_CONNECTED && (millis() - startTime) < WIFI_TIMEOUT) {
-    delay(500);
-    Serial.print(".");
-  }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    wifiConnected = true;
-    Serial.println();
-    Serial.println("✓ WiFi connected successfully");
-    Serial.print("✓ IP address: ");
-    Serial.println(WiFi.localIP());
-    Serial.print("✓ Signal strength: ");
-    Serial.print(WiFi.RSSI());
-    Serial.println(" dBm");
-    return true;
-  } else {
-    Serial.println();
-    Serial.println("✗ WiFi connection failed");
-    return false;
-  }
 }
 
 void ECGWebServer::setupRoutes() {
   // Bind route handlers to this instance
-  server.on("/", [this]() { this->handleRoot(); });
-  server.on("/data", [this]() { this->handleData(); });
-  server.on("/status", [this]() { this->handleStatus(); });
-  server.onNotFound([this]() { this->handleNotFound(); });
+  server.on("/", [this]() { this->runHandler(&ECGWebServer::handleRoot); });
+  server.on("/data", [this]() { this->runHandler(&ECGWebServer::handleData); });
+  server.on("/status", [this]() { this->runHandler(&ECGWebServer::handleStatus); });
+  server.on("/config", HTTP_GET, [this]() { this->runHandler(&ECGWebServer::handleConfigGet); });
+  server.on("/config", HTTP_POST, [this]() { this->runHandler(&ECGWebServer::handleConfigPost); });
+  server.on("/time", HTTP_GET, [this]() { this->runHandler(&ECGWebServer::handleTimeGet); });
+  server.on("/time", HTTP_POST, [this]() { this->runHandler(&ECGWebServer::handleTimePost); });
+  server.on("/power", [this]() { this->runHandler(&ECGWebServer::handlePower); });
+  server.on("/waveform", [this]() { this->runHandler(&ECGWebServer::handleWaveform); });
+  server.on("/quality", [this]() { this->runHandler(&ECGWebServer::handleQuality); });
+  server.on("/tasks", [this]() { this->runHandler(&ECGWebServer::handleTasks); });
+  server.on("/metrics", [this]() { this->runHandler(&ECGWebServer::handleMetrics); });
+  server.onNotFound([this]() { this->runHandler(&ECGWebServer::handleNotFound); });
 }
 
 void ECGWebServer::handleClient() {
+  wifiConnected = wifiLink != NULL && wifiLink->isConnected();
+  
+  // Without begin() (low power mode) the server stays off, also while a
+  // transmit window has WiFi up
+  if (!enabled) return;
+  
+  // First connection (reconnects are handled by the WiFi link)
+  if (!serverStarted && wifiConnected) {
+    startServer();
+  }
+  
   if (serverStarted) {
+    // Request parsing inside WebServer uses Strings; handlers are audited again
+    HeapGuard::Allow allow;
     server.handleClient();
   }
 }
 
-void ECGWebServer::updateECGData(int ecgValue, int heartRate, int signalQuality) {
+void ECGWebServer::runHandler(void (ECGWebServer::*handler)()) {
+  HeapGuard::Allow audit(false);
+  MemoryArena::Scope scope(arena);
+  (this->*handler)();
+}
+
+void ECGWebServer::sendJson(JsonDocument& doc) {
+  size_t length = measureJson(doc);
+  char* text = (char*)arena.allocate(length + 1, 1);
+  if (text == NULL) {
+    sendText(500, "Response too large");
+    return;
+  }
+  
+  serializeJson(doc, text, length + 1);
+  
+  HeapGuard::Allow allow;  // Response headers are built as Strings
+  server.send_P(200, "application/json", text, length);
+}
+
+void ECGWebServer::sendText(int code, const char* text) {
+  HeapGuard::Allow allow;
+  server.send_P(code, "text/plain", text, strlen(text));
+}
+
+bool ECGWebServer::waitForClient() {
+  // sendContent() blocks inside the TCP stack while the send buffer is full
+  // (slow or stalled client), and no samples are taken meanwhile. Only send
+  // once the socket is writable - lwIP reports that with more free buffer
+  // than a chunk needs - and keep sampling while waiting.
+  WiFiClient client = server.client();
+  int fd = client.fd();
+  unsigned long start = millis();
+  
+  while (fd >= 0 && client.connected()) {
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(fd, &writable);
+    struct timeval poll = { 0, 0 };
+    if (select(fd + 1, NULL, &writable, NULL, &poll) > 0) return true;
+    
+    if (millis() - start >= WAVEFORM_SEND_TIMEOUT) break;
+    if (backgroundTask != NULL) {
+      backgroundTask();
+    }
+  }
+  return false;
+}
+
+DeserializationError ECGWebServer::readBody(JsonDocument& doc) {
+  // WebServer only hands out the body as a String copy
+  HeapGuard::Allow allow;
+  return deserializeJson(doc, server.arg("plain"));
+}
+
+void ECGWebServer::updateECGData(int ecgValue, int heartRate, int signalQuality,
+                                 uint32_t sequence, uint64_t sampleTime) {
   currentECGValue = ecgValue;
   currentHeartRate = heartRate;
   currentSignalQuality = signalQuality;
+  currentSequence = sequence;
+  currentSampleTime = sampleTime;
   lastDataUpdate = millis();
 }
 
+void ECGWebServer::updateHeartRate(int instantHeartRate, int instantConfidence, int confidence) {
+  currentInstantHeartRate = instantHeartRate;
+  currentInstantConfidence = instantConfidence;
+  currentHeartRateConfidence = confidence;
+}
+
+void ECGWebServer::updateCalibration(int threshold, int baseline, int noiseFloor,
+                                     int peakAmplitude, bool calibrated) {
+  currentThreshold = threshold;
+  currentBaseline = baseline;
+  currentNoiseFloor = noiseFloor;
+  currentPeakAmplitude = peakAmplitude;
+  thresholdCalibrated = calibrated;
+}
+
 void ECGWebServer::updateLeadStatus(bool connected) {
   leadsConnected = connected;
 }
 
-String ECGWebServer::getIPAddress() {
+const char* ECGWebServer::getIPAddress() {
   if (wifiConnected) {
-    return WiFi.localIP().toString();
+    IPAddress ip = WiFi.localIP();
+    snprintf(ipAddress, sizeof(ipAddress), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    return ipAddress;
   }
   return "Not connected";
 }
 
-String ECGWebServer::getConnectionInfo() {
+const char* ECGWebServer::getConnectionInfo() {
   if (wifiConnected) {
-    return "Connected to " + String(WIFI_SSID) + " (" + WiFi.localIP().toString() + ")";
+    const char* ssid = runtimeConfig ? runtimeConfig->get().wifiSsid : WIFI_SSID;
+    snprintf(connectionInfo, sizeof(connectionInfo), "Connected to %s (%s)", ssid, getIPAddress());
+    return connectionInfo;
   }
   return "Not connected to WiFi";
 }
 
 void ECGWebServer::handleRoot() {
-  String html = generateHTML();
-  server.send(200, "text/html", html);
+  // Served straight from flash
+  HeapGuard::Allow allow;
+  server.send_P(200, "text/html", generateHTML());
 }
 
 void ECGWebServer::handleData() {
-  DynamicJsonDocument doc(200);
+  ArenaJsonDocument doc(200, ArenaAllocator(&arena));
   
   doc["ecgValue"] = currentECGValue;
+  doc["sequence"] = currentSequence;
+  doc["sampleTime"] = currentSampleTime;
+  if (sampleClock != NULL && sampleClock->isSynchronized()) {
+    doc["epochMs"] = sampleClock->toEpoch(currentSampleTime) / 1000;
+  }
   doc["timestamp"] = millis();
   doc["lastUpdate"] = lastDataUpdate;
   
-  String response;
-  serializeJson(doc, response);
-  
-  server.send(200, "application/json", response);
+  sendJson(doc);
 }
 
 void ECGWebServer::handleStatus() {
-  DynamicJsonDocument doc(400);
+  ArenaJsonDocument doc(800, ArenaAllocator(&arena));
   
   doc["heartRate"] = currentHeartRate;
+  doc["heartRateConfidence"] = currentHeartRateConfidence;
+  doc["instantHeartRate"] = currentInstantHeartRate;
+  doc["instantConfidence"] = currentInstantConfidence;
   doc["signalQuality"] = currentSignalQuality;
   doc["leadsConnected"] = leadsConnected;
-  doc["sampleRate"] = SAMPLE_RATE;
+  doc["threshold"] = currentThreshold;
+  doc["baseline"] = currentBaseline;
+  doc["noiseFloor"] = currentNoiseFloor;
+  doc["peakAmplitude"] = currentPeakAmplitude;
+  doc["thresholdCalibrated"] = thresholdCalibrated;
+  if (qualityMask != NULL && qualityMask->getRunCount() > 0) {
+    doc["artifactFlags"] = qualityMask->getRun(qualityMask->getRunCount() - 1).flags;
+    doc["maskedSamples"] = qualityMask->getMaskedSamples();
+  }
+  doc["sampleRate"] = runtimeConfig ? runtimeConfig->get().sampleRate : SAMPLE_RATE;
   doc["uptime"] = millis();
   doc["wifiConnected"] = wifiConnected;
-  doc["ipAddress"] = WiFi.localIP().toString();
+  if (wifiLink != NULL) {
+    doc["wifiState"] = wifiLink->getStateName();
+    doc["wifiConnectAttempts"] = wifiLink->getConnectAttempts();
+  }
+  doc["ipAddress"] = getIPAddress();
   doc["rssi"] = WiFi.RSSI();
   doc["freeHeap"] = ESP.getFreeHeap();
+  doc["largestFreeBlock"] = ESP.getMaxAllocHeap();
+  doc["heapViolations"] = HeapGuard::getViolationCount();
+  if (uplink != NULL) {
+    doc["uplinkPendingBytes"] = uplink->getPendingBytes();
+    doc["uplinkBytesUploaded"] = uplink->getBytesUploaded();
+    doc["uplinkDroppedRecords"] = uplink->getDroppedRecords();
+    doc["uplinkFailures"] = uplink->getUploadFailures();
+  }
+  
+  sendJson(doc);
+}
+
+void ECGWebServer::handleConfigGet() {
+  if (runtimeConfig == NULL) {
+    sendText(503, "Runtime configuration not available");
+    return;
+  }
+  
+  const ECGSettings& settings = runtimeConfig->get();
+  ArenaJsonDocument doc(768, ArenaAllocator(&arena));
+  
+  doc["wifiSsid"] = settings.wifiSsid;
+  doc["wifiPasswordSet"] = settings.wifiPassword[0] != '\0';  // Never echo the password
+  doc["sampleRate"] = settings.sampleRate;
+  doc["movingAverageSize"] = settings.movingAverageSize;
+  doc["heartbeatThreshold"] = settings.heartbeatThreshold;
+  doc["adaptiveThreshold"] = settings.adaptiveThreshold;
+  doc["artifactMasking"] = settings.artifactMasking;
+  doc["minBeatInterval"] = settings.minBeatInterval;
+  doc["maxBeatInterval"] = settings.maxBeatInterval;
+  doc["dataUpdateInterval"] = settings.dataUpdateInterval;
+  doc["statusUpdateInterval"] = settings.statusUpdateInterval;
+  doc["collectorUrl"] = settings.collectorUrl;
+  doc["loadedFromStorage"] = runtimeConfig->isLoadedFromStorage();
+  
+  sendJson(doc);
+}
+
+void ECGWebServer::handleConfigPost() {
+  if (runtimeConfig == NULL) {
+    sendText(503, "Runtime configuration not available");
+    return;
+  }
+  
+  ArenaJsonDocument doc(768, ArenaAllocator(&arena));
+  DeserializationError error = readBody(doc);
+  if (error) {
+    char message[64];
+    snprintf(message, sizeof(message), "Invalid JSON: %s", error.c_str());
+    sendText(400, message);
+    return;
+  }
+  
+  if (doc["factoryReset"] | false) {
+    {
+      HeapGuard::Allow allow;  // NVS allocates while writing
+      runtimeConfig->resetToDefaults();
+    }
+    handleConfigGet();
+    return;
+  }
+  
+  // Start from the active settings so partial updates are allowed
+  ECGSettings settings = runtimeConfig->get();
+  
+  if (doc.containsKey("wifiSsid")) {
+    strlcpy(settings.wifiSsid, doc["wifiSsid"] | "", sizeof(settings.wifiSsid));
+  }
+  if (doc.containsKey("wifiPassword")) {
+    strlcpy(settings.wifiPassword, doc["wifiPassword"] | "", sizeof(settings.wifiPassword));
+  }
+  if (doc.containsKey("sampleRate")) {
+    settings.sampleRate = doc["sampleRate"];
+    
+    // Follow the rate's derived filter length unless one is given explicitly
+    const RateProfile* profile = findRateProfile(settings.sampleRate);
+    if (profile != NULL) {
+      settings.movingAverageSize = profile->movingAverageSize;
+    }
+  }
+  if (doc.containsKey("movingAverageSize")) settings.movingAverageSize = doc["movingAverageSize"];
+  if (doc.containsKey("heartbeatThreshold")) settings.heartbeatThreshold = doc["heartbeatThreshold"];
+  if (doc.containsKey("adaptiveThreshold")) settings.adaptiveThreshold = doc["adaptiveThreshold"];
+  if (doc.containsKey("artifactMasking")) settings.artifactMasking = doc["artifactMasking"];
+  if (doc.containsKey("minBeatInterval")) settings.minBeatInterval = doc["minBeatInterval"];
+  if (doc.containsKey("maxBeatInterval")) settings.maxBeatInterval = doc["maxBeatInterval"];
+  if (doc.containsKey("dataUpdateInterval")) settings.dataUpdateInterval = doc["dataUpdateInterval"];
+  if (doc.containsKey("statusUpdateInterval")) settings.statusUpdateInterval = doc["statusUpdateInterval"];
+  if (doc.containsKey("collectorUrl")) {
+    strlcpy(settings.collectorUrl, doc["collectorUrl"] | "", sizeof(settings.collectorUrl));
+  }
+  
+  const char* problem;
+  {
+    HeapGuard::Allow allow;  // NVS allocates while writing
+    problem = runtimeConfig->update(settings);
+  }
+  if (problem != NULL) {
+    char message[128];
+    snprintf(message, sizeof(message), "Invalid configuration: %s", problem);
+    sendText(400, message);
+    return;
+  }
+  
+  handleConfigGet();
+}
+
+void ECGWebServer::handleTimeGet() {
+  if (sampleClock == NULL) {
+    sendText(503, "Sample clock not available");
+    return;
+  }
+  
+  ArenaJsonDocument doc(300, ArenaAllocator(&arena));
+  uint64_t localTime = sampleClock->now();
   
-  String response;
-  serializeJson(doc, response);
+  doc["localTime"] = localTime;
+  doc["synchronized"] = sampleClock->isSynchronized();
+  if (sampleClock->isSynchronized()) {
+    doc["epochMs"] = sampleClock->toEpoch(localTime) / 1000;
+  }
+  doc["driftPpm"] = sampleClock->getDriftPpm();
+  doc["rejectedReferences"] = sampleClock->getRejectedReferences();
+  doc["sequence"] = sampleClock->getSequence();
+  doc["missedSamples"] = sampleClock->getMissedSamples();
+  
+  sendJson(doc);
+}
+
+void ECGWebServer::handleTimePost() {
+  if (sampleClock == NULL) {
+    sendText(503, "Sample clock not available");
+    return;
+  }
+  
+  // Capture local time first so JSON parsing does not add to the offset
+  uint64_t localTime = sampleClock->now();
+  
+  ArenaJsonDocument doc(128, ArenaAllocator(&arena));
+  DeserializationError error = readBody(doc);
+  if (error || !doc.containsKey("epochMs")) {
+    sendText(400, "Expected {\"epochMs\": <unix time in ms>}");
+    return;
+  }
+  
+  int64_t epochMs = doc["epochMs"].as<int64_t>();
+  sampleClock->addReference(localTime, epochMs * 1000);
+  
+  handleTimeGet();
+}
+
+void ECGWebServer::handlePower() {
+  if (energyMonitor == NULL || sampleClock == NULL) {
+    sendText(503, "Energy accounting not available");
+    return;
+  }
+  
+  uint64_t now = sampleClock->now();
+  ArenaJsonDocument doc(3072, ArenaAllocator(&arena));
+  
+  // Time per power state (ms)
+  JsonObject states = doc.createNestedObject("stateTimeMs");
+  for (int i = 0; i < POWER_STATE_COUNT; i++) {
+    PowerState state = (PowerState)i;
+    states[EnergyMonitor::getStateName(state)] = energyMonitor->getStateTime(state, now) / 1000;
+  }
+  
+  doc["averageCurrentMa"] = energyMonitor->getAverageCurrent(now);
+  doc["batteryCapacityMah"] = BATTERY_CAPACITY_MAH;
+  doc["estimatedBatteryLifeHours"] = energyMonitor->estimateBatteryLife(BATTERY_CAPACITY_MAH, now);
   
-  server.send(200, "application/json", response);
+  // Recent radio transitions, oldest first
+  JsonArray trace = doc.createNestedArray("trace");
+  for (int i = 0; i < energyMonitor->getTraceCount(); i++) {
+    PowerTransition transition = energyMonitor->getTrace(i);
+    JsonObject entry = trace.createNestedObject();
+    entry["timeMs"] = transition.time;
+    entry["state"] = EnergyMonitor::getStateName((PowerState)transition.state);
+  }
+  
+  sendJson(doc);
+}
+
+void ECGWebServer::handleWaveform() {
+  if (sampleHistory == NULL) {
+    sendText(503, "Sample history not available");
+    return;
+  }
+  
+  int seconds = 10;
+  {
+    HeapGuard::Allow allow;
+    if (server.hasArg("seconds")) seconds = server.arg("seconds").toInt();
+  }
+  if (seconds <= 0 || seconds > WAVEFORM_MAX_SECONDS) {
+    char message[48];
+    snprintf(message, sizeof(message), "seconds must be between 1 and %d", WAVEFORM_MAX_SECONDS);
+    sendText(400, message);
+    return;
+  }
+  
+  int sampleRate = runtimeConfig ? runtimeConfig->get().sampleRate : SAMPLE_RATE;
+  uint32_t toSequence = sampleHistory->getNextSequence();
+  uint32_t fromSequence = toSequence - (uint32_t)seconds * sampleRate;
+  
+  SampleSnapshot snapshot;
+  if (!sampleHistory->snapshot(fromSequence, toSequence, snapshot)) {
+    sendText(503, "No samples recorded yet");
+    return;
+  }
+  
+  // Stream in chunks straight from the ring (no copy of the window)
+  char chunk[WAVEFORM_CHUNK_SAMPLES * 6 + 192];
+  uint64_t firstSampleTime = sampleClock ? sampleClock->getSampleTime(snapshot.firstSequence) : 0;
+  int64_t firstEpochMs = sampleClock ? sampleClock->toEpoch(firstSampleTime) / 1000 : 0;
+  
+  {
+    HeapGuard::Allow allow;
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+  }
+  
+  int length = snprintf(chunk, sizeof(chunk),
+                        "{\"sampleRate\":%d,\"firstSequence\":%lu,\"firstSampleTime\":%llu,"
+                        "\"firstEpochMs\":%lld,\"gapValue\":%d,\"samples\":[",
+                        sampleRate, (unsigned long)snapshot.firstSequence,
+                        (unsigned long long)firstSampleTime, (long long)firstEpochMs, SAMPLE_GAP);
+  server.sendContent(chunk, length);
+  
+  size_t sent = 0;
+  bool overrun = false;
+  
+  for (int s = 0; s < 2 && !overrun; s++) {
+    const SampleSpan& span = snapshot.segments[s];
+    
+    for (size_t i = 0; i < span.count && !overrun; i += WAVEFORM_CHUNK_SAMPLES) {
+      size_t end = min(span.count, i + WAVEFORM_CHUNK_SAMPLES);
+      length = 0;
+      for (size_t j = i; j < end; j++) {
+        length += snprintf(chunk + length, sizeof(chunk) - length,
+                           (sent + j - i) == 0 ? "%d" : ",%d", span.data[j]);
+      }
+      
+      // The writer may have lapped this chunk while it was formatted
+      if (!sampleHistory->isValid(snapshot.firstSequence + sent)) {
+        overrun = true;
+        break;
+      }
+      
+      // A client that stops reading is dropped rather than stalling the loop
+      if (!waitForClient()) {
+        server.client().stop();
+        return;
+      }
+      server.sendContent(chunk, length);
+      sent += end - i;
+      
+      // Keep sampling while the client drains the response
+      if (backgroundTask != NULL) {
+        backgroundTask();
+      }
+    }
+  }
+  
+  length = snprintf(chunk, sizeof(chunk), "],\"count\":%u,\"overrun\":%s}",
+                    (unsigned)sent, overrun ? "true" : "false");
+  server.sendContent(chunk, length);
+  server.sendContent("");
+}
+
+void ECGWebServer::handleQuality() {
+  if (qualityMask == NULL) {
+    sendText(503, "Quality mask not available");
+    return;
+  }
+  
+  ArenaJsonDocument doc(2304, ArenaAllocator(&arena));
+  
+  doc["maskedSamples"] = qualityMask->getMaskedSamples();
+  JsonArray runs = doc.createNestedArray("runs");
+  for (int i = 0; i < qualityMask->getRunCount(); i++) {
+    const QualityRun& run = qualityMask->getRun(i);
+    JsonObject entry = runs.createNestedObject();
+    entry["firstSequence"] = run.start;
+    entry["count"] = run.length;
+    entry["flags"] = run.flags;
+  }
+  
+  sendJson(doc);
+}
+
+void ECGWebServer::handleTasks() {
+  if (scheduler == NULL) {
+    sendText(503, "Scheduler not available");
+    return;
+  }
+  
+  ArenaJsonDocument doc(JSON_ARRAY_SIZE(SCHEDULER_MAX_TASKS) +
+                        SCHEDULER_MAX_TASKS * JSON_OBJECT_SIZE(8) + 64, ArenaAllocator(&arena));
+  
+  JsonArray tasks = doc.createNestedArray("tasks");
+  for (int i = 0; i < scheduler->getTaskCount(); i++) {
+    TaskStats stats;
+    scheduler->getStats(i, stats);
+    JsonObject entry = tasks.createNestedObject();
+    entry["name"] = stats.name;
+    entry["runs"] = stats.runs;
+    entry["skippedPeriods"] = stats.skippedPeriods;
+    entry["lateMeanUs"] = stats.meanLateness;
+    entry["lateStdUs"] = stats.latenessStd;
+    entry["lateMaxUs"] = stats.maxLateness;
+    entry["runMeanUs"] = stats.meanRunTime;
+    entry["runMaxUs"] = stats.maxRunTime;
+  }
+  
+  sendJson(doc);
+}
+
+void ECGWebServer::handleMetrics() {
+  if (bootProfile == NULL) {
+    sendText(503, "Boot profile not available");
+    return;
+  }
+  
+  ArenaJsonDocument doc(JSON_ARRAY_SIZE(BOOT_MAX_PHASES) + BOOT_MAX_PHASES * JSON_OBJECT_SIZE(2) +
+                        JSON_OBJECT_SIZE(8) + 64, ArenaAllocator(&arena));
+  
+  JsonArray phases = doc.createNestedArray("bootPhases");
+  for (int i = 0; i < bootProfile->getPhaseCount(); i++) {
+    const BootPhase& phase = bootProfile->getPhase(i);
+    JsonObject entry = phases.createNestedObject();
+    entry["name"] = phase.name;
+    entry["us"] = phase.time;
+  }
+  
+  uint32_t firstSample;
+  if (bootProfile->getTime(BOOT_PHASE_FIRST_SAMPLE, firstSample)) {
+    doc["timeToFirstSampleUs"] = firstSample;
+  }
+  doc["firstSampleTargetUs"] = BOOT_FIRST_SAMPLE_TARGET_US;
+  
+  if (wifiLink != NULL) {
+    doc["wifiConnectAttempts"] = wifiLink->getConnectAttempts();
+    doc["wifiCachedConnects"] = wifiLink->getCachedConnects();
+    doc["wifiLastConnectMs"] = wifiLink->getLastConnectTime();
+  }
+  doc["uptime"] = millis();
+  
+  sendJson(doc);
 }
 
 void ECGWebServer::handleNotFound() {
-  String message = "File Not Found\n\n";
-  message += "URI: " + server.uri() + "\n";
-  message += "Method: " + (server.method() == HTTP_GET ? "GET" : "POST") + "\n";
-  message += "Arguments: " + String(server.args()) + "\n";
+  size_t capacity = WEB_ARENA_SIZE / 2;
+  char* message = (char*)arena.allocate(capacity, 1);
+  if (message == NULL) return;
+  
+  // Request details are only available as String copies
+  HeapGuard::Allow allow;
+  int length = snprintf(message, capacity, "File Not Found\n\nURI: %s\nMethod: %s\nArguments: %d\n",
+                        server.uri().c_str(), server.method() == HTTP_GET ? "GET" : "POST",
+                        server.args());
   
-  for (uint8_t i = 0; i < server.args(); i++) {
-    message += " " + server.argName(i) + ": " + server.arg(i) + "\n";
+  for (int i = 0; i < server.args() && length < (int)capacity; i++) {
+    length += snprintf(message + length, capacity - length, " %s: %s\n",
+                       server.argName(i).c_str(), server.arg(i).c_str());
   }
   
-  server.send(404, "text/plain", message);
+  server.send_P(404, "text/plain", message, min(length, (int)capacity - 1));
 }
 
-String ECGWebServer::generateHTML() {
-  return R"(
+// Page lives in flash and is sent without a RAM copy
+static const char INDEX_HTML[] PROGMEM = R"(
 <!DOCTYPE html>
 <html>
 <head>
@@ -491,9 +960,16 @@ String ECGWebServer::generateHTML() {
             return (bytes / 1048576).toFixed(1) + ' MB';
         }
         
-        // Update intervals
-        setInterval(updateData, 20);     // 50 Hz data updates
-        setInterval(updateStatus, 1000); // 1 Hz status updates
+        // Update intervals come from the runtime configuration
+        function startUpdates(dataInterval, statusInterval) {
+            setInterval(updateData, dataInterval);
+            setInterval(updateStatus, statusInterval);
+        }
+        
+        fetch('/config')
+            .then(response => response.json())
+            .then(config => startUpdates(config.dataUpdateInterval, config.statusUpdateInterval))
+            .catch(() => startUpdates(20, 1000));  // 50 Hz data, 1 Hz status
         
         // Initial updates
         updateData();
@@ -506,4 +982,9 @@ String ECGWebServer::generateHTML() {
 </body>
 </html>
 )";
+
+const char* ECGWebServer::generateHTML() {
+  return INDEX_HTML;
 }
+
+#endif // ECG_FEATURE_NETWORK
@@ -1,53 +1,147 @@
 /*
  * ECG Web Server Class Header
  * 
- * Handles WiFi connection, web server setup, and HTTP endpoints
- * for real-time ECG data visualization
+ * Web server setup and HTTP endpoints for real-time ECG data
+ * visualization. The server starts once the WiFi link is connected.
  */
 
 #ifndef WEB_SERVER_H
 #define WEB_SERVER_H
 
+#include "../config/features.h"
+
+#if ECG_FEATURE_NETWORK
+
 #include <WiFi.h>
 #include <WebServer.h>
 #include <ArduinoJson.h>
+#include "../config/runtime_config.h"
+#include "../sensors/sample_clock.h"
+#include "../uplink/uplink.h"
+#include "../power/energy_monitor.h"
+#include "../storage/sample_history.h"
+#include "../processing/quality_mask.h"
+#include "../memory/memory_arena.h"
+#include "../network/wifi_link.h"
+#include "../scheduler/scheduler.h"
+#include "../telemetry/boot_profile.h"
 
 class ECGWebServer {
 private:
   WebServer server;
   bool wifiConnected;
+  bool enabled;             // begin() was called (not in low power mode)
   bool serverStarted;
+  RuntimeConfig* runtimeConfig;
+  SampleClock* sampleClock;
+  Uplink* uplink;
+  EnergyMonitor* energyMonitor;
+  SampleHistory* sampleHistory;
+  QualityMask* qualityMask;
+  WiFiLink* wifiLink;
+  Scheduler* scheduler;
+  BootProfile* bootProfile;
+  void (*backgroundTask)();
+  
+  // Per-request scratch: JSON documents and response text
+  StaticArena<WEB_ARENA_SIZE> arena;
+  char ipAddress[16];
+  char connectionInfo[96];
   
   // Current data
   int currentECGValue;
   int currentHeartRate;
+  int currentInstantHeartRate;
+  int currentInstantConfidence;
+  int currentHeartRateConfidence;
   int currentSignalQuality;
   bool leadsConnected;
   unsigned long lastDataUpdate;
+  uint32_t currentSequence;
+  uint64_t currentSampleTime;
+  
+  // Threshold calibration
+  int currentThreshold;
+  int currentBaseline;
+  int currentNoiseFloor;
+  int currentPeakAmplitude;
+  bool thresholdCalibrated;
   
   // Internal methods
-  bool connectToWiFi();
+  void startServer();
   void setupRoutes();
-  String generateHTML();
+  const char* generateHTML();
+  void runHandler(void (ECGWebServer::*handler)());
+  void sendJson(JsonDocument& doc);
+  void sendText(int code, const char* text);
+  bool waitForClient();
+  DeserializationError readBody(JsonDocument& doc);
   
   // Route handlers
   void handleRoot();
   void handleData();
   void handleStatus();
+  void handleConfigGet();
+  void handleConfigPost();
+  void handleTimeGet();
+  void handleTimePost();
+  void handlePower();
+  void handleWaveform();
+  void handleQuality();
+  void handleTasks();
+  void handleMetrics();
   void handleNotFound();
   
 public:
   // Constructor
   ECGWebServer();
   
-  // Initialize WiFi and web server
+  // Attach runtime configuration (call before begin)
+  void setRuntimeConfig(RuntimeConfig* config) { runtimeConfig = config; }
+  
+  // Attach the sample clock for timestamps and /time (call before begin)
+  void setSampleClock(SampleClock* clock) { sampleClock = clock; }
+  
+  // Attach the uplink for /status reporting (call before begin)
+  void setUplink(Uplink* uplink) { this->uplink = uplink; }
+  
+  // Attach energy accounting for /power (call before begin)
+  void setEnergyMonitor(EnergyMonitor* monitor) { energyMonitor = monitor; }
+  
+  // Attach the sample history for /waveform (call before begin)
+  void setSampleHistory(SampleHistory* history) { sampleHistory = history; }
+  
+  // Attach the artifact mask for /quality (call before begin)
+  void setQualityMask(QualityMask* mask) { qualityMask = mask; }
+  
+  // Attach the WiFi link the server follows (call before begin)
+  void setWiFiLink(WiFiLink* link) { wifiLink = link; }
+  
+  // Attach the task scheduler for /tasks (call before begin)
+  void setScheduler(Scheduler* scheduler) { this->scheduler = scheduler; }
+  
+  // Attach the boot phase timestamps for /metrics (call before begin)
+  void setBootProfile(BootProfile* profile) { bootProfile = profile; }
+  
+  // Work to keep running while a long response is streamed (e.g. sampling)
+  void setBackgroundTask(void (*task)()) { backgroundTask = task; }
+  
+  // Prepare the web server; it starts when the WiFi link comes up
   bool begin();
   
-  // Handle client requests
+  // Handle client requests (starts the server once WiFi comes up, if begin() was called)
   void handleClient();
   
-  // Update ECG data
-  void updateECGData(int ecgValue, int heartRate, int signalQuality);
+  // Update ECG data (sequence number and scheduled local time of the sample)
+  void updateECGData(int ecgValue, int heartRate, int signalQuality,
+                     uint32_t sequence, uint64_t sampleTime);
+  
+  // Update the beat-to-beat rate and the heart rate confidence values
+  void updateHeartRate(int instantHeartRate, int instantConfidence, int confidence);
+  
+  // Update learned threshold calibration values
+  void updateCalibration(int threshold, int baseline, int noiseFloor,
+                         int peakAmplitude, bool calibrated);
   
   // Update lead connection status
   void updateLeadStatus(bool connected);
@@ -57,8 +151,12 @@ public:
   bool isServerRunning() { return serverStarted; }
   
   // Get IP address
-  String getIPAddress();
+  const char* getIPAddress();
   
   // Get connection info
-  String getConnectionInfo();
+  const char* getConnectionInfo();
 };
+
+#endif // ECG_FEATURE_NETWORK
+
+#endif // WEB_SERVER_H
@@ -0,0 +1,252 @@
+/*
+ * ECG Batch Analyzer
+ * 
+ * Offline beat detection, heart rate trend and HRV for long recordings,
+ * using the device's SignalProcessor in parallel chunks.
+ * 
+ * Usage: ecg_analyze <recording.eca|recording.txt> [options]
+ *        ecg_analyze --simulate HOURS [options]
+ * 
+ *   --threads N           worker threads (default: all cores)
+ *   --chunk-minutes M     chunk length (default 20)
+ *   --warmup-seconds S    processing before each chunk start (default 32
+ *                         calibration windows, 128 s at device rates)
+ *   --verify              also run the streaming pass and compare
+ *   --bench               streaming vs 1, 2, 4 ... N threads, each verified
+ *   --beats FILE          write beats as CSV (sample,seconds,bpm)
+ *   --trend FILE          write the per-second trend as CSV
+ *   --mask FILE           write artifact mask changes as CSV (sample,seconds,flags)
+ *   --rate HZ, --seed N   simulator settings (default 500 Hz, seed 1)
+ */
+
+#include "batch_analyzer.h"
+#include "recording_input.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+static bool hasFlag(int argc, char** argv, const char* name) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return true;
+  }
+  return false;
+}
+
+static double timeStreaming(BatchAnalyzer& analyzer, AnalysisOutput& out) {
+  std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+  analyzer.analyzeStreaming(out);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+}
+
+// Makespan of the measured tasks on a given number of cores, handed out
+// in submission order to the first free worker (what stealing converges to)
+static double projectMakespan(const std::vector<double>& taskSeconds, int cores) {
+  std::vector<double> load(cores, 0.0);
+  for (size_t i = 0; i < taskSeconds.size(); i++) {
+    *std::min_element(load.begin(), load.end()) += taskSeconds[i];
+  }
+  return *std::max_element(load.begin(), load.end());
+}
+
+static void printStats(const BatchStats& stats) {
+  double taskTotal = 0;
+  for (size_t i = 0; i < stats.taskSeconds.size(); i++) taskTotal += stats.taskSeconds[i];
+  
+  printf("Chunks: %zu (%zu matched at the boundary, %zu repaired, %llu samples re-run)\n",
+         stats.chunks, stats.chunksMatched, stats.chunksRepaired,
+         (unsigned long long)stats.repairedSamples);
+  printf("Work: %.2f s in tasks, %.3f s stitching, %llu steals\n",
+         taskTotal, stats.stitchSeconds, (unsigned long long)stats.steals);
+}
+
+static bool writeBeats(const char* path, const AnalysisOutput& out, uint32_t sampleRate) {
+  FILE* file = fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "ERROR: cannot write %s\n", path);
+    return false;
+  }
+  fprintf(file, "sample,seconds,bpm\n");
+  for (size_t i = 0; i < out.beats.size(); i++) {
+    fprintf(file, "%llu,%.3f,%d\n", (unsigned long long)out.beats[i].sample,
+            (double)out.beats[i].sample / sampleRate, out.beats[i].heartRate);
+  }
+  fclose(file);
+  return true;
+}
+
+static bool writeTrend(const char* path, const AnalysisOutput& out, uint32_t sampleRate) {
+  FILE* file = fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "ERROR: cannot write %s\n", path);
+    return false;
+  }
+  fprintf(file, "seconds,bpm,confidence,threshold,quality\n");
+  for (size_t i = 0; i < out.trend.size(); i++) {
+    const TrendPoint& point = out.trend[i];
+    fprintf(file, "%llu,%d,%d,%d,%d\n", (unsigned long long)((point.sample + 1) / sampleRate),
+            point.heartRate, point.confidence, point.threshold, point.signalQuality);
+  }
+  fclose(file);
+  return true;
+}
+
+static bool writeMask(const char* path, const AnalysisOutput& out, uint32_t sampleRate) {
+  FILE* file = fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "ERROR: cannot write %s\n", path);
+    return false;
+  }
+  fprintf(file, "sample,seconds,flags\n");
+  for (size_t i = 0; i < out.mask.size(); i++) {
+    fprintf(file, "%llu,%.3f,%u\n", (unsigned long long)out.mask[i].sample,
+            (double)out.mask[i].sample / sampleRate, out.mask[i].flags);
+  }
+  fclose(file);
+  return true;
+}
+
+static int runBench(BatchAnalyzer& analyzer, BatchOptions options, const AnalysisOutput& reference,
+                    double streamingSeconds, uint64_t samples) {
+  int cores = (int)std::thread::hardware_concurrency();
+  int maxThreads = options.threads;
+  
+  printf("\nStreaming: %.2f s (%.1f MS/s)\n", streamingSeconds, samples / streamingSeconds / 1e6);
+  printf("Cores available: %d\n\n", cores);
+  printf("threads   wall s   speedup   projected   output\n");
+  
+  // Task times from the single-thread run are free of contention
+  std::vector<double> taskSeconds;
+  double serialSeconds = 0;
+  bool allEqual = true;
+  
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    options.threads = threads;
+    AnalysisOutput out;
+    BatchStats stats;
+    analyzer.analyzeParallel(options, out, stats);
+    
+    char detail[160];
+    bool equal = outputsEqual(reference, out, detail, sizeof(detail));
+    allEqual = allEqual && equal;
+    
+    if (threads == 1) {
+      taskSeconds = stats.taskSeconds;
+      serialSeconds = std::max(0.0, stats.wallSeconds - projectMakespan(taskSeconds, 1));
+    }
+    double projected = streamingSeconds / (serialSeconds + projectMakespan(taskSeconds, threads));
+    
+    if (threads <= cores) {
+      printf("%7d %8.2f %8.2fx %10.2fx   ", threads, stats.wallSeconds,
+             streamingSeconds / stats.wallSeconds, projected);
+    } else {
+      printf("%7d %8.2f %9s %10.2fx   ", threads, stats.wallSeconds, "-", projected);
+    }
+    printf("%s%s\n", equal ? "identical" : "DIFFERS: ", equal ? "" : detail);
+    
+    if (threads == 1) {
+      printf("          (%zu chunks, %.1f%% extra samples for warm-up)\n", stats.chunks,
+             100.0 * (stats.processedSamples - samples) / samples);
+    }
+  }
+  
+  printf("\nProjected: single-thread task times scheduled on that many cores plus\n"
+         "the serial planning and stitching. Runs with more threads than cores\n"
+         "(speedup '-') still check that the output does not depend on them.\n");
+  return allEqual ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: ecg_analyze <recording.eca|recording.txt> [options]\n"
+                    "       ecg_analyze --simulate HOURS [options]\n");
+    return 2;
+  }
+  
+  Recording recording;
+  const char* simulate = getOption(argc, argv, "--simulate", NULL);
+  if (simulate != NULL) {
+    simulateRecording(atof(simulate), atoi(getOption(argc, argv, "--rate", "500")),
+                      (uint32_t)atoi(getOption(argc, argv, "--seed", "1")), recording);
+  } else if (!loadRecording(argv[1], recording)) {
+    return 1;
+  }
+  
+  BatchAnalyzer analyzer;
+  if (!analyzer.begin(recording)) return 1;
+  
+  int cores = std::max(1, (int)std::thread::hardware_concurrency());
+  uint64_t window = analyzer.getCalibrationWindow();
+  
+  BatchOptions options;
+  options.threads = atoi(getOption(argc, argv, "--threads", "0"));
+  if (options.threads <= 0) options.threads = cores;
+  options.chunkSamples = (uint64_t)(atof(getOption(argc, argv, "--chunk-minutes", "20")) * 60 *
+                                    recording.sampleRate);
+  // The threshold EMA halves a start-up difference per window, so 32
+  // windows take it below float resolution
+  options.warmupSamples = 32 * window;
+  const char* warmup = getOption(argc, argv, "--warmup-seconds", NULL);
+  if (warmup != NULL) options.warmupSamples = (uint64_t)(atof(warmup) * recording.sampleRate);
+  options.checkpointSamples = 4 * window;
+  if (options.chunkSamples < window) options.chunkSamples = window;
+  
+  uint64_t samples = recording.samples.size();
+  printf("Recording: %.2f h at %u Hz, %llu samples (%.1f%% gaps)\n",
+         samples / 3600.0 / recording.sampleRate, recording.sampleRate,
+         (unsigned long long)samples, 100.0 * recording.gapSamples / samples);
+  
+  AnalysisOutput reference;
+  bool verify = hasFlag(argc, argv, "--verify") || hasFlag(argc, argv, "--bench");
+  double streamingSeconds = verify ? timeStreaming(analyzer, reference) : 0;
+  
+  if (hasFlag(argc, argv, "--bench")) {
+    return runBench(analyzer, options, reference, streamingSeconds, samples);
+  }
+  
+  AnalysisOutput out;
+  BatchStats stats;
+  analyzer.analyzeParallel(options, out, stats);
+  
+  HrvSummary hrv;
+  analyzer.summarizeHrv(out, hrv);
+  
+  printf("Analyzed in %.2f s on %d threads (%.1f MS/s)\n", stats.wallSeconds, options.threads,
+         samples / stats.wallSeconds / 1e6);
+  printStats(stats);
+  printf("Beats: %zu, mean HR %.1f BPM\n", out.beats.size(), hrv.meanHeartRate);
+  printf("Artifacts: %.2f%% of samples masked, %zu mask changes\n",
+         100.0 * analyzer.countMaskedSamples(out) / samples, out.mask.size());
+  printf("HRV: %zu intervals, mean RR %.1f ms, SDNN %.1f ms, RMSSD %.1f ms, pNN50 %.1f%%\n",
+         hrv.intervals, hrv.meanRR, hrv.sdnn, hrv.rmssd, hrv.pnn50);
+  
+  int result = 0;
+  if (verify) {
+    char detail[160];
+    if (outputsEqual(reference, out, detail, sizeof(detail))) {
+      printf("Verify: identical to the streaming run (%.2f s, speedup %.2fx)\n",
+             streamingSeconds, streamingSeconds / stats.wallSeconds);
+    } else {
+      printf("Verify: DIFFERS from the streaming run: %s\n", detail);
+      result = 1;
+    }
+  }
+  
+  const char* beatsPath = getOption(argc, argv, "--beats", NULL);
+  if (beatsPath != NULL && !writeBeats(beatsPath, out, recording.sampleRate)) result = 1;
+  const char* trendPath = getOption(argc, argv, "--trend", NULL);
+  if (trendPath != NULL && !writeTrend(trendPath, out, recording.sampleRate)) result = 1;
+  const char* maskPath = getOption(argc, argv, "--mask", NULL);
+  if (maskPath != NULL && !writeMask(maskPath, out, recording.sampleRate)) result = 1;
+  
+  return result;
+}
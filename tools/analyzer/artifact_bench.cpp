@@ -0,0 +1,229 @@
+/*
+ * Artifact Detection Benchmark
+ * 
+ * Runs the device SignalProcessor over simulated ECG with motion artifact
+ * episodes (electrode swings plus muscle noise, 15 s every 5 minutes)
+ * and measures:
+ * 
+ *   - ArtifactDetector and SignalProcessor cost per sample, against the sample
+ *     interval at the simulated rate
+ *   - detection: share of artifact samples masked, clean samples masked
+ *     and the delay from episode start to the first masked sample
+ *   - effect on the reported heart rate: error against the simulator's
+ *     rate and false beats, with masking on and off
+ * 
+ * Usage: artifact_bench [--hours N] [--rate HZ] [--seed N]
+ */
+
+#include "config/runtime_config.h"
+#include "processing/artifact_detector.h"
+#include "processing/signal_processor.h"
+#include "simulation/ecg_simulator.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const float SIMULATED_HEART_RATE = 72;
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+static double nowSeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct SimulatedSignal {
+  std::vector<int16_t> samples;
+  std::vector<uint8_t> artifact;     // Ground truth per sample
+  std::vector<uint8_t> beat;         // Simulator R-peaks
+};
+
+static void simulate(double hours, int sampleRate, uint32_t seed, SimulatedSignal& out) {
+  ECGSimulatorParams params;
+  ECGSimulator::getDefaults(params);
+  params.sampleRate = sampleRate;
+  params.heartRate = SIMULATED_HEART_RATE;
+  params.hrvStd = 30;
+  params.noiseStd = 4;
+  params.baselineWanderAmplitude = 60;
+  params.mainsAmplitude = 10;
+  params.artifactPeriod = 5UL * 60 * 1000;
+  params.artifactDuration = 15UL * 1000;
+  params.artifactAmplitude = 600;
+  params.seed = seed;
+  
+  ECGSimulator simulator;
+  simulator.begin(params);
+  
+  size_t total = (size_t)(hours * 3600 * sampleRate);
+  out.samples.resize(total);
+  out.artifact.resize(total);
+  out.beat.resize(total);
+  for (size_t i = 0; i < total; i++) {
+    out.samples[i] = (int16_t)simulator.nextSample();
+    out.artifact[i] = simulator.isArtifact();
+    out.beat[i] = simulator.isBeatOnset();
+  }
+}
+
+struct RunResult {
+  double nsPerSample;
+  uint64_t artifactSamples;
+  uint64_t artifactMasked;
+  uint64_t cleanSamples;
+  uint64_t cleanMasked;
+  std::vector<double> onsetDelaysMs;
+  double hrErrorAll;             // Mean absolute error per second (BPM)
+  double hrErrorNearArtifact;    // Seconds within an episode or the 20 s after it
+  double hrWorstNearArtifact;
+  uint64_t beats;
+  uint64_t falseBeats;           // Detections with no R-peak within 100 ms
+};
+
+static void runProcessor(const SimulatedSignal& signal, int sampleRate, bool masking, RunResult& result) {
+  ECGSettings settings;
+  RuntimeConfig::getDefaults(settings);
+  settings.sampleRate = sampleRate;
+  const RateProfile* profile = findRateProfile(sampleRate);
+  if (profile != NULL) settings.movingAverageSize = profile->movingAverageSize;
+  settings.artifactMasking = masking;
+  
+  SignalProcessor processor;
+  processor.begin();
+  processor.requestSettings(settings);
+  
+  // Detections first, scored afterwards so timing covers processing only
+  size_t total = signal.samples.size();
+  std::vector<uint8_t> masked(total);
+  std::vector<uint8_t> detected(total);
+  std::vector<int16_t> heartRate(total / sampleRate + 1);
+  
+  double started = nowSeconds();
+  for (size_t i = 0; i < total; i++) {
+    processor.processSample(signal.samples[i]);
+    masked[i] = processor.getArtifactFlags() != 0;
+    detected[i] = processor.isHeartbeatDetected();
+    if ((i + 1) % sampleRate == 0) heartRate[i / sampleRate] = processor.getHeartRate();
+  }
+  result = RunResult();
+  result.nsPerSample = (nowSeconds() - started) * 1e9 / total;
+  
+  // Mask against the simulator's episodes
+  for (size_t i = 0; i < total; i++) {
+    if (signal.artifact[i]) {
+      result.artifactSamples++;
+      if (masked[i]) result.artifactMasked++;
+      if (i == 0 || !signal.artifact[i - 1]) {
+        size_t j = i;
+        while (j < total && signal.artifact[j] && !masked[j]) j++;
+        if (j < total && signal.artifact[j]) result.onsetDelaysMs.push_back((j - i) * 1000.0 / sampleRate);
+      }
+    } else {
+      result.cleanSamples++;
+      if (masked[i]) result.cleanMasked++;
+    }
+  }
+  
+  // Beats without a simulated R-peak nearby (the filter delays detection)
+  int tolerance = sampleRate / 10;
+  for (size_t i = 0; i < total; i++) {
+    if (!detected[i]) continue;
+    result.beats++;
+    bool matched = false;
+    for (size_t j = i > (size_t)tolerance ? i - tolerance : 0; j <= i + tolerance && j < total; j++) {
+      if (signal.beat[j]) {
+        matched = true;
+        break;
+      }
+    }
+    if (!matched) result.falseBeats++;
+  }
+  
+  // Heart rate per second after the first minute, near episodes and elsewhere
+  double errorSum = 0, nearSum = 0;
+  size_t errorCount = 0, nearCount = 0;
+  size_t afterSamples = (size_t)20 * sampleRate;
+  size_t lastArtifact = (size_t)-1;
+  for (size_t second = 0; second + 1 < heartRate.size(); second++) {
+    size_t end = (second + 1) * sampleRate;
+    for (size_t i = second * sampleRate; i < end; i++) {
+      if (signal.artifact[i]) lastArtifact = i;
+    }
+    if (second < 60) continue;
+    
+    double error = fabs(heartRate[second] - SIMULATED_HEART_RATE);
+    errorSum += error;
+    errorCount++;
+    if (lastArtifact != (size_t)-1 && end - lastArtifact <= afterSamples) {
+      nearSum += error;
+      nearCount++;
+      result.hrWorstNearArtifact = std::max(result.hrWorstNearArtifact, error);
+    }
+  }
+  result.hrErrorAll = errorCount > 0 ? errorSum / errorCount : 0;
+  result.hrErrorNearArtifact = nearCount > 0 ? nearSum / nearCount : 0;
+}
+
+static double detectorCost(const SimulatedSignal& signal, int sampleRate) {
+  ArtifactDetector detector;
+  detector.configure(sampleRate, sampleRate * CALIBRATION_WINDOW_MS / 1000);
+  
+  uint32_t sink = 0;
+  double started = nowSeconds();
+  for (size_t i = 0; i < signal.samples.size(); i++) {
+    sink += detector.addSample(signal.samples[i]);
+  }
+  double ns = (nowSeconds() - started) * 1e9 / signal.samples.size();
+  if (sink == 0xFFFFFFFF) printf(" ");
+  return ns;
+}
+
+int main(int argc, char** argv) {
+  double hours = atof(getOption(argc, argv, "--hours", "2"));
+  int sampleRate = atoi(getOption(argc, argv, "--rate", "500"));
+  uint32_t seed = (uint32_t)atoi(getOption(argc, argv, "--seed", "1"));
+  
+  SimulatedSignal signal;
+  simulate(hours, sampleRate, seed, signal);
+  printf("Signal: %.1f h at %d Hz, %d BPM, artifact episodes 15 s every 5 min\n\n",
+         hours, sampleRate, (int)SIMULATED_HEART_RATE);
+  
+  double budgetNs = 1e9 / sampleRate;
+  double detectorNs = detectorCost(signal, sampleRate);
+  RunResult on, off;
+  runProcessor(signal, sampleRate, false, off);
+  runProcessor(signal, sampleRate, true, on);
+  
+  printf("Cost per sample (this host):\n");
+  printf("  ArtifactDetector           %7.1f ns (%.4f%% of the %.0f us budget)\n",
+         detectorNs, 100 * detectorNs / budgetNs, budgetNs / 1000);
+  printf("  processSample, no masking  %7.1f ns\n", off.nsPerSample);
+  printf("  processSample, masking     %7.1f ns\n\n", on.nsPerSample);
+  
+  std::vector<double>& delays = on.onsetDelaysMs;
+  std::sort(delays.begin(), delays.end());
+  printf("Detection:\n");
+  printf("  artifact samples masked    %6.2f%%\n", 100.0 * on.artifactMasked / on.artifactSamples);
+  printf("  clean samples masked       %6.2f%%\n", 100.0 * on.cleanMasked / on.cleanSamples);
+  if (!delays.empty()) {
+    printf("  onset delay                median %.0f ms, max %.0f ms (%zu episodes)\n\n",
+           delays[delays.size() / 2], delays.back(), delays.size());
+  }
+  
+  printf("Heart rate         masking off   masking on\n");
+  printf("  error, all       %8.2f BPM %8.2f BPM\n", off.hrErrorAll, on.hrErrorAll);
+  printf("  error, artifacts %8.2f BPM %8.2f BPM\n", off.hrErrorNearArtifact, on.hrErrorNearArtifact);
+  printf("  worst, artifacts %8.0f BPM %8.0f BPM\n", off.hrWorstNearArtifact, on.hrWorstNearArtifact);
+  printf("  beats            %8llu     %8llu\n", (unsigned long long)off.beats,
+         (unsigned long long)on.beats);
+  printf("  false beats      %8llu     %8llu\n", (unsigned long long)off.falseBeats,
+         (unsigned long long)on.falseBeats);
+  return 0;
+}
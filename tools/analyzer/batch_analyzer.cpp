@@ -0,0 +1,334 @@
+/*
+ * Batch Analyzer Class Implementation
+ */
+
+#include "batch_analyzer.h"
+#include "work_stealing_pool.h"
+#include "codec/sample_codec.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+BatchAnalyzer::BatchAnalyzer() {
+  recording = NULL;
+  RuntimeConfig::getDefaults(settings);
+  calibrationWindow = CALIBRATION_WINDOW_SIZE;
+}
+
+bool BatchAnalyzer::begin(const Recording& recording) {
+  this->recording = &recording;
+  
+  RuntimeConfig::getDefaults(settings);
+  settings.sampleRate = recording.sampleRate;
+  
+  const RateProfile* profile = findRateProfile(recording.sampleRate);
+  if (profile != NULL) {
+    settings.movingAverageSize = profile->movingAverageSize;
+    calibrationWindow = profile->calibrationWindowSize;
+  } else {
+    // Not a device rate: generic filter, the processor keeps its default window
+    settings.movingAverageSize = (recording.sampleRate * MOVING_AVERAGE_WINDOW_MS + 500) / 1000;
+    calibrationWindow = CALIBRATION_WINDOW_SIZE;
+    if (settings.movingAverageSize < 1 || settings.movingAverageSize > MAX_MOVING_AVERAGE_SIZE) {
+      fprintf(stderr, "ERROR: %u Hz needs a %d-sample filter (max %d)\n", recording.sampleRate,
+              settings.movingAverageSize, MAX_MOVING_AVERAGE_SIZE);
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+void BatchAnalyzer::prepare(SignalProcessor& processor) {
+  processor.begin();
+  processor.requestSettings(settings);
+}
+
+void BatchAnalyzer::processFrame(SignalProcessor& processor, uint64_t index, AnalysisOutput* output) {
+  int16_t value = recording->samples[index];
+  uint8_t previousFlags = processor.getArtifactFlags();
+  
+  // Same calls as handleSample() on the device
+  if (value == SAMPLE_GAP_VALUE) {
+    processor.skipSample();
+  } else {
+    processor.processSample(value);
+    if (processor.isHeartbeatDetected() && output != NULL) {
+      BeatRecord beat = { index, processor.getHeartRate() };
+      output->beats.push_back(beat);
+    }
+  }
+  
+  // The flags are processor state, so chunks agree on transitions at their
+  // boundaries once the states match
+  if (output != NULL && processor.getArtifactFlags() != previousFlags) {
+    MaskChange change = { index, processor.getArtifactFlags() };
+    output->mask.push_back(change);
+  }
+  
+  if (output != NULL && (index + 1) % recording->sampleRate == 0) {
+    TrendPoint point = { index, processor.getHeartRate(), processor.getHeartRateConfidence(),
+                         processor.getThreshold(), processor.getSignalQuality() };
+    output->trend.push_back(point);
+  }
+}
+
+void BatchAnalyzer::analyzeStreaming(AnalysisOutput& out) {
+  out.beats.clear();
+  out.trend.clear();
+  out.mask.clear();
+  
+  SignalProcessor processor;
+  prepare(processor);
+  
+  uint64_t total = recording->samples.size();
+  for (uint64_t i = 0; i < total; i++) {
+    processFrame(processor, i, &out);
+  }
+}
+
+void BatchAnalyzer::planChunks(const BatchOptions& options, std::vector<ChunkTask>& tasks) {
+  uint64_t total = recording->samples.size();
+  size_t count = (size_t)((total + options.chunkSamples - 1) / options.chunkSamples);
+  
+  tasks.resize(count);
+  for (size_t k = 0; k < count; k++) {
+    tasks[k].begin = k * options.chunkSamples;
+    tasks[k].end = std::min(total, tasks[k].begin + options.chunkSamples);
+    tasks[k].warmupStart = 0;
+  }
+  
+  // A warm-up starts where the streaming processor starts a calibration
+  // window. Windows count processed samples only, so lead-off gaps shift
+  // them against the sample index.
+  uint64_t processed = 0;
+  uint64_t lastAligned = 0;
+  size_t next = 1;
+  
+  for (uint64_t i = 0; next < count; i++) {
+    if (processed % calibrationWindow == 0) lastAligned = i;
+    
+    while (next < count) {
+      uint64_t begin = tasks[next].begin;
+      uint64_t target = begin > options.warmupSamples ? begin - options.warmupSamples : 0;
+      if (target != i) break;
+      tasks[next++].warmupStart = lastAligned;
+    }
+    
+    if (recording->samples[i] != SAMPLE_GAP_VALUE) processed++;
+  }
+}
+
+void BatchAnalyzer::runChunk(ChunkTask& task, uint64_t checkpointSpacing) {
+  std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+  
+  SignalProcessor processor;
+  prepare(processor);
+  
+  for (uint64_t i = task.warmupStart; i < task.end; i++) {
+    if (i >= task.begin && (i - task.begin) % checkpointSpacing == 0) {
+      task.checkpointSamples.push_back(i);
+      task.checkpoints.push_back(processor);
+    }
+    processFrame(processor, i, i >= task.begin ? &task.output : NULL);
+  }
+  
+  task.finalState = processor;
+  task.seconds = secondsSince(started);
+}
+
+static bool beatBefore(const BeatRecord& beat, uint64_t sample) { return beat.sample < sample; }
+static bool pointBefore(const TrendPoint& point, uint64_t sample) { return point.sample < sample; }
+static bool changeBefore(const MaskChange& change, uint64_t sample) { return change.sample < sample; }
+
+void BatchAnalyzer::stitch(std::vector<ChunkTask>& tasks, AnalysisOutput& out, BatchStats& stats) {
+  // The true streaming state, carried from chunk to chunk
+  SignalProcessor truth;
+  prepare(truth);
+  
+  for (size_t k = 0; k < tasks.size(); k++) {
+    ChunkTask& task = tasks[k];
+    uint64_t position = task.begin;
+    size_t checkpoint = 0;
+    bool adopted = false;
+    
+    while (true) {
+      while (checkpoint < task.checkpointSamples.size() &&
+             task.checkpointSamples[checkpoint] < position) {
+        checkpoint++;
+      }
+      
+      // Converged: the task's output from here on is the streaming output
+      if (checkpoint < task.checkpointSamples.size() &&
+          task.checkpointSamples[checkpoint] == position &&
+          truth.hasSameState(task.checkpoints[checkpoint])) {
+        std::vector<BeatRecord>::const_iterator beat = std::lower_bound(
+          task.output.beats.begin(), task.output.beats.end(), position, beatBefore);
+        std::vector<TrendPoint>::const_iterator point = std::lower_bound(
+          task.output.trend.begin(), task.output.trend.end(), position, pointBefore);
+        std::vector<MaskChange>::const_iterator change = std::lower_bound(
+          task.output.mask.begin(), task.output.mask.end(), position, changeBefore);
+        out.beats.insert(out.beats.end(), beat, task.output.beats.cend());
+        out.trend.insert(out.trend.end(), point, task.output.trend.cend());
+        out.mask.insert(out.mask.end(), change, task.output.mask.cend());
+        truth = task.finalState;
+        adopted = true;
+        break;
+      }
+      
+      if (position == task.end) break;
+      processFrame(truth, position++, &out);
+    }
+    
+    if (adopted && position == task.begin) {
+      stats.chunksMatched++;
+    } else {
+      stats.chunksRepaired++;
+      stats.repairedSamples += position - task.begin;
+    }
+    
+    // Snapshots are only needed for this chunk
+    std::vector<SignalProcessor>().swap(task.checkpoints);
+  }
+}
+
+void BatchAnalyzer::analyzeParallel(const BatchOptions& options, AnalysisOutput& out, BatchStats& stats) {
+  std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+  
+  out.beats.clear();
+  out.trend.clear();
+  out.mask.clear();
+  stats = BatchStats();
+  
+  std::vector<ChunkTask> tasks;
+  planChunks(options, tasks);
+  
+  WorkStealingPool pool;
+  pool.begin(options.threads);
+  for (size_t k = 0; k < tasks.size(); k++) {
+    ChunkTask* task = &tasks[k];
+    uint64_t spacing = options.checkpointSamples;
+    pool.submit([this, task, spacing] { runChunk(*task, spacing); });
+  }
+  pool.wait();
+  stats.steals = pool.getStealCount();
+  pool.stop();
+  
+  stats.chunks = tasks.size();
+  for (size_t k = 0; k < tasks.size(); k++) {
+    stats.processedSamples += tasks[k].end - tasks[k].warmupStart;
+    stats.taskSeconds.push_back(tasks[k].seconds);
+  }
+  
+  std::chrono::steady_clock::time_point stitchStarted = std::chrono::steady_clock::now();
+  stitch(tasks, out, stats);
+  stats.stitchSeconds = secondsSince(stitchStarted);
+  stats.wallSeconds = secondsSince(started);
+}
+
+void BatchAnalyzer::summarizeHrv(const AnalysisOutput& out, HrvSummary& summary) {
+  summary = HrvSummary();
+  
+  double sum = 0;
+  double sumSquares = 0;
+  double successiveSquares = 0;
+  size_t successiveCount = 0;
+  size_t over50 = 0;
+  double previousRR = 0;
+  
+  for (size_t i = 1; i < out.beats.size(); i++) {
+    double rr = (out.beats[i].sample - out.beats[i - 1].sample) * 1000.0 / recording->sampleRate;
+    
+    // Missed beats and gaps give intervals outside the detector's limits
+    if (rr < settings.minBeatInterval || rr > settings.maxBeatInterval) {
+      previousRR = 0;
+      continue;
+    }
+    
+    sum += rr;
+    sumSquares += rr * rr;
+    summary.intervals++;
+    
+    if (previousRR > 0) {
+      double difference = rr - previousRR;
+      successiveSquares += difference * difference;
+      successiveCount++;
+      if (fabs(difference) > 50) over50++;
+    }
+    previousRR = rr;
+  }
+  
+  if (summary.intervals == 0) return;
+  
+  summary.meanRR = sum / summary.intervals;
+  summary.meanHeartRate = 60000.0 / summary.meanRR;
+  summary.sdnn = sqrt(std::max(0.0, sumSquares / summary.intervals - summary.meanRR * summary.meanRR));
+  if (successiveCount > 0) {
+    summary.rmssd = sqrt(successiveSquares / successiveCount);
+    summary.pnn50 = 100.0 * over50 / successiveCount;
+  }
+}
+
+uint64_t BatchAnalyzer::countMaskedSamples(const AnalysisOutput& out) {
+  uint64_t masked = 0;
+  for (size_t i = 0; i < out.mask.size(); i++) {
+    if (out.mask[i].flags == 0 || out.mask[i].flags == ARTIFACT_LEAD_OFF) continue;
+    uint64_t end = i + 1 < out.mask.size() ? out.mask[i + 1].sample : recording->samples.size();
+    masked += end - out.mask[i].sample;
+  }
+  return masked;
+}
+
+bool outputsEqual(const AnalysisOutput& a, const AnalysisOutput& b, char* detail, size_t length) {
+  size_t beats = std::min(a.beats.size(), b.beats.size());
+  for (size_t i = 0; i < beats; i++) {
+    if (a.beats[i].sample != b.beats[i].sample || a.beats[i].heartRate != b.beats[i].heartRate) {
+      snprintf(detail, length, "beat %zu: sample %llu at %d BPM vs sample %llu at %d BPM", i,
+               (unsigned long long)a.beats[i].sample, a.beats[i].heartRate,
+               (unsigned long long)b.beats[i].sample, b.beats[i].heartRate);
+      return false;
+    }
+  }
+  if (a.beats.size() != b.beats.size()) {
+    snprintf(detail, length, "%zu beats vs %zu", a.beats.size(), b.beats.size());
+    return false;
+  }
+  
+  size_t points = std::min(a.trend.size(), b.trend.size());
+  for (size_t i = 0; i < points; i++) {
+    const TrendPoint& x = a.trend[i];
+    const TrendPoint& y = b.trend[i];
+    if (x.sample != y.sample || x.heartRate != y.heartRate || x.confidence != y.confidence ||
+        x.threshold != y.threshold || x.signalQuality != y.signalQuality) {
+      snprintf(detail, length, "trend second %zu: hr %d (%d%%) thr %d q %d vs hr %d (%d%%) thr %d q %d", i,
+               x.heartRate, x.confidence, x.threshold, x.signalQuality,
+               y.heartRate, y.confidence, y.threshold, y.signalQuality);
+      return false;
+    }
+  }
+  if (a.trend.size() != b.trend.size()) {
+    snprintf(detail, length, "%zu trend points vs %zu", a.trend.size(), b.trend.size());
+    return false;
+  }
+  
+  size_t changes = std::min(a.mask.size(), b.mask.size());
+  for (size_t i = 0; i < changes; i++) {
+    if (a.mask[i].sample != b.mask[i].sample || a.mask[i].flags != b.mask[i].flags) {
+      snprintf(detail, length, "mask change %zu: sample %llu flags 0x%02x vs sample %llu flags 0x%02x", i,
+               (unsigned long long)a.mask[i].sample, a.mask[i].flags,
+               (unsigned long long)b.mask[i].sample, b.mask[i].flags);
+      return false;
+    }
+  }
+  if (a.mask.size() != b.mask.size()) {
+    snprintf(detail, length, "%zu mask changes vs %zu", a.mask.size(), b.mask.size());
+    return false;
+  }
+  
+  return true;
+}
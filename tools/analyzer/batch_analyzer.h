@@ -0,0 +1,134 @@
+/*
+ * Batch Analyzer Class Header
+ * 
+ * Offline beat detection over long recordings with the device's own
+ * SignalProcessor. The recording is cut into chunks that run in parallel
+ * on a work-stealing pool. Each chunk task starts a fresh processor a
+ * warm-up stretch before its chunk, at a calibration window boundary, so
+ * by the chunk start it has normally converged to the state a streaming
+ * run would have there.
+ * 
+ * Stitching runs in chunk order and is exact, not a heuristic: the true
+ * processor state at a chunk boundary (from the previous chunk) is
+ * compared with the task's state. If they match, the task's beats are
+ * taken as they are. If not, the true processor is run on from the
+ * boundary, emitting beats itself, until it matches one of the task's
+ * checkpoints. So the output equals the single-threaded streaming run for
+ * any chunking and thread count; warm-up length only affects speed.
+ */
+
+#ifndef BATCH_ANALYZER_H
+#define BATCH_ANALYZER_H
+
+#include <stdint.h>
+#include <vector>
+#include "config/runtime_config.h"
+#include "processing/signal_processor.h"
+#include "recording_input.h"
+
+struct BeatRecord {
+  uint64_t sample;          // Index of the sample the beat was detected on
+  int heartRate;            // Processor heart rate after the beat (BPM)
+};
+
+// Processor outputs once per second of recording
+struct TrendPoint {
+  uint64_t sample;
+  int heartRate;
+  int confidence;           // Heart rate confidence (0-100)
+  int threshold;
+  int signalQuality;
+};
+
+// Artifact mask transition: flags from this sample on (0 = clean again)
+struct MaskChange {
+  uint64_t sample;
+  uint8_t flags;
+};
+
+struct AnalysisOutput {
+  std::vector<BeatRecord> beats;
+  std::vector<TrendPoint> trend;
+  std::vector<MaskChange> mask;
+};
+
+struct BatchOptions {
+  int threads;
+  uint64_t chunkSamples;
+  uint64_t warmupSamples;
+  uint64_t checkpointSamples;   // Spacing of task snapshots used to resume after a repair
+};
+
+struct BatchStats {
+  size_t chunks;
+  size_t chunksMatched;         // Task state equalled the true state at the chunk start
+  size_t chunksRepaired;
+  uint64_t repairedSamples;     // Samples re-run sequentially while stitching
+  uint64_t processedSamples;    // Including warm-up
+  uint64_t steals;
+  std::vector<double> taskSeconds;
+  double stitchSeconds;
+  double wallSeconds;
+};
+
+struct HrvSummary {
+  size_t intervals;
+  double meanRR;                // ms
+  double meanHeartRate;         // BPM
+  double sdnn;                  // ms
+  double rmssd;                 // ms
+  double pnn50;                 // Percent of successive differences above 50 ms
+};
+
+class BatchAnalyzer {
+private:
+  struct ChunkTask {
+    uint64_t warmupStart;
+    uint64_t begin;
+    uint64_t end;
+    AnalysisOutput output;      // Samples in [begin, end) only
+    std::vector<uint64_t> checkpointSamples;
+    std::vector<SignalProcessor> checkpoints;  // State before the checkpoint sample
+    SignalProcessor finalState;
+    double seconds;
+  };
+  
+  const Recording* recording;
+  ECGSettings settings;
+  int calibrationWindow;
+  
+  // Internal methods
+  void prepare(SignalProcessor& processor);
+  void processFrame(SignalProcessor& processor, uint64_t index, AnalysisOutput* output);
+  void planChunks(const BatchOptions& options, std::vector<ChunkTask>& tasks);
+  void runChunk(ChunkTask& task, uint64_t checkpointSpacing);
+  void stitch(std::vector<ChunkTask>& tasks, AnalysisOutput& out, BatchStats& stats);
+  
+public:
+  // Constructor
+  BatchAnalyzer();
+  
+  // Use the device defaults for the recording's rate; false if the rate
+  // needs a filter longer than the processor supports
+  bool begin(const Recording& recording);
+  
+  // Samples per calibration window (chunks and warm-ups align to it)
+  int getCalibrationWindow() { return calibrationWindow; }
+  
+  // Single processor over the whole recording, as on the device
+  void analyzeStreaming(AnalysisOutput& out);
+  
+  // Chunked run on a work-stealing pool; same output as analyzeStreaming
+  void analyzeParallel(const BatchOptions& options, AnalysisOutput& out, BatchStats& stats);
+  
+  // HRV over successive detected beats with a valid interval
+  void summarizeHrv(const AnalysisOutput& out, HrvSummary& summary);
+  
+  // Samples masked as artifacts (lead-off stretches and their settling excluded)
+  uint64_t countMaskedSamples(const AnalysisOutput& out);
+};
+
+// Compare two outputs; describes the first difference in detail
+bool outputsEqual(const AnalysisOutput& a, const AnalysisOutput& b, char* detail, size_t length);
+
+#endif // BATCH_ANALYZER_H
@@ -0,0 +1,280 @@
+/*
+ * Heart Rate Estimator Benchmark
+ * 
+ * Replays simulated ECG with injected rhythm faults through the device
+ * SignalProcessor and compares its median heart rate (HeartRateEstimator)
+ * with the mean of the last 10 intervals it replaced:
+ * 
+ *   - cost per beat of the estimator and of its sliding median
+ *   - heart rate error per beat on a clean rhythm, with premature
+ *     (ectopic) beats, with beats missing their QRS (missed beats), and
+ *     with both
+ *   - beats needed to follow a step from 60 to 90 BPM
+ * 
+ * Usage: hr_bench [--minutes N] [--rate HZ] [--seed N]
+ */
+
+#include "config/runtime_config.h"
+#include "processing/heart_rate_estimator.h"
+#include "processing/signal_processor.h"
+#include "processing/sliding_median.h"
+#include "simulation/ecg_simulator.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const float SIMULATED_HEART_RATE = 72;
+static const int LEGACY_BEATS = 10;
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+static double nowSeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The estimator this replaced: mean of the last 10 valid intervals
+class LegacyMeanRate {
+private:
+  unsigned long intervals[LEGACY_BEATS];
+  int index;
+  int rate;
+  
+public:
+  LegacyMeanRate() : index(0), rate(0) {
+    for (int i = 0; i < LEGACY_BEATS; i++) intervals[i] = 0;
+  }
+  
+  void addInterval(unsigned long interval) {
+    intervals[index] = interval;
+    index = (index + 1) % LEGACY_BEATS;
+    
+    unsigned long total = 0;
+    int valid = 0;
+    for (int i = 0; i < LEGACY_BEATS; i++) {
+      if (intervals[i] > 0) {
+        total += intervals[i];
+        valid++;
+      }
+    }
+    rate = constrain((int)(60000 / (total / valid)), 30, 200);
+  }
+  
+  int getHeartRate() { return rate; }
+};
+
+struct Scenario {
+  const char* name;
+  float ectopicRate;
+  float droppedBeatRate;
+};
+
+struct ScenarioResult {
+  uint64_t beats;
+  uint64_t rejected;
+  double legacyError;            // Mean absolute error per beat (BPM)
+  double medianError;
+  double legacyOver5;            // Beats more than 5 BPM off (percent)
+  double medianOver5;
+  double legacyWorst;
+  double medianWorst;
+  double confidence;             // Mean smoothed confidence
+};
+
+static void makeSettings(int sampleRate, ECGSettings& settings) {
+  RuntimeConfig::getDefaults(settings);
+  settings.sampleRate = sampleRate;
+  const RateProfile* profile = findRateProfile(sampleRate);
+  if (profile != NULL) settings.movingAverageSize = profile->movingAverageSize;
+}
+
+static void runScenario(const Scenario& scenario, double minutes, int sampleRate, uint32_t seed,
+                        ScenarioResult& result) {
+  ECGSimulatorParams params;
+  ECGSimulator::getDefaults(params);
+  params.sampleRate = sampleRate;
+  params.heartRate = SIMULATED_HEART_RATE;
+  params.hrvStd = 30;
+  params.noiseStd = 4;
+  params.baselineWanderAmplitude = 60;
+  params.ectopicRate = scenario.ectopicRate;
+  params.droppedBeatRate = scenario.droppedBeatRate;
+  params.seed = seed;
+  
+  ECGSimulator simulator;
+  simulator.begin(params);
+  ECGSettings settings;
+  makeSettings(sampleRate, settings);
+  SignalProcessor processor;
+  processor.begin();
+  processor.requestSettings(settings);
+  LegacyMeanRate legacy;
+  
+  result = ScenarioResult();
+  double legacySum = 0, medianSum = 0, confidenceSum = 0;
+  uint64_t legacyOver = 0, medianOver = 0;
+  uint64_t lastBeat = 0;
+  uint64_t total = (uint64_t)(minutes * 60 * sampleRate);
+  uint64_t scoredFrom = (uint64_t)60 * sampleRate;
+  
+  for (uint64_t i = 0; i < total; i++) {
+    processor.processSample(simulator.nextSample());
+    if (!processor.isHeartbeatDetected()) continue;
+    
+    // Same interval the processor measured (it only reports valid ones)
+    unsigned long interval = (unsigned long)((i - lastBeat) * 1000 / sampleRate);
+    lastBeat = i;
+    legacy.addInterval(interval);
+    if (processor.getInstantConfidence() == 0) result.rejected++;
+    if (i < scoredFrom) continue;
+    
+    double legacyError = fabs(legacy.getHeartRate() - SIMULATED_HEART_RATE);
+    double medianError = fabs(processor.getHeartRate() - SIMULATED_HEART_RATE);
+    result.beats++;
+    legacySum += legacyError;
+    medianSum += medianError;
+    if (legacyError > 5) legacyOver++;
+    if (medianError > 5) medianOver++;
+    result.legacyWorst = std::max(result.legacyWorst, legacyError);
+    result.medianWorst = std::max(result.medianWorst, medianError);
+    confidenceSum += processor.getHeartRateConfidence();
+  }
+  
+  if (result.beats == 0) return;
+  result.legacyError = legacySum / result.beats;
+  result.medianError = medianSum / result.beats;
+  result.legacyOver5 = 100.0 * legacyOver / result.beats;
+  result.medianOver5 = 100.0 * medianOver / result.beats;
+  result.confidence = confidenceSum / result.beats;
+}
+
+// Beats after a 60 -> 90 BPM step until the rate stays within 3 BPM
+static void runStep(int sampleRate, uint32_t seed, int& legacyBeats, int& medianBeats) {
+  ECGSimulatorParams params;
+  ECGSimulator::getDefaults(params);
+  params.sampleRate = sampleRate;
+  params.heartRate = 60;
+  params.hrvStd = 20;
+  params.seed = seed;
+  
+  ECGSimulator simulator;
+  simulator.begin(params);
+  ECGSettings settings;
+  makeSettings(sampleRate, settings);
+  SignalProcessor processor;
+  processor.begin();
+  processor.requestSettings(settings);
+  LegacyMeanRate legacy;
+  
+  uint64_t lastBeat = 0;
+  uint64_t stepAt = (uint64_t)120 * sampleRate;
+  uint64_t total = (uint64_t)180 * sampleRate;
+  int beatsAfterStep = 0;
+  legacyBeats = -1;
+  medianBeats = -1;
+  
+  for (uint64_t i = 0; i < total; i++) {
+    if (i == stepAt) {
+      params.heartRate = 90;
+      simulator.begin(params);
+    }
+    processor.processSample(simulator.nextSample());
+    if (!processor.isHeartbeatDetected()) continue;
+    
+    legacy.addInterval((unsigned long)((i - lastBeat) * 1000 / sampleRate));
+    lastBeat = i;
+    if (i < stepAt) continue;
+    
+    beatsAfterStep++;
+    if (abs(legacy.getHeartRate() - 90) > 3) legacyBeats = -1;
+    else if (legacyBeats < 0) legacyBeats = beatsAfterStep;
+    if (abs(processor.getHeartRate() - 90) > 3) medianBeats = -1;
+    else if (medianBeats < 0) medianBeats = beatsAfterStep;
+  }
+}
+
+static double estimatorCost(uint32_t seed) {
+  // Plausible intervals with 5% outliers, generated up front
+  const int count = 1000000;
+  std::vector<unsigned long> intervals(count);
+  uint32_t state = seed;
+  for (int i = 0; i < count; i++) {
+    state = state * 1664525 + 1013904223;
+    unsigned long interval = 780 + (state >> 8) % 110;
+    if ((state >> 4) % 20 == 0) interval = interval * 3 / 2;
+    intervals[i] = interval;
+  }
+  
+  HeartRateEstimator estimator;
+  long sink = 0;
+  double started = nowSeconds();
+  for (int i = 0; i < count; i++) {
+    estimator.addInterval(intervals[i]);
+    sink += estimator.getHeartRate();
+  }
+  double ns = (nowSeconds() - started) * 1e9 / count;
+  if (sink == 0) printf(" ");
+  return ns;
+}
+
+static double medianCost(int window) {
+  const int count = 1000000;
+  SlidingMedian median(window);
+  uint32_t state = 1;
+  long sink = 0;
+  double started = nowSeconds();
+  for (int i = 0; i < count; i++) {
+    state = state * 1664525 + 1013904223;
+    median.add((int32_t)(state >> 20));
+    sink += median.getMedian();
+  }
+  double ns = (nowSeconds() - started) * 1e9 / count;
+  if (sink == 0) printf(" ");
+  return ns;
+}
+
+int main(int argc, char** argv) {
+  double minutes = atof(getOption(argc, argv, "--minutes", "60"));
+  int sampleRate = atoi(getOption(argc, argv, "--rate", "500"));
+  uint32_t seed = (uint32_t)atoi(getOption(argc, argv, "--seed", "1"));
+  
+  printf("Cost per beat (this host):\n");
+  printf("  HeartRateEstimator         %6.1f ns\n", estimatorCost(seed));
+  printf("  SlidingMedian, window %2d   %6.1f ns\n", HR_MEDIAN_WINDOW, medianCost(HR_MEDIAN_WINDOW));
+  printf("  SlidingMedian, window %2d   %6.1f ns\n\n", SLIDING_MEDIAN_CAPACITY,
+         medianCost(SLIDING_MEDIAN_CAPACITY));
+  
+  static const Scenario SCENARIOS[] = {
+    { "clean", 0, 0 },
+    { "5% ectopic", 0.05, 0 },
+    { "3% missed", 0, 0.03 },
+    { "5% ectopic + 3% missed", 0.05, 0.03 },
+  };
+  
+  printf("%.0f min at %d Hz, %d BPM per scenario; error per beat after the first minute\n\n",
+         minutes, sampleRate, (int)SIMULATED_HEART_RATE);
+  printf("                          mean error (BPM)   beats > 5 BPM off    worst (BPM)   rejected  confidence\n");
+  printf("scenario                  mean-10   median   mean-10    median  mean-10 median\n");
+  for (size_t i = 0; i < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); i++) {
+    ScenarioResult result;
+    runScenario(SCENARIOS[i], minutes, sampleRate, seed, result);
+    printf("%-24s %8.2f %8.2f %8.1f%% %8.1f%% %8.0f %6.0f %9.1f%% %10.0f\n", SCENARIOS[i].name,
+           result.legacyError, result.medianError, result.legacyOver5, result.medianOver5,
+           result.legacyWorst, result.medianWorst,
+           100.0 * result.rejected / std::max<uint64_t>(result.beats, 1), result.confidence);
+  }
+  
+  int legacyBeats, medianBeats;
+  runStep(sampleRate, seed, legacyBeats, medianBeats);
+  printf("\nStep 60 -> 90 BPM: within 3 BPM after %d beats (mean-10), %d beats (median)\n",
+         legacyBeats, medianBeats);
+  return 0;
+}
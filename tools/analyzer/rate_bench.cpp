@@ -0,0 +1,209 @@
+/*
+ * Sample Rate Benchmark
+ * 
+ * Runs the same simulated rhythm through the device SignalProcessor at
+ * every supported sample rate (the profiles in processing/sample_rate.h)
+ * and measures:
+ * 
+ *   - processor cost per sample and per second of signal, against the
+ *     sample interval
+ *   - cross-rate equivalence: beats found, detection delay after the
+ *     R-peak, learned calibration values and heart rate per second,
+ *     compared with the SAMPLE_RATE run
+ * 
+ * The rhythm (RR intervals) is identical at every rate; white noise of
+ * the same level is added per sample. Exits with status 1 if a rate is
+ * not equivalent: a beat missed or invented, a detection delay more than
+ * one sample of the slower rate plus 2 ms away from SAMPLE_RATE, a mean
+ * heart rate difference above 1 BPM or calibration values more than 10%
+ * of the R-peak height apart.
+ * 
+ * Usage: rate_bench [--minutes N] [--seed N]
+ */
+
+#include "config/runtime_config.h"
+#include "processing/sample_rate.h"
+#include "processing/signal_processor.h"
+#include "simulation/ecg_simulator.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const float SIMULATED_HEART_RATE = 72;
+static const float NOISE_STD = 4;
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+static double nowSeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct RateResult {
+  int sampleRate;
+  double nsPerSample;
+  uint64_t references;
+  uint64_t missed;
+  uint64_t falseBeats;
+  double delayMs;                    // Mean detection delay after the R-peak
+  std::vector<int> heartRate;        // Per second
+  std::vector<int> baseline;         // Per second
+  std::vector<int> peak;             // Per second
+};
+
+// Box-Muller on xorshift32, so every rate gets noise of the same level
+static float nextGaussian(uint32_t& state) {
+  float u[2];
+  for (int i = 0; i < 2; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    u[i] = (state + 1.0f) / 4294967297.0f;
+  }
+  return sqrtf(-2 * logf(u[0])) * cosf(2 * PI * u[1]);
+}
+
+static void runRate(int sampleRate, double minutes, uint32_t seed, RateResult& result) {
+  ECGSimulatorParams params;
+  ECGSimulator::getDefaults(params);
+  params.sampleRate = sampleRate;
+  params.heartRate = SIMULATED_HEART_RATE;
+  params.hrvStd = 30;
+  params.baselineWanderAmplitude = 60;
+  params.noiseStd = 0;               // Keeps the simulator's RR draws independent of the rate
+  params.seed = seed;
+  
+  ECGSimulator simulator;
+  simulator.begin(params);
+  size_t total = (size_t)(minutes * 60 * sampleRate);
+  std::vector<int16_t> samples(total);
+  std::vector<uint8_t> beat(total);
+  uint32_t noiseState = seed * 2654435761u + 1;
+  for (size_t i = 0; i < total; i++) {
+    float value = simulator.nextSample() + NOISE_STD * nextGaussian(noiseState);
+    samples[i] = (int16_t)constrain((int)lroundf(value), 0, ADC_MAX_VALUE);
+    beat[i] = simulator.isBeatOnset();
+  }
+  
+  const RateProfile* profile = findRateProfile(sampleRate);
+  ECGSettings settings;
+  RuntimeConfig::getDefaults(settings);
+  settings.sampleRate = sampleRate;
+  settings.movingAverageSize = profile->movingAverageSize;
+  SignalProcessor processor;
+  processor.begin();
+  processor.requestSettings(settings);
+  
+  std::vector<uint8_t> detected(total);
+  result = RateResult();
+  result.sampleRate = sampleRate;
+  double started = nowSeconds();
+  for (size_t i = 0; i < total; i++) {
+    processor.processSample(samples[i]);
+    detected[i] = processor.isHeartbeatDetected();
+    if ((i + 1) % sampleRate == 0) {
+      result.heartRate.push_back(processor.getHeartRate());
+      result.baseline.push_back(processor.getBaseline());
+      result.peak.push_back(processor.getPeakAmplitude());
+    }
+  }
+  result.nsPerSample = (nowSeconds() - started) * 1e9 / total;
+  
+  // Match each R-peak to the first detection within 100 ms of it
+  size_t tolerance = sampleRate / 10;
+  std::vector<uint8_t> used(total, 0);
+  double delaySum = 0;
+  uint64_t matched = 0;
+  for (size_t i = 0; i < total; i++) {
+    if (!beat[i]) continue;
+    result.references++;
+    bool found = false;
+    for (size_t j = i > tolerance ? i - tolerance : 0; j <= i + tolerance && j < total; j++) {
+      if (detected[j] && !used[j]) {
+        used[j] = 1;
+        found = true;
+        delaySum += ((double)j - (double)i) * 1000.0 / sampleRate;
+        matched++;
+        break;
+      }
+    }
+    // The first beat has no interval to report
+    if (!found && result.references > 1) result.missed++;
+  }
+  for (size_t i = 0; i < total; i++) {
+    if (detected[i] && !used[i]) result.falseBeats++;
+  }
+  result.delayMs = matched > 0 ? delaySum / matched : 0;
+}
+
+int main(int argc, char** argv) {
+  double minutes = atof(getOption(argc, argv, "--minutes", "30"));
+  uint32_t seed = (uint32_t)atoi(getOption(argc, argv, "--seed", "1"));
+  
+  std::vector<RateResult> results(getRateProfileCount());
+  int reference = -1;
+  for (int i = 0; i < getRateProfileCount(); i++) {
+    runRate(getRateProfile(i).sampleRate, minutes, seed, results[i]);
+    if (results[i].sampleRate == SAMPLE_RATE) reference = i;
+  }
+  if (reference < 0) {
+    fprintf(stderr, "SAMPLE_RATE %d has no rate profile\n", SAMPLE_RATE);
+    return 1;
+  }
+  const RateResult& ref = results[reference];
+  
+  printf("%.0f min at %d BPM per rate, compared with %d Hz; cost on this host\n\n", minutes,
+         (int)SIMULATED_HEART_RATE, SAMPLE_RATE);
+  printf("rate   ns/sample  us/s signal  of interval   beats  missed  false  delay ms"
+         "  HR diff  baseline diff  peak diff   result\n");
+  
+  bool allEquivalent = true;
+  for (size_t r = 0; r < results.size(); r++) {
+    const RateResult& result = results[r];
+    
+    // Per-second values after the first minute (calibration and HR settled)
+    double hrDiff = 0, baselineDiff = 0, peakDiff = 0;
+    size_t seconds = std::min(result.heartRate.size(), ref.heartRate.size());
+    size_t counted = 0;
+    for (size_t s = 60; s < seconds; s++) {
+      hrDiff += abs(result.heartRate[s] - ref.heartRate[s]);
+      baselineDiff += abs(result.baseline[s] - ref.baseline[s]);
+      peakDiff += abs(result.peak[s] - ref.peak[s]);
+      counted++;
+    }
+    double peakHeight = 1;
+    if (counted > 0) {
+      hrDiff /= counted;
+      baselineDiff /= counted;
+      peakDiff /= counted;
+      peakHeight = std::max(1, ref.peak[seconds - 1] - ref.baseline[seconds - 1]);
+    }
+    
+    double slowerInterval = 1000.0 / std::min(result.sampleRate, ref.sampleRate);
+    bool equivalent = result.missed == 0 && result.falseBeats == 0 &&
+                      fabs(result.delayMs - ref.delayMs) <= slowerInterval + 2 &&
+                      hrDiff <= 1 &&
+                      baselineDiff <= 0.1 * peakHeight && peakDiff <= 0.1 * peakHeight;
+    allEquivalent = allEquivalent && equivalent;
+    
+    double usPerSecond = result.nsPerSample * result.sampleRate / 1000;
+    double ofInterval = result.nsPerSample * result.sampleRate / 1e9 * 100;
+    printf("%4d %11.1f %12.1f %11.3f%% %7llu %7llu %6llu %9.1f %8.2f %14.1f %10.1f   %s\n",
+           result.sampleRate, result.nsPerSample, usPerSecond, ofInterval,
+           (unsigned long long)result.references, (unsigned long long)result.missed,
+           (unsigned long long)result.falseBeats, result.delayMs, hrDiff, baselineDiff, peakDiff,
+           equivalent ? "equivalent" : "DIFFERENT");
+  }
+  
+  printf("\nHR, baseline and peak diff: mean absolute difference per second from %d Hz\n",
+         SAMPLE_RATE);
+  return allEquivalent ? 0 : 1;
+}
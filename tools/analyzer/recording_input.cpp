@@ -0,0 +1,156 @@
+/*
+ * Recording Input Implementation
+ */
+
+#include "recording_input.h"
+#include "../archive/archive_reader.h"
+#include "simulation/ecg_simulator.h"
+#include "simulation/recording_loader.h"
+#include <stdio.h>
+#include <string.h>
+
+// Holes longer than this between archive chunks are not filled
+static const int64_t MAX_HOLE_US = 24LL * 3600 * 1000000;
+
+static bool loadArchive(const char* path, Recording& out) {
+  ArchiveReader reader;
+  if (!reader.open(path)) {
+    fprintf(stderr, "ERROR: %s is not a readable archive\n", path);
+    return false;
+  }
+  if (reader.getChunkCount() == 0) {
+    fprintf(stderr, "ERROR: archive %s holds no samples\n", path);
+    return false;
+  }
+  
+  out.sampleRate = reader.getChunk(0).sampleRate;
+  out.startUs = reader.getStartUs();
+  out.samples.clear();
+  out.samples.reserve(reader.getFrameCount());
+  
+  std::vector<int16_t> column;
+  int64_t expectedUs = out.startUs;
+  
+  for (size_t chunk = 0; chunk < reader.getChunkCount(); chunk++) {
+    const ArchiveChunkInfo& info = reader.getChunk(chunk);
+    if (info.sampleRate != out.sampleRate) {
+      fprintf(stderr, "ERROR: sample rate changes from %u to %u Hz in chunk %zu; "
+              "export the segments separately\n", out.sampleRate, info.sampleRate, chunk);
+      return false;
+    }
+    
+    // Keep sample index and time in step across holes (a backwards clock
+    // correction simply continues the stream)
+    int64_t holeUs = info.startUs - expectedUs;
+    if (holeUs > MAX_HOLE_US) {
+      fprintf(stderr, "ERROR: %.1f hour hole before chunk %zu\n", holeUs / 3.6e9, chunk);
+      return false;
+    }
+    if (holeUs > 0) {
+      size_t holeFrames = (size_t)(holeUs * out.sampleRate / 1000000);
+      out.samples.insert(out.samples.end(), holeFrames, SAMPLE_GAP_VALUE);
+    }
+    
+    if (!reader.readChunk(chunk, 0, column)) {
+      fprintf(stderr, "ERROR: chunk %zu of %s is damaged\n", chunk, path);
+      return false;
+    }
+    out.samples.insert(out.samples.end(), column.begin(), column.end());
+    expectedUs = info.endUs;
+  }
+  
+  return true;
+}
+
+static bool loadText(const char* path, Recording& out) {
+  RecordingLoader loader;
+  if (!loader.open(path)) {
+    fprintf(stderr, "ERROR: cannot open recording %s\n", path);
+    return false;
+  }
+  
+  out.sampleRate = loader.getSampleRate();
+  out.startUs = 0;
+  out.samples.clear();
+  
+  int value;
+  while (loader.nextSample(value)) {
+    if (value < 0) value = 0;
+    if (value > INT16_MAX) value = INT16_MAX;
+    out.samples.push_back((int16_t)value);
+  }
+  
+  return true;
+}
+
+bool loadRecording(const char* path, Recording& out) {
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "ERROR: cannot open %s\n", path);
+    return false;
+  }
+  uint32_t magic = 0;
+  size_t got = fread(&magic, 1, sizeof(magic), file);
+  fclose(file);
+  
+  bool ok = (got == sizeof(magic) && magic == ARCHIVE_FILE_MAGIC) ? loadArchive(path, out)
+                                                                   : loadText(path, out);
+  if (!ok) return false;
+  
+  if (out.sampleRate == 0 || out.samples.empty()) {
+    fprintf(stderr, "ERROR: %s holds no samples\n", path);
+    return false;
+  }
+  
+  out.gapSamples = 0;
+  for (size_t i = 0; i < out.samples.size(); i++) {
+    if (out.samples[i] == SAMPLE_GAP_VALUE) out.gapSamples++;
+  }
+  return true;
+}
+
+void simulateRecording(double hours, int sampleRate, uint32_t seed, Recording& out) {
+  // Mean heart rate per hour of day, starting at midnight
+  static const float HOURLY_HEART_RATE[24] = {
+    58, 56, 55, 55, 56, 58, 64, 72, 78, 80, 76, 74,
+    78, 75, 72, 74, 78, 84, 82, 76, 72, 68, 64, 60
+  };
+  
+  uint64_t total = (uint64_t)(hours * 3600 * sampleRate);
+  uint64_t perHour = (uint64_t)3600 * sampleRate;
+  
+  out.sampleRate = sampleRate;
+  out.startUs = 0;
+  out.gapSamples = 0;
+  out.samples.clear();
+  out.samples.reserve(total);
+  
+  ECGSimulator simulator;
+  ECGSimulatorParams params;
+  ECGSimulator::getDefaults(params);
+  params.sampleRate = sampleRate;
+  params.hrvStd = 40;
+  params.noiseStd = 4;
+  params.baselineWanderAmplitude = 60;
+  params.mainsAmplitude = 10;
+  params.leadOffPeriod = 50UL * 60 * 1000;
+  params.leadOffDuration = 2UL * 60 * 1000;
+  params.artifactPeriod = 10UL * 60 * 1000;
+  params.artifactDuration = 15000;
+  
+  for (uint64_t i = 0; i < total; i++) {
+    if (i % perHour == 0) {
+      params.heartRate = HOURLY_HEART_RATE[(i / perHour) % 24];
+      params.seed = seed + (uint32_t)(i / perHour);
+      simulator.begin(params);
+    }
+    
+    int value = simulator.nextSample();
+    if (simulator.areLeadsConnected()) {
+      out.samples.push_back((int16_t)value);
+    } else {
+      out.samples.push_back(SAMPLE_GAP_VALUE);
+      out.gapSamples++;
+    }
+  }
+}
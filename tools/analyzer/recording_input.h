@@ -0,0 +1,31 @@
+/*
+ * Recording Input Header
+ * 
+ * Loads a whole recording into memory as one sample stream at a single
+ * rate for offline analysis. Sources are ECG archives (channel 0), the
+ * RecordingLoader text format, or the ECG simulator. Lead-off stretches
+ * and holes between archive chunks become SAMPLE_GAP_VALUE so sample
+ * index and time stay in step.
+ */
+
+#ifndef RECORDING_INPUT_H
+#define RECORDING_INPUT_H
+
+#include <stdint.h>
+#include <vector>
+
+struct Recording {
+  uint32_t sampleRate;
+  int64_t startUs;                // Time of sample 0 (0 if unknown)
+  std::vector<int16_t> samples;   // SAMPLE_GAP_VALUE where there is no signal
+  uint64_t gapSamples;
+};
+
+// Load an archive (.eca) or a RecordingLoader text file, chosen by content
+bool loadRecording(const char* path, Recording& out);
+
+// Synthesize hours of ECG with an hourly heart rate profile and a
+// 2-minute lead-off every 50 minutes
+void simulateRecording(double hours, int sampleRate, uint32_t seed, Recording& out);
+
+#endif // RECORDING_INPUT_H
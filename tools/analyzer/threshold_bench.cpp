@@ -0,0 +1,366 @@
+/*
+ * Adaptive Threshold Benchmark
+ * 
+ * Replays ECG with gain steps (electrode contact or amplifier gain
+ * changes) through the device SignalProcessor and measures how the
+ * online threshold calibration follows them:
+ * 
+ *   - AdaptiveThreshold and P2Quantile cost per sample, against the
+ *     whole SignalProcessor
+ *   - windows accepted by the calibration
+ *   - time after each gain step until the threshold settles within 10%
+ *     of its new level, and missed and false beats in the 10 s after the
+ *     step and over the whole segment, with the fixed threshold and the
+ *     adaptive one
+ * 
+ * The signal is simulated (clean, and with noise, baseline wander and
+ * mains hum) or replayed from an annotated recording. The gain is
+ * x1 -> x0.5 -> x2 -> x1, one segment each. Artifact masking is off, since
+ * an instant gain step is itself masked as an artifact.
+ * 
+ * Usage: threshold_bench [--rate HZ] [--segment-seconds N] [--seed N]
+ *                        [--recording FILE]
+ */
+
+#include "config/runtime_config.h"
+#include "processing/adaptive_threshold.h"
+#include "processing/p2_quantile.h"
+#include "processing/signal_processor.h"
+#include "simulation/ecg_simulator.h"
+#include "simulation/recording_loader.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const float GAIN_STEPS[] = { 1.0, 0.5, 2.0, 1.0 };
+static const int GAIN_STEP_COUNT = sizeof(GAIN_STEPS) / sizeof(GAIN_STEPS[0]);
+static const double RECOVERY_SECONDS = 10;
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+static double nowSeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Signal {
+  int sampleRate;
+  std::vector<int16_t> samples;
+  std::vector<uint8_t> beat;         // Reference R-peaks
+};
+
+static void simulate(int sampleRate, size_t total, float noiseStd, float wander, float mains,
+                     uint32_t seed, Signal& out) {
+  ECGSimulatorParams params;
+  ECGSimulator::getDefaults(params);
+  params.sampleRate = sampleRate;
+  params.hrvStd = 30;
+  params.noiseStd = noiseStd;
+  params.baselineWanderAmplitude = wander;
+  params.mainsAmplitude = mains;
+  params.seed = seed;
+  
+  ECGSimulator simulator;
+  simulator.begin(params);
+  out.sampleRate = sampleRate;
+  out.samples.resize(total);
+  out.beat.resize(total);
+  for (size_t i = 0; i < total; i++) {
+    out.samples[i] = (int16_t)simulator.nextSample();
+    out.beat[i] = simulator.isBeatOnset();
+  }
+}
+
+static bool loadRecording(const char* path, size_t total, Signal& out) {
+  RecordingLoader loader;
+  if (!loader.open(path)) return false;
+  out.sampleRate = loader.getSampleRate();
+  int value;
+  while (out.samples.size() < total && loader.nextSample(value)) {
+    out.samples.push_back((int16_t)value);
+    out.beat.push_back(loader.isBeatAnnotated());
+  }
+  return !out.samples.empty();
+}
+
+// Scale each segment around the isoelectric level (median of the first 10 s)
+static void applyGainSteps(Signal& signal, size_t segment) {
+  size_t head = std::min(signal.samples.size(), (size_t)10 * signal.sampleRate);
+  std::vector<int16_t> sorted(signal.samples.begin(), signal.samples.begin() + head);
+  std::sort(sorted.begin(), sorted.end());
+  float center = sorted[sorted.size() / 2];
+  
+  for (size_t i = 0; i < signal.samples.size(); i++) {
+    float gain = GAIN_STEPS[std::min(i / segment, (size_t)GAIN_STEP_COUNT - 1)];
+    float value = center + gain * (signal.samples[i] - center);
+    signal.samples[i] = (int16_t)constrain((int)lroundf(value), 0, ADC_MAX_VALUE);
+  }
+}
+
+struct Detection {
+  uint64_t references;
+  uint64_t missed;
+  uint64_t falseBeats;
+};
+
+struct StepResult {
+  double settleSeconds;              // -1 never settled, -2 never calibrated
+  Detection recovery[2];             // First RECOVERY_SECONDS, [fixed, adaptive]
+  Detection segment[2];              // Whole segment
+};
+
+struct RunResult {
+  double nsPerSample;
+  unsigned long windowsAccepted;
+  unsigned long windows;
+  StepResult steps[GAIN_STEP_COUNT];
+};
+
+// Window the processor calibrates over (the default for rates without a profile)
+static int calibrationWindow(int sampleRate) {
+  const RateProfile* profile = findRateProfile(sampleRate);
+  return profile != NULL ? profile->calibrationWindowSize : CALIBRATION_WINDOW_SIZE;
+}
+
+static void makeSettings(int sampleRate, bool adaptive, ECGSettings& settings) {
+  RuntimeConfig::getDefaults(settings);
+  settings.sampleRate = sampleRate;
+  settings.adaptiveThreshold = adaptive;
+  // A gain step looks like an artifact; keep the mask out of the comparison
+  settings.artifactMasking = false;
+  const RateProfile* profile = findRateProfile(sampleRate);
+  if (profile != NULL) settings.movingAverageSize = profile->movingAverageSize;
+}
+
+static void process(const Signal& signal, bool adaptive, std::vector<uint8_t>& detected,
+                    std::vector<int16_t>& threshold, std::vector<int16_t>& baseline,
+                    std::vector<uint8_t>& calibrated, double& nsPerSample,
+                    unsigned long& calibrations) {
+  ECGSettings settings;
+  makeSettings(signal.sampleRate, adaptive, settings);
+  SignalProcessor processor;
+  processor.begin();
+  processor.requestSettings(settings);
+  
+  size_t total = signal.samples.size();
+  detected.assign(total, 0);
+  threshold.assign(total, 0);
+  baseline.assign(total, 0);
+  calibrated.assign(total, 0);
+  double started = nowSeconds();
+  for (size_t i = 0; i < total; i++) {
+    processor.processSample(signal.samples[i]);
+    detected[i] = processor.isHeartbeatDetected();
+    threshold[i] = (int16_t)processor.getThreshold();
+    baseline[i] = (int16_t)processor.getBaseline();
+    calibrated[i] = processor.isThresholdCalibrated();
+  }
+  nsPerSample = (nowSeconds() - started) * 1e9 / total;
+  
+  // Accepted windows: a second calibration fed the same filtered samples
+  SignalProcessor replay;
+  replay.begin();
+  replay.requestSettings(settings);
+  AdaptiveThreshold shadow;
+  shadow.setWindowSize(calibrationWindow(signal.sampleRate));
+  for (size_t i = 0; i < total; i++) {
+    replay.processSample(signal.samples[i]);
+    shadow.addSample(replay.getFilteredValue());
+  }
+  calibrations = shadow.getCalibrationCount();
+}
+
+// Match detections to reference R-peaks (the filter delays detection)
+static void score(const Signal& signal, const std::vector<uint8_t>& detected,
+                  size_t from, size_t to, Detection& result) {
+  result = Detection();
+  int tolerance = signal.sampleRate / 10;
+  size_t total = signal.samples.size();
+  std::vector<uint8_t> used(to - from, 0);
+  
+  for (size_t i = from; i < to; i++) {
+    if (!signal.beat[i]) continue;
+    result.references++;
+    bool found = false;
+    size_t first = i > (size_t)tolerance ? i - tolerance : 0;
+    for (size_t j = std::max(first, from); j <= i + tolerance && j < std::min(to, total); j++) {
+      if (detected[j] && !used[j - from]) {
+        used[j - from] = 1;
+        found = true;
+        break;
+      }
+    }
+    if (!found) result.missed++;
+  }
+  for (size_t i = from; i < to; i++) {
+    if (detected[i] && !used[i - from]) result.falseBeats++;
+  }
+}
+
+static void run(const Signal& signal, size_t segment, RunResult& result) {
+  std::vector<uint8_t> detected[2];
+  std::vector<int16_t> threshold[2], baseline[2];
+  std::vector<uint8_t> calibrated[2];
+  unsigned long calibrations[2];
+  double ns[2];
+  for (int mode = 0; mode < 2; mode++) {
+    process(signal, mode == 1, detected[mode], threshold[mode], baseline[mode], calibrated[mode],
+            ns[mode], calibrations[mode]);
+  }
+  
+  int windowSize = calibrationWindow(signal.sampleRate);
+  result.nsPerSample = ns[1];
+  result.windowsAccepted = calibrations[1];
+  result.windows = signal.samples.size() / windowSize;
+  
+  size_t recovery = (size_t)(RECOVERY_SECONDS * signal.sampleRate);
+  for (int step = 0; step < GAIN_STEP_COUNT; step++) {
+    StepResult& stepResult = result.steps[step];
+    size_t from = step * segment;
+    size_t to = std::min(from + segment, signal.samples.size());
+    if (from >= to) {
+      stepResult = StepResult();
+      stepResult.settleSeconds = -1;
+      continue;
+    }
+    
+    // Settled once the threshold stays within 10% of the height it holds
+    // above the baseline over the last 30 s of the segment
+    const std::vector<int16_t>& levels = threshold[1];
+    size_t tail = std::min(to - from, (size_t)30 * signal.sampleRate);
+    double final = 0, finalBaseline = 0;
+    for (size_t i = to - tail; i < to; i++) {
+      final += levels[i];
+      finalBaseline += baseline[1][i];
+    }
+    final /= tail;
+    finalBaseline /= tail;
+    double tolerance = 0.1 * fabs(final - finalBaseline);
+    size_t settled = to;
+    for (size_t i = to; i > from; i--) {
+      if (fabs(levels[i - 1] - final) > tolerance) break;
+      settled = i - 1;
+    }
+    stepResult.settleSeconds = settled < to ? (double)(settled - from) / signal.sampleRate : -1;
+    if (!calibrated[1][to - 1]) stepResult.settleSeconds = -2;
+    
+    for (int mode = 0; mode < 2; mode++) {
+      score(signal, detected[mode], from, std::min(from + recovery, to), stepResult.recovery[mode]);
+      score(signal, detected[mode], from, to, stepResult.segment[mode]);
+    }
+  }
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+  return whole > 0 ? 100.0 * part / whole : 0;
+}
+
+static void printRun(const char* name, const RunResult& result) {
+  printf("%s: %lu of %lu calibration windows accepted, processor %.1f ns/sample\n", name,
+         result.windowsAccepted, result.windows, result.nsPerSample);
+  printf("                   first 10 s after the step          whole segment\n");
+  printf("  gain  settle s   missed fixed/adaptive  false       missed fixed/adaptive  false\n");
+  for (int step = 0; step < GAIN_STEP_COUNT; step++) {
+    const StepResult& s = result.steps[step];
+    if (s.segment[1].references == 0) continue;
+    char settle[16];
+    if (s.settleSeconds == -2) snprintf(settle, sizeof(settle), "-");
+    else if (s.settleSeconds < 0) snprintf(settle, sizeof(settle), "never");
+    else snprintf(settle, sizeof(settle), "%.0f", s.settleSeconds);
+    printf("  x%-4.1f %7s   %8.1f%% %8.1f%%  %3llu/%-3llu   %8.1f%% %8.1f%%  %3llu/%-3llu\n",
+           GAIN_STEPS[step], settle,
+           percent(s.recovery[0].missed, s.recovery[0].references),
+           percent(s.recovery[1].missed, s.recovery[1].references),
+           (unsigned long long)s.recovery[0].falseBeats, (unsigned long long)s.recovery[1].falseBeats,
+           percent(s.segment[0].missed, s.segment[0].references),
+           percent(s.segment[1].missed, s.segment[1].references),
+           (unsigned long long)s.segment[0].falseBeats, (unsigned long long)s.segment[1].falseBeats);
+  }
+  printf("\n");
+}
+
+static void measureCost(const Signal& signal) {
+  const int repeats = 20;
+  size_t total = signal.samples.size();
+  
+  P2Quantile quantile(0.5);
+  double started = nowSeconds();
+  for (int r = 0; r < repeats; r++) {
+    for (size_t i = 0; i < total; i++) quantile.add(signal.samples[i]);
+  }
+  double quantileNs = (nowSeconds() - started) * 1e9 / (repeats * total);
+  
+  AdaptiveThreshold threshold;
+  threshold.setWindowSize(calibrationWindow(signal.sampleRate));
+  started = nowSeconds();
+  for (int r = 0; r < repeats; r++) {
+    for (size_t i = 0; i < total; i++) threshold.addSample(signal.samples[i]);
+  }
+  double thresholdNs = (nowSeconds() - started) * 1e9 / (repeats * total);
+  if (quantile.getValue() < 0 || threshold.getThreshold() < 0) printf(" ");
+  
+  printf("Cost per sample (this host):\n");
+  printf("  P2Quantile::add              %6.1f ns\n", quantileNs);
+  printf("  AdaptiveThreshold::addSample %6.1f ns\n\n", thresholdNs);
+}
+
+int main(int argc, char** argv) {
+  int sampleRate = atoi(getOption(argc, argv, "--rate", "500"));
+  double segmentSeconds = atof(getOption(argc, argv, "--segment-seconds", "120"));
+  uint32_t seed = (uint32_t)atoi(getOption(argc, argv, "--seed", "1"));
+  const char* recording = getOption(argc, argv, "--recording", NULL);
+  
+  if (recording != NULL) {
+    Signal signal;
+    size_t limit = (size_t)-1;
+    if (!loadRecording(recording, limit, signal)) {
+      fprintf(stderr, "Cannot read %s\n", recording);
+      return 1;
+    }
+    size_t segment = std::max<size_t>(signal.samples.size() / GAIN_STEP_COUNT, 1);
+    applyGainSteps(signal, segment);
+    measureCost(signal);
+    RunResult result;
+    run(signal, segment, result);
+    printf("%s, %d Hz, %.0f s per gain step\n\n", recording, signal.sampleRate,
+           (double)segment / signal.sampleRate);
+    printRun("recording", result);
+    return 0;
+  }
+  
+  size_t segment = (size_t)(segmentSeconds * sampleRate);
+  size_t total = segment * GAIN_STEP_COUNT;
+  
+  struct Scenario {
+    const char* name;
+    float noiseStd;
+    float wander;
+    float mains;
+  };
+  static const Scenario SCENARIOS[] = {
+    { "clean", 4, 0, 0 },
+    { "noise 15, wander 150, mains 20", 15, 150, 20 },
+  };
+  
+  printf("%d Hz, %.0f s per gain step, %d-sample calibration windows\n\n", sampleRate,
+         segmentSeconds, calibrationWindow(sampleRate));
+  for (size_t i = 0; i < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); i++) {
+    Signal signal;
+    simulate(sampleRate, total, SCENARIOS[i].noiseStd, SCENARIOS[i].wander, SCENARIOS[i].mains,
+             seed, signal);
+    applyGainSteps(signal, segment);
+    if (i == 0) measureCost(signal);
+    RunResult result;
+    run(signal, segment, result);
+    printRun(SCENARIOS[i].name, result);
+  }
+  return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Work-Stealing Pool Class Implementation
+ */
+
+#include "work_stealing_pool.h"
+
+WorkStealingPool::WorkStealingPool()
+  : nextQueue(0), queuedCount(0), unfinishedCount(0), stealCount(0), stopping(false) {
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  stop();
+}
+
+void WorkStealingPool::begin(int threadCount) {
+  if (threadCount < 1) threadCount = 1;
+  
+  stopping = false;
+  for (int i = 0; i < threadCount; i++) {
+    queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+  }
+  for (int i = 0; i < threadCount; i++) {
+    threads.emplace_back(&WorkStealingPool::workerMain, this, (size_t)i);
+  }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+  WorkerQueue& queue = *queues[nextQueue];
+  nextQueue = (nextQueue + 1) % queues.size();
+  
+  // Counted before the push so takeTask never sees a negative count, and
+  // under the state lock so a sleeping worker cannot miss the wake-up
+  unfinishedCount++;
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    queuedCount++;
+  }
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  available.notify_one();
+}
+
+bool WorkStealingPool::takeTask(size_t worker, std::function<void()>& task) {
+  // Own deque first, newest task
+  {
+    WorkerQueue& own = *queues[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      queuedCount--;
+      return true;
+    }
+  }
+  
+  // Steal the oldest task of the next worker that has one
+  for (size_t i = 1; i < queues.size(); i++) {
+    WorkerQueue& victim = *queues[(worker + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      queuedCount--;
+      stealCount++;
+      return true;
+    }
+  }
+  
+  return false;
+}
+
+void WorkStealingPool::workerMain(size_t worker) {
+  std::function<void()> task;
+  
+  while (true) {
+    if (takeTask(worker, task)) {
+      task();
+      task = nullptr;
+      
+      if (--unfinishedCount == 0) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        finished.notify_all();
+      }
+      continue;
+    }
+    
+    std::unique_lock<std::mutex> lock(stateMutex);
+    available.wait(lock, [this] { return stopping || queuedCount > 0; });
+    if (stopping && queuedCount == 0) return;
+  }
+}
+
+void WorkStealingPool::wait() {
+  std::unique_lock<std::mutex> lock(stateMutex);
+  finished.wait(lock, [this] { return unfinishedCount == 0; });
+}
+
+void WorkStealingPool::stop() {
+  if (threads.empty()) return;
+  
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    stopping = true;
+  }
+  available.notify_all();
+  
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  threads.clear();
+  queues.clear();
+  nextQueue = 0;
+}
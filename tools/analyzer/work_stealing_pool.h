@@ -0,0 +1,68 @@
+/*
+ * Work-Stealing Pool Class Header
+ * 
+ * Threads with one task deque each. A worker takes its own newest task
+ * first and, when its deque is empty, steals the oldest task of another
+ * worker, so uneven tasks (chunks with long lead-off gaps finish early)
+ * keep every core busy without a shared queue on the hot path.
+ */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+  
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  std::vector<std::thread> threads;
+  size_t nextQueue;
+  
+  // Sleeping and completion
+  std::mutex stateMutex;
+  std::condition_variable available;
+  std::condition_variable finished;
+  std::atomic<size_t> queuedCount;
+  std::atomic<size_t> unfinishedCount;
+  std::atomic<uint64_t> stealCount;
+  bool stopping;
+  
+  // Internal methods
+  void workerMain(size_t worker);
+  bool takeTask(size_t worker, std::function<void()>& task);
+  
+public:
+  // Constructor
+  WorkStealingPool();
+  ~WorkStealingPool();
+  
+  // Start the given number of threads
+  void begin(int threadCount);
+  
+  // Queue a task (spread round-robin over the worker deques)
+  void submit(std::function<void()> task);
+  
+  // Block until every submitted task has run
+  void wait();
+  
+  // Finish queued tasks and join the threads
+  void stop();
+  
+  // Getters
+  int getThreadCount() { return (int)threads.size(); }
+  uint64_t getStealCount() { return stealCount.load(); }
+};
+
+#endif // WORK_STEALING_POOL_H
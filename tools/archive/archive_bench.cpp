@@ -0,0 +1,216 @@
+/*
+ * Archive Benchmark
+ * 
+ * Writes a multi-day synthetic Holter recording (500 Hz, 12-bit ADC
+ * counts with HRV, noise, baseline wander, mains hum and a lead-off
+ * episode every 4 hours) and measures:
+ * 
+ *   - write throughput of ArchiveWriter (generation excluded)
+ *   - file size per hour, against the uplink codec and Serial CSV
+ *   - open time, warm and cold random seek latency (1 s reads)
+ *   - sequential decode throughput
+ * 
+ * Usage: archive_bench [--days N] [--rate HZ] [--seeks N] [--path FILE]
+ */
+
+#include "archive_reader.h"
+#include "archive_writer.h"
+#include "codec/sample_codec.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static const int BLOCK_FRAMES = 250;
+
+static double nowSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+// Synthetic ECG in ADC counts; beats reported through beat
+class HolterGenerator {
+private:
+  std::mt19937 random;
+  std::normal_distribution<double> noise;
+  double sampleRate;
+  double phase;
+  double rr;
+  uint64_t index;
+  
+public:
+  HolterGenerator(int sampleRate) : random(42), noise(0.0, 1.0) {
+    this->sampleRate = sampleRate;
+    phase = 0;
+    rr = 0.8;
+    index = 0;
+  }
+  
+  int16_t next(bool& beat) {
+    double t = index++ / sampleRate;
+    phase += 1.0 / (sampleRate * rr);
+    beat = false;
+    if (phase >= 1.0) {
+      phase -= 1.0;
+      rr = 0.8 + 0.05 * noise(random);
+      beat = true;
+    }
+    
+    // P, Q, R, S, T as Gaussians over the beat phase
+    static const double centers[5] = { 0.10, 0.22, 0.25, 0.28, 0.50 };
+    static const double widths[5] = { 0.025, 0.008, 0.010, 0.008, 0.045 };
+    static const double heights[5] = { 0.15, -0.12, 1.20, -0.25, 0.30 };
+    double mv = 0;
+    for (int w = 0; w < 5; w++) {
+      double d = (phase - centers[w]) / widths[w];
+      mv += heights[w] * exp(-0.5 * d * d);
+    }
+    
+    double counts = 2048 + 600 * mv
+                  + 60 * sin(2 * M_PI * 0.25 * t)       // Respiration
+                  + 8 * sin(2 * M_PI * 50 * t)          // Mains
+                  + 4 * noise(random);
+    return (int16_t)std::min(4095.0, std::max(0.0, counts));
+  }
+};
+
+int main(int argc, char** argv) {
+  double days = atof(getOption(argc, argv, "--days", "3"));
+  int sampleRate = atoi(getOption(argc, argv, "--rate", "500"));
+  int seeks = atoi(getOption(argc, argv, "--seeks", "10000"));
+  const char* path = getOption(argc, argv, "--path", "/tmp/archive_bench.eca");
+  
+  uint64_t totalFrames = (uint64_t)(days * 86400 * sampleRate);
+  int64_t startUs = 1750000000000000LL;
+  
+  // ========== WRITE ==========
+  ArchiveWriter writer;
+  if (!writer.open(path, 1, "bench")) return 1;
+  
+  HolterGenerator generator(sampleRate);
+  int16_t block[BLOCK_FRAMES];
+  uint8_t encoded[maxEncodedBlockSize(BLOCK_FRAMES)];
+  uint64_t codecBytes = 0;
+  uint64_t csvBytes = 0;
+  double writeSeconds = 0;
+  uint64_t leadOffPeriod = (uint64_t)4 * 3600 * sampleRate;
+  uint64_t leadOffLength = (uint64_t)120 * sampleRate;
+  
+  printf("Writing %.1f days at %d Hz (%llu samples)...\n", days, sampleRate, (unsigned long long)totalFrames);
+  
+  for (uint64_t frame = 0; frame < totalFrames; frame += BLOCK_FRAMES) {
+    std::vector<ArchiveEvent> beats;
+    for (int i = 0; i < BLOCK_FRAMES; i++) {
+      bool beat;
+      int16_t value = generator.next(beat);
+      bool leadOff = (frame + i) % leadOffPeriod >= leadOffPeriod - leadOffLength;
+      block[i] = leadOff ? SAMPLE_GAP_VALUE : value;
+      if (beat && !leadOff) {
+        ArchiveEvent event = { archiveFrameTime(startUs, sampleRate, frame + i), EVENT_BEAT, 75 };
+        beats.push_back(event);
+      }
+      if (!leadOff) csvBytes += value >= 1000 ? 14 : 13;  // "2048,2300,750\n"
+    }
+    
+    SampleBlockHeader header = { (uint32_t)frame, BLOCK_FRAMES, (uint16_t)sampleRate, 0, 0 };
+    codecBytes += RECORD_FRAME_HEADER_SIZE + encodeSampleBlock(header, block, encoded, sizeof(encoded));
+    
+    double started = nowSeconds();
+    writer.writeSamples(archiveFrameTime(startUs, sampleRate, frame), sampleRate, block, BLOCK_FRAMES);
+    for (const ArchiveEvent& event : beats) writer.writeEvent(event);
+    writeSeconds += nowSeconds() - started;
+  }
+  
+  double started = nowSeconds();
+  writer.close();
+  writeSeconds += nowSeconds() - started;
+  
+  double hours = days * 24;
+  uint64_t fileBytes = writer.getBytesWritten();
+  printf("\nWrite:   %.1f Msamples/s, %.1f MB/s of raw int16 (%.2f s)\n",
+         totalFrames / writeSeconds / 1e6, totalFrames * 2.0 / writeSeconds / 1e6, writeSeconds);
+  printf("Size:    %.1f MB, %.2f MB/hour, %.2f bits/sample, %zu chunks, %llu beats\n",
+         fileBytes / 1e6, fileBytes / hours / 1e6, fileBytes * 8.0 / totalFrames,
+         writer.getChunkCount(), (unsigned long long)writer.getEventsWritten());
+  printf("Compare: raw int16 %.2f MB/h, uplink codec %.2f MB/h, Serial CSV %.2f MB/h\n",
+         totalFrames * 2.0 / hours / 1e6, codecBytes / hours / 1e6, csvBytes / hours / 1e6);
+  
+  // ========== SEEK ==========
+  ArchiveReader reader;
+  started = nowSeconds();
+  if (!reader.open(path)) return 1;
+  double openSeconds = nowSeconds() - started;
+  
+  std::mt19937_64 random(7);
+  std::uniform_int_distribution<int64_t> pick(reader.getStartUs(), reader.getEndUs() - 1000000);
+  std::vector<int16_t> out(sampleRate);
+  std::vector<double> latencies;
+  int64_t firstUs;
+  uint32_t rate;
+  uint64_t checksum = 0;
+  
+  for (int i = 0; i < seeks; i++) {
+    int64_t target = pick(random);
+    started = nowSeconds();
+    size_t count = reader.read(target, 0, out.data(), out.size(), firstUs, rate);
+    latencies.push_back(nowSeconds() - started);
+    checksum += count + out[0];
+  }
+  std::sort(latencies.begin(), latencies.end());
+  printf("\nOpen:    %.3f ms (index of %zu chunks)\n", openSeconds * 1e3, reader.getChunkCount());
+  printf("Seek:    warm, 1 s read: median %.1f us, p99 %.1f us, max %.1f us (%d seeks)\n",
+         latencies[latencies.size() / 2] * 1e6, latencies[latencies.size() * 99 / 100] * 1e6,
+         latencies.back() * 1e6, seeks);
+  
+  // ========== SCAN ==========
+  std::vector<int16_t> chunk;
+  uint64_t decoded = 0;
+  started = nowSeconds();
+  for (size_t i = 0; i < reader.getChunkCount(); i++) {
+    reader.readChunk(i, 0, chunk);
+    decoded += chunk.size();
+    checksum += chunk.empty() ? 0 : chunk[0];
+  }
+  double scanSeconds = nowSeconds() - started;
+  printf("Scan:    %.1f Msamples/s sequential decode (%.2f s)\n", decoded / scanSeconds / 1e6, scanSeconds);
+  
+  std::vector<ArchiveEvent> events;
+  started = nowSeconds();
+  reader.readEvents(reader.getStartUs(), reader.getStartUs() + 3600000000LL, events);
+  printf("Events:  %zu beats in the first hour read in %.2f ms\n", events.size(), (nowSeconds() - started) * 1e3);
+  
+  // Cold: drop the file from the page cache, then open and seek
+  latencies.clear();
+  for (int i = 0; i < 200; i++) {
+    reader.close();
+    int fd = open(path, O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    
+    int64_t target = pick(random);
+    started = nowSeconds();
+    reader.open(path);
+    size_t count = reader.read(target, 0, out.data(), out.size(), firstUs, rate);
+    latencies.push_back(nowSeconds() - started);
+    checksum += count;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  printf("Seek:    cold open + seek + 1 s read: median %.1f us, p99 %.1f us\n",
+         latencies[latencies.size() / 2] * 1e6, latencies[latencies.size() * 99 / 100] * 1e6);
+  
+  return checksum == 0;  // Keeps the reads from being optimized away
+}
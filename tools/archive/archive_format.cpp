@@ -0,0 +1,304 @@
+/*
+ * ECG Archive Format Implementation
+ */
+
+#include "archive_format.h"
+#include <algorithm>
+
+void archivePutLE(uint8_t* out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+uint64_t archiveGetLE(const uint8_t* in, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) {
+    value |= (uint64_t)in[i] << (8 * i);
+  }
+  return value;
+}
+
+static const uint32_t* crcTable() {
+  static uint32_t table[256];
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t value = i;
+    for (int bit = 0; bit < 8; bit++) {
+      value = (value & 1) ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+    }
+    table[i] = value;
+  }
+  return table;
+}
+
+uint32_t archiveCrc32(const uint8_t* data, size_t length) {
+  // Built once; static initialization is thread safe
+  static const uint32_t* table = crcTable();
+  
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFF;
+}
+
+void archivePutVarint(std::vector<uint8_t>& out, uint64_t value) {
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    out.push_back(value ? (byte | 0x80) : byte);
+  } while (value);
+}
+
+size_t archiveGetVarint(const uint8_t* in, size_t length, uint64_t& value) {
+  value = 0;
+  for (size_t used = 0; used < length && used < 10; used++) {
+    value |= (uint64_t)(in[used] & 0x7F) << (7 * used);
+    if (!(in[used] & 0x80)) return used + 1;
+  }
+  return 0;  // Truncated or overlong
+}
+
+// ========== SAMPLE COLUMNS ==========
+//
+// [u8 order][u16 seekPointCount][seek points][groups]
+// Seek point k (frame (k + 1) * ARCHIVE_SEEK_INTERVAL) holds the byte
+// offset of that frame's group and the two samples before it, which is
+// all the predictor needs to start decoding there.
+
+static int bitWidth(uint32_t value) {
+  int width = 0;
+  while (value) {
+    width++;
+    value >>= 1;
+  }
+  return width;
+}
+
+static inline int32_t predict(int order, size_t frame, int32_t previous, int32_t beforePrevious) {
+  if (frame == 0) return 0;
+  if (order == 2 && frame >= 2) return 2 * previous - beforePrevious;
+  return previous;
+}
+
+static void computeResiduals(const int16_t* samples, size_t count, int order,
+                             std::vector<uint32_t>& residuals) {
+  residuals.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    int32_t prediction = predict(order, i, i >= 1 ? samples[i - 1] : 0, i >= 2 ? samples[i - 2] : 0);
+    residuals[i] = (uint32_t)archiveZigzag(samples[i] - prediction);
+  }
+}
+
+static size_t packedSize(const std::vector<uint32_t>& residuals) {
+  size_t size = 0;
+  for (size_t start = 0; start < residuals.size(); start += ARCHIVE_GROUP_SIZE) {
+    size_t end = std::min(start + ARCHIVE_GROUP_SIZE, residuals.size());
+    uint32_t bits = 0;
+    for (size_t i = start; i < end; i++) bits |= residuals[i];
+    size += 1 + ((end - start) * bitWidth(bits) + 7) / 8;
+  }
+  return size;
+}
+
+void encodeSampleColumn(const int16_t* samples, size_t count, std::vector<uint8_t>& out) {
+  std::vector<uint32_t> first;
+  std::vector<uint32_t> second;
+  computeResiduals(samples, count, 1, first);
+  computeResiduals(samples, count, 2, second);
+  
+  // Second difference wins on smooth, oversampled stretches
+  bool useSecond = packedSize(second) < packedSize(first);
+  const std::vector<uint32_t>& residuals = useSecond ? second : first;
+  
+  std::vector<uint8_t> groups;
+  std::vector<uint8_t> seekPoints;
+  
+  for (size_t start = 0; start < count; start += ARCHIVE_GROUP_SIZE) {
+    if (start > 0 && start % ARCHIVE_SEEK_INTERVAL == 0) {
+      uint8_t point[8];
+      archivePutLE(point, groups.size(), 4);
+      archivePutLE(point + 4, (uint16_t)samples[start - 1], 2);
+      archivePutLE(point + 6, (uint16_t)samples[start - 2], 2);
+      seekPoints.insert(seekPoints.end(), point, point + 8);
+    }
+    
+    size_t end = std::min(start + ARCHIVE_GROUP_SIZE, count);
+    uint32_t bits = 0;
+    for (size_t i = start; i < end; i++) bits |= residuals[i];
+    int width = bitWidth(bits);
+    groups.push_back((uint8_t)width);
+    
+    uint64_t accumulator = 0;
+    int pending = 0;
+    for (size_t i = start; i < end; i++) {
+      accumulator |= (uint64_t)residuals[i] << pending;
+      pending += width;
+      while (pending >= 8) {
+        groups.push_back((uint8_t)accumulator);
+        accumulator >>= 8;
+        pending -= 8;
+      }
+    }
+    if (pending > 0) groups.push_back((uint8_t)accumulator);
+  }
+  
+  out.push_back(useSecond ? 2 : 1);
+  out.push_back((uint8_t)(seekPoints.size() / 8));
+  out.push_back((uint8_t)(seekPoints.size() / 8 >> 8));
+  out.insert(out.end(), seekPoints.begin(), seekPoints.end());
+  out.insert(out.end(), groups.begin(), groups.end());
+}
+
+// Decode frames [frame, end) starting at a group boundary; frames from
+// first on are written to out. position receives the byte after the last group.
+static bool decodeGroups(const uint8_t* groups, size_t length, size_t& position, int order,
+                         size_t frame, int32_t previous, int32_t beforePrevious,
+                         size_t count, size_t first, size_t end, int16_t* out) {
+  while (frame < end) {
+    if (position >= length) return false;
+    int width = groups[position++];
+    if (width > 32) return false;
+    
+    size_t groupCount = std::min(ARCHIVE_GROUP_SIZE, count - frame);
+    size_t groupBytes = (groupCount * width + 7) / 8;
+    if (position + groupBytes > length) return false;
+    
+    // Groups entirely before the range only advance the predictor
+    const uint8_t* packed = groups + position;
+    uint64_t mask = width == 32 ? 0xFFFFFFFFull : ((1ull << width) - 1);
+    uint64_t accumulator = 0;
+    int available = 0;
+    size_t next = 0;
+    
+    for (size_t i = 0; i < groupCount && frame < end; i++, frame++) {
+      while (available < width) {
+        accumulator |= (uint64_t)packed[next++] << available;
+        available += 8;
+      }
+      int64_t residual = archiveUnzigzag(accumulator & mask);
+      accumulator >>= width;
+      available -= width;
+      
+      int16_t value = (int16_t)(predict(order, frame, previous, beforePrevious) + residual);
+      beforePrevious = previous;
+      previous = value;
+      if (frame >= first) out[frame - first] = value;
+    }
+    position += groupBytes;
+  }
+  return true;
+}
+
+static bool readColumnHeader(const uint8_t* in, size_t length, int& order, size_t& seekPointCount) {
+  if (length < 3 || (in[0] != 1 && in[0] != 2)) return false;
+  order = in[0];
+  seekPointCount = archiveGetLE(in + 1, 2);
+  return length >= 3 + seekPointCount * 8;
+}
+
+bool decodeSampleColumn(const uint8_t* in, size_t length, int16_t* samples, size_t count) {
+  int order;
+  size_t seekPointCount;
+  if (!readColumnHeader(in, length, order, seekPointCount)) return false;
+  
+  size_t groupsStart = 3 + seekPointCount * 8;
+  size_t position = 0;
+  if (!decodeGroups(in + groupsStart, length - groupsStart, position, order, 0, 0, 0,
+                    count, 0, count, samples)) {
+    return false;
+  }
+  return groupsStart + position == length;
+}
+
+bool decodeSampleRange(const uint8_t* in, size_t length, size_t count, size_t first,
+                       size_t frames, int16_t* out) {
+  int order;
+  size_t seekPointCount;
+  if (!readColumnHeader(in, length, order, seekPointCount)) return false;
+  if (first + frames > count) return false;
+  
+  // Nearest seek point at or before the first frame
+  size_t point = std::min(first / ARCHIVE_SEEK_INTERVAL, seekPointCount);
+  size_t frame = 0;
+  size_t position = 0;
+  int32_t previous = 0;
+  int32_t beforePrevious = 0;
+  if (point > 0) {
+    const uint8_t* entry = in + 3 + (point - 1) * 8;
+    frame = point * ARCHIVE_SEEK_INTERVAL;
+    position = archiveGetLE(entry, 4);
+    previous = (int16_t)archiveGetLE(entry + 4, 2);
+    beforePrevious = (int16_t)archiveGetLE(entry + 6, 2);
+  }
+  
+  size_t groupsStart = 3 + seekPointCount * 8;
+  return decodeGroups(in + groupsStart, length - groupsStart, position, order, frame,
+                      previous, beforePrevious, count, first, first + frames, out);
+}
+
+// ========== HEADERS ==========
+
+void writeChunkHeader(const ArchiveChunkInfo& info, uint32_t bodyCrc, uint8_t* out) {
+  archivePutLE(out, ARCHIVE_CHUNK_MAGIC, 4);
+  archivePutLE(out + 4, info.length, 4);
+  archivePutLE(out + 8, (uint64_t)info.startUs, 8);
+  archivePutLE(out + 16, (uint64_t)info.eventFirstUs, 8);
+  archivePutLE(out + 24, info.frameCount, 4);
+  archivePutLE(out + 28, info.sampleRate, 4);
+  archivePutLE(out + 32, info.gapFrames, 4);
+  archivePutLE(out + 36, info.eventCount, 4);
+  archivePutLE(out + 40, info.flags, 4);
+  archivePutLE(out + 44, bodyCrc, 4);
+  archivePutLE(out + 48, archiveCrc32(out, 48), 4);
+}
+
+bool readChunkHeader(const uint8_t* in, size_t available, uint64_t offset,
+                     ArchiveChunkInfo& info, uint32_t& bodyCrc) {
+  if (available < ARCHIVE_CHUNK_HEADER_SIZE) return false;
+  if (archiveGetLE(in, 4) != ARCHIVE_CHUNK_MAGIC) return false;
+  if (archiveGetLE(in + 48, 4) != archiveCrc32(in, 48)) return false;
+  
+  info.offset = offset;
+  info.length = archiveGetLE(in + 4, 4);
+  info.startUs = (int64_t)archiveGetLE(in + 8, 8);
+  info.eventFirstUs = (int64_t)archiveGetLE(in + 16, 8);
+  info.frameCount = archiveGetLE(in + 24, 4);
+  info.sampleRate = archiveGetLE(in + 28, 4);
+  info.gapFrames = archiveGetLE(in + 32, 4);
+  info.eventCount = archiveGetLE(in + 36, 4);
+  info.flags = archiveGetLE(in + 40, 4);
+  bodyCrc = archiveGetLE(in + 44, 4);
+  
+  if (info.sampleRate == 0 || info.length < ARCHIVE_CHUNK_HEADER_SIZE || info.length > available) {
+    return false;
+  }
+  info.endUs = archiveFrameTime(info.startUs, info.sampleRate, info.frameCount);
+  return true;
+}
+
+void writeIndexEntry(const ArchiveChunkInfo& info, uint8_t* out) {
+  archivePutLE(out, (uint64_t)info.startUs, 8);
+  archivePutLE(out + 8, (uint64_t)info.endUs, 8);
+  archivePutLE(out + 16, (uint64_t)info.eventFirstUs, 8);
+  archivePutLE(out + 24, info.offset, 8);
+  archivePutLE(out + 32, info.length, 4);
+  archivePutLE(out + 36, info.frameCount, 4);
+  archivePutLE(out + 40, info.sampleRate, 4);
+  archivePutLE(out + 44, info.gapFrames, 4);
+  archivePutLE(out + 48, info.eventCount, 4);
+  archivePutLE(out + 52, info.flags, 4);
+}
+
+void readIndexEntry(const uint8_t* in, ArchiveChunkInfo& info) {
+  info.startUs = (int64_t)archiveGetLE(in, 8);
+  info.endUs = (int64_t)archiveGetLE(in + 8, 8);
+  info.eventFirstUs = (int64_t)archiveGetLE(in + 16, 8);
+  info.offset = archiveGetLE(in + 24, 8);
+  info.length = archiveGetLE(in + 32, 4);
+  info.frameCount = archiveGetLE(in + 36, 4);
+  info.sampleRate = archiveGetLE(in + 40, 4);
+  info.gapFrames = archiveGetLE(in + 44, 4);
+  info.eventCount = archiveGetLE(in + 48, 4);
+  info.flags = archiveGetLE(in + 52, 4);
+}
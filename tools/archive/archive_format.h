@@ -0,0 +1,118 @@
+/*
+ * ECG Archive Format
+ * 
+ * Chunked, columnar file format for long recordings (24 h Holter and
+ * longer). A file is a header, a sequence of self-describing chunks and
+ * a time index footer:
+ * 
+ *   [file header]
+ *   [chunk 0][chunk 1]...[chunk N-1]
+ *   [index: one entry per chunk][trailer]
+ * 
+ * A chunk holds up to ARCHIVE_DEFAULT_CHUNK_SECONDS of frames at one
+ * sample rate with no time discontinuity, stored as columns:
+ * 
+ *   [chunk header][channel 0 samples]...[channel C-1 samples][gaps][events]
+ * 
+ * Sample columns are predictive (first or second difference, whichever
+ * is smaller for the chunk), zigzag mapped and bit packed in groups of
+ * ARCHIVE_GROUP_SIZE with one width byte per group. A seek point every
+ * ARCHIVE_SEEK_INTERVAL frames lets a read start decoding next to the
+ * frames it wants instead of at the chunk start. Gaps (lead-off,
+ * lost samples) are kept as runs and stored as the previous value so
+ * they cost nothing in the sample column; readers see SAMPLE_GAP_VALUE.
+ * 
+ * The footer makes seeks a binary search over chunk start times. Chunk
+ * headers carry the same information plus a CRC, so a file whose writer
+ * never reached close() is recovered by scanning the chunks.
+ * 
+ * Times are microseconds: epoch time when the device clock was
+ * synchronized, device-local time otherwise (ARCHIVE_CHUNK_LOCAL_TIME).
+ * All fields are little-endian.
+ */
+
+#ifndef ARCHIVE_FORMAT_H
+#define ARCHIVE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "codec/sample_codec.h"
+
+const uint32_t ARCHIVE_FILE_MAGIC = 0x41474345;     // "ECGA"
+const uint32_t ARCHIVE_CHUNK_MAGIC = 0x43474345;    // "ECGC"
+const uint32_t ARCHIVE_INDEX_MAGIC = 0x49474345;    // "ECGI"
+const uint32_t ARCHIVE_END_MAGIC = 0x45474345;      // "ECGE"
+const uint16_t ARCHIVE_VERSION = 1;
+
+const size_t ARCHIVE_FILE_HEADER_SIZE = 48;
+const size_t ARCHIVE_CHUNK_HEADER_SIZE = 52;
+const size_t ARCHIVE_INDEX_ENTRY_SIZE = 56;
+const size_t ARCHIVE_TRAILER_SIZE = 16;
+const size_t ARCHIVE_SOURCE_LENGTH = 32;            // Device id field, NUL padded
+
+const int ARCHIVE_MAX_CHANNELS = 16;
+const size_t ARCHIVE_GROUP_SIZE = 64;               // Residuals per bit-width byte
+const size_t ARCHIVE_SEEK_INTERVAL = 1024;          // Frames between column seek points
+const uint32_t ARCHIVE_DEFAULT_CHUNK_SECONDS = 60;
+const int64_t ARCHIVE_MAX_GAP_FILL_US = 10000000;   // Longer gaps start a new chunk
+
+// Chunk flags
+const uint32_t ARCHIVE_CHUNK_LOCAL_TIME = 0x01;     // Times are device-local, not epoch
+
+// One entry of the time index (also decoded from chunk headers on recovery)
+struct ArchiveChunkInfo {
+  int64_t startUs;              // Time of frame 0
+  int64_t endUs;                // Time just after the last frame
+  int64_t eventFirstUs;         // Earliest event in the chunk (INT64_MAX if none)
+  uint64_t offset;              // File offset of the chunk header
+  uint32_t length;              // Chunk bytes including the header
+  uint32_t frameCount;
+  uint32_t sampleRate;
+  uint32_t gapFrames;
+  uint32_t eventCount;
+  uint32_t flags;
+};
+
+struct ArchiveEvent {
+  int64_t timeUs;
+  uint8_t type;                 // ECGEventType
+  int32_t value;
+};
+
+// Time of a frame within a chunk
+inline int64_t archiveFrameTime(int64_t startUs, uint32_t sampleRate, uint64_t frame) {
+  return startUs + (int64_t)(frame * 1000000 / sampleRate);
+}
+
+// Little-endian field access
+void archivePutLE(uint8_t* out, uint64_t value, int bytes);
+uint64_t archiveGetLE(const uint8_t* in, int bytes);
+
+// CRC-32 (IEEE) over a byte range
+uint32_t archiveCrc32(const uint8_t* data, size_t length);
+
+// Unsigned LEB128 varints with zigzag for signed values
+void archivePutVarint(std::vector<uint8_t>& out, uint64_t value);
+size_t archiveGetVarint(const uint8_t* in, size_t length, uint64_t& value);
+inline uint64_t archiveZigzag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+inline int64_t archiveUnzigzag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+// Compress one channel of a chunk (gaps already replaced by the previous value)
+void encodeSampleColumn(const int16_t* samples, size_t count, std::vector<uint8_t>& out);
+
+// Decompress a sample column; false if it is malformed or not count samples long
+bool decodeSampleColumn(const uint8_t* in, size_t length, int16_t* samples, size_t count);
+
+// Decompress frames [first, first + frames) of a column holding count samples
+bool decodeSampleRange(const uint8_t* in, size_t length, size_t count, size_t first,
+                       size_t frames, int16_t* out);
+
+// Chunk header and index entry serialization
+void writeChunkHeader(const ArchiveChunkInfo& info, uint32_t bodyCrc, uint8_t* out);
+bool readChunkHeader(const uint8_t* in, size_t available, uint64_t offset,
+                     ArchiveChunkInfo& info, uint32_t& bodyCrc);
+void writeIndexEntry(const ArchiveChunkInfo& info, uint8_t* out);
+void readIndexEntry(const uint8_t* in, ArchiveChunkInfo& info);
+
+#endif // ARCHIVE_FORMAT_H
@@ -0,0 +1,319 @@
+/*
+ * Archive Reader Class Implementation
+ */
+
+#include "archive_reader.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ArchiveReader::ArchiveReader() {
+  data = NULL;
+  size = 0;
+  channelCount = 0;
+  chunkSeconds = 0;
+  source[0] = '\0';
+  recovered = false;
+}
+
+ArchiveReader::~ArchiveReader() {
+  close();
+}
+
+bool ArchiveReader::open(const char* path) {
+  close();
+  
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf(stderr, "ERROR: cannot open archive %s\n", path);
+    return false;
+  }
+  
+  struct stat info;
+  if (fstat(fd, &info) < 0 || (size_t)info.st_size < ARCHIVE_FILE_HEADER_SIZE) {
+    fprintf(stderr, "ERROR: %s is not an ECG archive\n", path);
+    ::close(fd);
+    return false;
+  }
+  
+  void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    fprintf(stderr, "ERROR: cannot map archive %s\n", path);
+    return false;
+  }
+  
+  data = (const uint8_t*)mapping;
+  size = info.st_size;
+  
+  if (archiveGetLE(data, 4) != ARCHIVE_FILE_MAGIC || archiveGetLE(data + 4, 2) != ARCHIVE_VERSION) {
+    fprintf(stderr, "ERROR: %s is not an ECG archive (or a newer version)\n", path);
+    close();
+    return false;
+  }
+  
+  channelCount = archiveGetLE(data + 6, 2);
+  chunkSeconds = archiveGetLE(data + 8, 4);
+  memcpy(source, data + 16, ARCHIVE_SOURCE_LENGTH);
+  source[ARCHIVE_SOURCE_LENGTH - 1] = '\0';
+  
+  if (channelCount < 1 || channelCount > ARCHIVE_MAX_CHANNELS) {
+    fprintf(stderr, "ERROR: %s has an invalid channel count\n", path);
+    close();
+    return false;
+  }
+  
+  // Chunks are read through the index; tell the kernel not to read ahead
+  madvise((void*)data, size, MADV_RANDOM);
+  
+  recovered = !loadIndex();
+  if (recovered) {
+    scanChunks();
+  }
+  return true;
+}
+
+void ArchiveReader::close() {
+  if (data) {
+    munmap((void*)data, size);
+  }
+  data = NULL;
+  size = 0;
+  index.clear();
+}
+
+bool ArchiveReader::loadIndex() {
+  if (size < ARCHIVE_FILE_HEADER_SIZE + ARCHIVE_TRAILER_SIZE + 8) return false;
+  
+  const uint8_t* trailer = data + size - ARCHIVE_TRAILER_SIZE;
+  if (archiveGetLE(trailer + 12, 4) != ARCHIVE_END_MAGIC) return false;
+  
+  uint64_t indexOffset = archiveGetLE(trailer, 8);
+  if (indexOffset < ARCHIVE_FILE_HEADER_SIZE || indexOffset + 8 > size - ARCHIVE_TRAILER_SIZE) return false;
+  
+  const uint8_t* footer = data + indexOffset;
+  size_t footerLength = size - ARCHIVE_TRAILER_SIZE - indexOffset;
+  uint32_t count = archiveGetLE(footer + 4, 4);
+  if (archiveGetLE(footer, 4) != ARCHIVE_INDEX_MAGIC ||
+      footerLength != 8 + (size_t)count * ARCHIVE_INDEX_ENTRY_SIZE ||
+      archiveGetLE(trailer + 8, 4) != archiveCrc32(footer, footerLength)) {
+    return false;
+  }
+  
+  index.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    readIndexEntry(footer + 8 + i * ARCHIVE_INDEX_ENTRY_SIZE, index[i]);
+    if (index[i].offset + index[i].length > indexOffset || index[i].sampleRate == 0) {
+      index.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+void ArchiveReader::scanChunks() {
+  // Unfinished file: walk the chunk headers and stop at the first bad one
+  index.clear();
+  uint64_t offset = ARCHIVE_FILE_HEADER_SIZE;
+  
+  while (offset < size) {
+    ArchiveChunkInfo info;
+    uint32_t bodyCrc;
+    if (!readChunkHeader(data + offset, size - offset, offset, info, bodyCrc)) break;
+    
+    const uint8_t* body = data + offset + ARCHIVE_CHUNK_HEADER_SIZE;
+    if (archiveCrc32(body, info.length - ARCHIVE_CHUNK_HEADER_SIZE) != bodyCrc) break;
+    
+    index.push_back(info);
+    offset += info.length;
+  }
+}
+
+uint64_t ArchiveReader::getFrameCount() {
+  uint64_t frames = 0;
+  for (const ArchiveChunkInfo& info : index) {
+    frames += info.frameCount;
+  }
+  return frames;
+}
+
+long ArchiveReader::findChunk(int64_t timeUs) {
+  // First chunk that ends after timeUs
+  auto it = std::upper_bound(index.begin(), index.end(), timeUs,
+                             [](int64_t time, const ArchiveChunkInfo& info) { return time < info.endUs; });
+  while (it != index.end() && it->frameCount == 0) ++it;  // Event-only chunks
+  if (it == index.end()) return -1;
+  return (long)(it - index.begin());
+}
+
+bool ArchiveReader::locateColumn(const ArchiveChunkInfo& info, int column,
+                                 const uint8_t*& start, size_t& length) {
+  // Body: channelCount sample columns, then gaps, then events; each [u32 length][bytes]
+  const uint8_t* position = data + info.offset + ARCHIVE_CHUNK_HEADER_SIZE;
+  const uint8_t* end = data + info.offset + info.length;
+  
+  for (int i = 0; i <= column; i++) {
+    if (end - position < 4) return false;
+    length = archiveGetLE(position, 4);
+    start = position + 4;
+    if ((size_t)(end - start) < length) return false;
+    position = start + length;
+  }
+  return true;
+}
+
+bool ArchiveReader::applyGaps(const ArchiveChunkInfo& info, size_t first, size_t frames, int16_t* out) {
+  if (info.gapFrames == 0) return true;
+  
+  const uint8_t* column;
+  size_t length;
+  if (!locateColumn(info, channelCount, column, length)) return false;
+  
+  uint64_t runs;
+  size_t position = archiveGetVarint(column, length, runs);
+  if (position == 0) return false;
+  
+  uint64_t frame = 0;
+  for (uint64_t r = 0; r < runs; r++) {
+    uint64_t skip, count;
+    size_t used = archiveGetVarint(column + position, length - position, skip);
+    if (used == 0) return false;
+    position += used;
+    used = archiveGetVarint(column + position, length - position, count);
+    if (used == 0) return false;
+    position += used;
+    
+    frame += skip;
+    if (frame >= first + frames) break;
+    uint64_t from = std::max<uint64_t>(frame, first);
+    uint64_t to = std::min<uint64_t>(frame + count, first + frames);
+    for (uint64_t f = from; f < to; f++) {
+      out[f - first] = SAMPLE_GAP_VALUE;
+    }
+    frame += count;
+  }
+  return true;
+}
+
+bool ArchiveReader::readRange(size_t chunk, int channel, size_t first, size_t frames, int16_t* out) {
+  const ArchiveChunkInfo& info = index[chunk];
+  const uint8_t* column;
+  size_t length;
+  
+  if (!locateColumn(info, channel, column, length) ||
+      !decodeSampleRange(column, length, info.frameCount, first, frames, out) ||
+      !applyGaps(info, first, frames, out)) {
+    fprintf(stderr, "ERROR: archive chunk %zu is corrupt\n", chunk);
+    return false;
+  }
+  return true;
+}
+
+bool ArchiveReader::readChunk(size_t chunk, int channel, std::vector<int16_t>& out) {
+  if (chunk >= index.size() || channel < 0 || channel >= channelCount) return false;
+  const ArchiveChunkInfo& info = index[chunk];
+  
+  const uint8_t* column;
+  size_t length;
+  out.resize(info.frameCount);
+  if (!locateColumn(info, channel, column, length) ||
+      !decodeSampleColumn(column, length, out.data(), info.frameCount) ||
+      !applyGaps(info, 0, info.frameCount, out.data())) {
+    fprintf(stderr, "ERROR: archive chunk %zu is corrupt\n", chunk);
+    out.clear();
+    return false;
+  }
+  return true;
+}
+
+size_t ArchiveReader::read(int64_t timeUs, int channel, int16_t* out, size_t maxFrames,
+                           int64_t& firstUs, uint32_t& sampleRate) {
+  long chunk = findChunk(timeUs);
+  if (chunk < 0 || maxFrames == 0 || channel < 0 || channel >= channelCount) return 0;
+  
+  const ArchiveChunkInfo* info = &index[chunk];
+  sampleRate = info->sampleRate;
+  
+  // First frame at or after timeUs
+  uint64_t frame = 0;
+  if (timeUs > info->startUs) {
+    frame = ((uint64_t)(timeUs - info->startUs) * info->sampleRate + 999999) / 1000000;
+  }
+  if (frame >= info->frameCount) {
+    // timeUs is inside the last sample period; start at the next chunk
+    if ((size_t)chunk + 1 >= index.size()) return 0;
+    info = &index[++chunk];
+    sampleRate = info->sampleRate;
+    frame = 0;
+  }
+  firstUs = archiveFrameTime(info->startUs, info->sampleRate, frame);
+  
+  size_t copied = 0;
+  while (copied < maxFrames) {
+    size_t count = std::min((size_t)(info->frameCount - frame), maxFrames - copied);
+    if (!readRange(chunk, channel, frame, count, out + copied)) break;
+    copied += count;
+    
+    // Continue only into a chunk that picks up exactly where this one ends
+    if (copied == maxFrames || (size_t)chunk + 1 >= index.size()) break;
+    const ArchiveChunkInfo* next = &index[chunk + 1];
+    int64_t halfPeriod = 500000 / info->sampleRate;
+    if (next->sampleRate != info->sampleRate || next->flags != info->flags ||
+        next->startUs - info->endUs > halfPeriod || info->endUs - next->startUs > halfPeriod) {
+      break;
+    }
+    chunk++;
+    info = next;
+    frame = 0;
+  }
+  return copied;
+}
+
+void ArchiveReader::readEvents(int64_t fromUs, int64_t toUs, std::vector<ArchiveEvent>& out) {
+  out.clear();
+  
+  // Events can sit in the chunk after their time (late arrivals, gaps),
+  // so start one chunk early and stop once neither samples nor events reach toUs
+  auto it = std::upper_bound(index.begin(), index.end(), fromUs,
+                             [](int64_t time, const ArchiveChunkInfo& info) { return time < info.endUs; });
+  size_t chunk = it - index.begin();
+  if (chunk > 0) chunk--;
+  
+  for (; chunk < index.size(); chunk++) {
+    const ArchiveChunkInfo& info = index[chunk];
+    if (info.startUs >= toUs && info.eventFirstUs >= toUs) break;
+    if (info.eventCount == 0) continue;
+    
+    const uint8_t* column;
+    size_t length;
+    if (!locateColumn(info, channelCount + 1, column, length)) continue;
+    
+    size_t position = 0;
+    int64_t timeUs = info.startUs;
+    for (uint32_t e = 0; e < info.eventCount && position < length; e++) {
+      ArchiveEvent event;
+      event.type = column[position++];
+      uint64_t delta, value;
+      size_t used = archiveGetVarint(column + position, length - position, delta);
+      if (used == 0) break;
+      position += used;
+      used = archiveGetVarint(column + position, length - position, value);
+      if (used == 0) break;
+      position += used;
+      
+      timeUs += archiveUnzigzag(delta);
+      event.timeUs = timeUs;
+      event.value = (int32_t)archiveUnzigzag(value);
+      if (event.timeUs >= fromUs && event.timeUs < toUs) {
+        out.push_back(event);
+      }
+    }
+  }
+  
+  std::stable_sort(out.begin(), out.end(),
+                   [](const ArchiveEvent& a, const ArchiveEvent& b) { return a.timeUs < b.timeUs; });
+}
@@ -0,0 +1,77 @@
+/*
+ * Archive Reader Class Header
+ * 
+ * Memory-mapped reader for ECG archives. open() maps the file and loads
+ * the time index from the footer (or rebuilds it by scanning the chunks
+ * if the writer did not finish). Seeking is a binary search over chunk
+ * start times, then decoding starts at the column seek point nearest the
+ * requested frame, so a read touches a few KB however long the file is.
+ * 
+ * A reader is not thread safe; open one per thread (the mapping is
+ * shared by the page cache).
+ */
+
+#ifndef ARCHIVE_READER_H
+#define ARCHIVE_READER_H
+
+#include <vector>
+#include "archive_format.h"
+
+class ArchiveReader {
+private:
+  const uint8_t* data;
+  size_t size;
+  int channelCount;
+  uint32_t chunkSeconds;
+  char source[ARCHIVE_SOURCE_LENGTH];
+  std::vector<ArchiveChunkInfo> index;
+  bool recovered;
+  
+  // Internal methods
+  bool loadIndex();
+  void scanChunks();
+  bool locateColumn(const ArchiveChunkInfo& info, int column, const uint8_t*& start, size_t& length);
+  bool applyGaps(const ArchiveChunkInfo& info, size_t first, size_t frames, int16_t* out);
+  bool readRange(size_t chunk, int channel, size_t first, size_t frames, int16_t* out);
+  
+public:
+  // Constructor
+  ArchiveReader();
+  ~ArchiveReader();
+  
+  // Map an archive; false if it is not one
+  bool open(const char* path);
+  void close();
+  
+  // Chunk holding timeUs, or the next chunk if timeUs falls in a hole;
+  // -1 if timeUs is after the end of the archive
+  long findChunk(int64_t timeUs);
+  
+  // Read up to maxFrames samples of one channel starting at the first
+  // frame at or after timeUs. Reading continues across chunks while the
+  // stream is contiguous and stops at a rate change or time jump.
+  // Gaps read as SAMPLE_GAP_VALUE. Returns the number of frames read.
+  size_t read(int64_t timeUs, int channel, int16_t* out, size_t maxFrames,
+              int64_t& firstUs, uint32_t& sampleRate);
+  
+  // Events with timeUs in [fromUs, toUs), in time order
+  void readEvents(int64_t fromUs, int64_t toUs, std::vector<ArchiveEvent>& out);
+  
+  // Decode one whole chunk column (gaps as SAMPLE_GAP_VALUE)
+  bool readChunk(size_t chunk, int channel, std::vector<int16_t>& out);
+  
+  // Getters
+  bool isOpen() { return data != NULL; }
+  bool wasRecovered() { return recovered; }
+  int getChannelCount() { return channelCount; }
+  uint32_t getChunkSeconds() { return chunkSeconds; }
+  const char* getSource() { return source; }
+  size_t getFileSize() { return size; }
+  size_t getChunkCount() { return index.size(); }
+  const ArchiveChunkInfo& getChunk(size_t chunk) { return index[chunk]; }
+  int64_t getStartUs() { return index.empty() ? 0 : index.front().startUs; }
+  int64_t getEndUs() { return index.empty() ? 0 : index.back().endUs; }
+  uint64_t getFrameCount();
+};
+
+#endif // ARCHIVE_READER_H
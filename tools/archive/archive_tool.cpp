@@ -0,0 +1,320 @@
+/*
+ * ECG Archive Tool
+ * 
+ * Usage:
+ *   ecg_archive convert-outbox <outbox.bin> <out.eca> [--source ID]
+ *   ecg_archive convert-recording <recording.txt> <out.eca> [--start-ms T]
+ *   ecg_archive convert-serial <plot.csv> <out.eca> [--rate HZ] [--start-ms T]
+ *   ecg_archive info <file.eca>
+ *   ecg_archive export <file.eca> [--from-ms T] [--seconds N] [--channel C]
+ * 
+ * convert-outbox reads the device's record store (the outbox segments
+ * copied off LittleFS and joined in name order, or any file of framed
+ * uplink records). convert-recording
+ * reads the RecordingLoader text format; convert-serial reads the Serial
+ * Plotter output (ecgValue,threshold,hr*10) into three channels. export
+ * writes the RecordingLoader format, so archived stretches can be
+ * replayed through the pipeline.
+ */
+
+#include "archive_reader.h"
+#include "archive_writer.h"
+#include "record_archiver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+static int64_t getCurrentMs() {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static bool finishWriter(ArchiveWriter& writer) {
+  if (!writer.close()) return false;
+  printf("%llu frames, %llu events, %zu chunks, %llu bytes\n",
+         (unsigned long long)writer.getFramesWritten(), (unsigned long long)writer.getEventsWritten(),
+         writer.getChunkCount(), (unsigned long long)writer.getBytesWritten());
+  return true;
+}
+
+static int convertOutbox(const char* inputPath, const char* outputPath, const char* source) {
+  FILE* input = fopen(inputPath, "rb");
+  if (input == NULL) {
+    fprintf(stderr, "ERROR: cannot open %s\n", inputPath);
+    return 1;
+  }
+  
+  ArchiveWriter writer;
+  if (!writer.open(outputPath, 1, source)) return 1;
+  RecordArchiver archiver(&writer);
+  
+  // Stream the file in pieces; frames may straddle reads
+  std::vector<uint8_t> buffer(1 << 20);
+  size_t filled = 0;
+  size_t records = 0;
+  size_t count;
+  
+  while ((count = fread(buffer.data() + filled, 1, buffer.size() - filled, input)) > 0 || filled > 0) {
+    filled += count;
+    size_t position = 0;
+    
+    while (position < filled) {
+      const uint8_t* record;
+      size_t recordLength;
+      size_t used = readRecordFrame(buffer.data() + position, filled - position, record, recordLength);
+      if (used == 0) break;
+      archiver.addRecord(record, recordLength);
+      position += used;
+      records++;
+    }
+    
+    if (position == 0 && count == 0) {
+      fprintf(stderr, "WARNING: %zu trailing bytes (partial record) ignored\n", filled);
+      break;
+    }
+    memmove(buffer.data(), buffer.data() + position, filled - position);
+    filled -= position;
+  }
+  fclose(input);
+  
+  archiver.finish();
+  printf("%zu records (%lu malformed): ", records, archiver.getMalformedRecords());
+  return finishWriter(writer) ? 0 : 1;
+}
+
+static int convertRecording(const char* inputPath, const char* outputPath, int64_t startMs) {
+  FILE* input = fopen(inputPath, "r");
+  if (input == NULL) {
+    fprintf(stderr, "ERROR: cannot open %s\n", inputPath);
+    return 1;
+  }
+  
+  ArchiveWriter writer;
+  if (!writer.open(outputPath, 1, inputPath)) return 1;
+  
+  int sampleRate = 500;
+  float scale = 1.0;
+  float offset = 0;
+  int64_t startUs = startMs * 1000;
+  uint64_t frame = 0;
+  std::vector<int16_t> block;
+  char line[128];
+  
+  while (fgets(line, sizeof(line), input) != NULL) {
+    if (line[0] == '#') {
+      const char* field;
+      if ((field = strstr(line, "sampleRate=")) != NULL) sampleRate = atoi(field + 11);
+      if ((field = strstr(line, "scale=")) != NULL) scale = atof(field + 6);
+      if ((field = strstr(line, "offset=")) != NULL) offset = atof(field + 7);
+      continue;
+    }
+    
+    char* end;
+    float stored = strtod(line, &end);
+    if (end == line) continue;
+    
+    if (*end == ',' && end[1] > ' ') {
+      ArchiveEvent event;
+      event.timeUs = archiveFrameTime(startUs, sampleRate, frame + block.size());
+      event.type = EVENT_ANNOTATION;
+      event.value = end[1];
+      writer.writeEvent(event);
+    }
+    
+    block.push_back((int16_t)(stored * scale + offset));
+    if (block.size() == 4096) {
+      writer.writeSamples(archiveFrameTime(startUs, sampleRate, frame), sampleRate, block.data(), block.size());
+      frame += block.size();
+      block.clear();
+    }
+  }
+  writer.writeSamples(archiveFrameTime(startUs, sampleRate, frame), sampleRate, block.data(), block.size());
+  fclose(input);
+  
+  return finishWriter(writer) ? 0 : 1;
+}
+
+static int convertSerial(const char* inputPath, const char* outputPath, int sampleRate, int64_t startMs) {
+  FILE* input = fopen(inputPath, "r");
+  if (input == NULL) {
+    fprintf(stderr, "ERROR: cannot open %s\n", inputPath);
+    return 1;
+  }
+  
+  // Channels: ECG, detection threshold, heart rate x10
+  ArchiveWriter writer;
+  if (!writer.open(outputPath, 3, inputPath)) return 1;
+  
+  int64_t startUs = startMs * 1000;
+  uint64_t frame = 0;
+  std::vector<int16_t> block;
+  char line[128];
+  
+  while (fgets(line, sizeof(line), input) != NULL) {
+    int ecg, threshold, heartRate;
+    if (sscanf(line, "%d,%d,%d", &ecg, &threshold, &heartRate) != 3) continue;  // Log lines
+    
+    block.push_back(ecg);
+    block.push_back(threshold);
+    block.push_back(heartRate);
+    if (block.size() == 3 * 4096) {
+      writer.writeSamples(archiveFrameTime(startUs, sampleRate, frame), sampleRate, block.data(), 4096);
+      frame += 4096;
+      block.clear();
+    }
+  }
+  writer.writeSamples(archiveFrameTime(startUs, sampleRate, frame), sampleRate, block.data(), block.size() / 3);
+  fclose(input);
+  
+  return finishWriter(writer) ? 0 : 1;
+}
+
+static void printTime(const char* label, int64_t timeUs, bool local) {
+  if (local) {
+    printf("%s %.3f s (device clock)\n", label, timeUs / 1e6);
+    return;
+  }
+  time_t seconds = timeUs / 1000000;
+  char text[32];
+  strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", gmtime(&seconds));
+  printf("%s %s.%03d UTC (%lld ms)\n", label, text, (int)(timeUs / 1000 % 1000), (long long)(timeUs / 1000));
+}
+
+static int showInfo(const char* path) {
+  ArchiveReader reader;
+  if (!reader.open(path)) return 1;
+  
+  uint64_t gapFrames = 0;
+  uint64_t events = 0;
+  int64_t coveredUs = 0;
+  bool local = false;
+  for (size_t i = 0; i < reader.getChunkCount(); i++) {
+    const ArchiveChunkInfo& info = reader.getChunk(i);
+    gapFrames += info.gapFrames;
+    events += info.eventCount;
+    coveredUs += info.endUs - info.startUs;
+    if (info.flags & ARCHIVE_CHUNK_LOCAL_TIME) local = true;
+  }
+  
+  printf("Source:    %s\n", reader.getSource());
+  printf("Channels:  %d\n", reader.getChannelCount());
+  printf("Chunks:    %zu%s\n", reader.getChunkCount(), reader.wasRecovered() ? " (recovered, no index)" : "");
+  printf("Frames:    %llu (%llu gap)\n", (unsigned long long)reader.getFrameCount(), (unsigned long long)gapFrames);
+  printf("Events:    %llu\n", (unsigned long long)events);
+  printTime("Start:    ", reader.getStartUs(), local);
+  printTime("End:      ", reader.getEndUs(), local);
+  printf("Covered:   %.2f h\n", coveredUs / 3.6e9);
+  printf("Size:      %zu bytes", reader.getFileSize());
+  if (coveredUs > 0) {
+    printf(" (%.2f MB/hour, %.2f bits/sample)", reader.getFileSize() / (coveredUs / 3.6e9) / 1e6,
+           reader.getFileSize() * 8.0 / reader.getFrameCount() / reader.getChannelCount());
+  }
+  printf("\n");
+  return 0;
+}
+
+static const char* getEventLabel(const ArchiveEvent& event) {
+  static char label[2];
+  if (event.type == EVENT_ANNOTATION) {
+    label[0] = (char)event.value;
+    label[1] = '\0';
+    return label;
+  }
+  return event.type == EVENT_BEAT ? "N" : NULL;
+}
+
+static int exportRange(const char* path, int64_t fromMs, double seconds, int channel) {
+  ArchiveReader reader;
+  if (!reader.open(path)) return 1;
+  if (channel < 0 || channel >= reader.getChannelCount()) {
+    fprintf(stderr, "ERROR: no channel %d\n", channel);
+    return 1;
+  }
+  
+  int64_t fromUs = fromMs ? fromMs * 1000 : reader.getStartUs();
+  std::vector<int16_t> samples(1 << 16);
+  int64_t firstUs;
+  uint32_t sampleRate;
+  size_t count = reader.read(fromUs, channel, samples.data(), 1, firstUs, sampleRate);
+  if (count == 0) {
+    fprintf(stderr, "ERROR: no samples at or after %lld ms\n", (long long)(fromUs / 1000));
+    return 1;
+  }
+  
+  // One contiguous stretch at one rate
+  size_t wanted = (size_t)(seconds * sampleRate);
+  samples.resize(wanted);
+  count = reader.read(fromUs, channel, samples.data(), wanted, firstUs, sampleRate);
+  
+  std::vector<ArchiveEvent> events;
+  reader.readEvents(firstUs, archiveFrameTime(firstUs, sampleRate, count), events);
+  
+  printf("# sampleRate=%u\n", sampleRate);
+  printf("# source=%s channel=%d startMs=%lld\n", reader.getSource(), channel, (long long)(firstUs / 1000));
+  
+  size_t nextEvent = 0;
+  for (size_t i = 0; i < count; i++) {
+    int64_t endUs = archiveFrameTime(firstUs, sampleRate, i + 1);
+    const char* label = NULL;
+    while (nextEvent < events.size() && events[nextEvent].timeUs < endUs) {
+      const char* eventLabel = getEventLabel(events[nextEvent++]);
+      if (eventLabel) label = eventLabel;
+    }
+    if (label) {
+      printf("%d,%s\n", samples[i], label);
+    } else {
+      printf("%d\n", samples[i]);
+    }
+  }
+  return 0;
+}
+
+static void printUsage() {
+  printf("Usage:\n"
+         "  ecg_archive convert-outbox <outbox.bin> <out.eca> [--source ID]\n"
+         "  ecg_archive convert-recording <recording.txt> <out.eca> [--start-ms T]\n"
+         "  ecg_archive convert-serial <plot.csv> <out.eca> [--rate HZ] [--start-ms T]\n"
+         "  ecg_archive info <file.eca>\n"
+         "  ecg_archive export <file.eca> [--from-ms T] [--seconds N] [--channel C]\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printUsage();
+    return 1;
+  }
+  
+  const char* command = argv[1];
+  int64_t startMs = strtoll(getOption(argc, argv, "--start-ms", "0"), NULL, 10);
+  if (startMs == 0) startMs = getCurrentMs();
+  
+  if (strcmp(command, "convert-outbox") == 0 && argc >= 4) {
+    return convertOutbox(argv[2], argv[3], getOption(argc, argv, "--source", "outbox"));
+  }
+  if (strcmp(command, "convert-recording") == 0 && argc >= 4) {
+    return convertRecording(argv[2], argv[3], startMs);
+  }
+  if (strcmp(command, "convert-serial") == 0 && argc >= 4) {
+    return convertSerial(argv[2], argv[3], atoi(getOption(argc, argv, "--rate", "500")), startMs);
+  }
+  if (strcmp(command, "info") == 0) {
+    return showInfo(argv[2]);
+  }
+  if (strcmp(command, "export") == 0) {
+    return exportRange(argv[2], strtoll(getOption(argc, argv, "--from-ms", "0"), NULL, 10),
+                       atof(getOption(argc, argv, "--seconds", "10")),
+                       atoi(getOption(argc, argv, "--channel", "0")));
+  }
+  
+  printUsage();
+  return 1;
+}
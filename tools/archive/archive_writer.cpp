@@ -0,0 +1,266 @@
+/*
+ * Archive Writer Class Implementation
+ */
+
+#include "archive_writer.h"
+#include <algorithm>
+#include <string.h>
+
+ArchiveWriter::ArchiveWriter() {
+  file = NULL;
+  channelCount = 0;
+  chunkSeconds = ARCHIVE_DEFAULT_CHUNK_SECONDS;
+  fileOffset = 0;
+  chunkOpen = false;
+  chunkStartUs = 0;
+  chunkRate = 0;
+  chunkFlags = 0;
+  chunkFrames = 0;
+  maxChunkFrames = 0;
+  gapFrames = 0;
+  framesWritten = 0;
+  eventsWritten = 0;
+}
+
+ArchiveWriter::~ArchiveWriter() {
+  close();
+}
+
+bool ArchiveWriter::open(const char* path, int channelCount, const char* source,
+                         uint32_t chunkSeconds) {
+  close();
+  
+  if (channelCount < 1 || channelCount > ARCHIVE_MAX_CHANNELS || chunkSeconds == 0) {
+    fprintf(stderr, "ERROR: invalid archive layout\n");
+    return false;
+  }
+  
+  file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "ERROR: cannot create archive %s\n", path);
+    return false;
+  }
+  
+  this->channelCount = channelCount;
+  this->chunkSeconds = chunkSeconds;
+  fileOffset = 0;
+  index.clear();
+  chunkOpen = false;
+  pendingEvents.clear();
+  framesWritten = 0;
+  eventsWritten = 0;
+  
+  uint8_t header[ARCHIVE_FILE_HEADER_SIZE] = {0};
+  archivePutLE(header, ARCHIVE_FILE_MAGIC, 4);
+  archivePutLE(header + 4, ARCHIVE_VERSION, 2);
+  archivePutLE(header + 6, channelCount, 2);
+  archivePutLE(header + 8, chunkSeconds, 4);
+  if (source) {
+    strncpy((char*)header + 16, source, ARCHIVE_SOURCE_LENGTH - 1);
+  }
+  
+  return writeBytes(header, sizeof(header));
+}
+
+bool ArchiveWriter::writeBytes(const uint8_t* data, size_t length) {
+  if (fwrite(data, 1, length, file) != length) {
+    fprintf(stderr, "ERROR: archive write failed\n");
+    return false;
+  }
+  fileOffset += length;
+  return true;
+}
+
+void ArchiveWriter::startChunk(int64_t startUs, uint32_t sampleRate, uint32_t flags) {
+  chunkOpen = true;
+  chunkStartUs = startUs;
+  chunkRate = sampleRate;
+  chunkFlags = flags;
+  chunkFrames = 0;
+  maxChunkFrames = chunkSeconds * sampleRate;
+  gapRuns.clear();
+  gapFrames = 0;
+  for (int c = 0; c < channelCount; c++) {
+    columns[c].clear();
+    columns[c].reserve(maxChunkFrames);
+  }
+}
+
+void ArchiveWriter::appendFrame(const int16_t* frame, int64_t timeUs, uint32_t sampleRate,
+                                uint32_t flags) {
+  bool gap = true;
+  if (frame) {
+    for (int c = 0; c < channelCount; c++) {
+      if (frame[c] != SAMPLE_GAP_VALUE) gap = false;
+    }
+  }
+  
+  if (!chunkOpen) {
+    if (gap) return;  // Chunks never start with a gap; the index shows the hole
+    startChunk(timeUs, sampleRate, flags);
+  }
+  
+  if (gap) {
+    // Repeat the previous value so the gap costs nothing in the columns
+    for (int c = 0; c < channelCount; c++) {
+      columns[c].push_back(columns[c].back());
+    }
+    if (!gapRuns.empty() && gapRuns[gapRuns.size() - 2] + gapRuns.back() == chunkFrames) {
+      gapRuns.back()++;
+    } else {
+      gapRuns.push_back(chunkFrames);
+      gapRuns.push_back(1);
+    }
+    gapFrames++;
+  } else {
+    for (int c = 0; c < channelCount; c++) {
+      columns[c].push_back(frame[c]);
+    }
+  }
+  
+  chunkFrames++;
+  framesWritten++;
+  if (chunkFrames >= maxChunkFrames) {
+    flushChunk(false);
+  }
+}
+
+bool ArchiveWriter::writeSamples(int64_t timeUs, uint32_t sampleRate, const int16_t* frames,
+                                 size_t frameCount, uint32_t flags) {
+  if (file == NULL || sampleRate == 0) return false;
+  
+  if (chunkOpen) {
+    int64_t expected = archiveFrameTime(chunkStartUs, chunkRate, chunkFrames);
+    int64_t halfPeriod = 500000 / sampleRate;
+    int64_t lead = timeUs - expected;
+    
+    if (sampleRate != chunkRate || flags != chunkFlags || lead < -halfPeriod ||
+        lead > ARCHIVE_MAX_GAP_FILL_US) {
+      if (!flushChunk(false)) return false;
+    } else if (lead > halfPeriod) {
+      // Short dropout at the same rate: keep the chunk and mark the hole
+      uint64_t missing = ((uint64_t)lead * sampleRate + 500000) / 1000000;
+      for (uint64_t i = 0; i < missing; i++) {
+        appendFrame(NULL, archiveFrameTime(expected, sampleRate, i), sampleRate, flags);
+      }
+    }
+  }
+  
+  for (size_t i = 0; i < frameCount; i++) {
+    appendFrame(frames + i * channelCount, archiveFrameTime(timeUs, sampleRate, i), sampleRate, flags);
+  }
+  
+  return !ferror(file);
+}
+
+void ArchiveWriter::writeEvent(const ArchiveEvent& event) {
+  pendingEvents.push_back(event);
+}
+
+bool ArchiveWriter::flushChunk(bool final) {
+  if (!chunkOpen && !(final && !pendingEvents.empty())) return true;
+  
+  if (!chunkOpen) {
+    // Events after the last sample get an empty chunk of their own
+    startChunk(pendingEvents.front().timeUs, chunkRate ? chunkRate : 1, chunkFlags);
+  }
+  
+  ArchiveChunkInfo info;
+  info.startUs = chunkStartUs;
+  info.endUs = archiveFrameTime(chunkStartUs, chunkRate, chunkFrames);
+  info.offset = fileOffset;
+  info.frameCount = chunkFrames;
+  info.sampleRate = chunkRate;
+  info.gapFrames = gapFrames;
+  info.flags = chunkFlags;
+  
+  // Events up to the end of the chunk (all of them on the last one)
+  std::stable_sort(pendingEvents.begin(), pendingEvents.end(),
+                   [](const ArchiveEvent& a, const ArchiveEvent& b) { return a.timeUs < b.timeUs; });
+  size_t eventCount = 0;
+  while (eventCount < pendingEvents.size() &&
+         (final || pendingEvents[eventCount].timeUs < info.endUs)) {
+    eventCount++;
+  }
+  info.eventCount = eventCount;
+  info.eventFirstUs = eventCount > 0 ? pendingEvents[0].timeUs : INT64_MAX;
+  
+  body.clear();
+  std::vector<uint8_t> column;
+  
+  for (int c = 0; c < channelCount; c++) {
+    column.clear();
+    encodeSampleColumn(columns[c].data(), chunkFrames, column);
+    size_t at = body.size();
+    body.resize(at + 4);
+    archivePutLE(&body[at], column.size(), 4);
+    body.insert(body.end(), column.begin(), column.end());
+  }
+  
+  column.clear();
+  archivePutVarint(column, gapRuns.size() / 2);
+  uint32_t previousEnd = 0;
+  for (size_t i = 0; i < gapRuns.size(); i += 2) {
+    archivePutVarint(column, gapRuns[i] - previousEnd);
+    archivePutVarint(column, gapRuns[i + 1]);
+    previousEnd = gapRuns[i] + gapRuns[i + 1];
+  }
+  size_t at = body.size();
+  body.resize(at + 4);
+  archivePutLE(&body[at], column.size(), 4);
+  body.insert(body.end(), column.begin(), column.end());
+  
+  column.clear();
+  int64_t previousUs = chunkStartUs;
+  for (size_t i = 0; i < eventCount; i++) {
+    const ArchiveEvent& event = pendingEvents[i];
+    column.push_back(event.type);
+    archivePutVarint(column, archiveZigzag(event.timeUs - previousUs));
+    archivePutVarint(column, archiveZigzag(event.value));
+    previousUs = event.timeUs;
+  }
+  at = body.size();
+  body.resize(at + 4);
+  archivePutLE(&body[at], column.size(), 4);
+  body.insert(body.end(), column.begin(), column.end());
+  
+  info.length = ARCHIVE_CHUNK_HEADER_SIZE + body.size();
+  uint8_t header[ARCHIVE_CHUNK_HEADER_SIZE];
+  writeChunkHeader(info, archiveCrc32(body.data(), body.size()), header);
+  
+  pendingEvents.erase(pendingEvents.begin(), pendingEvents.begin() + eventCount);
+  eventsWritten += eventCount;
+  chunkOpen = false;
+  chunkFrames = 0;
+  
+  if (!writeBytes(header, sizeof(header)) || !writeBytes(body.data(), body.size())) {
+    return false;
+  }
+  index.push_back(info);
+  return true;
+}
+
+bool ArchiveWriter::close() {
+  if (file == NULL) return true;
+  
+  bool ok = flushChunk(true);
+  
+  // Index footer and trailer
+  uint64_t indexOffset = fileOffset;
+  std::vector<uint8_t> footer(8 + index.size() * ARCHIVE_INDEX_ENTRY_SIZE);
+  archivePutLE(&footer[0], ARCHIVE_INDEX_MAGIC, 4);
+  archivePutLE(&footer[4], index.size(), 4);
+  for (size_t i = 0; i < index.size(); i++) {
+    writeIndexEntry(index[i], &footer[8 + i * ARCHIVE_INDEX_ENTRY_SIZE]);
+  }
+  
+  uint8_t trailer[ARCHIVE_TRAILER_SIZE];
+  archivePutLE(trailer, indexOffset, 8);
+  archivePutLE(trailer + 8, archiveCrc32(footer.data(), footer.size()), 4);
+  archivePutLE(trailer + 12, ARCHIVE_END_MAGIC, 4);
+  
+  ok = ok && writeBytes(footer.data(), footer.size()) && writeBytes(trailer, sizeof(trailer));
+  ok = (fclose(file) == 0) && ok;
+  file = NULL;
+  return ok;
+}
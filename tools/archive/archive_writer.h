@@ -0,0 +1,84 @@
+/*
+ * Archive Writer Class Header
+ * 
+ * Appends samples and events to an ECG archive (see archive_format.h).
+ * Samples are buffered into the open chunk and written when it is full
+ * or when the stream changes rate or jumps in time; the index footer is
+ * written by close(). Everything before the open chunk is on disk, so a
+ * crash loses at most one chunk.
+ */
+
+#ifndef ARCHIVE_WRITER_H
+#define ARCHIVE_WRITER_H
+
+#include <stdio.h>
+#include <vector>
+#include "archive_format.h"
+
+class ArchiveWriter {
+private:
+  FILE* file;
+  int channelCount;
+  uint32_t chunkSeconds;
+  uint64_t fileOffset;
+  std::vector<ArchiveChunkInfo> index;
+  
+  // Open chunk
+  bool chunkOpen;
+  int64_t chunkStartUs;
+  uint32_t chunkRate;
+  uint32_t chunkFlags;
+  uint32_t chunkFrames;
+  uint32_t maxChunkFrames;
+  std::vector<int16_t> columns[ARCHIVE_MAX_CHANNELS];
+  std::vector<uint32_t> gapRuns;        // Start frame, length pairs
+  uint32_t gapFrames;
+  std::vector<ArchiveEvent> pendingEvents;
+  std::vector<uint8_t> body;
+  
+  // Totals
+  uint64_t framesWritten;
+  uint64_t eventsWritten;
+  
+  // Internal methods
+  void startChunk(int64_t startUs, uint32_t sampleRate, uint32_t flags);
+  void appendFrame(const int16_t* frame, int64_t timeUs, uint32_t sampleRate, uint32_t flags);
+  bool flushChunk(bool final);
+  bool writeBytes(const uint8_t* data, size_t length);
+  
+public:
+  // Constructor
+  ArchiveWriter();
+  ~ArchiveWriter();
+  
+  // Create an archive (source is the device id, truncated to 31 characters)
+  bool open(const char* path, int channelCount, const char* source,
+            uint32_t chunkSeconds = ARCHIVE_DEFAULT_CHUNK_SECONDS);
+  
+  // Append frames (channelCount interleaved samples each) starting at timeUs.
+  // Frames whose channels are all SAMPLE_GAP_VALUE are stored as gaps; a
+  // stream that resumes later at the same rate is gap filled up to
+  // ARCHIVE_MAX_GAP_FILL_US, anything else starts a new chunk.
+  bool writeSamples(int64_t timeUs, uint32_t sampleRate, const int16_t* frames,
+                    size_t frameCount, uint32_t flags = 0);
+  
+  // Add an event; it is stored with the chunk that covers its time
+  // (or the open chunk, if it arrives after its own chunk was written)
+  void writeEvent(const ArchiveEvent& event);
+  
+  // Write the open chunk now; the next samples start a new one (used when
+  // the time base is corrected and frames must not be gap filled)
+  bool endChunk() { return file != NULL && flushChunk(false); }
+  
+  // Write the open chunk and the index; returns false on an I/O error
+  bool close();
+  
+  // Getters
+  bool isOpen() { return file != NULL; }
+  size_t getChunkCount() { return index.size(); }
+  uint64_t getFramesWritten() { return framesWritten; }
+  uint64_t getEventsWritten() { return eventsWritten; }
+  uint64_t getBytesWritten() { return fileOffset; }
+};
+
+#endif // ARCHIVE_WRITER_H
@@ -0,0 +1,113 @@
+/*
+ * Record Archiver Class Implementation
+ */
+
+#include "record_archiver.h"
+
+RecordArchiver::RecordArchiver(ArchiveWriter* writer) {
+  this->writer = writer;
+  haveAnchor = false;
+  anchorSequence = 0;
+  anchorUs = 0;
+  sampleRate = 0;
+  flags = 0;
+  nextSequence = 0;
+  decodeBuffer.resize(65535);
+  malformedRecords = 0;
+}
+
+bool RecordArchiver::addRecord(const uint8_t* record, size_t length) {
+  uint8_t type = getRecordType(record, length);
+  
+  if (type == RECORD_SAMPLE_BLOCK) {
+    SampleBlockHeader header;
+    if (decodeSampleBlock(record, length, header, decodeBuffer.data(), decodeBuffer.size())) {
+      addBlock(header, decodeBuffer.data());
+      return true;
+    }
+  } else if (type == RECORD_EVENT) {
+    ECGEvent event;
+    if (decodeEvent(record, length, event)) {
+      addEvent(event);
+      return true;
+    }
+  }
+  
+  malformedRecords++;
+  return false;
+}
+
+int64_t RecordArchiver::getSequenceTime(uint32_t sequence) {
+  int64_t offset = (int32_t)(sequence - anchorSequence);
+  return anchorUs + offset * 1000000 / sampleRate;
+}
+
+void RecordArchiver::addBlock(const SampleBlockHeader& header, const int16_t* samples) {
+  if (header.sampleCount == 0 || header.sampleRate == 0) return;
+  
+  uint32_t blockFlags = header.firstEpochMs != 0 ? 0 : ARCHIVE_CHUNK_LOCAL_TIME;
+  int64_t headerUs = header.firstEpochMs != 0 ? header.firstEpochMs * 1000
+                                              : (int64_t)header.firstSampleTime;
+  
+  bool sameStream = haveAnchor && header.sampleRate == sampleRate && blockFlags == flags &&
+                    (int32_t)(header.firstSequence - nextSequence) >= 0;
+  
+  if (!sameStream && haveAnchor) {
+    // Restart or rate change: events of the old stream keep the old mapping
+    resolveEvents(true);
+  }
+  
+  if (sameStream) {
+    int64_t predicted = getSequenceTime(header.firstSequence);
+    int64_t error = headerUs - predicted;
+    if (error > ARCHIVE_RESYNC_US || error < -ARCHIVE_RESYNC_US) {
+      // Clock correction: follow the device, and do not gap fill the step
+      if (header.firstSequence == nextSequence) writer->endChunk();
+      sameStream = false;
+    }
+  }
+  
+  if (!sameStream) {
+    haveAnchor = true;
+    anchorSequence = header.firstSequence;
+    anchorUs = headerUs;
+    sampleRate = header.sampleRate;
+    flags = blockFlags;
+  }
+  
+  writer->writeSamples(getSequenceTime(header.firstSequence), sampleRate, samples,
+                       header.sampleCount, flags);
+  nextSequence = header.firstSequence + header.sampleCount;
+  resolveEvents(false);
+}
+
+void RecordArchiver::addEvent(const ECGEvent& event) {
+  pendingEvents.push_back(event);
+  resolveEvents(false);
+}
+
+void RecordArchiver::resolveEvents(bool all) {
+  if (!haveAnchor) return;
+  
+  size_t kept = 0;
+  for (size_t i = 0; i < pendingEvents.size(); i++) {
+    const ECGEvent& event = pendingEvents[i];
+    
+    // Wait for the block holding the sequence (it sets the time base)
+    if (!all && (int32_t)(event.sequence - nextSequence) >= 0) {
+      pendingEvents[kept++] = event;
+      continue;
+    }
+    
+    ArchiveEvent archived;
+    archived.timeUs = getSequenceTime(event.sequence);
+    archived.type = event.type;
+    archived.value = event.value;
+    writer->writeEvent(archived);
+  }
+  pendingEvents.resize(kept);
+}
+
+void RecordArchiver::finish() {
+  resolveEvents(true);
+}
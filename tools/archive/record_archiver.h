@@ -0,0 +1,59 @@
+/*
+ * Record Archiver Class Header
+ * 
+ * Feeds device records (sample blocks and events from the uplink stream
+ * or an outbox file) into an ArchiveWriter. Block times come from the
+ * sequence numbers so blocks join without jitter, and are re-anchored to
+ * the header time when the two drift apart by ARCHIVE_RESYNC_US (clock
+ * corrections, device restarts). Events refer to sample sequences and
+ * usually arrive before their block, so they are held until a block
+ * gives their sequence a time.
+ */
+
+#ifndef RECORD_ARCHIVER_H
+#define RECORD_ARCHIVER_H
+
+#include <vector>
+#include "archive_writer.h"
+#include "codec/sample_codec.h"
+
+const int64_t ARCHIVE_RESYNC_US = 5000;
+
+class RecordArchiver {
+private:
+  ArchiveWriter* writer;
+  
+  // Sequence to time mapping of the current stream
+  bool haveAnchor;
+  uint32_t anchorSequence;
+  int64_t anchorUs;
+  uint16_t sampleRate;
+  uint32_t flags;
+  uint32_t nextSequence;
+  
+  std::vector<ECGEvent> pendingEvents;
+  std::vector<int16_t> decodeBuffer;
+  unsigned long malformedRecords;
+  
+  // Internal methods
+  int64_t getSequenceTime(uint32_t sequence);
+  void resolveEvents(bool all);
+  
+public:
+  // Constructor
+  RecordArchiver(ArchiveWriter* writer);
+  
+  // Decode and archive one record (without its frame header)
+  bool addRecord(const uint8_t* record, size_t length);
+  
+  // Archive decoded data
+  void addBlock(const SampleBlockHeader& header, const int16_t* samples);
+  void addEvent(const ECGEvent& event);
+  
+  // Write events still waiting for samples (call before closing the writer)
+  void finish();
+  
+  unsigned long getMalformedRecords() { return malformedRecords; }
+};
+
+#endif // RECORD_ARCHIVER_H
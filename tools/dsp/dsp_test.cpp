@@ -0,0 +1,165 @@
+/*
+ * DSP Kernel Test and Benchmark
+ * 
+ * Checks the compiled-in backend of src/dsp (SSE2 on x86, NEON on ARM,
+ * scalar with -DDSP_FORCE_SCALAR) against the scalar reference dspScalar*:
+ * 
+ *   - edge inputs: every length up to 40 and the lengths around the
+ *     vector width and the 65536 limit of dspSum, at each start offset
+ *     within a 16-byte line, filled with the extremes (+-32767),
+ *     alternating extremes, zeros and a ramp
+ *   - random inputs: --trials random lengths, offsets and values over the
+ *     whole input range
+ * 
+ * Results must be bit-identical. Then times both on the block sizes the
+ * pipeline uses and reports the speedup. Exits with status 1 on any
+ * mismatch.
+ * 
+ * Usage: dsp_test [--trials N] [--seed N] [--iterations N]
+ */
+
+#include <Arduino.h>
+#include "dsp/dsp_kernels.h"
+#include "config/config.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t MAX_LENGTH = 65536;          // dspSum limit
+static const int VALUE_LIMIT = 32767;
+static const size_t LINE_SAMPLES = 8;            // Offsets within a 16-byte line
+
+static int16_t data[MAX_LENGTH + LINE_SAMPLES] __attribute__((aligned(16)));
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+struct CheckStats {
+  unsigned long cases = 0;
+  unsigned long mismatches = 0;
+};
+
+static void check(const int16_t* x, size_t n, const char* pattern, CheckStats& stats) {
+  stats.cases++;
+  int32_t sum = dspSum(x, n);
+  int32_t expectedSum = dspScalarSum(x, n);
+  int64_t squares = dspSumSquares(x, n);
+  int64_t expectedSquares = dspScalarSumSquares(x, n);
+  
+  if (sum != expectedSum || squares != expectedSquares) {
+    if (stats.mismatches < 10) {
+      printf("MISMATCH %s n=%zu offset=%zu: sum %d (expected %d), squares %lld (expected %lld)\n",
+             pattern, n, (size_t)(x - data) % LINE_SAMPLES, sum, expectedSum,
+             (long long)squares, (long long)expectedSquares);
+    }
+    stats.mismatches++;
+  }
+}
+
+enum Pattern { PATTERN_MAX, PATTERN_MIN, PATTERN_ALTERNATING, PATTERN_ZERO, PATTERN_RAMP, PATTERN_COUNT };
+static const char* PATTERN_NAMES[PATTERN_COUNT] = { "max", "min", "alternating", "zero", "ramp" };
+
+static void fill(Pattern pattern, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    switch (pattern) {
+      case PATTERN_MAX: data[i] = VALUE_LIMIT; break;
+      case PATTERN_MIN: data[i] = -VALUE_LIMIT; break;
+      case PATTERN_ALTERNATING: data[i] = (i & 1) ? -VALUE_LIMIT : VALUE_LIMIT; break;
+      case PATTERN_ZERO: data[i] = 0; break;
+      default: data[i] = (int16_t)((int)(i % (2 * VALUE_LIMIT + 1)) - VALUE_LIMIT); break;
+    }
+  }
+}
+
+static void runEdgeCases(CheckStats& stats) {
+  static const size_t LONG_LENGTHS[] = { 63, 64, 65, 127, 128, 129, 255, 256, 1000,
+                                         4096, MAX_LENGTH - 9, MAX_LENGTH - 1, MAX_LENGTH };
+  
+  for (int p = 0; p < PATTERN_COUNT; p++) {
+    fill((Pattern)p, MAX_LENGTH + LINE_SAMPLES);
+    
+    for (size_t offset = 0; offset < LINE_SAMPLES; offset++) {
+      for (size_t n = 0; n <= 40; n++) {
+        check(data + offset, n, PATTERN_NAMES[p], stats);
+      }
+      for (size_t n : LONG_LENGTHS) {
+        check(data + offset, n, PATTERN_NAMES[p], stats);
+      }
+    }
+  }
+}
+
+static void runRandomCases(unsigned long trials, unsigned int seed, CheckStats& stats) {
+  for (unsigned long t = 0; t < trials; t++) {
+    // Mostly pipeline-sized blocks, some up to the limit
+    size_t n = rand_r(&seed) % 8 == 0 ? rand_r(&seed) % (MAX_LENGTH + 1) : rand_r(&seed) % 513;
+    size_t offset = rand_r(&seed) % LINE_SAMPLES;
+    for (size_t i = 0; i < n; i++) {
+      data[offset + i] = (int16_t)(rand_r(&seed) % (2 * VALUE_LIMIT + 1) - VALUE_LIMIT);
+    }
+    check(data + offset, n, "random", stats);
+  }
+}
+
+// ns per call of each kernel; sink keeps the calls from being dropped
+static volatile int64_t sink;
+
+template <typename Kernel>
+static double timeKernel(Kernel kernel, size_t n, unsigned long iterations) {
+  auto start = std::chrono::steady_clock::now();
+  int64_t total = 0;
+  for (unsigned long i = 0; i < iterations; i++) {
+    total += kernel(data + (i & 1), n);
+  }
+  auto end = std::chrono::steady_clock::now();
+  sink = total;
+  return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+static void runBenchmark(unsigned long iterations, unsigned int seed) {
+  for (size_t i = 0; i < MAX_LENGTH + LINE_SAMPLES; i++) {
+    data[i] = (int16_t)(ADC_MAX_VALUE / 2 + rand_r(&seed) % 401 - 200);
+  }
+  
+  // Moving average windows, the analysis buffer, and a long block
+  static const size_t SIZES[] = { 5, (size_t)MAX_MOVING_AVERAGE_SIZE, 100, (size_t)MAX_ECG_BUFFER_SIZE, 4096 };
+  
+  printf("\n%-8s %-12s %10s %10s %8s\n", "samples", "kernel", "scalar ns", "backend ns", "speedup");
+  for (size_t n : SIZES) {
+    unsigned long count = iterations * 32 / (n + 32);   // Similar time per size
+    double scalarSum = timeKernel(dspScalarSum, n, count);
+    double backendSum = timeKernel(dspSum, n, count);
+    double scalarSquares = timeKernel(dspScalarSumSquares, n, count);
+    double backendSquares = timeKernel(dspSumSquares, n, count);
+    printf("%-8zu %-12s %10.1f %10.1f %7.2fx\n", n, "sum", scalarSum, backendSum, scalarSum / backendSum);
+    printf("%-8zu %-12s %10.1f %10.1f %7.2fx\n", n, "sumSquares", scalarSquares, backendSquares,
+           scalarSquares / backendSquares);
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned long trials = atol(getOption(argc, argv, "--trials", "20000"));
+  unsigned int seed = atoi(getOption(argc, argv, "--seed", "1"));
+  unsigned long iterations = atol(getOption(argc, argv, "--iterations", "2000000"));
+  
+  printf("backend %s\n", dspBackendName());
+  
+  CheckStats edge;
+  runEdgeCases(edge);
+  printf("edge inputs    %lu cases, %lu mismatches\n", edge.cases, edge.mismatches);
+  
+  CheckStats random;
+  runRandomCases(trials, seed, random);
+  printf("random inputs  %lu cases, %lu mismatches\n", random.cases, random.mismatches);
+  
+  runBenchmark(iterations, seed);
+  
+  bool passed = edge.mismatches == 0 && random.mismatches == 0;
+  printf("\n%s\n", passed ? "PASS" : "FAIL");
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+/*
+ * Device Registry Class Implementation
+ */
+
+#include "device_registry.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <time.h>
+
+// Samples per block are bounded by the 16-bit count in the header
+static const size_t MAX_BLOCK_SAMPLES = 65535;
+
+DeviceState::DeviceState(const std::string& id, uint16_t feedIndex, size_t maxSamples)
+  : id(id), feedIndex(feedIndex), storedOffset(0), bytesReceived(0),
+    malformedRecords(0), index(maxSamples), archiver(&archive), archiveOpenedMs(0) {
+}
+
+DeviceState::~DeviceState() {
+  archiver.finish();
+  archive.close();
+}
+
+DeviceRegistry::DeviceRegistry(size_t maxSamplesPerDevice, const std::string& archiveDir,
+                               int archiveHours) {
+  this->maxSamplesPerDevice = maxSamplesPerDevice;
+  this->archiveDir = archiveDir;
+  this->archiveHours = archiveHours;
+}
+
+static int64_t getCurrentMs() {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void DeviceRegistry::rotateArchive(DeviceState* device) {
+  int64_t nowMs = getCurrentMs();
+  if (device->archive.isOpen() && nowMs - device->archiveOpenedMs < (int64_t)archiveHours * 3600000) {
+    return;
+  }
+  
+  device->archiver.finish();
+  device->archive.close();
+  
+  // <dir>/<device id with ':' removed>-<UTC start>.eca
+  char name[64];
+  size_t length = 0;
+  for (size_t i = 0; i < device->id.size() && length < 40; i++) {
+    char c = device->id[i];
+    if (isalnum((unsigned char)c) || c == '-' || c == '_') name[length++] = c;
+  }
+  time_t seconds = nowMs / 1000;
+  strftime(name + length, sizeof(name) - length, "-%Y%m%dT%H%M%SZ.eca", gmtime(&seconds));
+  
+  std::string path = archiveDir + "/" + name;
+  device->archiveOpenedMs = nowMs;
+  device->archive.open(path.c_str(), 1, device->id.c_str());
+}
+
+DeviceState* DeviceRegistry::getDevice(const std::string& id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  
+  std::unique_ptr<DeviceState>& device = devices[id];
+  if (!device) {
+    device.reset(new DeviceState(id, (uint16_t)(devices.size() - 1), maxSamplesPerDevice));
+  }
+  return device.get();
+}
+
+static void appendLE(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out.push_back((uint8_t)(value >> (8 * i)));
+  }
+}
+
+IngestResult DeviceRegistry::ingest(const std::string& id, uint64_t streamOffset,
+                                    const uint8_t* batch, size_t length) {
+  DeviceState* device = getDevice(id);
+  std::lock_guard<std::mutex> lock(device->mutex);
+  
+  IngestResult result;
+  result.newRecords = 0;
+  device->bytesReceived += length;
+  
+  // Offsets ahead of ours mean the device dropped data it could not buffer
+  if (streamOffset > device->storedOffset) {
+    device->storedOffset = streamOffset;
+  }
+  
+  // Skip the retransmitted part; stored offsets always fall on frame boundaries
+  uint64_t skip = device->storedOffset - streamOffset;
+  if (skip >= length) {
+    result.ackOffset = device->storedOffset;
+    return result;
+  }
+  
+  const uint8_t* data = batch + skip;
+  size_t remaining = length - (size_t)skip;
+  uint64_t newOffset = device->storedOffset;
+  
+  static thread_local std::vector<int16_t> samples(MAX_BLOCK_SAMPLES);
+  size_t feedStart = 0;
+  
+  bool archiving = !archiveDir.empty();
+  if (archiving) rotateArchive(device);
+  
+  result.feedMessage.push_back(FEED_MESSAGE_VERSION);
+  appendLE(result.feedMessage, device->feedIndex, 2);
+  result.feedMessage.push_back((uint8_t)id.size());
+  result.feedMessage.insert(result.feedMessage.end(), id.begin(), id.end());
+  appendLE(result.feedMessage, newOffset, 8);
+  feedStart = result.feedMessage.size();
+  
+  while (remaining > 0) {
+    const uint8_t* record;
+    size_t recordLength;
+    size_t used = readRecordFrame(data, remaining, record, recordLength);
+    if (used == 0) {
+      // Truncated batch - acknowledge what was complete
+      device->malformedRecords++;
+      break;
+    }
+    
+    uint8_t type = getRecordType(record, recordLength);
+    if (type == RECORD_SAMPLE_BLOCK) {
+      SampleBlockHeader header;
+      if (decodeSampleBlock(record, recordLength, header, samples.data(), samples.size())) {
+        device->index.addBlock(header, samples.data());
+        if (archiving) device->archiver.addBlock(header, samples.data());
+      } else {
+        device->malformedRecords++;
+      }
+    } else if (type == RECORD_EVENT) {
+      ECGEvent event;
+      if (decodeEvent(record, recordLength, event)) {
+        device->index.addEvent(event);
+        if (archiving) device->archiver.addEvent(event);
+      } else {
+        device->malformedRecords++;
+      }
+    } else {
+      device->malformedRecords++;  // Unknown type, kept in the stream
+    }
+    
+    result.feedMessage.insert(result.feedMessage.end(), data, data + used);
+    data += used;
+    remaining -= used;
+    newOffset += used;
+    result.newRecords++;
+  }
+  
+  device->storedOffset = newOffset;
+  result.ackOffset = newOffset;
+  
+  if (result.feedMessage.size() == feedStart) {
+    result.feedMessage.clear();
+  }
+  return result;
+}
+
+std::vector<DeviceSummary> DeviceRegistry::listDevices() {
+  std::vector<DeviceState*> states;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : devices) {
+      states.push_back(entry.second.get());
+    }
+  }
+  
+  std::vector<DeviceSummary> summaries;
+  for (DeviceState* device : states) {
+    std::lock_guard<std::mutex> lock(device->mutex);
+    DeviceSummary summary;
+    summary.id = device->id;
+    summary.feedIndex = device->feedIndex;
+    summary.storedOffset = device->storedOffset;
+    summary.samples = device->index.getSampleCount();
+    summary.firstMs = device->index.getFirstMs();
+    summary.lastMs = device->index.getLastMs();
+    summary.lastSequence = device->index.getLastSequence();
+    summary.heartRate = device->index.getLastHeartRate();
+    summary.leadsOff = device->index.isLeadsOff();
+    summaries.push_back(summary);
+  }
+  return summaries;
+}
+
+bool DeviceRegistry::query(const std::string& id, int64_t fromMs, int64_t toMs,
+                           SeriesRange& range, std::vector<ECGEvent>& events) {
+  DeviceState* device;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = devices.find(id);
+    if (it == devices.end()) return false;
+    device = it->second.get();
+  }
+  
+  std::lock_guard<std::mutex> lock(device->mutex);
+  if (!device->index.query(fromMs, toMs, range)) return false;
+  
+  device->index.queryEvents(range.firstSequence,
+                            range.firstSequence + (uint32_t)range.samples.size(), events);
+  return true;
+}
@@ -0,0 +1,100 @@
+/*
+ * Device Registry Class Header
+ * 
+ * Collector side of the uplink protocol for many devices. Each device has
+ * a stream offset (bytes stored so far) and a time series index. ingest()
+ * takes one upload batch, skips what was already stored, decodes the new
+ * records with the shared codec and returns the acknowledgement offset
+ * together with the new records for the live feed.
+ * 
+ * Devices are independent, so batches from different devices are ingested
+ * in parallel; each device has its own lock.
+ * 
+ * With an archive directory set, every device's records are also written
+ * to a columnar archive (tools/archive), one file per device per
+ * rotation period.
+ */
+
+#ifndef DEVICE_REGISTRY_H
+#define DEVICE_REGISTRY_H
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "time_series_index.h"
+#include "../archive/record_archiver.h"
+
+struct DeviceState {
+  std::mutex mutex;
+  std::string id;
+  uint16_t feedIndex;             // Short id used in feed messages
+  uint64_t storedOffset;          // Stream bytes stored through
+  uint64_t bytesReceived;
+  uint64_t malformedRecords;
+  TimeSeriesIndex index;
+  
+  // Long-term storage (when enabled)
+  ArchiveWriter archive;
+  RecordArchiver archiver;
+  int64_t archiveOpenedMs;
+  
+  DeviceState(const std::string& id, uint16_t feedIndex, size_t maxSamples);
+  ~DeviceState();
+};
+
+struct DeviceSummary {
+  std::string id;
+  uint16_t feedIndex;
+  uint64_t storedOffset;
+  size_t samples;
+  int64_t firstMs;
+  int64_t lastMs;
+  uint32_t lastSequence;
+  int heartRate;
+  bool leadsOff;
+};
+
+struct IngestResult {
+  uint64_t ackOffset;
+  size_t newRecords;
+  std::vector<uint8_t> feedMessage;   // Empty when nothing new arrived
+};
+
+class DeviceRegistry {
+private:
+  std::mutex mutex;                   // Guards the map only
+  std::map<std::string, std::unique_ptr<DeviceState>> devices;
+  size_t maxSamplesPerDevice;
+  std::string archiveDir;
+  int archiveHours;
+  
+  void rotateArchive(DeviceState* device);
+  
+public:
+  // Constructor (history per device, in samples; archiving off if archiveDir is empty)
+  DeviceRegistry(size_t maxSamplesPerDevice, const std::string& archiveDir = "",
+                 int archiveHours = 24);
+  
+  // Find or create a device
+  DeviceState* getDevice(const std::string& id);
+  
+  // Store one upload batch (framed records starting at streamOffset)
+  IngestResult ingest(const std::string& id, uint64_t streamOffset,
+                      const uint8_t* batch, size_t length);
+  
+  // Snapshot of every device
+  std::vector<DeviceSummary> listDevices();
+  
+  // Range query on one device; false if unknown or empty
+  bool query(const std::string& id, int64_t fromMs, int64_t toMs, SeriesRange& range,
+             std::vector<ECGEvent>& events);
+};
+
+// Feed message layout (WebSocket binary message, little-endian):
+//   [u8 version=1][u16 feedIndex][u8 idLength][id][u64 streamOffset][framed records]
+const uint8_t FEED_MESSAGE_VERSION = 1;
+
+#endif // DEVICE_REGISTRY_H
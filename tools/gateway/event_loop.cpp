@@ -0,0 +1,118 @@
+/*
+ * Event Loop Class Implementation
+ */
+
+#include "event_loop.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <stdio.h>
+
+static const int MAX_EVENTS = 256;
+
+EventLoop::EventLoop() {
+  epollFd = -1;
+  wakeFd = -1;
+  running = false;
+}
+
+EventLoop::~EventLoop() {
+  for (size_t i = 0; i < handlers.size(); i++) {
+    delete handlers[i];
+  }
+  if (wakeFd >= 0) close(wakeFd);
+  if (epollFd >= 0) close(epollFd);
+}
+
+bool EventLoop::begin() {
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epollFd < 0 || wakeFd < 0) {
+    perror("ERROR: event loop setup failed");
+    return false;
+  }
+  
+  return watch(wakeFd, EPOLLIN, [this](uint32_t) {
+    uint64_t count;
+    while (read(wakeFd, &count, sizeof(count)) == sizeof(count)) {}
+    runPosted();
+  });
+}
+
+bool EventLoop::watch(int fd, uint32_t events, Handler handler) {
+  if (fd >= (int)handlers.size()) {
+    handlers.resize(fd + 1, NULL);
+  }
+  delete handlers[fd];
+  handlers[fd] = new Handler(handler);
+  
+  epoll_event event = {};
+  event.events = events;
+  event.data.fd = fd;
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+    perror("ERROR: epoll_ctl add");
+    delete handlers[fd];
+    handlers[fd] = NULL;
+    return false;
+  }
+  return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events) {
+  epoll_event event = {};
+  event.events = events;
+  event.data.fd = fd;
+  return epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void EventLoop::remove(int fd) {
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+  if (fd < (int)handlers.size()) {
+    // The handler may be the caller; free it once the current batch is done
+    Handler* handler = handlers[fd];
+    handlers[fd] = NULL;
+    post([handler]() { delete handler; });
+  }
+}
+
+void EventLoop::post(std::function<void()> callback) {
+  {
+    std::lock_guard<std::mutex> lock(postedMutex);
+    posted.push_back(std::move(callback));
+  }
+  uint64_t one = 1;
+  ssize_t written = write(wakeFd, &one, sizeof(one));
+  (void)written;  // Counter already non-zero is fine
+}
+
+void EventLoop::runPosted() {
+  std::vector<std::function<void()>> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(postedMutex);
+    callbacks.swap(posted);
+  }
+  for (size_t i = 0; i < callbacks.size(); i++) {
+    callbacks[i]();
+  }
+}
+
+void EventLoop::run() {
+  epoll_event events[MAX_EVENTS];
+  running = true;
+  
+  while (running) {
+    int count = epoll_wait(epollFd, events, MAX_EVENTS, 1000);
+    
+    for (int i = 0; i < count; i++) {
+      int fd = events[i].data.fd;
+      // Skip fds closed by an earlier event in this batch
+      if (fd < (int)handlers.size() && handlers[fd] != NULL) {
+        (*handlers[fd])(events[i].events);
+      }
+    }
+  }
+}
+
+void EventLoop::stop() {
+  post([this]() { running = false; });
+}
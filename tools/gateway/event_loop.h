@@ -0,0 +1,53 @@
+/*
+ * Event Loop Class Header
+ * 
+ * Single-threaded epoll loop for the gateway's sockets. Other threads hand
+ * work back to the loop with post(); an eventfd wakes epoll_wait so the
+ * posted callbacks run promptly on the loop thread.
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdint.h>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class EventLoop {
+public:
+  // Called with the epoll event mask when a watched fd is ready
+  typedef std::function<void(uint32_t events)> Handler;
+  
+private:
+  int epollFd;
+  int wakeFd;
+  bool running;
+  std::vector<Handler*> handlers;     // Indexed by fd
+  std::mutex postedMutex;
+  std::vector<std::function<void()>> posted;
+  
+  void runPosted();
+  
+public:
+  // Constructor
+  EventLoop();
+  ~EventLoop();
+  
+  // Create the epoll instance and the wakeup eventfd
+  bool begin();
+  
+  // Register, update and remove a file descriptor
+  bool watch(int fd, uint32_t events, Handler handler);
+  bool modify(int fd, uint32_t events);
+  void remove(int fd);
+  
+  // Run a callback on the loop thread (thread safe)
+  void post(std::function<void()> callback);
+  
+  // Dispatch events until stop() is called
+  void run();
+  void stop();
+};
+
+#endif // EVENT_LOOP_H
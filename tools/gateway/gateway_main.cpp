@@ -0,0 +1,72 @@
+/*
+ * ECG Ward Gateway
+ * 
+ * Usage: ecg_gateway [--port N] [--workers N] [--history-seconds N] [--cpu N]
+ *                    [--archive-dir DIR] [--archive-hours N]
+ * 
+ * Point each monitor's collector URL (POST /config "collectorUrl") at
+ * http://<gateway>:<port>/ingest.
+ */
+
+#include "gateway_server.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static GatewayServer* activeServer = NULL;
+
+static void handleSignal(int) {
+  if (activeServer) activeServer->stop();
+}
+
+static void printUsage() {
+  printf("Usage: ecg_gateway [--port N] [--workers N] [--history-seconds N] [--cpu N]\n"
+         "                   [--archive-dir DIR] [--archive-hours N]\n");
+}
+
+int main(int argc, char** argv) {
+  GatewayOptions options;
+  int historySeconds = 600;
+  
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--port") == 0 && hasValue) {
+      options.port = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--workers") == 0 && hasValue) {
+      options.workerThreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--history-seconds") == 0 && hasValue) {
+      historySeconds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--cpu") == 0 && hasValue) {
+      options.cpu = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--archive-dir") == 0 && hasValue) {
+      options.archiveDir = argv[++i];
+    } else if (strcmp(argv[i], "--archive-hours") == 0 && hasValue) {
+      options.archiveHours = atoi(argv[++i]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  
+  // Sized for the highest selectable sample rate
+  options.historySamples = (size_t)historySeconds * 1000;
+  if (options.workerThreads < 1) options.workerThreads = 1;
+  if (options.archiveHours < 1) options.archiveHours = 1;
+  
+  GatewayServer server(options);
+  if (!server.begin()) return 1;
+  
+  activeServer = &server;
+  signal(SIGINT, handleSignal);
+  signal(SIGTERM, handleSignal);
+  signal(SIGPIPE, SIG_IGN);
+  
+  server.run();
+  
+  GatewayStats& stats = server.getStats();
+  printf("Stopped: %llu batches, %llu records, %llu bytes\n",
+         (unsigned long long)stats.batches, (unsigned long long)stats.records,
+         (unsigned long long)stats.bytesIngested);
+  return 0;
+}
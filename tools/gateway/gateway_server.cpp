@@ -0,0 +1,413 @@
+/*
+ * Gateway Server Class Implementation
+ */
+
+#include "gateway_server.h"
+#include "websocket.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const size_t READ_CHUNK = 16384;
+
+GatewayOptions::GatewayOptions() {
+  port = 8080;
+  workerThreads = 4;
+  historySamples = 10 * 60 * 500;   // 10 minutes at 500 Hz
+  maxBodySize = 65536;
+  maxSubscriberBacklog = 4 * 1024 * 1024;
+  cpu = -1;
+  archiveHours = 24;
+}
+
+GatewayStats::GatewayStats()
+  : batches(0), records(0), bytesIngested(0), feedMessages(0),
+    feedMessagesDropped(0), connectionsAccepted(0) {
+}
+
+GatewayServer::GatewayServer(const GatewayOptions& options)
+  : options(options), registry(options.historySamples, options.archiveDir, options.archiveHours) {
+  listenFd = -1;
+  nextConnectionId = 1;
+}
+
+GatewayServer::~GatewayServer() {
+  workers.stop();
+  for (auto& entry : connections) {
+    close(entry.second->fd);
+    delete entry.second;
+  }
+  if (listenFd >= 0) close(listenFd);
+}
+
+static void setNonBlocking(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+bool GatewayServer::begin() {
+  if (!loop.begin()) return false;
+  
+  listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  int enable = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(options.port);
+  
+  if (bind(listenFd, (sockaddr*)&address, sizeof(address)) < 0 || listen(listenFd, 512) < 0) {
+    perror("ERROR: cannot listen");
+    return false;
+  }
+  setNonBlocking(listenFd);
+  
+  loop.watch(listenFd, EPOLLIN, [this](uint32_t) { acceptConnections(); });
+  workers.begin(options.workerThreads, options.cpu);
+  
+  printf("Gateway listening on port %d with %d workers\n", options.port, options.workerThreads);
+  return true;
+}
+
+void GatewayServer::run() {
+  if (options.cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(options.cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+  loop.run();
+}
+
+void GatewayServer::stop() {
+  loop.stop();
+}
+
+// ========== SOCKETS ==========
+
+void GatewayServer::acceptConnections() {
+  while (true) {
+    int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) return;  // EAGAIN, or a transient error
+    
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    
+    Connection* connection = new Connection();
+    connection->id = nextConnectionId++;
+    connection->fd = fd;
+    connection->websocket = false;
+    connection->busy = false;
+    connection->closeAfterWrite = false;
+    connections[connection->id] = connection;
+    stats.connectionsAccepted++;
+    
+    uint64_t id = connection->id;
+    loop.watch(fd, EPOLLIN | EPOLLRDHUP, [this, id](uint32_t events) { handleEvents(id, events); });
+  }
+}
+
+void GatewayServer::handleEvents(uint64_t id, uint32_t events) {
+  auto it = connections.find(id);
+  if (it == connections.end()) return;
+  Connection* connection = it->second;
+  
+  if (events & (EPOLLERR | EPOLLHUP)) {
+    closeConnection(connection);
+    return;
+  }
+  
+  if (events & EPOLLOUT) {
+    flush(connection);
+    if (connections.find(id) == connections.end()) return;
+  }
+  
+  if (events & (EPOLLIN | EPOLLRDHUP)) {
+    if (!readInput(connection)) {
+      closeConnection(connection);
+      return;
+    }
+    processInput(connection);
+  }
+}
+
+bool GatewayServer::readInput(Connection* connection) {
+  char buffer[READ_CHUNK];
+  
+  while (true) {
+    ssize_t count = recv(connection->fd, buffer, sizeof(buffer), 0);
+    if (count > 0) {
+      connection->input.append(buffer, count);
+      continue;
+    }
+    if (count == 0) return false;  // Peer closed
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+  }
+}
+
+void GatewayServer::processInput(Connection* connection) {
+  uint64_t id = connection->id;
+  
+  while (!connection->busy && !connection->input.empty()) {
+    size_t consumed = 0;
+    
+    if (connection->websocket) {
+      uint8_t opcode;
+      std::string payload;
+      ParseStatus status = parseWebSocketFrame(connection->input, opcode, payload, consumed);
+      if (status == PARSE_INCOMPLETE) return;
+      if (status == PARSE_ERROR || opcode == WS_CLOSE) {
+        closeConnection(connection);
+        return;
+      }
+      connection->input.erase(0, consumed);
+      
+      if (opcode == WS_PING) {
+        std::string pong;
+        encodeWebSocketFrame(WS_PONG, (const uint8_t*)payload.data(), payload.size(), pong);
+        send(connection, pong);
+      }
+      // Other client messages are ignored; the feed is one-way
+    } else {
+      HttpRequest request;
+      ParseStatus status = parseHttpRequest(connection->input, options.maxBodySize, request, consumed);
+      if (status == PARSE_INCOMPLETE) return;
+      if (status == PARSE_ERROR) {
+        send(connection, buildHttpResponse(400, "text/plain", "Malformed request\n", false));
+        connection->closeAfterWrite = true;
+        connection->input.clear();
+        flush(connection);
+        return;
+      }
+      connection->input.erase(0, consumed);
+      handleRequest(connection, request);
+    }
+    
+    // The handler may have closed the connection
+    if (connections.find(id) == connections.end()) return;
+  }
+}
+
+void GatewayServer::send(Connection* connection, const std::string& data) {
+  connection->output += data;
+  flush(connection);
+}
+
+void GatewayServer::flush(Connection* connection) {
+  while (!connection->output.empty()) {
+    ssize_t count = ::send(connection->fd, connection->output.data(), connection->output.size(),
+                           MSG_NOSIGNAL);
+    if (count < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      closeConnection(connection);
+      return;
+    }
+    connection->output.erase(0, count);
+  }
+  
+  if (connection->output.empty() && connection->closeAfterWrite) {
+    closeConnection(connection);
+    return;
+  }
+  
+  // Ask for EPOLLOUT only while there is a backlog
+  uint32_t events = EPOLLIN | EPOLLRDHUP;
+  if (!connection->output.empty()) events |= EPOLLOUT;
+  loop.modify(connection->fd, events);
+}
+
+void GatewayServer::closeConnection(Connection* connection) {
+  loop.remove(connection->fd);
+  close(connection->fd);
+  connections.erase(connection->id);
+  delete connection;
+}
+
+void GatewayServer::broadcast(const std::string& deviceId, const std::vector<uint8_t>& message) {
+  std::string frame;
+  encodeWebSocketFrame(WS_BINARY, message.data(), message.size(), frame);
+  
+  std::vector<Connection*> subscribers;
+  for (auto& entry : connections) {
+    Connection* connection = entry.second;
+    if (!connection->websocket) continue;
+    if (!connection->feedDevice.empty() && connection->feedDevice != deviceId) continue;
+    subscribers.push_back(connection);
+  }
+  
+  for (Connection* connection : subscribers) {
+    // A stalled dashboard loses messages rather than stalling the ward
+    if (connection->output.size() + frame.size() > options.maxSubscriberBacklog) {
+      stats.feedMessagesDropped++;
+      continue;
+    }
+    stats.feedMessages++;
+    send(connection, frame);
+  }
+}
+
+// ========== REQUESTS ==========
+
+void GatewayServer::handleRequest(Connection* connection, HttpRequest& request) {
+  bool keepAlive = request.wantsKeepAlive();
+  
+  if (request.method == "POST" && request.path == "/ingest") {
+    handleIngest(connection, request);
+  } else if (request.method == "GET" && request.path == "/feed" && isWebSocketUpgrade(request)) {
+    connection->websocket = true;
+    connection->feedDevice = getQueryParameter(request.query, "device");
+    send(connection, buildWebSocketHandshake(request));
+  } else if (request.method == "GET" && request.path == "/devices") {
+    send(connection, buildHttpResponse(200, "application/json", buildDeviceList(), keepAlive));
+  } else if (request.method == "GET" && request.path == "/series") {
+    handleSeries(connection, request);
+  } else if (request.method == "GET" && request.path == "/stats") {
+    send(connection, buildHttpResponse(200, "application/json", buildStats(), keepAlive));
+  } else {
+    send(connection, buildHttpResponse(404, "text/plain", "Not found\n", keepAlive));
+  }
+  
+  if (!keepAlive && !connection->busy && !connection->websocket) {
+    connection->closeAfterWrite = true;
+    flush(connection);
+  }
+}
+
+void GatewayServer::handleIngest(Connection* connection, HttpRequest& request) {
+  std::string deviceId = request.getHeader("x-device-id");
+  std::string offsetText = request.getHeader("x-stream-offset");
+  bool keepAlive = request.wantsKeepAlive();
+  
+  if (deviceId.empty() || deviceId.size() > 255 || offsetText.empty()) {
+    send(connection, buildHttpResponse(400, "text/plain", "X-Device-Id and X-Stream-Offset required\n",
+                                       keepAlive));
+    return;
+  }
+  
+  uint64_t offset = strtoull(offsetText.c_str(), NULL, 10);
+  uint64_t id = connection->id;
+  connection->busy = true;
+  
+  // Decode and index on a worker; reply and fan out on the loop
+  std::string body;
+  body.swap(request.body);
+  workers.submit([this, id, deviceId, offset, body, keepAlive]() {
+    IngestResult result = registry.ingest(deviceId, offset, (const uint8_t*)body.data(), body.size());
+    
+    stats.batches++;
+    stats.records += result.newRecords;
+    stats.bytesIngested += body.size();
+    
+    char reply[48];
+    snprintf(reply, sizeof(reply), "{\"ackOffset\":%llu}", (unsigned long long)result.ackOffset);
+    std::string response = buildHttpResponse(200, "application/json", reply, keepAlive);
+    
+    loop.post([this, id, deviceId, response, keepAlive, result]() {
+      if (!result.feedMessage.empty()) {
+        broadcast(deviceId, result.feedMessage);
+      }
+      respond(id, response, keepAlive);
+    });
+  });
+}
+
+void GatewayServer::handleSeries(Connection* connection, HttpRequest& request) {
+  std::string deviceId = getQueryParameter(request.query, "device");
+  int64_t fromMs = strtoll(getQueryParameter(request.query, "fromMs").c_str(), NULL, 10);
+  int64_t toMs = strtoll(getQueryParameter(request.query, "toMs").c_str(), NULL, 10);
+  bool keepAlive = request.wantsKeepAlive();
+  uint64_t id = connection->id;
+  connection->busy = true;
+  
+  workers.submit([this, id, deviceId, fromMs, toMs, keepAlive]() {
+    SeriesRange range;
+    std::vector<ECGEvent> events;
+    std::string response;
+    
+    if (!registry.query(deviceId, fromMs, toMs, range, events)) {
+      response = buildHttpResponse(404, "text/plain", "No samples in range\n", keepAlive);
+    } else {
+      std::string body;
+      char field[96];
+      snprintf(field, sizeof(field), "{\"sampleRate\":%u,\"firstSequence\":%u,\"firstMs\":%lld,\"samples\":[",
+               range.sampleRate, range.firstSequence, (long long)range.firstMs);
+      body += field;
+      for (size_t i = 0; i < range.samples.size(); i++) {
+        snprintf(field, sizeof(field), i == 0 ? "%d" : ",%d", range.samples[i]);
+        body += field;
+      }
+      body += "],\"events\":[";
+      for (size_t i = 0; i < events.size(); i++) {
+        snprintf(field, sizeof(field), "%s{\"sequence\":%u,\"type\":%u,\"value\":%d}",
+                 i == 0 ? "" : ",", events[i].sequence, events[i].type, events[i].value);
+        body += field;
+      }
+      body += "]}";
+      response = buildHttpResponse(200, "application/json", body, keepAlive);
+    }
+    
+    loop.post([this, id, response, keepAlive]() { respond(id, response, keepAlive); });
+  });
+}
+
+void GatewayServer::respond(uint64_t id, const std::string& response, bool keepAlive) {
+  auto it = connections.find(id);
+  if (it == connections.end()) return;  // Client went away meanwhile
+  
+  Connection* connection = it->second;
+  connection->busy = false;
+  if (!keepAlive) connection->closeAfterWrite = true;
+  send(connection, response);
+  
+  // Continue with pipelined requests
+  if (connections.find(id) != connections.end()) {
+    processInput(connection);
+  }
+}
+
+std::string GatewayServer::buildDeviceList() {
+  std::vector<DeviceSummary> devices = registry.listDevices();
+  std::string body = "[";
+  char entry[512];
+  
+  for (size_t i = 0; i < devices.size(); i++) {
+    const DeviceSummary& device = devices[i];
+    snprintf(entry, sizeof(entry),
+             "%s{\"id\":\"%s\",\"feedIndex\":%u,\"storedOffset\":%llu,\"samples\":%zu,"
+             "\"firstMs\":%lld,\"lastMs\":%lld,\"lastSequence\":%u,\"heartRate\":%d,\"leadsOff\":%s}",
+             i == 0 ? "" : ",", device.id.c_str(), device.feedIndex,
+             (unsigned long long)device.storedOffset, device.samples, (long long)device.firstMs,
+             (long long)device.lastMs, device.lastSequence, device.heartRate,
+             device.leadsOff ? "true" : "false");
+    body += entry;
+  }
+  
+  return body + "]";
+}
+
+std::string GatewayServer::buildStats() {
+  size_t subscribers = 0;
+  for (auto& entry : connections) {
+    if (entry.second->websocket) subscribers++;
+  }
+  
+  char body[384];
+  snprintf(body, sizeof(body),
+           "{\"batches\":%llu,\"records\":%llu,\"bytesIngested\":%llu,\"feedMessages\":%llu,"
+           "\"feedMessagesDropped\":%llu,\"connections\":%zu,\"subscribers\":%zu,\"workers\":%d}",
+           (unsigned long long)stats.batches, (unsigned long long)stats.records,
+           (unsigned long long)stats.bytesIngested, (unsigned long long)stats.feedMessages,
+           (unsigned long long)stats.feedMessagesDropped, connections.size(), subscribers,
+           workers.getThreadCount());
+  return body;
+}
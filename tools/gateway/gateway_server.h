@@ -0,0 +1,107 @@
+/*
+ * Gateway Server Class Header
+ * 
+ * Ward gateway for many ECG monitors. Devices point their collector URL
+ * at POST /ingest and upload exactly as they would to any collector (see
+ * Uplink). Browsers open one WebSocket on /feed and receive every bed's
+ * new records multiplexed in binary feed messages, and query history
+ * from the per-device index over /devices and /series.
+ * 
+ * Threading: the event loop owns all sockets and connection state;
+ * decoding, indexing and queries run on the worker pool and post their
+ * results back to the loop.
+ */
+
+#ifndef GATEWAY_SERVER_H
+#define GATEWAY_SERVER_H
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "event_loop.h"
+#include "worker_pool.h"
+#include "device_registry.h"
+#include "http_message.h"
+
+struct GatewayOptions {
+  int port;
+  int workerThreads;
+  size_t historySamples;          // Per device
+  size_t maxBodySize;             // Largest accepted upload
+  size_t maxSubscriberBacklog;    // Bytes queued per feed client before dropping
+  int cpu;                        // Pin all gateway threads to this CPU (-1 = no)
+  std::string archiveDir;         // Per-device archives (empty = no archiving)
+  int archiveHours;               // Start a new archive file after this long
+  
+  GatewayOptions();
+};
+
+struct GatewayStats {
+  std::atomic<uint64_t> batches;
+  std::atomic<uint64_t> records;
+  std::atomic<uint64_t> bytesIngested;
+  std::atomic<uint64_t> feedMessages;
+  std::atomic<uint64_t> feedMessagesDropped;
+  std::atomic<uint64_t> connectionsAccepted;
+  
+  GatewayStats();
+};
+
+class GatewayServer {
+private:
+  struct Connection {
+    uint64_t id;
+    int fd;
+    std::string input;
+    std::string output;
+    bool websocket;
+    std::string feedDevice;       // Feed filter (empty = all devices)
+    bool busy;                    // Request being handled by a worker
+    bool closeAfterWrite;
+  };
+  
+  GatewayOptions options;
+  EventLoop loop;
+  WorkerPool workers;
+  DeviceRegistry registry;
+  GatewayStats stats;
+  int listenFd;
+  uint64_t nextConnectionId;
+  std::unordered_map<uint64_t, Connection*> connections;
+  
+  // Socket handling (loop thread)
+  void acceptConnections();
+  void handleEvents(uint64_t id, uint32_t events);
+  bool readInput(Connection* connection);
+  void processInput(Connection* connection);
+  void send(Connection* connection, const std::string& data);
+  void flush(Connection* connection);
+  void closeConnection(Connection* connection);
+  void broadcast(const std::string& deviceId, const std::vector<uint8_t>& message);
+  
+  // Requests
+  void handleRequest(Connection* connection, HttpRequest& request);
+  void handleIngest(Connection* connection, HttpRequest& request);
+  void handleSeries(Connection* connection, HttpRequest& request);
+  std::string buildDeviceList();
+  std::string buildStats();
+  void respond(uint64_t id, const std::string& response, bool keepAlive);
+  
+public:
+  // Constructor
+  GatewayServer(const GatewayOptions& options);
+  ~GatewayServer();
+  
+  // Open the listening socket and start the workers
+  bool begin();
+  
+  // Serve until stop() (run on the thread that should own the sockets)
+  void run();
+  void stop();
+  
+  GatewayStats& getStats() { return stats; }
+  DeviceRegistry& getRegistry() { return registry; }
+};
+
+#endif // GATEWAY_SERVER_H
@@ -0,0 +1,124 @@
+/*
+ * HTTP Message Helpers Implementation
+ */
+
+#include "http_message.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+
+static const size_t MAX_HEADER_SIZE = 8192;
+
+static std::string toLower(const std::string& text) {
+  std::string lower = text;
+  for (size_t i = 0; i < lower.size(); i++) {
+    if (lower[i] >= 'A' && lower[i] <= 'Z') lower[i] += 'a' - 'A';
+  }
+  return lower;
+}
+
+static std::string trim(const std::string& text) {
+  size_t start = text.find_first_not_of(" \t");
+  size_t end = text.find_last_not_of(" \t\r");
+  if (start == std::string::npos) return "";
+  return text.substr(start, end - start + 1);
+}
+
+std::string HttpRequest::getHeader(const char* name) const {
+  std::map<std::string, std::string>::const_iterator it = headers.find(name);
+  return it == headers.end() ? "" : it->second;
+}
+
+bool HttpRequest::wantsKeepAlive() const {
+  return strcasecmp(getHeader("connection").c_str(), "close") != 0;
+}
+
+ParseStatus parseHttpRequest(const std::string& buffer, size_t maxBodySize,
+                             HttpRequest& request, size_t& consumed) {
+  size_t headerEnd = buffer.find("\r\n\r\n");
+  if (headerEnd == std::string::npos) {
+    return buffer.size() > MAX_HEADER_SIZE ? PARSE_ERROR : PARSE_INCOMPLETE;
+  }
+  
+  // Request line
+  size_t lineEnd = buffer.find("\r\n");
+  std::string line = buffer.substr(0, lineEnd);
+  size_t methodEnd = line.find(' ');
+  size_t targetEnd = line.find(' ', methodEnd + 1);
+  if (methodEnd == std::string::npos || targetEnd == std::string::npos) return PARSE_ERROR;
+  
+  request.method = line.substr(0, methodEnd);
+  std::string target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+  size_t queryStart = target.find('?');
+  request.path = target.substr(0, queryStart);
+  request.query = queryStart == std::string::npos ? "" : target.substr(queryStart + 1);
+  
+  // Headers
+  request.headers.clear();
+  size_t position = lineEnd + 2;
+  while (position < headerEnd) {
+    size_t end = buffer.find("\r\n", position);
+    std::string header = buffer.substr(position, end - position);
+    size_t colon = header.find(':');
+    if (colon == std::string::npos) return PARSE_ERROR;
+    request.headers[toLower(trim(header.substr(0, colon)))] = trim(header.substr(colon + 1));
+    position = end + 2;
+  }
+  
+  // Body
+  size_t bodyLength = 0;
+  std::string contentLength = request.getHeader("content-length");
+  if (!contentLength.empty()) {
+    char* end;
+    bodyLength = strtoul(contentLength.c_str(), &end, 10);
+    if (*end != '\0' || bodyLength > maxBodySize) return PARSE_ERROR;
+  }
+  
+  size_t bodyStart = headerEnd + 4;
+  if (buffer.size() < bodyStart + bodyLength) return PARSE_INCOMPLETE;
+  
+  request.body.assign(buffer, bodyStart, bodyLength);
+  consumed = bodyStart + bodyLength;
+  return PARSE_COMPLETE;
+}
+
+static const char* getReason(int code) {
+  switch (code) {
+    case 101: return "Switching Protocols";
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 413: return "Payload Too Large";
+    case 503: return "Service Unavailable";
+    default: return "Error";
+  }
+}
+
+std::string buildHttpResponse(int code, const char* contentType, const std::string& body,
+                              bool keepAlive) {
+  char header[256];
+  snprintf(header, sizeof(header),
+           "HTTP/1.1 %d %s\r\n"
+           "Content-Type: %s\r\n"
+           "Content-Length: %zu\r\n"
+           "Access-Control-Allow-Origin: *\r\n"
+           "Connection: %s\r\n\r\n",
+           code, getReason(code), contentType, body.size(), keepAlive ? "keep-alive" : "close");
+  return header + body;
+}
+
+std::string getQueryParameter(const std::string& query, const char* name) {
+  std::string key = std::string(name) + "=";
+  size_t position = 0;
+  
+  while (position < query.size()) {
+    size_t end = query.find('&', position);
+    if (end == std::string::npos) end = query.size();
+    
+    if (query.compare(position, key.size(), key) == 0) {
+      return query.substr(position + key.size(), end - position - key.size());
+    }
+    position = end + 1;
+  }
+  return "";
+}
@@ -0,0 +1,45 @@
+/*
+ * HTTP Message Helpers Header
+ * 
+ * Minimal HTTP/1.1 request parsing and response formatting for the
+ * gateway: Content-Length bodies only (the device uplink and browsers
+ * never send chunked requests), keep-alive and WebSocket upgrades.
+ */
+
+#ifndef HTTP_MESSAGE_H
+#define HTTP_MESSAGE_H
+
+#include <stddef.h>
+#include <map>
+#include <string>
+
+enum ParseStatus {
+  PARSE_INCOMPLETE,
+  PARSE_COMPLETE,
+  PARSE_ERROR
+};
+
+struct HttpRequest {
+  std::string method;
+  std::string path;
+  std::string query;                            // Without the '?'
+  std::map<std::string, std::string> headers;   // Lower-case names
+  std::string body;
+  
+  // Header value or an empty string
+  std::string getHeader(const char* name) const;
+  bool wantsKeepAlive() const;
+};
+
+// Parse one request from the front of buffer; consumed is set when complete
+ParseStatus parseHttpRequest(const std::string& buffer, size_t maxBodySize,
+                             HttpRequest& request, size_t& consumed);
+
+// Format a complete response
+std::string buildHttpResponse(int code, const char* contentType, const std::string& body,
+                              bool keepAlive);
+
+// Value of name=value in a query string (not URL-decoded; ids and numbers only)
+std::string getQueryParameter(const std::string& query, const char* name);
+
+#endif // HTTP_MESSAGE_H
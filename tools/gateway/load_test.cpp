@@ -0,0 +1,280 @@
+/*
+ * Gateway Load Test
+ * 
+ * Runs the gateway in-process and drives it with simulated monitors over
+ * keep-alive connections, each uploading exactly what a device does
+ * every UPLINK_INTERVAL (2 s of 500 Hz ECG in 250-sample blocks plus beat
+ * events). Optional WebSocket subscribers receive the multiplexed feed.
+ * 
+ * Uploads are sent back to back, so the run measures saturation. The
+ * gateway's CPU time (process time minus the client thread) converts
+ * the ingest rate into beds per core:
+ * 
+ *   beds per core = (samples/s / 500) / (gateway CPU seconds / wall seconds)
+ * 
+ * Usage: load_test [--devices N] [--subscribers N] [--seconds N] [--workers N] [--port N]
+ *                  [--archive-dir DIR]
+ */
+
+#include "gateway_server.h"
+#include "websocket.h"
+#include "codec/sample_codec.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+static const int BED_SAMPLE_RATE = 500;
+static const int BLOCK_SAMPLES = 250;
+static const int BATCH_SECONDS = 2;
+
+struct SimulatedDevice {
+  char id[24];
+  int fd;
+  uint64_t streamOffset;
+  uint32_t sequence;
+  int64_t epochMs;
+  double phase;
+  std::string request;
+  size_t requestSent;
+  std::string response;
+  uint64_t samplesAcked;
+};
+
+struct Subscriber {
+  int fd;
+  uint64_t bytes;
+};
+
+static double nowSeconds(clockid_t clock) {
+  timespec ts;
+  clock_gettime(clock, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int connectTo(int port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if (connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+    perror("connect");
+    exit(1);
+  }
+  int enable = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  return fd;
+}
+
+// Synthetic ECG: 72 BPM spikes on a slow baseline, in ADC counts
+static int16_t nextSample(SimulatedDevice& device, bool& beat) {
+  double beatPeriod = BED_SAMPLE_RATE * 60.0 / 72.0;
+  device.phase += 1.0;
+  beat = false;
+  if (device.phase >= beatPeriod) {
+    device.phase -= beatPeriod;
+    beat = true;
+  }
+  double t = device.phase / beatPeriod;
+  double value = 2048 + 80 * sin(device.sequence * 0.002) + 900 * exp(-t * t * 4000);
+  return (int16_t)value;
+}
+
+// Build the next upload (framed records) and its HTTP request
+static void buildUpload(SimulatedDevice& device) {
+  std::vector<uint8_t> body;
+  uint8_t record[1024];
+  uint8_t frame[1024];
+  int16_t samples[BLOCK_SAMPLES];
+  
+  for (int block = 0; block < BATCH_SECONDS * BED_SAMPLE_RATE / BLOCK_SAMPLES; block++) {
+    SampleBlockHeader header;
+    header.firstSequence = device.sequence;
+    header.sampleCount = BLOCK_SAMPLES;
+    header.sampleRate = BED_SAMPLE_RATE;
+    header.firstSampleTime = (uint64_t)device.sequence * 2000;
+    header.firstEpochMs = device.epochMs;
+    
+    std::vector<ECGEvent> beats;
+    for (int i = 0; i < BLOCK_SAMPLES; i++) {
+      bool beat;
+      samples[i] = nextSample(device, beat);
+      if (beat) {
+        ECGEvent event = { EVENT_BEAT, device.sequence + i, 72 };
+        beats.push_back(event);
+      }
+    }
+    device.sequence += BLOCK_SAMPLES;
+    device.epochMs += BLOCK_SAMPLES * 1000 / BED_SAMPLE_RATE;
+    
+    size_t length = encodeSampleBlock(header, samples, record, sizeof(record));
+    size_t framed = writeRecordFrame(record, length, frame, sizeof(frame));
+    body.insert(body.end(), frame, frame + framed);
+    
+    for (const ECGEvent& event : beats) {
+      length = encodeEvent(event, record, sizeof(record));
+      framed = writeRecordFrame(record, length, frame, sizeof(frame));
+      body.insert(body.end(), frame, frame + framed);
+    }
+  }
+  
+  char head[256];
+  snprintf(head, sizeof(head),
+           "POST /ingest HTTP/1.1\r\nHost: gateway\r\nContent-Type: application/octet-stream\r\n"
+           "X-Device-Id: %s\r\nX-Stream-Offset: %llu\r\nContent-Length: %zu\r\n\r\n",
+           device.id, (unsigned long long)device.streamOffset, body.size());
+  device.request.assign(head);
+  device.request.append((const char*)body.data(), body.size());
+  device.requestSent = 0;
+  device.response.clear();
+}
+
+// Complete response in the buffer: parse the ack and drop it
+static bool takeResponse(SimulatedDevice& device) {
+  size_t headerEnd = device.response.find("\r\n\r\n");
+  if (headerEnd == std::string::npos) return false;
+  
+  const char* lengthField = strstr(device.response.c_str(), "Content-Length: ");
+  if (!lengthField) return false;
+  size_t bodyLength = strtoul(lengthField + 16, NULL, 10);
+  if (device.response.size() < headerEnd + 4 + bodyLength) return false;
+  
+  const char* ack = strstr(device.response.c_str() + headerEnd, "\"ackOffset\":");
+  uint64_t ackOffset = ack ? strtoull(ack + 12, NULL, 10) : 0;
+  if (ackOffset != device.streamOffset + (device.request.size() - device.request.find("\r\n\r\n") - 4)) {
+    fprintf(stderr, "ERROR: %s acknowledged %llu\n", device.id, (unsigned long long)ackOffset);
+    exit(1);
+  }
+  device.streamOffset = ackOffset;
+  device.samplesAcked += BATCH_SECONDS * BED_SAMPLE_RATE;
+  return true;
+}
+
+int main(int argc, char** argv) {
+  int deviceCount = 64;
+  int subscriberCount = 1;
+  int seconds = 10;
+  GatewayOptions options;
+  options.port = 18080;
+  options.workerThreads = 1;
+  options.cpu = 0;
+  
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--devices") == 0) deviceCount = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--subscribers") == 0) subscriberCount = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--seconds") == 0) seconds = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--workers") == 0) options.workerThreads = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--port") == 0) options.port = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--archive-dir") == 0) options.archiveDir = argv[i + 1];
+  }
+  options.historySamples = 60 * BED_SAMPLE_RATE;
+  
+  GatewayServer server(options);
+  if (!server.begin()) return 1;
+  std::thread gatewayThread([&server]() { server.run(); });
+  
+  // Feed subscribers (one dashboard watching every bed)
+  std::vector<Subscriber> subscribers(subscriberCount);
+  for (Subscriber& subscriber : subscribers) {
+    subscriber.fd = connectTo(options.port);
+    subscriber.bytes = 0;
+    const char* upgrade =
+        "GET /feed HTTP/1.1\r\nHost: gateway\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    write(subscriber.fd, upgrade, strlen(upgrade));
+  }
+  
+  std::vector<SimulatedDevice> devices(deviceCount);
+  for (int i = 0; i < deviceCount; i++) {
+    SimulatedDevice& device = devices[i];
+    snprintf(device.id, sizeof(device.id), "bed-%04d", i);
+    device.fd = connectTo(options.port);
+    device.streamOffset = 0;
+    device.sequence = 0;
+    device.epochMs = 1750000000000LL;
+    device.phase = i * 7.0;
+    device.samplesAcked = 0;
+    buildUpload(device);
+  }
+  
+  std::vector<pollfd> polls(deviceCount + subscriberCount);
+  char buffer[65536];
+  
+  double startWall = nowSeconds(CLOCK_MONOTONIC);
+  double startProcess = nowSeconds(CLOCK_PROCESS_CPUTIME_ID);
+  double startClient = nowSeconds(CLOCK_THREAD_CPUTIME_ID);
+  
+  while (nowSeconds(CLOCK_MONOTONIC) - startWall < seconds) {
+    for (int i = 0; i < deviceCount; i++) {
+      polls[i].fd = devices[i].fd;
+      polls[i].events = devices[i].requestSent < devices[i].request.size() ? POLLOUT : POLLIN;
+    }
+    for (int i = 0; i < subscriberCount; i++) {
+      polls[deviceCount + i].fd = subscribers[i].fd;
+      polls[deviceCount + i].events = POLLIN;
+    }
+    poll(polls.data(), polls.size(), 100);
+    
+    for (int i = 0; i < deviceCount; i++) {
+      SimulatedDevice& device = devices[i];
+      if (polls[i].revents & POLLOUT) {
+        ssize_t count = write(device.fd, device.request.data() + device.requestSent,
+                              device.request.size() - device.requestSent);
+        if (count > 0) device.requestSent += count;
+      } else if (polls[i].revents & POLLIN) {
+        ssize_t count = read(device.fd, buffer, sizeof(buffer));
+        if (count <= 0) {
+          fprintf(stderr, "ERROR: gateway closed %s\n", device.id);
+          return 1;
+        }
+        device.response.append(buffer, count);
+        if (takeResponse(device)) buildUpload(device);
+      }
+    }
+    for (int i = 0; i < subscriberCount; i++) {
+      if (polls[deviceCount + i].revents & POLLIN) {
+        ssize_t count = read(subscribers[i].fd, buffer, sizeof(buffer));
+        if (count > 0) subscribers[i].bytes += count;
+      }
+    }
+  }
+  
+  double wall = nowSeconds(CLOCK_MONOTONIC) - startWall;
+  double client = nowSeconds(CLOCK_THREAD_CPUTIME_ID) - startClient;
+  double gatewayCpu = nowSeconds(CLOCK_PROCESS_CPUTIME_ID) - startProcess - client;
+  
+  uint64_t samples = 0;
+  for (const SimulatedDevice& device : devices) samples += device.samplesAcked;
+  uint64_t feedBytes = 0;
+  for (const Subscriber& subscriber : subscribers) feedBytes += subscriber.bytes;
+  
+  GatewayStats& stats = server.getStats();
+  double samplesPerSecond = samples / wall;
+  double beds = samplesPerSecond / BED_SAMPLE_RATE;
+  double gatewayCores = gatewayCpu / wall;
+  
+  printf("devices=%d subscribers=%d workers=%d wall=%.1fs\n",
+         deviceCount, subscriberCount, options.workerThreads, wall);
+  printf("batches=%llu records=%llu ingest=%.1f MB/s feed=%.1f MB/s dropped=%llu\n",
+         (unsigned long long)stats.batches, (unsigned long long)stats.records,
+         stats.bytesIngested / wall / 1e6, feedBytes / wall / 1e6,
+         (unsigned long long)stats.feedMessagesDropped);
+  printf("samples/s=%.0f (%.0f beds at %d Hz) gateway CPU=%.2f cores client CPU=%.2f cores\n",
+         samplesPerSecond, beds, BED_SAMPLE_RATE, gatewayCores, client / wall);
+  printf("beds per gateway core: %.0f\n", beds / gatewayCores);
+  
+  server.stop();
+  gatewayThread.join();
+  return 0;
+}
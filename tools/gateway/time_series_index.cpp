@@ -0,0 +1,129 @@
+/*
+ * Time Series Index Class Implementation
+ */
+
+#include "time_series_index.h"
+#include <algorithm>
+
+TimeSeriesIndex::TimeSeriesIndex(size_t maxSamples) {
+  this->maxSamples = maxSamples;
+  sampleCount = 0;
+  lastHeartRate = 0;
+  leadsOff = false;
+}
+
+int64_t TimeSeriesIndex::getTimeKey(const SampleBlockHeader& header) {
+  if (header.firstEpochMs != 0) return header.firstEpochMs;
+  return (int64_t)(header.firstSampleTime / 1000);
+}
+
+void TimeSeriesIndex::addBlock(const SampleBlockHeader& header, const int16_t* samples) {
+  if (header.sampleCount == 0 || header.sampleRate == 0) return;
+  
+  IndexedBlock block;
+  block.header = header;
+  block.startMs = getTimeKey(header);
+  block.samples.assign(samples, samples + header.sampleCount);
+  
+  // Devices send in order; a restarted device clock starts a new history
+  if (!blocks.empty() && block.startMs < blocks.back().startMs) {
+    blocks.clear();
+    events.clear();
+    sampleCount = 0;
+  }
+  
+  blocks.push_back(std::move(block));
+  sampleCount += header.sampleCount;
+  trim();
+}
+
+void TimeSeriesIndex::addEvent(const ECGEvent& event) {
+  events.push_back(event);
+  
+  if (event.type == EVENT_BEAT) {
+    lastHeartRate = event.value;
+  } else if (event.type == EVENT_LEADS_OFF) {
+    leadsOff = true;
+  } else if (event.type == EVENT_LEADS_ON) {
+    leadsOff = false;
+  }
+}
+
+void TimeSeriesIndex::trim() {
+  while (sampleCount > maxSamples && blocks.size() > 1) {
+    sampleCount -= blocks.front().samples.size();
+    blocks.pop_front();
+  }
+  
+  // Drop events older than the oldest block
+  uint32_t oldest = blocks.front().header.firstSequence;
+  while (!events.empty() && (int32_t)(events.front().sequence - oldest) < 0) {
+    events.pop_front();
+  }
+}
+
+bool TimeSeriesIndex::query(int64_t fromMs, int64_t toMs, SeriesRange& range) const {
+  range.samples.clear();
+  if (blocks.empty() || toMs <= fromMs) return false;
+  
+  // First block that ends after fromMs
+  auto endsBefore = [](const IndexedBlock& block, int64_t ms) {
+    return block.startMs + (int64_t)block.samples.size() * 1000 / block.header.sampleRate <= ms;
+  };
+  auto it = std::lower_bound(blocks.begin(), blocks.end(), fromMs, endsBefore);
+  if (it == blocks.end() || it->startMs >= toMs) return false;
+  
+  uint16_t rate = it->header.sampleRate;
+  size_t skip = fromMs > it->startMs ? (size_t)((fromMs - it->startMs) * rate / 1000) : 0;
+  size_t maxCount = (size_t)((toMs - std::max(fromMs, it->startMs)) * rate / 1000);
+  
+  range.firstSequence = it->header.firstSequence + skip;
+  range.firstMs = it->startMs + (int64_t)skip * 1000 / rate;
+  range.sampleRate = rate;
+  
+  uint32_t nextSequence = range.firstSequence;
+  for (; it != blocks.end() && range.samples.size() < maxCount; ++it) {
+    if (it->header.sampleRate != rate) break;  // Rate change ends the range
+    
+    // Fill samples the device skipped
+    uint32_t blockStart = it->header.firstSequence;
+    while ((int32_t)(blockStart - nextSequence) > 0 && range.samples.size() < maxCount) {
+      range.samples.push_back(SAMPLE_GAP_VALUE);
+      nextSequence++;
+    }
+    
+    size_t start = (size_t)(nextSequence - blockStart);
+    for (size_t i = start; i < it->samples.size() && range.samples.size() < maxCount; i++) {
+      range.samples.push_back(it->samples[i]);
+      nextSequence++;
+    }
+  }
+  
+  return !range.samples.empty();
+}
+
+void TimeSeriesIndex::queryEvents(uint32_t fromSequence, uint32_t toSequence,
+                                  std::vector<ECGEvent>& out) const {
+  for (size_t i = 0; i < events.size(); i++) {
+    uint32_t sequence = events[i].sequence;
+    if ((int32_t)(sequence - fromSequence) >= 0 && (int32_t)(sequence - toSequence) < 0) {
+      out.push_back(events[i]);
+    }
+  }
+}
+
+int64_t TimeSeriesIndex::getFirstMs() const {
+  return blocks.empty() ? 0 : blocks.front().startMs;
+}
+
+int64_t TimeSeriesIndex::getLastMs() const {
+  if (blocks.empty()) return 0;
+  const IndexedBlock& last = blocks.back();
+  return last.startMs + (int64_t)last.samples.size() * 1000 / last.header.sampleRate;
+}
+
+uint32_t TimeSeriesIndex::getLastSequence() const {
+  if (blocks.empty()) return 0;
+  const IndexedBlock& last = blocks.back();
+  return last.header.firstSequence + (uint32_t)last.samples.size() - 1;
+}
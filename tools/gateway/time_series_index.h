@@ -0,0 +1,68 @@
+/*
+ * Time Series Index Class Header
+ * 
+ * In-memory history of one device: decoded sample blocks and events,
+ * trimmed to a sample budget. Blocks are keyed by time in ms (epoch time
+ * once the device clock is synchronized, device-local time before that)
+ * so range queries are a binary search plus a copy.
+ */
+
+#ifndef TIME_SERIES_INDEX_H
+#define TIME_SERIES_INDEX_H
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "codec/sample_codec.h"
+
+struct IndexedBlock {
+  SampleBlockHeader header;
+  int64_t startMs;                // Time key of the first sample
+  std::vector<int16_t> samples;
+};
+
+struct SeriesRange {
+  int64_t firstMs;                // Time key of the first returned sample
+  uint32_t firstSequence;
+  uint16_t sampleRate;
+  std::vector<int16_t> samples;   // Sequence gaps are filled with SAMPLE_GAP_VALUE
+};
+
+class TimeSeriesIndex {
+private:
+  std::deque<IndexedBlock> blocks;
+  std::deque<ECGEvent> events;
+  size_t maxSamples;
+  size_t sampleCount;
+  int lastHeartRate;
+  bool leadsOff;
+  
+  static int64_t getTimeKey(const SampleBlockHeader& header);
+  void trim();
+  
+public:
+  // Constructor (history limit in samples)
+  TimeSeriesIndex(size_t maxSamples);
+  
+  // Add decoded data
+  void addBlock(const SampleBlockHeader& header, const int16_t* samples);
+  void addEvent(const ECGEvent& event);
+  
+  // Copy the samples between two time keys (ms); false if nothing is stored there
+  bool query(int64_t fromMs, int64_t toMs, SeriesRange& range) const;
+  
+  // Events with a sequence in [fromSequence, toSequence)
+  void queryEvents(uint32_t fromSequence, uint32_t toSequence, std::vector<ECGEvent>& out) const;
+  
+  // Getters
+  size_t getSampleCount() const { return sampleCount; }
+  size_t getBlockCount() const { return blocks.size(); }
+  size_t getEventCount() const { return events.size(); }
+  int64_t getFirstMs() const;
+  int64_t getLastMs() const;
+  uint32_t getLastSequence() const;
+  int getLastHeartRate() const { return lastHeartRate; }
+  bool isLeadsOff() const { return leadsOff; }
+};
+
+#endif // TIME_SERIES_INDEX_H
@@ -0,0 +1,152 @@
+/*
+ * WebSocket Helpers Implementation
+ * 
+ * SHA-1 and base64 are only used for the handshake key, so compact
+ * reference implementations are enough.
+ */
+
+#include "websocket.h"
+#include <string.h>
+#include <strings.h>
+
+static const char* WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+static const size_t MAX_CLIENT_FRAME = 65536;
+
+static uint32_t rotateLeft(uint32_t value, int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+static void sha1(const std::string& message, uint8_t digest[20]) {
+  uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+  
+  // Pad to a multiple of 64 bytes with the bit length at the end
+  std::string data = message;
+  uint64_t bitLength = (uint64_t)message.size() * 8;
+  data.push_back((char)0x80);
+  while (data.size() % 64 != 56) data.push_back(0);
+  for (int i = 7; i >= 0; i--) data.push_back((char)(bitLength >> (8 * i)));
+  
+  for (size_t chunk = 0; chunk < data.size(); chunk += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+      const uint8_t* p = (const uint8_t*)data.data() + chunk + 4 * i;
+      w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+    for (int i = 16; i < 80; i++) {
+      w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+      else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+      else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+      else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+      
+      uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotateLeft(b, 30);
+      b = a;
+      a = temp;
+    }
+    
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+  
+  for (int i = 0; i < 20; i++) {
+    digest[i] = (uint8_t)(h[i / 4] >> (24 - 8 * (i % 4)));
+  }
+}
+
+static std::string base64(const uint8_t* data, size_t length) {
+  static const char* ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  
+  for (size_t i = 0; i < length; i += 3) {
+    uint32_t block = (uint32_t)data[i] << 16;
+    if (i + 1 < length) block |= (uint32_t)data[i + 1] << 8;
+    if (i + 2 < length) block |= data[i + 2];
+    
+    out.push_back(ALPHABET[(block >> 18) & 63]);
+    out.push_back(ALPHABET[(block >> 12) & 63]);
+    out.push_back(i + 1 < length ? ALPHABET[(block >> 6) & 63] : '=');
+    out.push_back(i + 2 < length ? ALPHABET[block & 63] : '=');
+  }
+  return out;
+}
+
+std::string computeWebSocketAccept(const std::string& key) {
+  uint8_t digest[20];
+  sha1(key + WEBSOCKET_GUID, digest);
+  return base64(digest, sizeof(digest));
+}
+
+bool isWebSocketUpgrade(const HttpRequest& request) {
+  return strcasecmp(request.getHeader("upgrade").c_str(), "websocket") == 0 &&
+         !request.getHeader("sec-websocket-key").empty();
+}
+
+std::string buildWebSocketHandshake(const HttpRequest& request) {
+  return "HTTP/1.1 101 Switching Protocols\r\n"
+         "Upgrade: websocket\r\n"
+         "Connection: Upgrade\r\n"
+         "Sec-WebSocket-Accept: " + computeWebSocketAccept(request.getHeader("sec-websocket-key")) +
+         "\r\n\r\n";
+}
+
+void encodeWebSocketFrame(uint8_t opcode, const uint8_t* payload, size_t length, std::string& out) {
+  out.push_back((char)(0x80 | opcode));  // FIN, no fragmentation
+  
+  if (length < 126) {
+    out.push_back((char)length);
+  } else if (length <= 0xFFFF) {
+    out.push_back((char)126);
+    out.push_back((char)(length >> 8));
+    out.push_back((char)length);
+  } else {
+    out.push_back((char)127);
+    for (int i = 7; i >= 0; i--) out.push_back((char)((uint64_t)length >> (8 * i)));
+  }
+  
+  out.append((const char*)payload, length);
+}
+
+ParseStatus parseWebSocketFrame(const std::string& buffer, uint8_t& opcode,
+                                std::string& payload, size_t& consumed) {
+  const uint8_t* data = (const uint8_t*)buffer.data();
+  if (buffer.size() < 2) return PARSE_INCOMPLETE;
+  
+  opcode = data[0] & 0x0F;
+  bool masked = (data[1] & 0x80) != 0;
+  uint64_t length = data[1] & 0x7F;
+  size_t position = 2;
+  
+  if (length == 126) {
+    if (buffer.size() < 4) return PARSE_INCOMPLETE;
+    length = ((uint64_t)data[2] << 8) | data[3];
+    position = 4;
+  } else if (length == 127) {
+    if (buffer.size() < 10) return PARSE_INCOMPLETE;
+    length = 0;
+    for (int i = 0; i < 8; i++) length = (length << 8) | data[2 + i];
+    position = 10;
+  }
+  
+  // Clients must mask; the feed never needs large client messages
+  if (!masked || length > MAX_CLIENT_FRAME) return PARSE_ERROR;
+  
+  if (buffer.size() < position + 4 + length) return PARSE_INCOMPLETE;
+  
+  const uint8_t* mask = data + position;
+  position += 4;
+  
+  payload.resize((size_t)length);
+  for (size_t i = 0; i < length; i++) {
+    payload[i] = (char)(data[position + i] ^ mask[i % 4]);
+  }
+  
+  consumed = position + (size_t)length;
+  return PARSE_COMPLETE;
+}
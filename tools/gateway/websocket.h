@@ -0,0 +1,41 @@
+/*
+ * WebSocket Helpers Header
+ * 
+ * Server side of RFC 6455 as needed for the live feed: the upgrade
+ * handshake, unmasked server frames, and parsing of masked client frames
+ * (close, ping and anything a dashboard may send).
+ */
+
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include "http_message.h"
+
+enum WebSocketOpcode {
+  WS_TEXT = 0x1,
+  WS_BINARY = 0x2,
+  WS_CLOSE = 0x8,
+  WS_PING = 0x9,
+  WS_PONG = 0xA
+};
+
+// Sec-WebSocket-Accept value for a client key
+std::string computeWebSocketAccept(const std::string& key);
+
+// True if the request asks for a WebSocket upgrade
+bool isWebSocketUpgrade(const HttpRequest& request);
+
+// 101 response completing the handshake
+std::string buildWebSocketHandshake(const HttpRequest& request);
+
+// Append one unfragmented server frame to out
+void encodeWebSocketFrame(uint8_t opcode, const uint8_t* payload, size_t length, std::string& out);
+
+// Parse one client frame from the front of buffer (unmasks the payload)
+ParseStatus parseWebSocketFrame(const std::string& buffer, uint8_t& opcode,
+                                std::string& payload, size_t& consumed);
+
+#endif // WEBSOCKET_H
@@ -0,0 +1,64 @@
+/*
+ * Worker Pool Class Implementation
+ */
+
+#include "worker_pool.h"
+#include <pthread.h>
+#include <sched.h>
+
+WorkerPool::WorkerPool() {
+  stopping = false;
+}
+
+WorkerPool::~WorkerPool() {
+  stop();
+}
+
+void WorkerPool::begin(int threadCount, int cpu) {
+  stopping = false;
+  for (int i = 0; i < threadCount; i++) {
+    threads.emplace_back(&WorkerPool::workerMain, this);
+    
+    if (cpu >= 0) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      pthread_setaffinity_np(threads.back().native_handle(), sizeof(set), &set);
+    }
+  }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(std::move(task));
+  }
+  available.notify_one();
+}
+
+void WorkerPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  available.notify_all();
+  
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  threads.clear();
+}
+
+void WorkerPool::workerMain() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      available.wait(lock, [this]() { return stopping || !tasks.empty(); });
+      if (tasks.empty()) return;  // Stopping and drained
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+}
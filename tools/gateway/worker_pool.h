@@ -0,0 +1,46 @@
+/*
+ * Worker Pool Class Header
+ * 
+ * Fixed set of threads draining a shared task queue. The gateway runs
+ * decoding, indexing and feed encoding here so the event loop only moves
+ * bytes.
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+private:
+  std::vector<std::thread> threads;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable available;
+  bool stopping;
+  
+  void workerMain();
+  
+public:
+  // Constructor
+  WorkerPool();
+  ~WorkerPool();
+  
+  // Start the given number of threads (pinned to one CPU if cpu >= 0)
+  void begin(int threadCount, int cpu = -1);
+  
+  // Queue a task
+  void submit(std::function<void()> task);
+  
+  // Finish queued tasks and join the threads
+  void stop();
+  
+  int getThreadCount() { return (int)threads.size(); }
+};
+
+#endif // WORKER_POOL_H
@@ -0,0 +1,154 @@
+/*
+ * Host Arduino Shim
+ * 
+ * Minimal stand-in for the Arduino core so that device sources which only
+ * use Serial logging and the math helpers (src/processing, src/dsp,
+ * src/config, src/simulation, src/uplink/outbox) compile unchanged into
+ * host tools. Put this directory on the include path ahead of any real
+ * core: -I../host
+ * 
+ * Serial output goes to stderr and is off by default; tools that want the
+ * device log set Serial.enabled. src/memory/heap_guard builds here too, with
+ * its malloc interposer (-DECG_HOST_HEAP_GUARD).
+ * 
+ * The GPIO and ADC calls are there so the sensor path and the serial-only
+ * sketch link on the host (tools/size_report). There is no hardware: the
+ * ADC reads mid-scale and the lead-off pins read LOW (leads connected).
+ * 
+ * Timing tools can switch to virtual time (virtualClock): micros() and
+ * millis() then return virtualClock.now, and delay() advances it to a
+ * 1 ms tick boundary like vTaskDelay() instead of waiting.
+ * delayMicroseconds() advances it exactly. WiFi.h is the matching radio
+ * shim for src/power.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PI 3.1415926535897932384626433832795
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define DEC 10
+#define HEX 16
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ESP32 ADC attenuation (referenced by config.h)
+enum adc_attenuation_t { ADC_0db, ADC_2_5db, ADC_6db, ADC_11db };
+
+using std::min;
+using std::max;
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// Virtual time for timing tools (tools/timing)
+struct HostVirtualClock {
+  bool enabled = false;
+  uint64_t now = 0;                  // us
+  
+  void advance(uint64_t us) { now += us; }
+};
+
+inline HostVirtualClock virtualClock;
+
+inline unsigned long micros() {
+  if (virtualClock.enabled) return (unsigned long)virtualClock.now;
+  
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+inline unsigned long millis() {
+  return micros() / 1000;
+}
+
+inline void delay(unsigned long ms) {
+  if (virtualClock.enabled) {
+    // Tick sleep: wakes on the ms-th tick boundary from now
+    virtualClock.now = (virtualClock.now / 1000 + ms) * 1000;
+    return;
+  }
+  
+  unsigned long start = millis();
+  while (millis() - start < ms) {}
+}
+
+inline void delayMicroseconds(uint32_t us) {
+  if (virtualClock.enabled) {
+    virtualClock.advance(us);
+    return;
+  }
+  
+  unsigned long start = micros();
+  while (micros() - start < us) {}
+}
+
+inline void yield() {}
+
+// CPU clock switching has no effect on the host
+inline bool setCpuFrequencyMhz(uint32_t) { return true; }
+
+// newlib has strlcpy; glibc only from 2.38
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char* destination, const char* source, size_t size) {
+  size_t length = strlen(source);
+  if (size > 0) {
+    size_t copied = length < size - 1 ? length : size - 1;
+    memcpy(destination, source, copied);
+    destination[copied] = '\0';
+  }
+  return length;
+}
+#endif
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+inline void analogReadResolution(uint8_t) {}
+inline void analogSetAttenuation(adc_attenuation_t) {}
+inline uint16_t analogRead(uint8_t) { return 2048; }
+
+class Print {
+public:
+  bool enabled = false;
+  
+  void print(const char* text) { if (enabled) fputs(text, stderr); }
+  void print(char c) { if (enabled) fputc(c, stderr); }
+  void print(int value) { if (enabled) fprintf(stderr, "%d", value); }
+  void print(unsigned int value) { if (enabled) fprintf(stderr, "%u", value); }
+  void print(long value) { if (enabled) fprintf(stderr, "%ld", value); }
+  void print(unsigned long value) { if (enabled) fprintf(stderr, "%lu", value); }
+  void print(unsigned long value, int base) {
+    if (enabled) fprintf(stderr, base == HEX ? "%lX" : "%lu", value);
+  }
+  void print(double value, int digits = 2) { if (enabled) fprintf(stderr, "%.*f", digits, value); }
+  
+  void println() { print("\n"); }
+  template <typename T>
+  void println(T value) { print(value); print("\n"); }
+  template <typename T>
+  void println(T value, int format) { print(value, format); print("\n"); }
+  
+  void flush() { fflush(stderr); }
+};
+
+class HostSerial : public Print {
+public:
+  void begin(unsigned long) {}
+};
+
+inline HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
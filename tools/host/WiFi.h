@@ -0,0 +1,42 @@
+/*
+ * Host WiFi Shim
+ *
+ * Radio mode switching for device sources that only turn the radio on and
+ * off (src/power). There is no network: the shim remembers the mode and
+ * when it last changed (virtual time when enabled), so a host model can
+ * decide when an association would complete.
+ */
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+
+enum wifi_mode_t { WIFI_OFF, WIFI_STA };
+enum wifi_ps_type_t { WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM };
+
+class HostWiFi {
+public:
+  wifi_mode_t currentMode = WIFI_OFF;
+  wifi_ps_type_t powerSave = WIFI_PS_NONE;
+  unsigned long modeChangedAt = 0;   // millis() of the last mode change
+
+  bool mode(wifi_mode_t mode) {
+    if (mode != currentMode) {
+      currentMode = mode;
+      modeChangedAt = millis();
+    }
+    return true;
+  }
+
+  bool setSleep(wifi_ps_type_t type) {
+    powerSave = type;
+    return true;
+  }
+
+  wifi_mode_t getMode() { return currentMode; }
+};
+
+inline HostWiFi WiFi;
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,247 @@
+/*
+ * Heap Audit Run
+ * 
+ * Runs the memory audit mode on the host: HeapGuard with its malloc
+ * interposer (-DECG_HOST_HEAP_GUARD) and auditing enabled
+ * (-DECG_MEMORY_AUDIT=1). setup() allocates freely and arms the guard
+ * like ecg_monitor.ino; the loop then runs the sample path (ECGSimulator,
+ * SignalProcessor, SampleHistory) with HeapGuard::check() once a second,
+ * as housekeeping does on the device.
+ * 
+ * Checks, in order:
+ * 
+ *   - the sample path makes no heap allocation after setup
+ *   - the uplink's outbox work from the loop makes none outside its Allow
+ *     scopes: appends and flushes through a segment rotation, then a peek
+ *     of the full segment and its acknowledgement (state file, removal)
+ *   - a /config POST makes none: the settings write runs in an Allow scope
+ *     inside the handler's audited scope, as in ECGWebServer
+ *   - an allocation inside a HeapGuard::Allow scope is not a violation
+ *   - an allocation from another thread is not audited (the guard watches
+ *     the loop task only)
+ *   - an allocation in the loop is: a forked child allocates, and
+ *     check() must report it and abort (MEMORY_AUDIT_ABORT)
+ *   - so is the settings write without its Allow scope (the host writes a
+ *     file where the device writes NVS; both allocate)
+ * 
+ * The outbox and the settings file live in a temporary directory. Exits
+ * with status 1 if any check fails.
+ * 
+ * Usage: heap_audit [--seconds N] [--rate HZ]
+ */
+
+#include "memory/heap_guard.h"
+#include "config/runtime_config.h"
+#include "uplink/outbox.h"
+#include "processing/signal_processor.h"
+#include "simulation/ecg_simulator.h"
+#include "storage/sample_history.h"
+#include <dirent.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+static void* volatile allocationSink;   // Keeps the test allocations from being optimized away
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+static void allocate(size_t size) {
+  allocationSink = malloc(size);
+  free(allocationSink);
+}
+
+static const char* result(bool passed) {
+  return passed ? "ok" : "FAILED";
+}
+
+// Runs body in a forked child with the audit check after it; true if the
+// child aborted, as the device resets on a violation
+template <typename Body>
+static bool abortsInLoop(Body body) {
+  fflush(stdout);
+  Serial.enabled = true;
+  pid_t child = fork();
+  if (child == 0) {
+    body();
+    HeapGuard::check();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(child, &status, 0);
+  Serial.enabled = false;
+  return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+static void removeDirectory(const char* directory) {
+  DIR* dir = opendir(directory);
+  if (dir == NULL) return;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') continue;
+    char path[320];
+    snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    struct stat info;
+    if (stat(path, &info) == 0 && S_ISDIR(info.st_mode)) {
+      removeDirectory(path);
+    } else {
+      remove(path);
+    }
+  }
+  closedir(dir);
+  rmdir(directory);
+}
+
+int main(int argc, char** argv) {
+  int seconds = atoi(getOption(argc, argv, "--seconds", "600"));
+  int sampleRate = atoi(getOption(argc, argv, "--rate", "500"));
+  
+  // setup(): allocation is fine until the guard is armed
+  ECGSimulatorParams params;
+  ECGSimulator::getDefaults(params);
+  params.sampleRate = sampleRate;
+  ECGSimulator* simulator = new ECGSimulator();
+  simulator->begin(params);
+  
+  ECGSettings settings;
+  RuntimeConfig::getDefaults(settings);
+  settings.sampleRate = sampleRate;
+  SignalProcessor* processor = new SignalProcessor();
+  processor->begin();
+  processor->requestSettings(settings);
+  
+  SampleHistory* history = new SampleHistory();
+  history->begin((size_t)SAMPLE_HISTORY_SAMPLES);
+  
+  // Outbox and settings file (CONFIG_FILE_PATH is relative) in a scratch directory
+  char base[] = "/tmp/heap_audit_XXXXXX";
+  if (mkdtemp(base) == NULL || chdir(base) != 0) return 1;
+  Outbox* outbox = new Outbox();
+  if (!outbox->begin("outbox", "outbox.state")) return 1;
+  RuntimeConfig* runtimeConfig = new RuntimeConfig();
+  runtimeConfig->begin();
+  
+  HeapGuard::arm();
+  bool armed = HeapGuard::isArmed();
+  
+  // loop(): the sample path with the audit check once a second
+  unsigned long beats = 0;
+  for (int second = 0; armed && second < seconds; second++) {
+    for (int i = 0; i < sampleRate; i++) {
+      uint32_t sequence = (uint32_t)second * sampleRate + i;
+      int value = simulator->nextSample();
+      bool connected = simulator->areLeadsConnected();
+      history->append(connected ? value : SAMPLE_GAP, sequence);
+      if (!connected) {
+        processor->skipSample();
+        continue;
+      }
+      processor->processSample(value);
+      if (processor->isHeartbeatDetected()) beats++;
+    }
+    HeapGuard::check();
+  }
+  uint32_t violations = HeapGuard::getViolationCount();
+  uint32_t sampleViolations = violations;
+  
+  // Uplink from the loop: blocks of about 300 bytes, flushed every four,
+  // until the outbox starts a new segment
+  uint8_t record[300];
+  memset(record, 0x5A, sizeof(record));
+  int appends = 0;
+  while (armed && outbox->getSegmentCount() < 2 && appends < 1000) {
+    outbox->append(record, sizeof(record));
+    if (++appends % 4 == 0) outbox->flush();
+  }
+  outbox->flush();
+  HeapGuard::check();
+  bool rotated = outbox->getSegmentCount() == 2;
+  uint32_t rotationViolations = HeapGuard::getViolationCount() - violations;
+  violations = HeapGuard::getViolationCount();
+  
+  // The first segment goes out in batches and the collector acknowledges it
+  uint8_t batch[UPLINK_MAX_BATCH_BYTES];
+  uint64_t offset;
+  size_t length;
+  while ((length = outbox->peek(batch, sizeof(batch), offset)) > 0 && outbox->getSegmentCount() == 2) {
+    outbox->acknowledge(offset + length);
+  }
+  HeapGuard::check();
+  bool acknowledged = outbox->getSegmentCount() == 1 && outbox->getAckedOffset() > 0;
+  uint32_t ackViolations = HeapGuard::getViolationCount() - violations;
+  violations = HeapGuard::getViolationCount();
+  
+  // POST /config: the handler runs audited, the settings write is allowed
+  settings.movingAverageSize++;
+  const char* problem;
+  {
+    HeapGuard::Allow audit(false);
+    HeapGuard::Allow allow;
+    problem = runtimeConfig->update(settings);
+  }
+  HeapGuard::check();
+  bool configSaved = problem == NULL;
+  uint32_t configViolations = HeapGuard::getViolationCount() - violations;
+  violations = HeapGuard::getViolationCount();
+  
+  {
+    HeapGuard::Allow allow;
+    allocate(256);
+  }
+  uint32_t allowViolations = HeapGuard::getViolationCount() - violations;
+  violations = HeapGuard::getViolationCount();
+  
+  std::thread* worker;
+  {
+    HeapGuard::Allow allow;   // Creating the thread allocates its state
+    worker = new std::thread([]() { allocate(256); });
+  }
+  worker->join();
+  uint32_t threadViolations = HeapGuard::getViolationCount() - violations;
+  
+  // A loop allocation must be caught; check() reports it (the device log
+  // goes to stderr) and aborts the child like the device resets
+  bool caught = abortsInLoop([]() { allocate(48); });
+  bool configCaught = abortsInLoop([&]() {
+    HeapGuard::Allow audit(false);
+    runtimeConfig->update(settings);
+  });
+  
+  char sampleLabel[64];
+  snprintf(sampleLabel, sizeof(sampleLabel), "sample path, %d s at %d Hz (%lu beats)", seconds, sampleRate, beats);
+  printf("\n%-44s %-14s %s\n", "guard armed", "", result(armed));
+  printf("%-44s %2u violations  %s\n", sampleLabel, sampleViolations, result(sampleViolations == 0));
+  char rotationLabel[64];
+  snprintf(rotationLabel, sizeof(rotationLabel), "outbox: %d appends and a new segment", appends);
+  printf("%-44s %2u violations  %s\n", rotationLabel, rotationViolations,
+         result(rotated && rotationViolations == 0));
+  printf("%-44s %2u violations  %s\n", "outbox: segment acknowledged and removed", ackViolations,
+         result(acknowledged && ackViolations == 0));
+  printf("%-44s %2u violations  %s\n", "POST /config (settings written)", configViolations,
+         result(configSaved && configViolations == 0));
+  printf("%-44s %2u violations  %s\n", "allocation in an Allow scope", allowViolations,
+         result(allowViolations == 0));
+  printf("%-44s %2u violations  %s\n", "allocation from another thread", threadViolations,
+         result(threadViolations == 0));
+  printf("%-44s %-14s %s\n", "allocation in the loop", caught ? "aborted" : "not caught", result(caught));
+  printf("%-44s %-14s %s\n", "settings write without its Allow scope", configCaught ? "aborted" : "not caught",
+         result(configCaught));
+  
+  bool passed = armed && sampleViolations == 0 && rotated && rotationViolations == 0 &&
+                acknowledged && ackViolations == 0 && configSaved && configViolations == 0 &&
+                allowViolations == 0 && threadViolations == 0 && caught && configCaught;
+  printf("%s\n", passed ? "PASS" : "FAIL");
+  
+  delete outbox;
+  removeDirectory(base);
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+/*
+ * Battery Life Simulation
+ * 
+ * Runs the device PowerManager and EnergyMonitor on the host's virtual
+ * clock (tools/host) with the monitor's scheduler tasks and a cost model
+ * for each, in both power modes:
+ * 
+ *   - normal: CPU at full clock, idle between deadlines, radio associated
+ *     all the time and uploading every UPLINK_INTERVAL
+ *   - low power: CPU at LOW_POWER_CPU_MHZ, light sleep between sample
+ *     deadlines, one sample captured per wake-up and the pipeline run per
+ *     LOW_POWER_BLOCK_MS block, radio only on in transmit windows
+ * 
+ * The radio model associates --connect ms after the radio is switched on;
+ * uploads then drain the outbox in UPLINK_MAX_BATCH_BYTES batches (one per
+ * UPLINK_CATCHUP_INTERVAL while behind) that take --post ms each.
+ * 
+ * Battery life comes from the state trace the EnergyMonitor accumulated
+ * (time per CPU and radio state) and the current model in config.h, as
+ * on the device. Exits with status 1 if low power mode misses samples,
+ * leaves data behind after a transmit window, or does not last longer
+ * than normal mode.
+ * 
+ * Usage: battery_sim [--hours N] [--rate HZ] [--bytes-per-s N]
+ *                    [--connect MS] [--post MS]
+ */
+
+#include "power/power_manager.h"
+#include "scheduler/scheduler.h"
+#include "sensors/sample_clock.h"
+#include <WiFi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Cost model at 240 MHz (us); low power mode scales by the clock ratio
+static const uint64_t CAPTURE_COST = 15;        // ADC read, sample clock, history
+static const uint64_t PROCESS_COST = 30;        // SignalProcessor and uplink queuing per sample
+static const uint64_t WEB_POLL_COST = 25;       // handleClient() with the server running
+static const uint64_t TASK_COST = 10;           // LED, status, WiFi, housekeeping, clock sync
+static const uint64_t UPLINK_POLL_COST = 15;
+static const int FULL_CPU_MHZ = 240;
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+struct SimOptions {
+  double hours;
+  int sampleRate;
+  double bytesPerSecond;
+  unsigned long connectMs;
+  unsigned long postMs;
+};
+
+struct SimResult {
+  uint64_t stateTime[POWER_STATE_COUNT];
+  uint64_t totalTime;
+  float averageCurrent;
+  float batteryLife;
+  unsigned long missedSamples;
+  uint64_t maxLateness;
+  double maxPendingBytes;
+  double pendingAfterWindow;   // Most left over when a window closed
+  unsigned long windows;
+};
+
+// Monitor model: the sketch's tasks around the device PowerManager
+struct Monitor {
+  SampleClock clock;
+  PowerManager power;
+  Scheduler scheduler;
+  SimOptions options;
+  bool lowPower;
+  int samplingTask;
+  int blockCount;
+  uint64_t costScale;          // Cost multiplier for the CPU clock
+  
+  double pendingBytes;
+  bool linkUp;
+  bool posting;
+  unsigned long postStarted;
+  unsigned long lastUpload;
+  unsigned long uploadInterval;
+  SimResult result;
+  
+  void spend(uint64_t cost) { virtualClock.advance(cost * costScale); }
+  
+  void serviceSampling() {
+    if (!clock.isSampleDue()) return;
+    clock.takeSample();
+    uint64_t lateness = clock.now() - clock.getLastSampleTime();
+    if (lateness > result.maxLateness) result.maxLateness = lateness;
+    spend(CAPTURE_COST);
+    
+    if (!lowPower) {
+      spend(PROCESS_COST);
+      return;
+    }
+    // The pipeline runs once per block
+    if (++blockCount >= getBlockSize()) {
+      spend(PROCESS_COST * blockCount);
+      blockCount = 0;
+    }
+  }
+  
+  int getBlockSize() { return options.sampleRate * LOW_POWER_BLOCK_MS / 1000; }
+  
+  void updateUplink() {
+    spend(UPLINK_POLL_COST);
+    unsigned long now = millis();
+    
+    // Association completes a fixed time after the radio comes on
+    linkUp = WiFi.getMode() == WIFI_STA && now - WiFi.modeChangedAt >= options.connectMs;
+    
+    // The post runs beside the loop; its batch is acknowledged when it ends
+    if (posting && (!linkUp || now - postStarted >= options.postMs)) {
+      posting = false;
+      if (linkUp) {
+        pendingBytes -= pendingBytes < UPLINK_MAX_BATCH_BYTES ? pendingBytes : UPLINK_MAX_BATCH_BYTES;
+        uploadInterval = pendingBytes >= UPLINK_MAX_BATCH_BYTES ? UPLINK_CATCHUP_INTERVAL : UPLINK_INTERVAL;
+      }
+    }
+    if (linkUp && !posting && pendingBytes >= 1 && now - lastUpload >= uploadInterval) {
+      posting = true;
+      postStarted = now;
+      lastUpload = now;
+    }
+    
+    bool radioOn = power.isRadioEnabled();
+    power.updateRadio(linkUp, (uint64_t)pendingBytes);
+    
+    // Window closed: what it could not send waits for the next one
+    if (radioOn && !power.isRadioEnabled()) {
+      result.windows++;
+      if (pendingBytes > result.pendingAfterWindow) result.pendingAfterWindow = pendingBytes;
+      posting = false;
+    }
+  }
+  
+  void addData(double seconds) {
+    pendingBytes += options.bytesPerSecond * seconds;
+    if (pendingBytes > result.maxPendingBytes) result.maxPendingBytes = pendingBytes;
+  }
+};
+
+static Monitor* monitor = NULL;
+
+static void runSampling() {
+  monitor->serviceSampling();
+  monitor->scheduler.runAt(monitor->samplingTask, monitor->clock.getNextDeadline());
+}
+
+static void handleWeb() { monitor->spend(monitor->lowPower ? 1 : WEB_POLL_COST); }
+static void runTask() { monitor->spend(TASK_COST); }
+static void updateUplink() { monitor->updateUplink(); }
+static void queueData() { monitor->addData(UPLINK_TASK_PERIOD / 1000.0); }
+
+static void simulate(bool lowPower, const SimOptions& options, SimResult& result) {
+  virtualClock.enabled = true;
+  virtualClock.now = 0;
+  WiFi.currentMode = WIFI_OFF;
+  WiFi.modeChangedAt = 0;
+  
+  // Fresh device objects per run; the clocks start at zero again
+  monitor = new Monitor();
+  Monitor& m = *monitor;
+  m.options = options;
+  m.lowPower = lowPower;
+  m.costScale = lowPower ? FULL_CPU_MHZ / LOW_POWER_CPU_MHZ : 1;
+  m.blockCount = 0;
+  m.pendingBytes = 0;
+  m.linkUp = false;
+  m.posting = false;
+  m.postStarted = 0;
+  m.lastUpload = 0;
+  m.uploadInterval = 0;
+  m.result = SimResult();
+  
+  m.clock.begin(options.sampleRate);
+  m.power.begin(&m.clock, lowPower);
+  if (!lowPower) WiFi.mode(WIFI_STA);   // WiFiLink connects at boot
+  
+  m.scheduler.begin(&m.clock);
+  m.samplingTask = m.scheduler.addTask("sampling", runSampling, 0);
+  m.scheduler.addTask("led", runTask, LED_TASK_PERIOD);
+  m.scheduler.addTask("web", handleWeb, WEB_TASK_PERIOD);
+  m.scheduler.addTask("status", runTask, STATUS_TASK_PERIOD);
+  m.scheduler.addTask("wifi", runTask, WIFI_TASK_PERIOD);
+  m.scheduler.addTask("uplink", updateUplink, UPLINK_TASK_PERIOD);
+  m.scheduler.addTask("data", queueData, UPLINK_TASK_PERIOD);
+  m.scheduler.addTask("housekeeping", runTask, HOUSEKEEPING_TASK_PERIOD);
+  m.scheduler.addTask("clock sync", runTask, CLOCK_SYNC_INTERVAL);
+  
+  uint64_t end = (uint64_t)(options.hours * 3600e6);
+  while (virtualClock.now < end) {
+    // loop() of the sketch
+    m.scheduler.runDue();
+    if (lowPower) {
+      m.power.sleepUntilNextSample();
+    } else {
+      m.scheduler.idle();
+    }
+    
+    // Short gaps are spun through awake
+    uint64_t deadline = m.scheduler.getNextDeadline();
+    if (deadline > virtualClock.now) virtualClock.now = deadline;
+  }
+  
+  EnergyMonitor& energy = m.power.getEnergyMonitor();
+  uint64_t now = m.clock.now();
+  for (int i = 0; i < POWER_STATE_COUNT; i++) {
+    m.result.stateTime[i] = energy.getStateTime((PowerState)i, now);
+  }
+  m.result.totalTime = now;
+  m.result.averageCurrent = energy.getAverageCurrent(now);
+  m.result.batteryLife = energy.estimateBatteryLife(BATTERY_CAPACITY_MAH, now);
+  m.result.missedSamples = m.clock.getMissedSamples();
+  result = m.result;
+  delete monitor;
+  monitor = NULL;
+  virtualClock.enabled = false;
+}
+
+static void printResult(const char* name, const SimResult& result) {
+  printf("%-10s", name);
+  for (int i = 0; i < POWER_STATE_COUNT; i++) {
+    printf(" %8.2f%%", 100.0 * result.stateTime[i] / result.totalTime);
+  }
+  printf(" %8.2f %9.1f %7lu %8llu %9.0f\n", result.averageCurrent, result.batteryLife,
+         result.missedSamples, (unsigned long long)result.maxLateness, result.maxPendingBytes);
+}
+
+int main(int argc, char** argv) {
+  SimOptions options;
+  options.hours = atof(getOption(argc, argv, "--hours", "6"));
+  options.sampleRate = atoi(getOption(argc, argv, "--rate", "500"));
+  options.bytesPerSecond = atof(getOption(argc, argv, "--bytes-per-s", "600"));
+  options.connectMs = atol(getOption(argc, argv, "--connect", "1500"));
+  options.postMs = atol(getOption(argc, argv, "--post", "150"));
+  
+  printf("%.0f h at %d Hz, %.0f B/s uplink data, association %lu ms, %lu ms per post, %.0f mAh\n\n",
+         options.hours, options.sampleRate, options.bytesPerSecond, options.connectMs,
+         options.postMs, BATTERY_CAPACITY_MAH);
+  printf("               time per state (EnergyMonitor)                          average  battery  missed  max late  max pending\n");
+  printf("mode       cpuActive  cpuSleep  radioOff  modemSlp  radioAct      mA   life (h)  samples     (us)    (bytes)\n");
+  
+  SimResult normal, lowPower;
+  simulate(false, options, normal);
+  printResult("normal", normal);
+  simulate(true, options, lowPower);
+  printResult("low power", lowPower);
+  
+  // Data that accumulates between windows, plus one batch of rounding
+  double windowData = options.bytesPerSecond * (LOW_POWER_TX_INTERVAL + LOW_POWER_TX_WINDOW_MAX) / 1000;
+  bool drained = lowPower.pendingAfterWindow < UPLINK_MAX_BATCH_BYTES;
+  printf("\nLow power: %lu transmit windows, at most %.0f bytes left after one (%.0f accumulate per interval)\n",
+         lowPower.windows, lowPower.pendingAfterWindow, windowData);
+  printf("Battery life %.1fx normal mode\n", lowPower.batteryLife / normal.batteryLife);
+  
+  bool passed = lowPower.missedSamples == 0 && drained && lowPower.batteryLife > normal.batteryLife;
+  return passed ? 0 : 1;
+}
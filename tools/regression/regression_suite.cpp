@@ -0,0 +1,450 @@
+/*
+ * Golden-Output Regression Suite
+ * 
+ * Runs a fixed set of simulated signals (and optionally annotated
+ * recordings stored locally) through the device SignalProcessor, the
+ * same calls as handleSample(), and checks two things per scenario:
+ * 
+ *   - golden output: beats found, missed and false against the reference
+ *     annotations, samples masked, and a digest of every beat (sample,
+ *     heart rate), every per-second trend point (heart rate, confidence,
+ *     threshold, baseline, peak, signal quality) and every artifact mask
+ *     change. Any change in the processor's output changes the digest.
+ *   - performance: the processor's CPU time per sample, relative to a
+ *     fixed reference workload timed around each pass so the baseline
+ *     carries over between hosts. A scenario fails if it is more than
+ *     --tolerance slower than its baseline.
+ * 
+ * Exits with status 1 if a scenario fails either check. --write and
+ * --write-perf regenerate the files after an intended change; --trace
+ * prints the full output of one scenario to diff against an older build.
+ * 
+ * Usage: regression_suite [--golden FILE] [--perf FILE] [--tolerance F]
+ *                         [--repeat N] [--recording FILE]... [--trace NAME]
+ *                         [--write] [--write-perf] [--no-perf]
+ */
+
+#include "config/runtime_config.h"
+#include "processing/sample_rate.h"
+#include "processing/signal_processor.h"
+#include "simulation/ecg_simulator.h"
+#include "simulation/recording_loader.h"
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+static const unsigned long SCENARIO_SECONDS = 300;
+static const int REFERENCE_OPERATIONS = 4000000;
+static const int REFERENCE_RING_SIZE = 1024;       // Power of two
+static const int PERF_ATTEMPTS = 3;                // Timings of a scenario over its limit before it fails
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+static bool hasFlag(int argc, char** argv, const char* name) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return true;
+  }
+  return false;
+}
+
+// CPU time of this process, so time spent descheduled by other load on the
+// host is not counted
+static double cpuSeconds() {
+  return (double)clock() / CLOCKS_PER_SEC;
+}
+
+// Gap samples stand for lead-off, as in the analyzer
+static const int16_t GAP = -1;
+
+struct Signal {
+  std::string name;
+  int sampleRate;
+  std::vector<int16_t> samples;
+  std::vector<uint8_t> beat;             // Reference R-peak annotations
+};
+
+struct Output {
+  uint64_t references;
+  uint64_t detected;
+  uint64_t missed;
+  uint64_t falseBeats;
+  uint64_t masked;
+  uint32_t digest;
+  double nsPerSample;
+};
+
+// FNV-1a over 32-bit values
+static void addToDigest(uint32_t& digest, int32_t value) {
+  for (int i = 0; i < 4; i++) {
+    digest ^= (uint8_t)(value >> (8 * i));
+    digest *= 16777619u;
+  }
+}
+
+static void setupScenario(const char* name, ECGSimulatorParams& params) {
+  ECGSimulator::getDefaults(params);
+  params.seed = 1;
+  if (strncmp(name, "clean_", 6) == 0) {
+    params.sampleRate = atoi(name + 6);
+  } else if (strcmp(name, "hrv_500") == 0) {
+    params.hrvStd = 60;
+  } else if (strcmp(name, "tachycardia_1000") == 0) {
+    params.sampleRate = 1000;
+    params.heartRate = 150;
+  } else if (strcmp(name, "noise_mains_500") == 0) {
+    params.noiseStd = 15;
+    params.mainsAmplitude = 20;
+  } else if (strcmp(name, "wander_250") == 0) {
+    params.sampleRate = 250;
+    params.baselineWanderAmplitude = 200;
+  } else if (strcmp(name, "lead_off_500") == 0) {
+    params.leadOffPeriod = 60000;
+    params.leadOffDuration = 5000;
+  } else if (strcmp(name, "artifacts_500") == 0) {
+    params.artifactPeriod = 60000;
+    params.artifactDuration = 10000;
+  } else if (strcmp(name, "ectopic_500") == 0) {
+    params.ectopicRate = 0.05;
+    params.droppedBeatRate = 0.02;
+  }
+}
+
+static const char* const SCENARIOS[] = {
+  "clean_250", "clean_500", "clean_1000", "hrv_500", "tachycardia_1000",
+  "noise_mains_500", "wander_250", "lead_off_500", "artifacts_500", "ectopic_500"
+};
+
+static void simulate(const char* name, Signal& signal) {
+  ECGSimulatorParams params;
+  setupScenario(name, params);
+  ECGSimulator simulator;
+  simulator.begin(params);
+  
+  signal.name = name;
+  signal.sampleRate = params.sampleRate;
+  size_t total = SCENARIO_SECONDS * params.sampleRate;
+  signal.samples.resize(total);
+  signal.beat.resize(total);
+  for (size_t i = 0; i < total; i++) {
+    int value = simulator.nextSample();
+    signal.samples[i] = simulator.areLeadsConnected() ? (int16_t)value : GAP;
+    signal.beat[i] = simulator.isBeatOnset();
+  }
+}
+
+static bool loadRecording(const char* path, Signal& signal) {
+  RecordingLoader loader;
+  if (!loader.open(path)) {
+    fprintf(stderr, "Cannot open recording %s\n", path);
+    return false;
+  }
+  
+  const char* base = strrchr(path, '/');
+  signal.name = std::string("recording:") + (base != NULL ? base + 1 : path);
+  signal.sampleRate = loader.getSampleRate();
+  int value;
+  while (loader.nextSample(value)) {
+    signal.samples.push_back((int16_t)constrain(value, 0, ADC_MAX_VALUE));
+    signal.beat.push_back(loader.isBeatAnnotated());
+  }
+  return true;
+}
+
+static void prepare(SignalProcessor& processor, int sampleRate) {
+  ECGSettings settings;
+  RuntimeConfig::getDefaults(settings);
+  settings.sampleRate = sampleRate;
+  const RateProfile* profile = findRateProfile(sampleRate);
+  if (profile != NULL) settings.movingAverageSize = profile->movingAverageSize;
+  processor.begin();
+  processor.requestSettings(settings);
+}
+
+// One pass with the same calls as handleSample(); trace receives every
+// digested value when set
+static void run(const Signal& signal, Output& output, std::vector<uint8_t>* detected, FILE* trace) {
+  SignalProcessor processor;
+  prepare(processor, signal.sampleRate);
+  
+  output.digest = 2166136261u;
+  output.masked = 0;
+  size_t total = signal.samples.size();
+  for (size_t i = 0; i < total; i++) {
+    uint8_t previousFlags = processor.getArtifactFlags();
+    if (signal.samples[i] == GAP) {
+      processor.skipSample();
+    } else {
+      processor.processSample(signal.samples[i]);
+      if (processor.isHeartbeatDetected()) {
+        if (detected != NULL) (*detected)[i] = 1;
+        addToDigest(output.digest, (int32_t)i);
+        addToDigest(output.digest, processor.getHeartRate());
+        if (trace != NULL) fprintf(trace, "beat %zu hr %d\n", i, processor.getHeartRate());
+      }
+    }
+    
+    uint8_t flags = processor.getArtifactFlags();
+    if (flags != 0) output.masked++;
+    if (flags != previousFlags) {
+      addToDigest(output.digest, (int32_t)i);
+      addToDigest(output.digest, flags);
+      if (trace != NULL) fprintf(trace, "mask %zu flags %d\n", i, flags);
+    }
+    
+    if ((i + 1) % signal.sampleRate == 0) {
+      int values[] = { processor.getHeartRate(), processor.getHeartRateConfidence(),
+                       processor.getThreshold(), processor.getBaseline(),
+                       processor.getPeakAmplitude(), processor.getSignalQuality() };
+      for (size_t v = 0; v < sizeof(values) / sizeof(values[0]); v++) {
+        addToDigest(output.digest, values[v]);
+      }
+      if (trace != NULL) {
+        fprintf(trace, "second %zu hr %d confidence %d threshold %d baseline %d peak %d quality %d\n",
+                (i + 1) / signal.sampleRate, values[0], values[1], values[2], values[3], values[4],
+                values[5]);
+      }
+    }
+  }
+}
+
+static void evaluate(const Signal& signal, const std::vector<uint8_t>& detected, Output& output) {
+  // Match each reference R-peak to the first detection within 100 ms of it
+  size_t total = signal.samples.size();
+  size_t tolerance = signal.sampleRate / 10;
+  std::vector<uint8_t> used(total, 0);
+  output.references = output.detected = output.missed = output.falseBeats = 0;
+  for (size_t i = 0; i < total; i++) {
+    if (detected[i]) output.detected++;
+    if (!signal.beat[i] || signal.samples[i] == GAP) continue;
+    output.references++;
+    bool found = false;
+    for (size_t j = i > tolerance ? i - tolerance : 0; j <= i + tolerance && j < total; j++) {
+      if (detected[j] && !used[j]) {
+        used[j] = 1;
+        found = true;
+        break;
+      }
+    }
+    // The first beat has no interval to report
+    if (!found && output.references > 1) output.missed++;
+  }
+  // The R-peak of a detection in the last 100 ms may lie past the end
+  for (size_t i = 0; i + tolerance < total; i++) {
+    if (detected[i] && !used[i]) output.falseBeats++;
+  }
+}
+
+// Fixed workload shaped like the processor (ring buffer, running sum,
+// smoothing, data-dependent branches); its time scales scenario costs
+// between hosts and follows the processor under cache and memory contention
+static double referenceNs() {
+  static int16_t ring[REFERENCE_RING_SIZE];
+  volatile int sink = 0;
+  uint32_t state = 2463534242u;
+  int32_t sum = 0;
+  float smoothed = 0;
+  int crossings = 0;
+  double started = cpuSeconds();
+  for (int i = 0; i < REFERENCE_OPERATIONS; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    int index = i & (REFERENCE_RING_SIZE - 1);
+    int value = (int)(state >> 20);
+    sum += value - ring[index];
+    ring[index] = (int16_t)value;
+    smoothed += 0.01f * ((float)sum / REFERENCE_RING_SIZE - smoothed);
+    if (value > smoothed) crossings++;
+  }
+  sink = crossings;
+  (void)sink;
+  return (cpuSeconds() - started) * 1e9 / REFERENCE_OPERATIONS;
+}
+
+// Times --repeat passes, each against the reference just before and
+// after it so a change in host load hits both, and keeps the least
+// disturbed pass in relative and nsPerSample
+static void measure(const Signal& signal, int repeat, double& relative, double& nsPerSample) {
+  double before = referenceNs();
+  for (int r = 0; r < repeat; r++) {
+    double started = cpuSeconds();
+    Output timed;
+    run(signal, timed, NULL, NULL);
+    double cost = (cpuSeconds() - started) * 1e9 / signal.samples.size();
+    double after = referenceNs();
+    double ratio = cost / ((before + after) / 2);
+    if (ratio < relative) {
+      relative = ratio;
+      nsPerSample = cost;
+    }
+    before = after;
+  }
+}
+
+static std::string formatGolden(const Signal& signal, const Output& output) {
+  char line[256];
+  snprintf(line, sizeof(line), "%s rate %d beats %llu detected %llu missed %llu false %llu masked %llu digest %08x",
+           signal.name.c_str(), signal.sampleRate, (unsigned long long)output.references,
+           (unsigned long long)output.detected, (unsigned long long)output.missed,
+           (unsigned long long)output.falseBeats, (unsigned long long)output.masked, output.digest);
+  return line;
+}
+
+// Files of "name rest-of-line", '#' starts a comment
+static std::map<std::string, std::string> readEntries(const char* path) {
+  std::map<std::string, std::string> entries;
+  FILE* file = fopen(path, "r");
+  if (file == NULL) return entries;
+  char line[512];
+  while (fgets(line, sizeof(line), file) != NULL) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '#' || line[0] == '\0') continue;
+    const char* space = strchr(line, ' ');
+    if (space == NULL) continue;
+    entries[std::string(line, space - line)] = line;
+  }
+  fclose(file);
+  return entries;
+}
+
+int main(int argc, char** argv) {
+  const char* goldenPath = getOption(argc, argv, "--golden", "golden.txt");
+  const char* perfPath = getOption(argc, argv, "--perf", "perf_baseline.txt");
+  double tolerance = atof(getOption(argc, argv, "--tolerance", "0.15"));
+  int repeat = std::max(1, atoi(getOption(argc, argv, "--repeat", "5")));
+  const char* traceName = getOption(argc, argv, "--trace", NULL);
+  bool writeGolden = hasFlag(argc, argv, "--write");
+  bool writePerf = hasFlag(argc, argv, "--write-perf");
+  bool checkPerf = !hasFlag(argc, argv, "--no-perf") || writePerf;
+  
+  std::vector<Signal> signals;
+  for (size_t s = 0; s < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); s++) {
+    signals.push_back(Signal());
+    simulate(SCENARIOS[s], signals.back());
+  }
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--recording") != 0) continue;
+    signals.push_back(Signal());
+    if (!loadRecording(argv[i + 1], signals.back())) return 1;
+  }
+  
+  if (traceName != NULL) {
+    for (size_t s = 0; s < signals.size(); s++) {
+      if (signals[s].name != traceName) continue;
+      Output output;
+      run(signals[s], output, NULL, stdout);
+      return 0;
+    }
+    fprintf(stderr, "No scenario %s\n", traceName);
+    return 1;
+  }
+  
+  std::map<std::string, std::string> golden = readEntries(goldenPath);
+  std::map<std::string, std::string> baseline = readEntries(perfPath);
+  
+  std::vector<std::string> goldenLines;
+  std::vector<Output> outputs(signals.size());
+  std::vector<const char*> goldenResults(signals.size());
+  std::vector<double> relative(signals.size(), 0);
+  std::vector<double> allowed(signals.size(), 0);
+  int failures = 0;
+  for (size_t s = 0; s < signals.size(); s++) {
+    const Signal& signal = signals[s];
+    Output& output = outputs[s];
+    std::vector<uint8_t> detected(signal.samples.size(), 0);
+    run(signal, output, &detected, NULL);
+    evaluate(signal, detected, output);
+    
+    std::string line = formatGolden(signal, output);
+    goldenLines.push_back(line);
+    goldenResults[s] = "new";
+    if (golden.count(signal.name) > 0) {
+      goldenResults[s] = golden[signal.name] == line ? "ok" : "CHANGED";
+    }
+    if (!writeGolden && strcmp(goldenResults[s], "ok") != 0) failures++;
+    
+    output.nsPerSample = 0;
+    if (baseline.count(signal.name) > 0) {
+      allowed[s] = atof(baseline[signal.name].c_str() + signal.name.size()) * (1 + tolerance);
+    }
+    if (checkPerf) {
+      relative[s] = 1e30;
+      measure(signal, repeat, relative[s], output.nsPerSample);
+    }
+  }
+  
+  // Load on the host comes in bursts of a few seconds, so a scenario over
+  // its limit is timed again after the others, when a burst has passed
+  for (int attempt = 1; checkPerf && !writePerf && attempt < PERF_ATTEMPTS; attempt++) {
+    for (size_t s = 0; s < signals.size(); s++) {
+      if (allowed[s] > 0 && relative[s] > allowed[s]) {
+        measure(signals[s], repeat, relative[s], outputs[s].nsPerSample);
+      }
+    }
+  }
+  
+  std::vector<std::string> perfLines;
+  printf("scenario             rate  beats  missed  false  masked  digest    golden   ns/sample  relative  baseline  perf\n");
+  for (size_t s = 0; s < signals.size(); s++) {
+    const Signal& signal = signals[s];
+    const Output& output = outputs[s];
+    const char* perfResult = "-";
+    if (checkPerf) {
+      char perfLine[128];
+      snprintf(perfLine, sizeof(perfLine), "%s %.2f", signal.name.c_str(), relative[s]);
+      perfLines.push_back(perfLine);
+      
+      perfResult = "new";
+      if (allowed[s] > 0) perfResult = relative[s] <= allowed[s] ? "ok" : "SLOWER";
+      if (!writePerf && strcmp(perfResult, "ok") != 0) failures++;
+    }
+    
+    std::string baselineValue = "-";
+    if (baseline.count(signal.name) > 0) baselineValue = baseline[signal.name].substr(signal.name.size() + 1);
+    printf("%-20s %4d %6llu %7llu %6llu %7llu  %08x  %-7s  %9.1f  %8.2f  %8s  %s\n",
+           signal.name.c_str(), signal.sampleRate, (unsigned long long)output.references,
+           (unsigned long long)output.missed, (unsigned long long)output.falseBeats,
+           (unsigned long long)output.masked, output.digest, goldenResults[s], output.nsPerSample,
+           checkPerf ? relative[s] : 0.0, baselineValue.c_str(), perfResult);
+  }
+  if (checkPerf) {
+    printf("\nrelative: ns/sample over ns per reference operation (tolerance %.0f%%)\n",
+           tolerance * 100);
+  }
+  
+  if (writeGolden) {
+    FILE* file = fopen(goldenPath, "w");
+    if (file == NULL) {
+      fprintf(stderr, "Cannot write %s\n", goldenPath);
+      return 1;
+    }
+    fprintf(file, "# Written by regression_suite --write; one line per scenario\n");
+    for (size_t i = 0; i < goldenLines.size(); i++) fprintf(file, "%s\n", goldenLines[i].c_str());
+    fclose(file);
+    printf("Wrote %s\n", goldenPath);
+  }
+  if (writePerf) {
+    FILE* file = fopen(perfPath, "w");
+    if (file == NULL) {
+      fprintf(stderr, "Cannot write %s\n", perfPath);
+      return 1;
+    }
+    fprintf(file, "# Written by regression_suite --write-perf; cost per sample over the reference operation\n");
+    for (size_t i = 0; i < perfLines.size(); i++) fprintf(file, "%s\n", perfLines[i].c_str());
+    fclose(file);
+    printf("Wrote %s\n", perfPath);
+  }
+  
+  if (failures > 0) printf("\n%d check(s) failed\n", failures);
+  return failures > 0 ? 1 : 0;
+}
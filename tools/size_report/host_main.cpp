@@ -0,0 +1,24 @@
+/*
+ * Host Sketch Runner
+ * 
+ * Links an Arduino sketch against the host shim (tools/host) so its code
+ * and static memory can be measured: setup() once, then loop() the given
+ * number of times (default 0).
+ * 
+ * Usage: <sketch> [LOOPS]
+ */
+
+#include <stdlib.h>
+
+void setup();
+void loop();
+
+int main(int argc, char** argv) {
+  long loops = argc > 1 ? atol(argv[1]) : 0;
+  
+  setup();
+  for (long i = 0; i < loops; i++) {
+    loop();
+  }
+  return 0;
+}
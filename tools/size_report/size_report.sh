@@ -0,0 +1,111 @@
+#!/bin/sh
+#
+# Flash and RAM per monitor configuration
+#
+# Builds the serial-only monitor (examples/simple_ecg_monitor), the full
+# monitor (ecg_monitor.ino) and optionally a baseline sketch from git, and
+# prints code and static RAM for each. The serial-only monitor is also
+# built without each signal path stage of src/config/features.h and
+# without all three (serial-minimal).
+#
+#   ESP32 (default): arduino-cli with the esp32 core and ArduinoJson
+#   installed; numbers are the ones the IDE reports.
+#   --host: g++ against tools/host with unused sections dropped, like the
+#   ESP32 link. Only the serial-only build links on the host; the numbers
+#   are x86-64 but compare like for like.
+#
+# Usage: size_report.sh [--host] [--fqbn FQBN] [--baseline REV:PATH.ino]
+#   e.g. size_report.sh --host --baseline HEAD~1:examples/simple_ecg_monitor.ino
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+MODE=esp32
+FQBN=esp32:esp32:esp32
+BASELINE=
+
+while [ $# -gt 0 ]; do
+  case "$1" in
+    --host) MODE=host ;;
+    --fqbn) FQBN=$2; shift ;;
+    --baseline) BASELINE=$2; shift ;;
+    *) echo "ERROR: unknown option $1" >&2; exit 1 ;;
+  esac
+  shift
+done
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Sketch folders (arduino-cli wants the folder named like the sketch)
+mkdir -p "$WORK/simple_ecg_monitor" "$WORK/ecg_monitor"
+cp "$ROOT/examples/simple_ecg_monitor/simple_ecg_monitor.ino" "$WORK/simple_ecg_monitor/"
+cp "$ROOT/ecg_monitor.ino" "$WORK/ecg_monitor/"
+cp -r "$ROOT/src" "$WORK/ecg_monitor/"
+if [ -n "$BASELINE" ]; then
+  mkdir -p "$WORK/baseline"
+  git -C "$ROOT" show "$BASELINE" > "$WORK/baseline/baseline.ino"
+fi
+
+printf "%-22s %10s %10s\n" "configuration" "code" "static RAM"
+
+# Signal path stages left out per serial-only configuration
+NO_THRESHOLD="-DECG_FEATURE_ADAPTIVE_THRESHOLD=0"
+NO_ARTIFACTS="-DECG_FEATURE_ARTIFACT_DETECTION=0"
+NO_MEDIAN="-DECG_FEATURE_MEDIAN_HEART_RATE=0"
+
+if [ "$MODE" = esp32 ]; then
+  esp32_size() {
+    # "Sketch uses N bytes ..." / "Global variables use N bytes ..."
+    arduino-cli compile --fqbn "$FQBN" --library "$ROOT" \
+      --build-property "compiler.cpp.extra_flags=$3" "$2" > "$WORK/log" 2>&1 ||
+      { cat "$WORK/log" >&2; echo "ERROR: $1 does not build" >&2; exit 1; }
+    code=$(sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p' "$WORK/log")
+    ram=$(sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p' "$WORK/log")
+    printf "%-22s %10s %10s\n" "$1" "$code" "$ram"
+  }
+  [ -n "$BASELINE" ] && esp32_size baseline "$WORK/baseline"
+  esp32_size serial-only "$WORK/simple_ecg_monitor"
+  esp32_size "  no adaptive thresh." "$WORK/simple_ecg_monitor" "$NO_THRESHOLD"
+  esp32_size "  no artifact detect." "$WORK/simple_ecg_monitor" "$NO_ARTIFACTS"
+  esp32_size "  no median HR" "$WORK/simple_ecg_monitor" "$NO_MEDIAN"
+  esp32_size serial-minimal "$WORK/simple_ecg_monitor" "$NO_THRESHOLD $NO_ARTIFACTS $NO_MEDIAN"
+  esp32_size full "$WORK/ecg_monitor"
+  exit 0
+fi
+
+# Host: everything the serial-only build can link; the linker keeps what it uses
+SOURCES=$(cd "$ROOT" && ls src/sensors/*.cpp src/processing/*.cpp src/dsp/*.cpp \
+  src/config/runtime_config.cpp src/simulation/ecg_simulator.cpp src/telemetry/*.cpp \
+  src/monitor/*.cpp | sed "s#^#$ROOT/#")
+CXXFLAGS="-Os -std=c++17 -ffunction-sections -fdata-sections -Wl,--gc-sections"
+
+host_size() {
+  # Function prototypes first, as the Arduino build generates them
+  sed -n 's/^\([A-Za-z_][A-Za-z0-9_ <>:*&]* [*&]*[A-Za-z_][A-Za-z0-9_]*([^;{]*)\) *{ *$/\1;/p' "$2" \
+    > "$WORK/sketch.cpp"
+  cat "$2" >> "$WORK/sketch.cpp"
+  g++ $CXXFLAGS $4 -I"$ROOT/tools/host" -I"$ROOT/src" -o "$WORK/sketch" \
+    -include Arduino.h "$WORK/sketch.cpp" "$ROOT/tools/size_report/host_main.cpp" $3 ||
+    { echo "ERROR: $1 does not build" >&2; exit 1; }
+  # text / data / bss of the host runtime alone, subtracted below
+  set -- "$1" $(size "$WORK/sketch" | tail -1)
+  printf "%-22s %10d %10d\n" "$1" $(($2 - BASE_TEXT)) $(($3 + $4 - BASE_RAM))
+}
+
+# Empty sketch: C++ runtime and shim, not part of either configuration
+printf 'void setup() {}\nvoid loop() {}\n' > "$WORK/empty.ino"
+g++ $CXXFLAGS -I"$ROOT/tools/host" -o "$WORK/empty" -x c++ -include Arduino.h "$WORK/empty.ino" \
+  -x none "$ROOT/tools/size_report/host_main.cpp"
+set -- $(size "$WORK/empty" | tail -1)
+BASE_TEXT=$1
+BASE_RAM=$(($2 + $3))
+
+[ -n "$BASELINE" ] && host_size baseline "$WORK/baseline/baseline.ino" ""
+SERIAL_SKETCH="$WORK/simple_ecg_monitor/simple_ecg_monitor.ino"
+host_size serial-only "$SERIAL_SKETCH" "$SOURCES"
+host_size "  no adaptive thresh." "$SERIAL_SKETCH" "$SOURCES" "$NO_THRESHOLD"
+host_size "  no artifact detect." "$SERIAL_SKETCH" "$SOURCES" "$NO_ARTIFACTS"
+host_size "  no median HR" "$SERIAL_SKETCH" "$SOURCES" "$NO_MEDIAN"
+host_size serial-minimal "$SERIAL_SKETCH" "$SOURCES" "$NO_THRESHOLD $NO_ARTIFACTS $NO_MEDIAN"
+echo "full                   (needs the ESP32 core; run without --host)"
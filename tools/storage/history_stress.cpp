@@ -0,0 +1,226 @@
+/*
+ * Sample History Stress Test
+ * 
+ * Runs the device SampleHistory with the access pattern of the monitor:
+ * one writer appending samples (with a missed sample every GAP_PERIOD
+ * sequences) and --readers threads streaming snapshots like the /waveform
+ * handler, a chunk at a time with isValid() before a chunk is accepted.
+ * Every sample value is a function of its sequence number, so a reader can
+ * check each accepted chunk against what the writer stored.
+ * 
+ * Three phases start just below the 32-bit sequence wrap:
+ * 
+ *   - wrap: single-threaded appends across the wrap, with the whole history
+ *     and random ranges checked after every few appends
+ *   - long run: sequence jumps that add up to more than 2^32 samples, after
+ *     which the oldest sequence must still be one lap behind the newest
+ *   - concurrent: the writer at full speed against the readers; lapped
+ *     chunks must be reported as overruns, never accepted with wrong data
+ * 
+ * --capacity is deliberately not a power of two by default; the history
+ * rounds it. Exits with status 1 on any wrong sample or range.
+ * 
+ * Usage: history_stress [--capacity N] [--readers N] [--samples N]
+ *                       [--seed N]
+ */
+
+#include "storage/sample_history.h"
+#include "config/config.h"
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+static const uint32_t GAP_PERIOD = 997;
+static const uint32_t WRAP_MARGIN = 100000;   // Phases start this far below the wrap
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+static bool isSkipped(uint32_t sequence) {
+  return sequence % GAP_PERIOD == 0;
+}
+
+static int16_t expectedValue(uint32_t sequence) {
+  return isSkipped(sequence) ? SAMPLE_GAP : (int16_t)(sequence & 0x3FFF);
+}
+
+static void appendUpTo(SampleHistory& history, uint32_t sequence) {
+  if (!isSkipped(sequence)) {
+    history.append(expectedValue(sequence), sequence);
+  }
+}
+
+// Checks count samples of a snapshot from offset on; returns wrong samples
+static unsigned long checkSamples(const SampleSnapshot& snapshot, size_t offset, size_t count) {
+  unsigned long wrong = 0;
+  for (size_t i = offset; i < offset + count; i++) {
+    const SampleSpan& first = snapshot.segments[0];
+    int16_t value = i < first.count ? first.data[i] : snapshot.segments[1].data[i - first.count];
+    if (value != expectedValue(snapshot.firstSequence + i)) wrong++;
+  }
+  return wrong;
+}
+
+static unsigned long checkRange(SampleHistory& history, uint32_t from, uint32_t to) {
+  SampleSnapshot snapshot;
+  if (!history.snapshot(from, to, snapshot)) return 1;
+  if (snapshot.segments[0].count + snapshot.segments[1].count != snapshot.count) return 1;
+  return checkSamples(snapshot, 0, snapshot.count);
+}
+
+static bool runWrapPhase(size_t capacity, unsigned int seed) {
+  SampleHistory history;
+  std::vector<int16_t> storage(capacity);
+  history.begin(storage.data(), capacity);
+  size_t ringSize = history.getCapacity();
+  
+  uint32_t start = 0u - (uint32_t)ringSize * 2;
+  uint32_t end = (uint32_t)ringSize * 2;
+  unsigned long checks = 0;
+  unsigned long wrong = 0;
+  
+  for (uint32_t sequence = start; sequence != end; sequence++) {
+    appendUpTo(history, sequence);
+    if (sequence % 97 != 0) continue;
+    
+    uint32_t oldest = history.getOldestSequence();
+    uint32_t next = history.getNextSequence();
+    wrong += checkRange(history, oldest, next);
+    
+    uint32_t from = oldest + rand_r(&seed) % (next - oldest);
+    uint32_t to = from + 1 + rand_r(&seed) % (next - from);
+    wrong += checkRange(history, from, to);
+    checks += 2;
+  }
+  
+  printf("wrap        capacity %zu (asked %zu), sequences %u..%u, %lu ranges checked, %lu wrong samples\n",
+         ringSize, capacity, start, end, checks, wrong);
+  return wrong == 0;
+}
+
+static bool runLongRunPhase(size_t capacity) {
+  SampleHistory history;
+  std::vector<int16_t> storage(capacity);
+  history.begin(storage.data(), capacity);
+  uint32_t ringSize = history.getCapacity();
+  
+  // Half a lap, then two jumps (each fills at most one lap of gaps) that
+  // end just over 2^32 sequences later, so sequence - first is small again
+  uint32_t sequence = 0;
+  for (; sequence < ringSize / 2; sequence++) appendUpTo(history, sequence);
+  for (int i = 0; i < 2; i++) {
+    sequence += 0x7FFFFFFF;
+    history.append(expectedValue(sequence), sequence);
+  }
+  sequence++;
+  history.append(expectedValue(sequence), sequence);
+  
+  // The jumps left gaps, so only the range is checked
+  uint32_t next = history.getNextSequence();
+  uint32_t oldest = history.getOldestSequence();
+  SampleSnapshot snapshot;
+  bool passed = next == sequence + 1 && oldest == next - ringSize + 1 &&
+                history.snapshot(next - ringSize * 2, next, snapshot) && snapshot.firstSequence == oldest &&
+                snapshot.count == ringSize - 1;
+  
+  printf("long run    2^32 + %u sequences, oldest %u, expected %u\n",
+         ringSize / 2, oldest, next - ringSize + 1);
+  return passed;
+}
+
+struct ReaderStats {
+  unsigned long snapshots = 0;
+  unsigned long overruns = 0;
+  unsigned long samples = 0;
+  unsigned long wrong = 0;
+};
+
+static void runReader(SampleHistory& history, std::atomic<bool>& done, unsigned int seed,
+                      ReaderStats& stats) {
+  while (!done.load()) {
+    uint32_t next = history.getNextSequence();
+    uint32_t length = 1 + rand_r(&seed) % history.getCapacity();
+    
+    SampleSnapshot snapshot;
+    if (!history.snapshot(next - length, next, snapshot)) continue;
+    stats.snapshots++;
+    
+    // Copy a chunk, then accept it only if the writer has not lapped it
+    int16_t chunk[WAVEFORM_CHUNK_SAMPLES];
+    for (size_t offset = 0; offset < snapshot.count; offset += WAVEFORM_CHUNK_SAMPLES) {
+      size_t count = snapshot.count - offset < (size_t)WAVEFORM_CHUNK_SAMPLES ?
+                     snapshot.count - offset : WAVEFORM_CHUNK_SAMPLES;
+      for (size_t i = 0; i < count; i++) {
+        size_t index = offset + i;
+        const SampleSpan& first = snapshot.segments[0];
+        chunk[i] = index < first.count ? first.data[index] : snapshot.segments[1].data[index - first.count];
+      }
+      
+      if (!history.isValid(snapshot.firstSequence + offset)) {
+        stats.overruns++;
+        break;
+      }
+      
+      for (size_t i = 0; i < count; i++) {
+        if (chunk[i] != expectedValue(snapshot.firstSequence + offset + i)) stats.wrong++;
+      }
+      stats.samples += count;
+    }
+  }
+}
+
+static bool runConcurrentPhase(size_t capacity, int readerCount, unsigned long samples, unsigned int seed) {
+  SampleHistory history;
+  std::vector<int16_t> storage(capacity);
+  history.begin(storage.data(), capacity);
+  
+  std::atomic<bool> done(false);
+  std::vector<ReaderStats> stats(readerCount);
+  std::vector<std::thread> readers;
+  
+  uint32_t start = 0u - WRAP_MARGIN;
+  history.append(expectedValue(start), start);
+  for (int i = 0; i < readerCount; i++) {
+    readers.emplace_back(runReader, std::ref(history), std::ref(done), seed + i, std::ref(stats[i]));
+  }
+  
+  for (unsigned long i = 1; i < samples; i++) {
+    appendUpTo(history, start + (uint32_t)i);
+  }
+  done.store(true);
+  for (std::thread& reader : readers) reader.join();
+  
+  ReaderStats total;
+  for (const ReaderStats& s : stats) {
+    total.snapshots += s.snapshots;
+    total.overruns += s.overruns;
+    total.samples += s.samples;
+    total.wrong += s.wrong;
+  }
+  
+  printf("concurrent  %d readers, %lu samples written across the wrap\n", readerCount, samples);
+  printf("            %lu snapshots, %lu samples accepted, %lu overruns, %lu wrong samples\n",
+         total.snapshots, total.samples, total.overruns, total.wrong);
+  return total.wrong == 0 && total.samples > 0;
+}
+
+int main(int argc, char** argv) {
+  size_t capacity = atol(getOption(argc, argv, "--capacity", "30000"));
+  int readerCount = atoi(getOption(argc, argv, "--readers", "3"));
+  unsigned long samples = atol(getOption(argc, argv, "--samples", "50000000"));
+  unsigned int seed = atoi(getOption(argc, argv, "--seed", "1"));
+  
+  bool passed = runWrapPhase(capacity, seed);
+  passed = runLongRunPhase(capacity) && passed;
+  passed = runConcurrentPhase(capacity, readerCount, samples, seed) && passed;
+  
+  printf("%s\n", passed ? "PASS" : "FAIL");
+  return passed ? 0 : 1;
+}
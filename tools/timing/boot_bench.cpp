@@ -0,0 +1,208 @@
+/*
+ * Boot Benchmark
+ * 
+ * Replays the monitor's boot sequence on the host's virtual clock with a
+ * cost model for each step and reports when every boot phase is reached
+ * (the same BootProfile timestamps /metrics serves on the device):
+ * 
+ *   - connect in setup: the original boot, where the web server connected
+ *     to WiFi before loop() took the first sample
+ *   - background connect: WiFi connects from a scheduler task, but the
+ *     outbox is mounted before sampling starts
+ *   - fast boot: the first sample right after the sensor is set up, then
+ *     the outbox and WiFi in the background, joining the cached AP
+ * 
+ * Exits with status 1 if the fast boot misses BOOT_FIRST_SAMPLE_TARGET_US.
+ * Costs are estimates for an ESP32 at 240 MHz (us).
+ * 
+ * Usage: boot_bench [--rate HZ]
+ */
+
+#include "sensors/sample_clock.h"
+#include "telemetry/boot_profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Cost model (us)
+static const uint64_t SERIAL_COST = 200;
+static const uint64_t CONFIG_COST = 8000;           // NVS init and settings blob
+static const uint64_t SENSOR_COST = 400;            // ADC, lead-off pins, processor, history
+static const uint64_t STORAGE_COST = 25000;         // LittleFS mount
+static const uint64_t OUTBOX_COST = 10000;          // Outbox recovery
+static const uint64_t WIFI_DRIVER_COST = 80000;     // WiFi.mode(): driver and PHY start
+static const uint64_t WIFI_SCAN_CONNECT = 2200000;  // Scan for the SSID, join, DHCP
+static const uint64_t WIFI_CACHED_CONNECT = 450000; // Join channel/BSSID directly, DHCP
+static const uint64_t SERVER_COST = 2000;
+static const uint64_t WINDOW = 3000000;             // Samples lost are counted over this
+
+static const char* const PHASE_ORDER[] = {
+  BOOT_PHASE_SETUP, BOOT_PHASE_CONFIG, BOOT_PHASE_SENSOR, BOOT_PHASE_STORAGE,
+  BOOT_PHASE_FIRST_SAMPLE, BOOT_PHASE_SETUP_DONE, BOOT_PHASE_WIFI,
+};
+static const int PHASE_COUNT = sizeof(PHASE_ORDER) / sizeof(PHASE_ORDER[0]);
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+enum BootSequence {
+  BOOT_CONNECT_IN_SETUP,
+  BOOT_BACKGROUND_CONNECT,
+  BOOT_FAST
+};
+
+struct BootRun {
+  BootProfile profile;
+  unsigned long lostSamples;       // Not recorded in the first WINDOW since app start
+};
+
+// Blocking work after sampling started: the sample clock catches up
+// afterwards and skips what is more than MAX_SAMPLE_LATENESS behind
+static void spend(SampleClock* clock, uint64_t cost) {
+  virtualClock.advance(cost);
+  while (clock != NULL && clock->isSampleDue()) clock->takeSample();
+}
+
+// Waiting that does not block (e.g. for the AP): samples stay on time
+static void elapse(SampleClock* clock, uint64_t duration) {
+  uint64_t end = virtualClock.now + duration;
+  while (clock != NULL && clock->getNextDeadline() <= end) {
+    virtualClock.now = clock->getNextDeadline();
+    clock->takeSample();
+  }
+  virtualClock.now = end;
+}
+
+static void runBoot(BootSequence sequence, int sampleRate, bool apReachable, bool apCached,
+                    BootRun& run) {
+  virtualClock.now = 0;
+  BootProfile& profile = run.profile;
+  profile = BootProfile();
+  SampleClock clock;
+  SampleClock* sampling = NULL;
+  uint64_t connectLatency = apCached && sequence == BOOT_FAST ? WIFI_CACHED_CONNECT : WIFI_SCAN_CONNECT;
+  
+  profile.mark(BOOT_PHASE_SETUP);
+  spend(sampling, SERIAL_COST);
+  spend(sampling, CONFIG_COST);
+  profile.mark(BOOT_PHASE_CONFIG);
+  clock.begin(sampleRate);
+  spend(sampling, SENSOR_COST);
+  profile.mark(BOOT_PHASE_SENSOR);
+  
+  if (sequence != BOOT_FAST) {
+    spend(sampling, STORAGE_COST + OUTBOX_COST);
+    profile.mark(BOOT_PHASE_STORAGE);
+  }
+  
+  if (sequence == BOOT_CONNECT_IN_SETUP) {
+    // ECGWebServer::begin() waited for the connection (up to WIFI_TIMEOUT)
+    spend(sampling, WIFI_DRIVER_COST);
+    if (apReachable) {
+      spend(sampling, connectLatency);
+      profile.mark(BOOT_PHASE_WIFI);
+      spend(sampling, SERVER_COST);
+    } else {
+      spend(sampling, WIFI_TIMEOUT * 1000ULL);
+    }
+  }
+  
+  // First sample; from here on blocking work delays (or skips) samples
+  clock.begin(sampleRate);
+  clock.takeSample();
+  sampling = &clock;
+  profile.mark(BOOT_PHASE_FIRST_SAMPLE);
+  profile.mark(BOOT_PHASE_SETUP_DONE);
+  
+  if (sequence == BOOT_FAST) {
+    spend(sampling, STORAGE_COST + OUTBOX_COST);
+    profile.mark(BOOT_PHASE_STORAGE);
+  }
+  
+  if (sequence != BOOT_CONNECT_IN_SETUP) {
+    // Driver start blocks the WiFi task; the connection then completes on its own
+    spend(sampling, WIFI_DRIVER_COST);
+    if (apReachable) {
+      elapse(sampling, connectLatency);
+      profile.mark(BOOT_PHASE_WIFI);
+      spend(sampling, SERVER_COST);
+    }
+  }
+  
+  // Samples due since app start that were never taken (before the first
+  // one, or skipped by the sample clock)
+  if (virtualClock.now < WINDOW) elapse(sampling, WINDOW - virtualClock.now);
+  uint32_t expected = (uint32_t)(WINDOW * sampleRate / 1000000);
+  uint32_t taken = clock.getSequence() - clock.getMissedSamples();
+  run.lostSamples = expected > taken ? expected - taken : 0;
+}
+
+static const char* formatPhase(BootProfile& profile, const char* phase, char* text, size_t size) {
+  uint32_t time;
+  if (!profile.getTime(phase, time)) return "-";
+  snprintf(text, size, "%.1f", time / 1000.0);
+  return text;
+}
+
+int main(int argc, char** argv) {
+  int sampleRate = atoi(getOption(argc, argv, "--rate", "500"));
+  virtualClock.enabled = true;
+  
+  static const char* const NAMES[] = { "connect in setup", "background connect", "fast boot" };
+  static BootRun runs[3];
+  for (int i = 0; i < 3; i++) {
+    runBoot((BootSequence)i, sampleRate, true, true, runs[i]);
+  }
+  
+  printf("Boot phases (ms since app start), AP reachable and cached, %d Hz\n\n", sampleRate);
+  printf("%-16s %18s %20s %12s\n", "phase", NAMES[0], NAMES[1], NAMES[2]);
+  for (int p = 0; p < PHASE_COUNT; p++) {
+    char text[3][16];
+    printf("%-16s %18s %20s %12s\n", PHASE_ORDER[p],
+           formatPhase(runs[0].profile, PHASE_ORDER[p], text[0], sizeof(text[0])),
+           formatPhase(runs[1].profile, PHASE_ORDER[p], text[1], sizeof(text[1])),
+           formatPhase(runs[2].profile, PHASE_ORDER[p], text[2], sizeof(text[2])));
+  }
+  printf("%-16s %18lu %20lu %12lu\n", "lost in first 3 s", runs[0].lostSamples,
+         runs[1].lostSamples, runs[2].lostSamples);
+  
+  struct Case {
+    const char* name;
+    bool apReachable;
+    bool apCached;
+  };
+  static const Case CASES[] = {
+    { "AP cached", true, true },
+    { "first boot (no cache)", true, false },
+    { "AP unreachable", false, false },
+  };
+  
+  printf("\nTime to first sample / WiFi connected (ms)\n\n");
+  printf("%-22s %18s %20s %16s\n", "case", NAMES[0], NAMES[1], NAMES[2]);
+  uint32_t worstFirstSample = 0;
+  for (size_t c = 0; c < sizeof(CASES) / sizeof(CASES[0]); c++) {
+    char cells[3][40];
+    for (int i = 0; i < 3; i++) {
+      BootRun run;
+      runBoot((BootSequence)i, sampleRate, CASES[c].apReachable, CASES[c].apCached, run);
+      uint32_t firstSample = 0, wifi = 0;
+      run.profile.getTime(BOOT_PHASE_FIRST_SAMPLE, firstSample);
+      char wifiText[16] = "-";
+      if (run.profile.getTime(BOOT_PHASE_WIFI, wifi)) {
+        snprintf(wifiText, sizeof(wifiText), "%.0f", wifi / 1000.0);
+      }
+      snprintf(cells[i], sizeof(cells[i]), "%.1f / %s", firstSample / 1000.0, wifiText);
+      if (i == BOOT_FAST && firstSample > worstFirstSample) worstFirstSample = firstSample;
+    }
+    printf("%-22s %18s %20s %16s\n", CASES[c].name, cells[0], cells[1], cells[2]);
+  }
+  
+  bool met = worstFirstSample <= BOOT_FIRST_SAMPLE_TARGET_US;
+  printf("\nTarget: fast boot first sample within %.1f ms: %s (worst %.1f ms)\n",
+         BOOT_FIRST_SAMPLE_TARGET_US / 1000.0, met ? "met" : "MISSED", worstFirstSample / 1000.0);
+  return met ? 0 : 1;
+}
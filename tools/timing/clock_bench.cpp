@@ -0,0 +1,282 @@
+/*
+ * Sample Clock Drift Benchmark
+ * 
+ * Runs the device SampleClock on the host's virtual clock for two simulated
+ * days with a crystal that is off by --ppm, once constant and once with a
+ * slow temperature swing of --wander ppm, and SNTP syncs every
+ * SNTP_SYNC_INTERVAL whose times are off by --jitter ms (standard
+ * deviation). Compares how the monitor takes its references:
+ * 
+ *   - polling: the original clock sync task, which read gettimeofday()
+ *     every 60 s. Between SNTP syncs the system clock runs on the same
+ *     crystal, and each sync steps it.
+ *   - sync events: the SNTP sync callback posts the time it just set
+ *     (SampleClock::postReference), and the clock sync task adds it.
+ * 
+ * Reports the estimated drift, rejected references, the timestamp error of
+ * the samples against true time and its largest growth between two
+ * references, and the long-run drift of the sample grid (samples taken
+ * against samples due in true time) in ms per hour.
+ * 
+ * The 1 ms/hour limit applies to the sync events runs after the first
+ * DRIFT_SETTLE_HOURS, and the limit column shows what is gated:
+ * 
+ *   - constant crystal: grid drift and worst interval.
+ *   - swing: grid drift only. Between two references the estimate lags the
+ *     crystal by one sync interval, about 3.6 ms/hour for each ppm the
+ *     crystal moves within an interval, which no correction from hourly
+ *     references can remove. The worst interval is reported, not gated.
+ * 
+ * Polling is the old behaviour and is reported for comparison only. Exits
+ * with status 1 if a gated value is 1 ms/hour or more.
+ * 
+ * Also checks the grid epochs: through rate switches, a drift correction, a
+ * stall with skipped samples and a restart, getSampleTime() and
+ * getSampleRate() must return what each earlier sample was taken at.
+ * Exits with status 1 on any difference.
+ * 
+ * Usage: clock_bench [--hours N] [--ppm N] [--wander N] [--jitter MS]
+ *                    [--rate HZ] [--seed N]
+ */
+
+#include "sensors/sample_clock.h"
+#include "config/config.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const int64_t EPOCH_START = 1760000000LL * 1000000;   // True time at boot (us)
+static const uint64_t FIRST_SYNC = 5000000;                  // SNTP's first sync after boot (us)
+static const uint64_t POLL_INTERVAL = 60000000;              // The original clock sync period (us)
+static const double WANDER_PERIOD = 12 * 3600.0;             // Temperature swing (s)
+static const int DRIFT_SETTLE_HOURS = 3;
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+enum SyncMode {
+  SYNC_POLLING,
+  SYNC_EVENTS
+};
+
+struct ClockRun {
+  double maxDriftError;          // |estimated - true| drift after settling (ppm)
+  unsigned long rejected;        // References out of MAX_CLOCK_DRIFT_PPM
+  double maxTimestampError;      // ms, after settling
+  double gridDriftPerHour;       // Sample grid against true time after settling (ms/hour)
+  double worstDriftPerHour;      // Largest timestamp error change between two references (ms/hour)
+};
+
+// Box-Muller on xorshift32
+static double nextGaussian(uint32_t& state) {
+  double u[2];
+  for (int i = 0; i < 2; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    u[i] = (state + 1.0) / 4294967297.0;
+  }
+  return sqrt(-2 * log(u[0])) * cos(2 * PI * u[1]);
+}
+
+static void runClock(SyncMode mode, double hours, double basePpm, double wanderPpm,
+                     double jitterMs, int sampleRate, uint32_t seed, ClockRun& result) {
+  virtualClock.enabled = true;
+  virtualClock.now = 0;
+  uint32_t randomState = seed * 2654435761u + 1;
+  
+  SampleClock clock;
+  clock.begin(sampleRate);
+  
+  double trueUs = 0;                       // True time since boot
+  int64_t systemEpoch = 0;                 // gettimeofday() at systemLocal
+  uint64_t systemLocal = 0;
+  bool systemSet = false;
+  uint64_t nextSync = FIRST_SYNC;
+  uint64_t nextPoll = POLL_INTERVAL;
+  uint64_t nextCheck = CLOCK_SYNC_INTERVAL * 1000ULL;
+  uint64_t end = (uint64_t)(hours * 3600e6);
+  double ppm = basePpm;                    // Crystal error, updated every second
+  uint64_t nextWander = 0;
+  
+  double settleUs = DRIFT_SETTLE_HOURS * 3600e6;
+  uint64_t samplesAfterSettle = 0;
+  double settleStartUs = -1;
+  bool referenceAdded = false;
+  double intervalStartError = 0;
+  double intervalStartUs = -1;
+  double lastError = 0;
+  double lastUs = 0;
+  result = ClockRun();
+  
+  while (virtualClock.now < end) {
+    // Advance to the next sample deadline; true time runs slower by the drift
+    uint64_t deadline = clock.getNextDeadline();
+    if (deadline >= nextWander) {
+      ppm = basePpm + wanderPpm * sin(2 * PI * trueUs / 1e6 / WANDER_PERIOD);
+      nextWander += 1000000;
+    }
+    trueUs += (double)(deadline - virtualClock.now) / (1 + ppm / 1e6);
+    virtualClock.now = deadline;
+    clock.takeSample();
+    
+    // SNTP sets the system clock (lwIP task)
+    if (virtualClock.now >= nextSync) {
+      systemEpoch = EPOCH_START + (int64_t)(trueUs + jitterMs * 1000 * nextGaussian(randomState));
+      systemLocal = virtualClock.now;
+      systemSet = true;
+      if (mode == SYNC_EVENTS) clock.postReference((uint32_t)micros(), systemEpoch);
+      nextSync += SNTP_SYNC_INTERVAL * 1000ULL;
+    }
+    
+    // Clock sync task
+    if (mode == SYNC_EVENTS && virtualClock.now >= nextCheck) {
+      referenceAdded = clock.applyPostedReference();
+      nextCheck += CLOCK_SYNC_INTERVAL * 1000ULL;
+    }
+    if (mode == SYNC_POLLING && systemSet && virtualClock.now >= nextPoll) {
+      // The system clock counts local time since the last step
+      clock.addReference(virtualClock.now, systemEpoch + (int64_t)(virtualClock.now - systemLocal));
+      referenceAdded = true;
+      nextPoll += POLL_INTERVAL;
+    }
+    
+    if (trueUs < settleUs || !clock.isSynchronized()) {
+      referenceAdded = false;
+      continue;
+    }
+    
+    double error = (clock.toEpoch(clock.getLastSampleTime()) - EPOCH_START - trueUs) / 1000;
+    if (settleStartUs < 0) settleStartUs = trueUs;
+    samplesAfterSettle++;
+    result.maxTimestampError = fmax(result.maxTimestampError, fabs(error));
+    result.maxDriftError = fmax(result.maxDriftError, fabs(clock.getDriftPpm() - ppm));
+    
+    // Error growth from one reference to the next is the residual drift; the
+    // step at a reference is its jitter
+    if (referenceAdded) {
+      if (intervalStartUs >= 0 && lastUs > intervalStartUs) {
+        double driftPerHour = fabs(lastError - intervalStartError) / ((lastUs - intervalStartUs) / 3600e6);
+        result.worstDriftPerHour = fmax(result.worstDriftPerHour, driftPerHour);
+      }
+      intervalStartUs = trueUs;
+      intervalStartError = error;
+      referenceAdded = false;
+    }
+    lastError = error;
+    lastUs = trueUs;
+  }
+  
+  // Samples taken against the samples due in the same true time
+  double settledHours = (trueUs - settleStartUs) / 3600e6;
+  double due = (trueUs - settleStartUs) * sampleRate / 1e6;
+  result.gridDriftPerHour = settledHours > 0 ?
+    fabs((double)samplesAfterSettle - due) * 1000.0 / sampleRate / settledHours : 0;
+  result.rejected = clock.getRejectedReferences();
+  virtualClock.enabled = false;
+}
+
+// Every grid change the monitor makes, then every sample looked up again
+static bool checkEpochs(int sampleRate) {
+  virtualClock.enabled = true;
+  virtualClock.now = 0;
+  SampleClock clock;
+  clock.begin(sampleRate);
+  
+  const int STEPS = 6;
+  const int SAMPLES_PER_STEP = 2000;
+  std::vector<uint64_t> times;
+  std::vector<int> rates;
+  
+  for (int step = 0; step < STEPS; step++) {
+    for (int i = 0; i < SAMPLES_PER_STEP; i++) {
+      virtualClock.now = clock.getNextDeadline();
+      if (step == 3 && i == SAMPLES_PER_STEP / 2) {
+        virtualClock.now += 100000;   // A stall the clock skips samples after
+      }
+      uint32_t sequence = clock.takeSample();
+      times.resize(sequence + 1, 0);
+      rates.resize(sequence + 1, 0);
+      times[sequence] = clock.getLastSampleTime();
+      rates[sequence] = clock.getSampleRate();
+    }
+    
+    switch (step) {
+      case 0: clock.setSampleRate(250); break;
+      case 1: {
+        // Two references 15 min apart (local times need not be now)
+        uint64_t local = clock.now();
+        clock.addReference(local, EPOCH_START);
+        clock.addReference(local + MIN_DRIFT_MEASUREMENT_SPAN * 1000ULL,
+                           EPOCH_START + (int64_t)(MIN_DRIFT_MEASUREMENT_SPAN * 1000ULL * (1 - 40e-6)));
+        break;
+      }
+      case 2: clock.setSampleRate(360); break;
+      case 3: virtualClock.now += 5000; clock.restart(); break;
+      case 4: clock.setSampleRate(sampleRate); break;
+      default: break;
+    }
+  }
+  
+  unsigned long checked = 0, wrongTimes = 0, wrongRates = 0;
+  for (uint32_t sequence = 0; sequence < times.size(); sequence++) {
+    if (rates[sequence] == 0) continue;   // Skipped
+    checked++;
+    if (clock.getSampleTime(sequence) != times[sequence]) wrongTimes++;
+    if (clock.getSampleRate(sequence) != rates[sequence]) wrongRates++;
+  }
+  virtualClock.enabled = false;
+  
+  printf("Grid epochs: %lu samples over %d grid changes and a stall, %lu wrong times, %lu wrong rates\n",
+         checked, STEPS - 1, wrongTimes, wrongRates);
+  return checked > 0 && wrongTimes == 0 && wrongRates == 0;
+}
+
+int main(int argc, char** argv) {
+  double hours = atof(getOption(argc, argv, "--hours", "48"));
+  double ppm = atof(getOption(argc, argv, "--ppm", "40"));
+  double wander = atof(getOption(argc, argv, "--wander", "2"));
+  double jitter = atof(getOption(argc, argv, "--jitter", "1"));
+  int sampleRate = atoi(getOption(argc, argv, "--rate", "500"));
+  uint32_t seed = (uint32_t)atoi(getOption(argc, argv, "--seed", "1"));
+  
+  printf("%.0f h at %d Hz, crystal %+.1f ppm, SNTP every %lu s with %.1f ms jitter\n\n",
+         hours, sampleRate, ppm, SNTP_SYNC_INTERVAL / 1000, jitter);
+  printf("crystal        references     drift error  rejected  timestamp error  worst interval  grid drift  limit\n");
+  printf("                              max (ppm)              max (ms)         (ms/hour)       (ms/hour)   1 ms/hour\n");
+  
+  const char* names[] = { "polling", "sync events" };
+  bool passed = true;
+  for (int swing = 0; swing < 2; swing++) {
+    char crystal[32];
+    snprintf(crystal, sizeof(crystal), swing ? "swing %.1f ppm" : "constant", wander);
+    for (int mode = SYNC_POLLING; mode <= SYNC_EVENTS; mode++) {
+      ClockRun result;
+      runClock((SyncMode)mode, hours, ppm, swing ? wander : 0, jitter, sampleRate, seed, result);
+      // Gate the sync events runs; the worst interval only with the constant crystal
+      const char* limit = "-";
+      if (mode == SYNC_EVENTS) {
+        bool ok = result.gridDriftPerHour < 1 && (swing || result.worstDriftPerHour < 1);
+        limit = !ok ? "FAIL" : swing ? "ok (grid)" : "ok";
+        passed = passed && ok;
+      }
+      printf("%-14s %-14s %11.2f %9lu %16.2f %15.3f %11.3f  %s\n", crystal, names[mode],
+             result.maxDriftError, result.rejected, result.maxTimestampError,
+             result.worstDriftPerHour, result.gridDriftPerHour, limit);
+    }
+  }
+  
+  printf("\nAfter the first %d hours. Timestamp error: toEpoch() of each sample against\n"
+         "true time. Worst interval: largest change of that error between two references.\n",
+         DRIFT_SETTLE_HOURS);
+  printf("1 ms/hour limit: %s\n\n", passed ? "met" : "EXCEEDED");
+  
+  passed = checkEpochs(sampleRate) && passed;
+  return passed ? 0 : 1;
+}
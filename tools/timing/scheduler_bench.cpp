@@ -0,0 +1,308 @@
+/*
+ * Scheduler Benchmark
+ * 
+ * Runs the monitor's main loop on the host's virtual clock (tools/host)
+ * with a cost model for each subsystem, and reports sampling jitter for:
+ * 
+ *   - the loop the scheduler replaced: every subsystem polled in turn,
+ *     a blocking 50 ms LED flash per beat and delay(1) after each pass
+ *   - the cooperative Scheduler: deadline-ordered tasks, sampling re-armed
+ *     at each sample clock deadline, idle() between deadlines
+ * 
+ * The uplink posts from its own task on the other core, so the loop only
+ * pays for handing it a batch. The scheduler is also run with the
+ * collector unreachable, every post timing out after UPLINK_HTTP_TIMEOUT
+ * and backing off like Uplink, once with the post in the loop (as before
+ * the upload task) and once with the upload task.
+ * 
+ * Virtual time only moves when a task spends it, so results are exact
+ * and repeatable. The sample clock, beat LED and scheduler are the device
+ * classes; the costs below are estimates for an ESP32 at 240 MHz. Exits
+ * with status 1 if the scheduler misses a sample with the upload task.
+ * 
+ * Usage: scheduler_bench [--minutes N] [--rate HZ]
+ */
+
+#include "scheduler/scheduler.h"
+#include "sensors/sample_clock.h"
+#include "telemetry/beat_indicator.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Cost model (us)
+static const uint64_t SAMPLE_COST = 45;             // ADC read + SignalProcessor
+static const uint64_t WEB_POLL_COST = 25;           // handleClient() with no request
+static const uint64_t WEB_REQUEST_COST = 4000;      // /status as JSON
+static const uint64_t WEB_REQUEST_PERIOD = 1000000; // Dashboard polling
+static const uint64_t STATUS_COST = 20;
+static const uint64_t WIFI_COST = 10;
+static const uint64_t UPLINK_POLL_COST = 15;
+static const uint64_t UPLOAD_HANDOFF_COST = 10;     // Peek a batch, queue it for the upload task
+static const uint64_t UPLOAD_TIME = 12000;          // HTTP POST of one batch
+static const uint64_t UPLOAD_TIMEOUT = UPLINK_HTTP_TIMEOUT * 1000ULL;   // Collector unreachable
+static const uint64_t UPLOAD_PERIOD = UPLINK_INTERVAL * 1000ULL;
+static const uint64_t HOUSEKEEPING_COST = 15;
+static const uint64_t BEAT_PERIOD = 833333;         // 72 BPM
+static const unsigned long LEGACY_LED_MS = 50;      // delay() per beat in the old loop
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+// Where the HTTP post runs
+enum UploadMode { UPLOAD_IN_LOOP, UPLOAD_TASK };
+
+// Monitor model shared by all loops
+struct Monitor {
+  SampleClock clock;
+  BeatIndicator led;
+  bool blockingLed;
+  UploadMode uploadMode;
+  bool collectorUp;
+  uint64_t nextBeat;
+  uint64_t nextRequest;
+  uint64_t nextUpload;
+  uint64_t uploadStarted;
+  uint64_t uploadBackoff;
+  bool uploading;
+  unsigned long posts;
+  std::vector<uint32_t> lateness;
+  
+  Monitor() : led(LED_PIN) {}
+  
+  void begin(int sampleRate, bool blocking, UploadMode mode, bool up) {
+    clock.begin(sampleRate);
+    led.begin();
+    blockingLed = blocking;
+    uploadMode = mode;
+    collectorUp = up;
+    nextBeat = virtualClock.now + BEAT_PERIOD;
+    nextRequest = virtualClock.now + WEB_REQUEST_PERIOD;
+    nextUpload = virtualClock.now + UPLOAD_PERIOD;
+    uploadStarted = 0;
+    uploadBackoff = UPLOAD_PERIOD;
+    uploading = false;
+    posts = 0;
+    lateness.clear();
+  }
+  
+  void serviceSampling() {
+    if (!clock.isSampleDue()) return;
+    
+    clock.takeSample();
+    lateness.push_back((uint32_t)(clock.now() - clock.getLastSampleTime()));
+    virtualClock.advance(SAMPLE_COST);
+    
+    if (clock.getLastSampleTime() < nextBeat) return;
+    nextBeat += BEAT_PERIOD;
+    if (blockingLed) {
+      digitalWrite(LED_PIN, HIGH);
+      delay(LEGACY_LED_MS);
+      digitalWrite(LED_PIN, LOW);
+    } else {
+      led.pulse();
+    }
+  }
+  
+  void handleWeb() {
+    virtualClock.advance(WEB_POLL_COST);
+    if (virtualClock.now >= nextRequest) {
+      nextRequest += WEB_REQUEST_PERIOD;
+      virtualClock.advance(WEB_REQUEST_COST);
+    }
+  }
+  
+  // Uplink::loop(): take a finished post's result, then start the next
+  void updateUplink() {
+    virtualClock.advance(UPLINK_POLL_COST);
+    uint64_t postTime = collectorUp ? UPLOAD_TIME : UPLOAD_TIMEOUT;
+    
+    if (uploading) {
+      if (virtualClock.now < uploadStarted + postTime) return;
+      finishUpload();
+    }
+    if (virtualClock.now < nextUpload) return;
+    
+    uploadStarted = virtualClock.now;
+    uploading = true;
+    posts++;
+    if (uploadMode == UPLOAD_IN_LOOP) {
+      virtualClock.advance(postTime);
+      finishUpload();
+    } else {
+      virtualClock.advance(UPLOAD_HANDOFF_COST);   // The post runs on the other core
+    }
+  }
+  
+  // Next attempt counts from the start of this one, backing off on failure
+  void finishUpload() {
+    uploading = false;
+    if (collectorUp) {
+      uploadBackoff = UPLOAD_PERIOD;
+    } else {
+      uploadBackoff = std::min<uint64_t>(std::max<uint64_t>(uploadBackoff * 2, UPLINK_MIN_BACKOFF * 1000ULL),
+                               UPLINK_MAX_BACKOFF * 1000ULL);
+    }
+    nextUpload = uploadStarted + uploadBackoff;
+  }
+};
+
+static Monitor monitor;
+static Scheduler scheduler;
+static int samplingTask = -1;
+
+static void runSampling() {
+  monitor.serviceSampling();
+  scheduler.runAt(samplingTask, monitor.clock.getNextDeadline());
+}
+
+static void updateLed() { monitor.led.update(); }
+static void handleWeb() { monitor.handleWeb(); }
+static void publishStatus() { virtualClock.advance(STATUS_COST); }
+static void updateWiFi() { virtualClock.advance(WIFI_COST); }
+static void updateUplink() { monitor.updateUplink(); }
+static void housekeeping() { virtualClock.advance(HOUSEKEEPING_COST); }
+static void syncClock() {}
+
+struct JitterResult {
+  double mean;
+  double std;
+  uint32_t p99;
+  uint32_t max;
+  size_t samples;
+  unsigned long missed;
+  unsigned long posts;
+};
+
+static void summarize(JitterResult& result) {
+  std::vector<uint32_t>& late = monitor.lateness;
+  result.samples = late.size();
+  result.missed = monitor.clock.getMissedSamples();
+  result.posts = monitor.posts;
+  double sum = 0, squares = 0;
+  for (uint32_t value : late) {
+    sum += value;
+    squares += (double)value * value;
+  }
+  result.mean = late.empty() ? 0 : sum / late.size();
+  result.std = late.empty() ? 0 : sqrt(std::max(squares / late.size() - result.mean * result.mean, 0.0));
+  std::sort(late.begin(), late.end());
+  result.p99 = late.empty() ? 0 : late[late.size() * 99 / 100];
+  result.max = late.empty() ? 0 : late.back();
+}
+
+// The loop before the scheduler: poll everything, then delay(1)
+static void runLegacy(int sampleRate, uint64_t duration, JitterResult& result) {
+  uint64_t end = virtualClock.now + duration;
+  monitor.begin(sampleRate, true, UPLOAD_IN_LOOP, true);
+  
+  while (virtualClock.now < end) {
+    monitor.handleWeb();
+    virtualClock.advance(HOUSEKEEPING_COST);    // Config changes
+    monitor.updateUplink();
+    monitor.serviceSampling();
+    virtualClock.advance(HOUSEKEEPING_COST);    // Clock sync check, heap audit
+    delay(1);
+  }
+  summarize(result);
+}
+
+static void runScheduler(int sampleRate, uint64_t duration, UploadMode mode, bool collectorUp,
+                         JitterResult& result) {
+  uint64_t end = virtualClock.now + duration;
+  monitor.begin(sampleRate, false, mode, collectorUp);
+  
+  scheduler = Scheduler();
+  scheduler.begin(&monitor.clock);
+  samplingTask = scheduler.addTask("sampling", runSampling, 0);
+  scheduler.addTask("led", updateLed, LED_TASK_PERIOD);
+  scheduler.addTask("web", handleWeb, WEB_TASK_PERIOD);
+  scheduler.addTask("status", publishStatus, STATUS_TASK_PERIOD);
+  scheduler.addTask("wifi", updateWiFi, WIFI_TASK_PERIOD);
+  scheduler.addTask("uplink", updateUplink, UPLINK_TASK_PERIOD);
+  scheduler.addTask("housekeeping", housekeeping, HOUSEKEEPING_TASK_PERIOD);
+  scheduler.addTask("clock sync", syncClock, CLOCK_SYNC_INTERVAL);
+  
+  while (virtualClock.now < end) {
+    scheduler.runDue();
+    scheduler.idle();
+    
+    // idle() yields when the gap is short; a real loop spins to the deadline
+    uint64_t deadline = scheduler.getNextDeadline();
+    if (deadline > virtualClock.now) virtualClock.now = deadline;
+  }
+  summarize(result);
+}
+
+// Real cost of one dispatch on this host (heap update + call)
+static double dispatchCost() {
+  SampleClock clock;
+  Scheduler bench;
+  bench.begin(&clock);
+  for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+    bench.addTask("bench", syncClock, 1 + i);
+  }
+  
+  const int runs = 2000000;
+  auto started = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; i++) {
+    if (!bench.runNext()) virtualClock.now = bench.getNextDeadline();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  return seconds * 1e9 / runs;
+}
+
+static void printResult(const char* name, const JitterResult& result) {
+  printf("%-18s %9.1f %8.1f %8u %8u %9zu %8lu %6lu\n", name, result.mean, result.std, result.p99,
+         result.max, result.samples, result.missed, result.posts);
+}
+
+int main(int argc, char** argv) {
+  double minutes = atof(getOption(argc, argv, "--minutes", "10"));
+  int sampleRate = atoi(getOption(argc, argv, "--rate", "500"));
+  uint64_t duration = (uint64_t)(minutes * 60e6);
+  
+  virtualClock.enabled = true;
+  
+  // The task statistics below are those of the last run
+  JitterResult timeoutInLoop, timeoutTask, legacy, cooperative;
+  runScheduler(sampleRate, duration, UPLOAD_IN_LOOP, false, timeoutInLoop);
+  runScheduler(sampleRate, duration, UPLOAD_TASK, false, timeoutTask);
+  runLegacy(sampleRate, duration, legacy);
+  runScheduler(sampleRate, duration, UPLOAD_TASK, true, cooperative);
+  
+  printf("Sampling at %d Hz, %.0f min of virtual time per loop\n\n", sampleRate, minutes);
+  printf("                   sample lateness (us)                  samples   missed  posts\n");
+  printf("loop                    mean      std      p99      max\n");
+  printResult("polling loop", legacy);
+  printResult("scheduler", cooperative);
+  
+  printf("\nCollector unreachable, every post times out after %lu ms\n", UPLINK_HTTP_TIMEOUT);
+  printResult("post in loop", timeoutInLoop);
+  printResult("upload task", timeoutTask);
+  
+  printf("\nScheduler tasks (virtual time, us)\n");
+  printf("task            runs  skipped  late mean    std    max  run mean    max\n");
+  for (int i = 0; i < scheduler.getTaskCount(); i++) {
+    TaskStats stats;
+    scheduler.getStats(i, stats);
+    printf("%-12s %7u %8u %10u %6u %6u %9u %6u\n", stats.name, stats.runs, stats.skippedPeriods,
+           stats.meanLateness, stats.latenessStd, stats.maxLateness, stats.meanRunTime,
+           stats.maxRunTime);
+  }
+  
+  virtualClock.enabled = false;
+  printf("\nDispatch cost (this host, %d tasks): %.1f ns per task run\n", SCHEDULER_MAX_TASKS,
+         dispatchCost());
+  
+  bool passed = cooperative.missed == 0 && timeoutTask.missed == 0;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,365 @@
+/*
+ * Outbox Delivery Test
+ * 
+ * Runs the device Outbox against a mock collector through outages,
+ * reboots and catch-up, on a simulated timeline, and checks that every
+ * record the outbox accepted reaches the collector exactly once and in
+ * order. Records carry a running index, so the collector sees any loss,
+ * duplicate or reordering.
+ * 
+ * The device side follows Uplink::loop(): flush the appended records every
+ * UPLINK_OUTBOX_FLUSH_INTERVAL, peek a batch, post it with its stream
+ * offset and acknowledge what the collector replies, one batch per
+ * UPLINK_INTERVAL when caught up and per UPLINK_CATCHUP_INTERVAL while
+ * behind, with backoff after failures. The collector skips the part
+ * of a batch below its stored offset, like tools/gateway.
+ * 
+ * Timeline (--rate bytes/s of records, default 600, about 500 Hz ECG):
+ * 
+ *   - online, long enough to write the outbox limit several times over
+ *   - collector outage, with a reboot in the middle and a record cut
+ *     short by the power loss
+ *   - catch-up, with a reboot after the collector has stored a batch
+ *     whose acknowledgement was lost
+ *   - an outage longer than the outbox holds (new records are dropped and
+ *     counted), then catch-up again
+ * 
+ * Reboots come right after a flush; records appended since the last flush
+ * would be lost with the power.
+ * 
+ * Exits with status 1 on a lost, duplicated or reordered record, a record
+ * dropped while the outbox was not full, stored data above the limit, an
+ * acknowledgement beyond the flushed records, or a backlog that did not
+ * drain.
+ * 
+ * Usage: outbox_test [--rate BYTES] [--seed N] [--dir PATH]
+ */
+
+#include "uplink/outbox.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+static const uint64_t TICK_MS = 50;
+static const uint64_t MINUTE_MS = 60000;
+
+static const char* getOption(int argc, char** argv, const char* name, const char* fallback) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], name) == 0) return argv[i + 1];
+  }
+  return fallback;
+}
+
+// Collector side of the uplink protocol for one device
+struct MockCollector {
+  bool online = true;
+  bool loseNextAck = false;      // Store the next batch, but the reply never arrives
+  bool ackLost = false;
+  uint64_t storedOffset = 0;
+  std::vector<uint32_t> received;
+  unsigned long gaps = 0;        // Batches that started above the stored offset
+  unsigned long retransmitted = 0;
+  
+  // Returns false when the device gets no acknowledgement
+  bool post(uint64_t offset, const uint8_t* batch, size_t length, uint64_t& ackOffset) {
+    if (!online) return false;
+    
+    if (offset > storedOffset) {
+      gaps++;
+      storedOffset = offset;
+    }
+    uint64_t skip = storedOffset - offset;
+    if (skip > 0) retransmitted++;
+    
+    for (size_t position = skip; position + 2 <= length;) {
+      size_t recordLength = batch[position] | (batch[position + 1] << 8);
+      if (position + 2 + recordLength > length || recordLength < 4) break;
+      uint32_t index;
+      memcpy(&index, batch + position + 2, 4);
+      received.push_back(index);
+      position += 2 + recordLength;
+      storedOffset = offset + position;
+    }
+    
+    ackOffset = storedOffset;
+    if (loseNextAck) {
+      loseNextAck = false;
+      ackLost = true;
+      return false;
+    }
+    return true;
+  }
+};
+
+// Device side: record source, outbox and the uplink's upload policy
+struct Device {
+  Outbox* outbox = NULL;
+  const char* directory;
+  char statePath[96];
+  uint32_t nextIndex = 0;
+  std::vector<uint32_t> accepted;     // Indexes the outbox took, in order
+  unsigned long droppedWhileRoom = 0;
+  double pendingBytes = 0;            // Record bytes due at the source rate
+  uint32_t randomState;
+  
+  uint64_t lastFlush = 0;
+  unsigned long flushes = 0;
+  unsigned long ackedUnflushed = 0;   // Acknowledgements beyond the records on flash
+  
+  uint8_t uploadBuffer[UPLINK_MAX_BATCH_BYTES];
+  unsigned long uploadBackoff = 0;
+  uint64_t lastUploadAttempt = 0;
+  unsigned long uploads = 0;
+  
+  uint64_t maxStored = 0;
+  int maxSegments = 0;
+  uint64_t overallMaxStored = 0;
+  
+  bool boot() {
+    if (outbox != NULL) outbox->flush();
+    delete outbox;
+    outbox = new Outbox();
+    uploadBackoff = 0;
+    return outbox->begin(directory, statePath);
+  }
+  
+  uint32_t nextRandom() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+  }
+  
+  void produce(double bytes) {
+    // Sample blocks vary with the signal; 150-450 bytes
+    pendingBytes += bytes;
+    while (pendingBytes >= 300) {
+      uint8_t record[512];
+      size_t length = 150 + nextRandom() % 301;
+      memcpy(record, &nextIndex, 4);
+      memset(record + 4, (uint8_t)nextIndex, length - 4);
+      
+      bool full = outbox->getStoredBytes() + 2 + length > UPLINK_OUTBOX_MAX_BYTES;
+      if (outbox->append(record, length)) {
+        accepted.push_back(nextIndex);
+      } else if (!full) {
+        droppedWhileRoom++;
+      }
+      nextIndex++;
+      pendingBytes -= length;
+    }
+    
+    if (outbox->getStoredBytes() > maxStored) maxStored = outbox->getStoredBytes();
+    if (maxStored > overallMaxStored) overallMaxStored = maxStored;
+    if (outbox->getSegmentCount() > maxSegments) maxSegments = outbox->getSegmentCount();
+  }
+  
+  void flush(uint64_t now) {
+    if (now - lastFlush < UPLINK_OUTBOX_FLUSH_INTERVAL) return;
+    lastFlush = now;
+    if (outbox->getFlushedOffset() != outbox->getEndOffset()) flushes++;
+    outbox->flush();
+  }
+  
+  void upload(MockCollector& collector, uint64_t now) {
+    if (outbox->getPendingBytes() == 0) return;
+    if (now - lastUploadAttempt < uploadBackoff) return;
+    lastUploadAttempt = now;
+    
+    uint64_t offset;
+    size_t length = outbox->peek(uploadBuffer, sizeof(uploadBuffer), offset);
+    if (length == 0) return;
+    
+    uint64_t ackOffset;
+    uploads++;
+    if (collector.post(offset, uploadBuffer, length, ackOffset)) {
+      if (ackOffset > outbox->getFlushedOffset()) ackedUnflushed++;
+      outbox->acknowledge(ackOffset);
+      uploadBackoff = (outbox->getPendingBytes() >= UPLINK_MAX_BATCH_BYTES) ? UPLINK_CATCHUP_INTERVAL : UPLINK_INTERVAL;
+    } else {
+      uploadBackoff = constrain(uploadBackoff * 2, UPLINK_MIN_BACKOFF, UPLINK_MAX_BACKOFF);
+    }
+  }
+};
+
+// Power loss in the middle of an append: a frame header and part of a record
+static void tearNewestSegment(const char* directory) {
+  DIR* dir = opendir(directory);
+  char newest[64] = "";
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (strstr(entry->d_name, ".bin") && strcmp(entry->d_name, newest) > 0) {
+      strlcpy(newest, entry->d_name, sizeof(newest));
+    }
+  }
+  closedir(dir);
+  
+  char path[320];
+  snprintf(path, sizeof(path), "%s/%s", directory, newest);
+  FILE* file = fopen(path, "ab");
+  uint8_t torn[] = { 200, 0, 0xAA, 0xBB, 0xCC };
+  fwrite(torn, 1, sizeof(torn), file);
+  fclose(file);
+}
+
+static void removeDirectory(const char* directory) {
+  DIR* dir = opendir(directory);
+  if (dir == NULL) return;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') continue;
+    char path[320];
+    snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    remove(path);
+  }
+  closedir(dir);
+  rmdir(directory);
+}
+
+enum PhaseEvent {
+  EVENT_NONE,
+  EVENT_TORN_REBOOT,       // Power lost mid-append, reboot at the start
+  EVENT_LOST_ACK_REBOOT    // Reboot right after a batch whose reply was lost
+};
+
+struct Phase {
+  const char* name;
+  uint64_t minutes;
+  bool collectorOnline;
+  PhaseEvent event;
+};
+
+int main(int argc, char** argv) {
+  double rate = atof(getOption(argc, argv, "--rate", "600"));
+  uint32_t seed = (uint32_t)atoi(getOption(argc, argv, "--seed", "1"));
+  
+  char defaultDir[] = "/tmp/outbox_test_XXXXXX";
+  const char* base = getOption(argc, argv, "--dir", NULL);
+  bool temporary = base == NULL;
+  if (temporary) base = mkdtemp(defaultDir);
+  char directory[128];
+  snprintf(directory, sizeof(directory), "%s/outbox", base);
+  
+  Device device;
+  device.directory = directory;
+  snprintf(device.statePath, sizeof(device.statePath), "%s/outbox.state", base);
+  device.randomState = seed * 2654435761u + 1;
+  removeDirectory(directory);
+  remove(device.statePath);
+  
+  MockCollector collector;
+  if (!device.boot()) return 1;
+  
+  // Minutes to fill the outbox at this rate
+  uint64_t fillMinutes = (uint64_t)(UPLINK_OUTBOX_MAX_BYTES / rate / 60);
+  const Phase phases[] = {
+    { "online", 4 * fillMinutes, true, EVENT_NONE },
+    { "outage", fillMinutes / 3, false, EVENT_NONE },
+    { "outage, reboot", fillMinutes / 3, false, EVENT_TORN_REBOOT },
+    { "catch-up, reboot", 30, true, EVENT_LOST_ACK_REBOOT },
+    { "long outage", fillMinutes + 10, false, EVENT_NONE },
+    { "catch-up", 30, true, EVENT_NONE }
+  };
+  
+  printf("Records at %.0f B/s, outbox limit %lu bytes (%llu min), segments of %lu bytes\n\n",
+         rate, (unsigned long)UPLINK_OUTBOX_MAX_BYTES, (unsigned long long)fillMinutes,
+         (unsigned long)UPLINK_OUTBOX_SEGMENT_BYTES);
+  printf("phase                  minutes  pending at end  max stored  segments  dropped  drained after\n");
+  
+  uint64_t now = 0;
+  bool drained = true;
+  for (const Phase& phase : phases) {
+    if (phase.event == EVENT_TORN_REBOOT) {
+      tearNewestSegment(directory);
+      if (!device.boot()) return 1;
+    }
+    collector.loseNextAck = phase.event == EVENT_LOST_ACK_REBOOT;
+    
+    collector.online = phase.collectorOnline;
+    device.maxStored = 0;
+    device.maxSegments = 0;
+    unsigned long droppedBefore = device.outbox->getDroppedRecords();
+    uint64_t start = now;
+    long drainedAfter = -1;
+    
+    for (uint64_t end = now + phase.minutes * MINUTE_MS; now < end; now += TICK_MS) {
+      device.produce(rate * TICK_MS / 1000);
+      device.flush(now);
+      if (collector.online) device.upload(collector, now);
+      if (collector.ackLost) {
+        collector.ackLost = false;
+        if (!device.boot()) return 1;
+      }
+      if (drainedAfter < 0 && device.outbox->getPendingBytes() < UPLINK_MAX_BATCH_BYTES) {
+        drainedAfter = (long)((now - start) / 1000);
+      }
+    }
+    
+    char drainedText[32] = "-";
+    if (phase.collectorOnline) {
+      if (drainedAfter >= 0) {
+        snprintf(drainedText, sizeof(drainedText), "%ld s", drainedAfter);
+      } else {
+        snprintf(drainedText, sizeof(drainedText), "never");
+        drained = false;
+      }
+    }
+    printf("%-22s %8llu %15llu %11llu %9d %8lu  %s\n", phase.name,
+           (unsigned long long)phase.minutes, (unsigned long long)device.outbox->getPendingBytes(),
+           (unsigned long long)device.maxStored, device.maxSegments,
+           device.outbox->getDroppedRecords() - droppedBefore, drainedText);
+  }
+  
+  // Let the last records through
+  collector.online = true;
+  for (uint64_t end = now + 2 * MINUTE_MS; now < end; now += TICK_MS) {
+    device.flush(now);
+    device.upload(collector, now);
+  }
+  
+  // Every accepted record exactly once, in order
+  size_t missing = 0, duplicates = 0, reordered = 0;
+  size_t next = 0;
+  for (size_t i = 0; i < collector.received.size(); i++) {
+    uint32_t index = collector.received[i];
+    if (next < device.accepted.size() && index == device.accepted[next]) {
+      next++;
+    } else if (i > 0 && index <= collector.received[i - 1]) {
+      duplicates++;
+    } else {
+      // Skipped accepted records
+      while (next < device.accepted.size() && device.accepted[next] != index) {
+        missing++;
+        next++;
+      }
+      if (next < device.accepted.size()) {
+        next++;
+      } else {
+        reordered++;
+      }
+    }
+  }
+  missing += device.accepted.size() - next;
+  
+  printf("\nrecords accepted %zu, received %zu: missing %zu, duplicates %zu, out of order %zu\n",
+         device.accepted.size(), collector.received.size(), missing, duplicates, reordered);
+  printf("dropped with room left %lu, batches retransmitted %lu, offset gaps %lu, uploads %lu\n",
+         device.droppedWhileRoom, collector.retransmitted, collector.gaps, device.uploads);
+  printf("most stored %llu bytes, flushes %lu, acknowledged beyond the flushed records %lu\n",
+         (unsigned long long)device.overallMaxStored, device.flushes, device.ackedUnflushed);
+  
+  bool passed = missing == 0 && duplicates == 0 && reordered == 0 && collector.gaps == 0 &&
+                device.droppedWhileRoom == 0 && collector.retransmitted > 0 && drained &&
+                device.ackedUnflushed == 0 &&
+                device.overallMaxStored <= UPLINK_OUTBOX_MAX_BYTES;
+  printf("%s\n", passed ? "PASS" : "FAIL");
+  
+  delete device.outbox;
+  removeDirectory(directory);
+  remove(device.statePath);
+  if (temporary) rmdir(base);
+  return passed ? 0 : 1;
+}